@@ -1920,6 +1920,14 @@ bool CApplication::LoadSkin(const CStdString& skinID)
   return false;
 }
 
+/* logs the time taken by a phase of loading the skin, and starts timing the next */
+static void LogSkinLoadTime(const char *phase, int64_t &start)
+{
+  int64_t end = CurrentHostCounter();
+  CLog::Log(LOGDEBUG, "Load Skin %s: %.2fms", phase, 1000.f * (end - start) / CurrentHostFrequency());
+  start = end;
+}
+
 void CApplication::LoadSkin(const SkinPtr& skin)
 {
   if (!skin)
@@ -1973,6 +1981,9 @@ void CApplication::LoadSkin(const SkinPtr& skin)
 
   UnloadSkin();
 
+  int64_t start, phase;
+  start = phase = CurrentHostCounter();
+
   CLog::Log(LOGINFO, "  load skin from: %s (version: %s)", skin->Path().c_str(), skin->Version().c_str());
   g_SkinInfo = skin;
   g_SkinInfo->Start();
@@ -1996,6 +2007,7 @@ void CApplication::LoadSkin(const SkinPtr& skin)
   g_colorManager.Load(g_guiSettings.GetString("lookandfeel.skincolors"));
 
   g_fontManager.LoadFonts(g_guiSettings.GetString("lookandfeel.font"));
+  LogSkinLoadTime("fonts", phase);
 
   // load in the skin strings
   CStdString langPath;
@@ -2005,19 +2017,13 @@ void CApplication::LoadSkin(const SkinPtr& skin)
   g_localizeStrings.LoadSkinStrings(langPath, g_guiSettings.GetString("locale.language"));
 
   g_SkinInfo->LoadIncludes();
-
-  int64_t start;
-  start = CurrentHostCounter();
+  LogSkinLoadTime("strings and includes", phase);
 
   CLog::Log(LOGINFO, "  load new skin...");
 
   // Load the user windows
   LoadUserWindows();
-
-  int64_t end, freq;
-  end = CurrentHostCounter();
-  freq = CurrentHostFrequency();
-  CLog::Log(LOGDEBUG,"Load Skin XML: %.2fms", 1000.f * (end - start) / freq);
+  LogSkinLoadTime("XML", phase);
 
   CLog::Log(LOGINFO, "  initialize new skin...");
   g_windowManager.AddMsgTarget(this);
@@ -2040,6 +2046,14 @@ void CApplication::LoadSkin(const SkinPtr& skin)
     if (overlay) overlay->SetVisibleCondition("skin.hasmusicoverlay");
   }
 
+  LogSkinLoadTime("windows", phase);
+
+  unsigned int conditions;
+  uint64_t requests, evaluations;
+  g_infoManager.GetBoolStats(conditions, requests, evaluations);
+  LogSkinLoadTime("total", start);
+  CLog::Log(LOGDEBUG, "Load Skin registered %u conditions", conditions);
+
   CLog::Log(LOGINFO, "  skin loaded...");
 
   // leave the graphics lock
@@ -2349,10 +2363,10 @@ void CApplication::Render()
 
   g_Windowing.EndRender();
 
-  // reset our info cache - we do this at the end of Render so that it is
+  // update our info cache - we do this at the end of Render so that it is
   // fresh for the next process(), or after a windowclose animation (where process()
   // isn't called)
-  g_infoManager.ResetCache();
+  g_infoManager.UpdateCache();
   lock.Leave();
 
   unsigned int now = XbmcThreads::SystemClockMillis();
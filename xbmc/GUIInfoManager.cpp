@@ -81,6 +81,8 @@
 #include "video/VideoDatabase.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 
+#include <algorithm>
+
 #define SYSHEATUPDATEINTERVAL 60000
 
 using namespace std;
@@ -103,12 +105,15 @@ CGUIInfoManager::CGUIInfoManager(void) :
   m_performingSeek = false;
   m_nextWindowID = WINDOW_INVALID;
   m_prevWindowID = WINDOW_INVALID;
-  m_stringParameters.push_back("__ZZZZ__");   // to offset the string parameters by 1 to assure that all entries are non-zero
+  ConditionalStringParameter("__ZZZZ__");     // to offset the string parameters by 1 to assure that all entries are non-zero
   m_currentFile = new CFileItem;
   m_currentSlide = new CFileItem;
   m_frameCounter = 0;
   m_lastFPSTime = 0;
   m_updateTime = 1;
+  for (unsigned int i = 0; i < sizeof(m_sourceChanged) / sizeof(m_sourceChanged[0]); i++)
+    m_sourceChanged[i] = m_updateTime;
+  m_wasPlaying = false;
   m_MusicBitrate = 0;
   m_playerShowTime = false;
   m_playerShowCodec = false;
@@ -726,6 +731,19 @@ int CGUIInfoManager::TranslateSingleString(const CStdString &strCondition)
   strTest.TrimLeft(" \t\r\n");
   strTest.TrimRight(" \t\r\n");
 
+  // skins use the same conditions and labels over and over, so only parse them once
+  CSingleLock lock(m_critInfo);
+  map<CStdString, int>::const_iterator i = m_translated.find(strTest);
+  if (i != m_translated.end())
+    return i->second;
+
+  int ret = TranslateSingleStringInternal(strTest);
+  m_translated[strTest] = ret;
+  return ret;
+}
+
+int CGUIInfoManager::TranslateSingleStringInternal(const CStdString &strTest)
+{
   vector< Property> info;
   SplitInfoString(strTest, info);
 
@@ -1990,18 +2008,18 @@ unsigned int CGUIInfoManager::Register(const CStdString &expression, int context
 
   CSingleLock lock(m_critInfo);
   // do we have the boolean expression already registered?
-  InfoBool test(condition, context);
-  for (unsigned int i = 0; i < m_bools.size(); ++i)
-  {
-    if (*m_bools[i] == test)
-      return i+1;
-  }
+  CStdString key(condition);
+  key.ToLower();
+  map<pair<int, CStdString>, unsigned int>::const_iterator i = m_boolIndex.find(make_pair(context, key));
+  if (i != m_boolIndex.end())
+    return i->second;
 
   if (condition.find_first_of("|+[]!") != condition.npos)
     m_bools.push_back(new InfoExpression(condition, context));
   else
     m_bools.push_back(new InfoSingle(condition, context));
 
+  m_boolIndex[make_pair(context, key)] = m_bools.size();
   return m_bools.size();
 }
 
@@ -2015,30 +2033,169 @@ bool CGUIInfoManager::EvaluateBool(const CStdString &expression, int contextWind
 }
 
 /*
- TODO: what to do with item-based infobools...
- these crop up:
- 1. if condition is between LISTITEM_START and LISTITEM_END
- 2. if condition is STRING_IS_EMPTY, STRING_COMPARE, STRING_STR, INTEGER_GREATER_THAN and the
-    corresponding label is between LISTITEM_START and LISTITEM_END
-
- In both cases they shouldn't be in our cache as they depend on items outside of our control atm.
-
- We only pass a listitem object in for controls inside a listitemlayout, so I think it's probably OK
- to not cache these, as they're "pushed" out anyway.
-
- The problem is how do we avoid these?  The only thing we have to go on is the expression here, so I
- guess what we have to do is call through via Update.  One thing we don't handle, however, is that the
- majority of conditions (even inside lists) don't depend on the listitem at all.
+ Each registered bool keeps its value until one of the sources it depends on changes.  We keep
+ the last time any source in each combination of them changed, so the check is a single lookup.
 
- Advantage is that we know this at creation time I think, so could perhaps signal it in IsDirty()?
+ Bools that depend on a listitem aren't cached when an item is passed in, as they depend on items
+ outside of our control.  We only pass a listitem object in for controls inside a listitemlayout,
+ and the majority of conditions (even inside lists) don't depend on the listitem at all, so those
+ still come from the cache.
  */
 bool CGUIInfoManager::GetBoolValue(unsigned int expression, const CGUIListItem *item)
 {
   if (expression && --expression < m_bools.size())
-    return m_bools[expression]->Get(m_updateTime, item);
+  {
+    InfoBool *info = m_bools[expression];
+    return info->Get(m_sourceChanged[info->GetSources()], item);
+  }
   return false;
 }
 
+unsigned int CGUIInfoManager::GetBoolSources(unsigned int expression) const
+{
+  if (expression && --expression < m_bools.size())
+    return m_bools[expression]->GetSources();
+  return 0;
+}
+
+void CGUIInfoManager::GetBoolStats(unsigned int &conditions, uint64_t &requests, uint64_t &evaluations)
+{
+  CSingleLock lock(m_critInfo);
+  conditions = m_bools.size();
+  requests = evaluations = 0;
+  for (unsigned int i = 0; i < m_bools.size(); ++i)
+  {
+    requests += m_bools[i]->GetRequests();
+    evaluations += m_bools[i]->GetEvaluations();
+  }
+}
+
+unsigned int CGUIInfoManager::GetConditionSources(int condition) const
+{
+  condition = abs(condition);
+  if (condition >= LISTITEM_START && condition < LISTITEM_END)
+    return INFO_SOURCE_LISTITEM | INFO_SOURCE_CONTAINER;
+  if (condition >= MULTI_INFO_START && condition <= MULTI_INFO_END)
+  {
+    if (condition - MULTI_INFO_START < (int)m_multiInfo.size())
+      return GetMultiInfoSources(m_multiInfo[condition - MULTI_INFO_START]);
+    return INFO_SOURCE_VOLATILE;
+  }
+
+  switch (condition)
+  {
+    case SYSTEM_ALWAYS_TRUE:
+    case SYSTEM_ALWAYS_FALSE:
+    case SYSTEM_ETHERNET_LINK_ACTIVE:
+    case SYSTEM_HAS_PVR:
+    case SYSTEM_PLATFORM_LINUX:
+    case SYSTEM_PLATFORM_WINDOWS:
+    case SYSTEM_PLATFORM_DARWIN:
+    case SYSTEM_PLATFORM_DARWIN_OSX:
+    case SYSTEM_PLATFORM_DARWIN_IOS:
+    case SYSTEM_PLATFORM_DARWIN_ATV2:
+    case SYSTEM_PLATFORM_ANDROID:
+      return 0;
+    case WINDOW_IS_MEDIA:
+    case SYSTEM_LOGGEDON:
+      return INFO_SOURCE_WINDOW;
+    // these are only ever true while playing
+    case PLAYER_HAS_MEDIA:
+    case PLAYER_HAS_AUDIO:
+    case PLAYER_HAS_VIDEO:
+    case PLAYER_PLAYING:
+    case PLAYER_PAUSED:
+    case PLAYER_REWINDING:
+    case PLAYER_REWINDING_2x:
+    case PLAYER_REWINDING_4x:
+    case PLAYER_REWINDING_8x:
+    case PLAYER_REWINDING_16x:
+    case PLAYER_REWINDING_32x:
+    case PLAYER_FORWARDING:
+    case PLAYER_FORWARDING_2x:
+    case PLAYER_FORWARDING_4x:
+    case PLAYER_FORWARDING_8x:
+    case PLAYER_FORWARDING_16x:
+    case PLAYER_FORWARDING_32x:
+    case PLAYER_CAN_RECORD:
+    case PLAYER_CAN_PAUSE:
+    case PLAYER_CAN_SEEK:
+    case PLAYER_RECORDING:
+    case PLAYER_DISPLAY_AFTER_SEEK:
+    case PLAYER_CACHING:
+    case PLAYER_SEEKBAR:
+    case PLAYER_SEEKING:
+    case PLAYER_SHOWTIME:
+    case PLAYER_PASSTHROUGH:
+    case PLAYER_HASDURATION:
+    case MUSICPM_ENABLED:
+    case AUDIOSCROBBLER_ENABLED:
+    case LASTFM_RADIOPLAYING:
+    case LASTFM_CANLOVE:
+    case LASTFM_CANBAN:
+    case MUSICPLAYER_HASPREVIOUS:
+    case MUSICPLAYER_HASNEXT:
+    case MUSICPLAYER_PLAYLISTPLAYING:
+    case VIDEOPLAYER_USING_OVERLAYS:
+    case VIDEOPLAYER_ISFULLSCREEN:
+    case VIDEOPLAYER_HASMENU:
+    case VIDEOPLAYER_HASTELETEXT:
+    case VIDEOPLAYER_HASSUBTITLES:
+    case VIDEOPLAYER_SUBTITLESENABLED:
+    case VIDEOPLAYER_HAS_EPG:
+    case PLAYLIST_ISRANDOM:
+    case PLAYLIST_ISREPEAT:
+    case PLAYLIST_ISREPEATONE:
+    case VISUALISATION_LOCKED:
+    case VISUALISATION_ENABLED:
+      return INFO_SOURCE_PLAYER;
+  }
+  return INFO_SOURCE_VOLATILE;
+}
+
+unsigned int CGUIInfoManager::GetMultiInfoSources(const GUIInfo &info) const
+{
+  int condition = abs(info.m_info);
+  if (condition >= LISTITEM_START && condition <= LISTITEM_END)
+    return INFO_SOURCE_LISTITEM | INFO_SOURCE_CONTAINER;
+
+  switch (condition)
+  {
+    case SKIN_BOOL:
+    case SKIN_STRING:
+    case SKIN_HAS_THEME:
+      return INFO_SOURCE_SKIN;
+    case WINDOW_NEXT:
+    case WINDOW_PREVIOUS:
+    case WINDOW_IS_VISIBLE:
+    case WINDOW_IS_TOPMOST:
+    case WINDOW_IS_ACTIVE:
+      return INFO_SOURCE_WINDOW;
+    case STRING_IS_EMPTY:
+    case STRING_STR:
+    case STRING_STR_LEFT:
+    case STRING_STR_RIGHT:
+    case INTEGER_GREATER_THAN:
+      return GetLabelSources(info.GetData1());
+    case STRING_COMPARE:
+      {
+        // a negative second parameter is the info label to compare against
+        int info2 = info.GetData2();
+        if (info2 < 0)
+          return GetLabelSources(info.GetData1()) | GetLabelSources(-info2);
+        return GetLabelSources(info.GetData1());
+      }
+  }
+  return INFO_SOURCE_VOLATILE;
+}
+
+unsigned int CGUIInfoManager::GetLabelSources(int info) const
+{
+  if (info >= LISTITEM_START && info < LISTITEM_END)
+    return INFO_SOURCE_LISTITEM | INFO_SOURCE_CONTAINER;
+  return INFO_SOURCE_VOLATILE;
+}
+
 // checks the condition and returns it as necessary.  Currently used
 // for toggle button controls and visibility of images.
 bool CGUIInfoManager::GetBool(int condition1, int contextWindow, const CGUIListItem *item)
@@ -4136,12 +4293,35 @@ CStdString CGUIInfoManager::GetAudioScrobblerLabel(int item)
   return "";
 }
 
+static bool SortByEvaluations(const InfoBool *left, const InfoBool *right)
+{
+  return left->GetEvaluations() > right->GetEvaluations();
+}
+
 void CGUIInfoManager::Clear()
 {
   CSingleLock lock(m_critInfo);
+  if (!m_bools.empty())
+  {
+    unsigned int conditions;
+    uint64_t requests, evaluations;
+    GetBoolStats(conditions, requests, evaluations);
+    CLog::Log(LOGDEBUG, "%s - %u conditions were asked for %"PRIu64" times and evaluated %"PRIu64" times",
+              __FUNCTION__, conditions, requests, evaluations);
+
+    vector<InfoBool*> bools(m_bools);
+    sort(bools.begin(), bools.end(), SortByEvaluations);
+    for (unsigned int i = 0; i < bools.size() && i < 10; ++i)
+      CLog::Log(LOGDEBUG, "%s - %u evaluations of %u requests: %s", __FUNCTION__,
+                bools[i]->GetEvaluations(), bools[i]->GetRequests(), bools[i]->GetExpression().c_str());
+  }
+
   for (unsigned int i = 0; i < m_bools.size(); ++i)
     delete m_bools[i];
   m_bools.clear();
+  m_boolIndex.clear();
+  // skin settings are translated to ids of the current skin
+  m_translated.clear();
 
   m_skinVariableStrings.clear();
 }
@@ -4180,26 +4360,32 @@ int CGUIInfoManager::AddListItemProp(const CStdString &str, int offset)
 int CGUIInfoManager::AddMultiInfo(const GUIInfo &info)
 {
   // check to see if we have this info already
-  for (unsigned int i = 0; i < m_multiInfo.size(); i++)
-    if (m_multiInfo[i] == info)
-      return (int)i + MULTI_INFO_START;
+  map<GUIInfo, int>::const_iterator i = m_multiInfoIndex.find(info);
+  if (i != m_multiInfoIndex.end())
+    return i->second;
   // return the new offset
   m_multiInfo.push_back(info);
   int id = (int)m_multiInfo.size() + MULTI_INFO_START - 1;
   if (id > MULTI_INFO_END)
     CLog::Log(LOGERROR, "%s - too many multiinfo bool/labels in this skin", __FUNCTION__);
+  m_multiInfoIndex[info] = id;
   return id;
 }
 
 int CGUIInfoManager::ConditionalStringParameter(const CStdString &parameter, bool caseSensitive /*= false*/)
 {
   // check to see if we have this parameter already
-  for (unsigned int i = 0; i < m_stringParameters.size(); i++)
-    if (parameter.Equals(m_stringParameters[i], caseSensitive))
-      return (int)i;
+  CStdString lower(parameter);
+  lower.ToLower();
+  map<CStdString, int>::const_iterator i = caseSensitive ? m_stringParameterCaseIndex.find(parameter) : m_stringParameterIndex.find(lower);
+  if (i != (caseSensitive ? m_stringParameterCaseIndex.end() : m_stringParameterIndex.end()))
+    return i->second;
   // return the new offset
   m_stringParameters.push_back(parameter);
-  return (int)m_stringParameters.size() - 1;
+  int id = (int)m_stringParameters.size() - 1;
+  m_stringParameterIndex.insert(make_pair(lower, id));
+  m_stringParameterCaseIndex.insert(make_pair(parameter, id));
+  return id;
 }
 
 bool CGUIInfoManager::GetItemInt(int &value, const CGUIListItem *item, int info) const
@@ -5060,6 +5246,45 @@ void CGUIInfoManager::ResetCache()
   // reset any animation triggers as well
   m_containerMoves.clear();
   m_updateTime++;
+  for (unsigned int i = 0; i < sizeof(m_sourceChanged) / sizeof(m_sourceChanged[0]); i++)
+    m_sourceChanged[i] = m_updateTime;
+}
+
+void CGUIInfoManager::UpdateCache()
+{
+  // reset any animation triggers as well
+  m_containerMoves.clear();
+
+  // we have no notifications for containers or most of the system state, so check those every frame
+  unsigned int sources = INFO_SOURCE_VOLATILE | INFO_SOURCE_CONTAINER | INFO_SOURCE_LISTITEM;
+
+  // the player conditions are all false when not playing, so need a last update once we stop
+  bool playing = g_application.IsPlaying();
+  if (playing || m_wasPlaying)
+    sources |= INFO_SOURCE_PLAYER;
+  m_wasPlaying = playing;
+
+  vector<int> windowState;
+  g_windowManager.GetActiveWindowState(windowState);
+  windowState.push_back(m_nextWindowID);
+  windowState.push_back(m_prevWindowID);
+  if (windowState != m_windowState)
+  {
+    m_windowState.swap(windowState);
+    sources |= INFO_SOURCE_WINDOW;
+  }
+
+  MarkSourcesChanged(sources);
+}
+
+void CGUIInfoManager::MarkSourcesChanged(unsigned int sources)
+{
+  m_updateTime++;
+  for (unsigned int i = 0; i < sizeof(m_sourceChanged) / sizeof(m_sourceChanged[0]); i++)
+  {
+    if (i & sources)
+      m_sourceChanged[i] = m_updateTime;
+  }
 }
 
 // Called from tuxbox service thread to update current status
@@ -33,6 +33,7 @@
 #include "XBDateTime.h"
 #include "utils/Observer.h"
 #include "interfaces/info/SkinVariable.h"
+#include "interfaces/info/InfoBool.h"
 
 #include <list>
 #include <map>
@@ -659,6 +660,14 @@ public:
   {
     return (m_info == right.m_info && m_data1 == right.m_data1 && m_data2 == right.m_data2);
   };
+  bool operator <(const GUIInfo &right) const
+  {
+    if (m_info != right.m_info)
+      return m_info < right.m_info;
+    if (m_data1 != right.m_data1)
+      return m_data1 < right.m_data1;
+    return m_data2 < right.m_data2;
+  };
   uint32_t GetInfoFlag() const;
   uint32_t GetData1() const;
   int GetData2() const;
@@ -782,7 +791,33 @@ public:
   void SetNextWindow(int windowID) { m_nextWindowID = windowID; };
   void SetPreviousWindow(int windowID) { m_prevWindowID = windowID; };
 
+  /*! \brief Invalidate all cached boolean conditions
+   Used when something the conditions depend on changes outside of the per-frame checks,
+   such as a window being opened or a skin setting changing.
+   \sa UpdateCache
+   */
   void ResetCache();
+
+  /*! \brief Invalidate the cached boolean conditions whose sources may have changed
+   Called once a frame.  Conditions depending on containers, listitems or anything we can't
+   track are always invalidated, the player ones only while playing, and the window ones only
+   if the active windows have changed.
+   \sa ResetCache
+   */
+  void UpdateCache();
+
+  /*! \brief Note that the given sources have changed, invalidating the conditions depending on them
+   \param sources INFO_SOURCE_* flags of the sources that changed
+   */
+  void MarkSourcesChanged(unsigned int sources);
+
+  /*! \brief Get statistics on the registered boolean conditions
+   \param conditions number of registered conditions and expressions
+   \param requests number of times their values were asked for
+   \param evaluations number of times their values were evaluated
+   */
+  void GetBoolStats(unsigned int &conditions, uint64_t &requests, uint64_t &evaluations);
+
   bool GetItemInt(int &value, const CGUIListItem *item, int info) const;
   CStdString GetItemLabel(const CFileItem *item, int info, CStdString *fallback = NULL);
   CStdString GetItemImage(const CFileItem *item, int info, CStdString *fallback = NULL);
@@ -816,8 +851,22 @@ public:
   bool ConditionsChangedValues(const std::map<int, bool>& map);
 protected:
   friend class INFO::InfoSingle;
+  friend class INFO::InfoExpression;
   bool GetBool(int condition, int contextWindow = 0, const CGUIListItem *item=NULL);
 
+  /*! \brief Get the INFO_SOURCE_* flags a condition depends on
+   \param condition the condition as returned by TranslateSingleString
+   \return the sources of the condition, 0 if it is constant
+   */
+  unsigned int GetConditionSources(int condition) const;
+  unsigned int GetMultiInfoSources(const GUIInfo &info) const;
+  unsigned int GetLabelSources(int info) const;
+
+  /*! \brief Get the INFO_SOURCE_* flags a registered boolean expression depends on
+   \sa Register
+   */
+  unsigned int GetBoolSources(unsigned int expression) const;
+
   // routines for window retrieval
   bool CheckWindowCondition(CGUIWindow *window, int condition) const;
   CGUIWindow *GetWindowWithCondition(int contextWindow, int condition) const;
@@ -857,6 +906,11 @@ protected:
    */
   void SplitInfoString(const CStdString &infoString, std::vector<Property> &info);
 
+  /*! \brief Translate a trimmed condition or label, bypassing the cache of translated strings
+   \sa TranslateSingleString
+   */
+  int TranslateSingleStringInternal(const CStdString &strCondition);
+
   // Conditional string parameters for testing are stored in a vector for later retrieval.
   // The offset into the string parameters array is returned.
   int ConditionalStringParameter(const CStdString &strParameter, bool caseSensitive = false);
@@ -874,9 +928,12 @@ protected:
 
   // Conditional string parameters are stored here
   CStdStringArray m_stringParameters;
+  std::map<CStdString, int> m_stringParameterIndex;      ///< first string parameter by lower case string
+  std::map<CStdString, int> m_stringParameterCaseIndex;  ///< first string parameter by string
 
   // Array of multiple information mapped to a single integer lookup
   std::vector<GUIInfo> m_multiInfo;
+  std::map<GUIInfo, int> m_multiInfoIndex;               ///< id of each multi info
   std::vector<std::string> m_listitemProperties;
 
   CStdString m_currentMovieDuration;
@@ -912,8 +969,13 @@ protected:
   int m_prevWindowID;
 
   std::vector<INFO::InfoBool*> m_bools;
+  std::map<std::pair<int, CStdString>, unsigned int> m_boolIndex; ///< registered bools by context and lower case expression
+  std::map<CStdString, int> m_translated;                          ///< translated conditions by trimmed string
   std::vector<INFO::CSkinVariableString> m_skinVariableStrings;
   unsigned int m_updateTime;
+  unsigned int m_sourceChanged[1 << INFO_SOURCE_COUNT]; ///< last update time any of the sources in each combination changed
+  std::vector<int> m_windowState;                        ///< active windows at the last update, to tell when they change
+  bool m_wasPlaying;                                     ///< whether we were playing at the last update
 
   int m_libraryHasMusic;
   int m_libraryHasMovies;
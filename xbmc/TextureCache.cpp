@@ -77,6 +77,22 @@ bool CTextureCache::HasCachedImage(const CStdString &url)
   return (!cachedImage.IsEmpty() && cachedImage != url);
 }
 
+bool CTextureCache::GetCachedImageTag(const CStdString &image, CStdString &cachedPath, CStdString &tag)
+{
+  CStdString url = UnwrapImageURL(image);
+  if (IsCachedImage(url))
+    return false;
+
+  CStdString cacheFile;
+  {
+    CSingleLock lock(m_databaseSection);
+    if (!m_database.GetCachedTextureTag(url, cacheFile, tag))
+      return false;
+  }
+  cachedPath = GetCachedPath(cacheFile);
+  return true;
+}
+
 CStdString CTextureCache::GetCachedImage(const CStdString &image, CTextureDetails &details, bool trackUsage)
 {
   CStdString url = UnwrapImageURL(image);
@@ -109,6 +109,17 @@ public:
    */
   bool HasCachedImage(const CStdString &image);
 
+  /*! \brief Retrieve the cached version of an image along with a tag identifying its contents
+   The tag is built from the texture id and image hash in the texture database, so it changes
+   whenever the image is recached. It can be used to validate a cached image without reading it.
+   \param image url of the image
+   \param cachedPath [out] path of the cached image
+   \param tag [out] tag of the cached image
+   \return true if the image is cached, false otherwise
+   \sa HasCachedImage
+   */
+  bool GetCachedImageTag(const CStdString &image, CStdString &cachedPath, CStdString &tag);
+
   /*! \brief clear the cached version of the given image
    \param image url of the image
    \sa GetCachedImage
@@ -184,6 +184,31 @@ bool CTextureDatabase::SetCachedTextureValid(const CStdString &url, bool updatea
   return ExecuteQuery(sql);
 }
 
+bool CTextureDatabase::GetCachedTextureTag(const CStdString &url, CStdString &cacheFile, CStdString &tag)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    CStdString sql = PrepareSQL("SELECT id, cachedurl, imagehash FROM texture WHERE url='%s'", url.c_str());
+    m_pDS->query(sql.c_str());
+    if (!m_pDS->eof())
+    { // a recached texture gets a new id, the hash changes with the original image
+      cacheFile = m_pDS->fv(1).get_asString();
+      tag.Format("%d-%s", m_pDS->fv(0).get_asInt(), m_pDS->fv(2).get_asString().c_str());
+      m_pDS->close();
+      return true;
+    }
+    m_pDS->close();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s, failed on url '%s'", __FUNCTION__, url.c_str());
+  }
+  return false;
+}
+
 bool CTextureDatabase::AddCachedTexture(const CStdString &url, const CTextureDetails &details)
 {
   try
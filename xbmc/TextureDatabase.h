@@ -31,6 +31,7 @@ public:
   virtual bool Open();
 
   bool GetCachedTexture(const CStdString &originalURL, CTextureDetails &details);
+  bool GetCachedTextureTag(const CStdString &originalURL, CStdString &cacheFile, CStdString &tag);
   bool AddCachedTexture(const CStdString &originalURL, const CTextureDetails &details);
   bool SetCachedTextureValid(const CStdString &originalURL, bool updateable);
   bool ClearCachedTexture(const CStdString &originalURL, CStdString &cacheFile);
@@ -0,0 +1,54 @@
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEResampleFactory.h"
+#include "Utils/AEResamplePolyphase.h"
+#include "Utils/AEResampleSRC.h"
+
+#include "settings/AdvancedSettings.h"
+#include "utils/log.h"
+
+IAEResample *CAEResampleFactory::Create(unsigned int channels, unsigned int inRate, unsigned int outRate, bool variableRatio)
+{
+  AEResampleQuality quality = (AEResampleQuality)g_advancedSettings.m_audioResampleQuality;
+
+  /* the polyphase filter is cheaper, but only does the ratio it was set up for */
+  IAEResample *resampler;
+  if (!variableRatio)
+  {
+    resampler = new CAEResamplePolyphase();
+    if (resampler->Initialize(channels, inRate, outRate, quality))
+    {
+      CLog::Log(LOGDEBUG, "CAEResampleFactory::Create - Using %s for %u to %u", resampler->GetName(), inRate, outRate);
+      return resampler;
+    }
+    delete resampler;
+  }
+
+  resampler = new CAEResampleSRC();
+  if (resampler->Initialize(channels, inRate, outRate, quality))
+  {
+    CLog::Log(LOGDEBUG, "CAEResampleFactory::Create - Using %s for %u to %u", resampler->GetName(), inRate, outRate);
+    return resampler;
+  }
+  delete resampler;
+
+  return NULL;
+}
@@ -0,0 +1,36 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+class IAEResample;
+
+class CAEResampleFactory
+{
+public:
+  /**
+   * Creates the cheapest resampler for the conversion at the configured quality
+   * @param channels the number of channels per frame
+   * @param inRate the sample rate of the input
+   * @param outRate the sample rate of the output
+   * @param variableRatio true if the ratio will be changed after it was created
+   * @return the resampler, or NULL on failure
+   */
+  static IAEResample *Create(unsigned int channels, unsigned int inRate, unsigned int outRate, bool variableRatio);
+};
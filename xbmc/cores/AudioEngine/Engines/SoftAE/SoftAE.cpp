@@ -54,6 +54,9 @@ using namespace std;
 #define SOFTAE_IDLE_WAIT_MSEC 100 // catchall for undefined platforms
 #endif
 
+/* the most frames the stream stage mixes in one go */
+#define SOFTAE_MIX_FRAMES 256
+
 CSoftAE::CSoftAE():
   m_thread             (NULL        ),
   m_audiophile         (true        ),
@@ -1065,13 +1068,18 @@ void CSoftAE::Run()
     /* if we have enough room in the buffer */
     if (m_buffer.Free() >= m_frameSize)
     {
+      /* mix as many frames as fit, raw frames are passed on one at a time */
+      unsigned int frames = 1;
+      if (!m_rawPassthrough)
+        frames = std::min((unsigned int)(m_buffer.Free() / m_frameSize), (unsigned int)SOFTAE_MIX_FRAMES);
+
       /* take some data for our use from the buffer */
-      uint8_t *out = (uint8_t*)m_buffer.Take(m_frameSize);
-      memset(out, 0, m_frameSize);
+      uint8_t *out = (uint8_t*)m_buffer.Take(frames * m_frameSize);
+      memset(out, 0, frames * m_frameSize);
 
       /* run the stream stage */
       CSoftAEStream *oldMaster = m_masterStream;
-      if ((this->*m_streamStageFn)(m_chLayout.Count(), out, restart) > 0)
+      if ((this->*m_streamStageFn)(m_chLayout.Count(), frames, out, restart) > 0)
         hasAudio = true; /* have some audio */
 
       /* if in audiophile mode and the master stream has changed, flag for restart */
@@ -1364,8 +1372,9 @@ void CSoftAE::PrintSinks()
   }
 }
 
-unsigned int CSoftAE::RunRawStreamStage(unsigned int channelCount, void *out, bool &restart)
+unsigned int CSoftAE::RunRawStreamStage(unsigned int channelCount, unsigned int frames, void *out, bool &restart)
 {
+  /* raw frames can not be mixed, Run only ever asks for one */
   StreamList resumeStreams;
   static StreamList::iterator itt;
   CSingleLock streamLock(m_streamLock);
@@ -1407,7 +1416,7 @@ unsigned int CSoftAE::RunRawStreamStage(unsigned int channelCount, void *out, bo
   return mixed;
 }
 
-unsigned int CSoftAE::RunStreamStage(unsigned int channelCount, void *out, bool &restart)
+unsigned int CSoftAE::RunStreamStage(unsigned int channelCount, unsigned int frames, void *out, bool &restart)
 {
   // no point doing anything if we have no streams,
   // we do not have to take a lock just to check empty
@@ -1415,6 +1424,7 @@ unsigned int CSoftAE::RunStreamStage(unsigned int channelCount, void *out, bool
     return 0;
 
   float *dst = (float*)out;
+  float gains[SOFTAE_MIX_FRAMES];
   unsigned int mixed = 0;
 
   /* identify the master stream */
@@ -1426,25 +1436,28 @@ unsigned int CSoftAE::RunStreamStage(unsigned int channelCount, void *out, bool
   {
     CSoftAEStream *stream = *itt;
 
-    float *frame = (float*)stream->GetFrame();
-    if (!frame && stream->IsDrained() && stream->m_slave && stream->m_slave->IsPaused())
-      resumeStreams.push_back(stream);
-
-    if (!frame)
-      continue;
-
-    float volume = stream->GetVolume() * stream->GetReplayGain() * stream->RunLimiter(frame, channelCount);
-    #ifdef __SSE__
-    if (channelCount > 1)
-      CAEUtil::SSEMulAddArray(dst, frame, volume, channelCount);
-    else
-    #endif
+    /* a block can span packets, so the frames may come in several runs */
+    unsigned int done = 0;
+    while (done < frames)
     {
-      for (unsigned int i = 0; i < channelCount; ++i)
-        *dst++ += *frame++ * volume;
+      uint8_t *data;
+      unsigned int count = stream->GetFrames(data, frames - done, gains);
+      if (count == 0)
+      {
+        if (stream->IsDrained() && stream->m_slave && stream->m_slave->IsPaused())
+          resumeStreams.push_back(stream);
+        break;
+      }
+
+      /* the gains hold the volume of each frame, the limiter and replay gain are applied on top */
+      float *frame = (float*)data;
+      stream->RunLimiter(frame, channelCount, count, gains);
+      CAEUtil::MulAddFrames(dst + done * channelCount, frame, gains, stream->GetReplayGain(), channelCount, count);
+      done += count;
     }
 
-    ++mixed;
+    if (done > 0)
+      ++mixed;
   }
 
   ResumeSlaveStreams(resumeStreams);
@@ -237,9 +237,13 @@ private:
   int          RunRawOutputStage(bool hasAudio);
   int          RunTranscodeStage(bool hasAudio);
 
-  unsigned int (CSoftAE::*m_streamStageFn)(unsigned int channelCount, void *out, bool &restart);
-  unsigned int RunRawStreamStage (unsigned int channelCount, void *out, bool &restart);
-  unsigned int RunStreamStage    (unsigned int channelCount, void *out, bool &restart);
+  /*! \brief Run the stream stage on a block of frames.
+   Mixes the playing streams into out, which has room for frames frames.
+   \return the number of streams that were mixed in.
+   */
+  unsigned int (CSoftAE::*m_streamStageFn)(unsigned int channelCount, unsigned int frames, void *out, bool &restart);
+  unsigned int RunRawStreamStage (unsigned int channelCount, unsigned int frames, void *out, bool &restart);
+  unsigned int RunStreamStage    (unsigned int channelCount, unsigned int frames, void *out, bool &restart);
 
   void         ResumeSlaveStreams(const StreamList &streams);
   void         RunNormalizeStage (unsigned int channelCount, void *out, unsigned int mixed);
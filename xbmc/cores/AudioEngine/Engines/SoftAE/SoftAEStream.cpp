@@ -24,6 +24,7 @@
 #include "utils/MathUtils.h"
 
 #include "AEFactory.h"
+#include "AEResampleFactory.h"
 #include "Utils/AEUtil.h"
 
 #include "SoftAE.h"
@@ -44,7 +45,9 @@ CSoftAEStream::CSoftAEStream(enum AEDataFormat dataFormat, unsigned int sampleRa
   m_rgain           (1.0f ),
   m_refillBuffer    (0    ),
   m_convertFn       (NULL ),
-  m_ssrc            (NULL ),
+  m_resampler       (NULL ),
+  m_resampleBuffer  (NULL ),
+  m_resampleFrames  (0    ),
   m_framesBuffered  (0    ),
   m_newPacket       (NULL ),
   m_packet          (NULL ),
@@ -55,8 +58,6 @@ CSoftAEStream::CSoftAEStream(enum AEDataFormat dataFormat, unsigned int sampleRa
   m_fadeRunning     (false),
   m_slave           (NULL )
 {
-  m_ssrcData.data_out = NULL;
-
   m_initDataFormat        = dataFormat;
   m_initSampleRate        = sampleRate;
   m_initEncodedSampleRate = encodedSampleRate;
@@ -107,8 +108,10 @@ void CSoftAEStream::Initialize()
 
     if (m_resample)
     {
-      _aligned_free(m_ssrcData.data_out);
-      m_ssrcData.data_out = NULL;
+      _aligned_free(m_resampleBuffer);
+      m_resampleBuffer = NULL;
+      delete m_resampler;
+      m_resampler = NULL;
     }
   }
 
@@ -188,14 +191,17 @@ void CSoftAEStream::Initialize()
   /* if we need to resample, set it up */
   if (m_resample)
   {
-    int err;
-    m_ssrc                   = src_new(SRC_SINC_MEDIUM_QUALITY, m_initChannelLayout.Count(), &err);
-    m_ssrcData.data_in       = m_convertBuffer;
-    m_internalRatio          = (double)AE.GetSampleRate() / (double)m_initSampleRate;
-    m_ssrcData.src_ratio     = m_internalRatio;
-    m_ssrcData.data_out      = (float*)_aligned_malloc(m_format.m_frameSamples * (int)std::ceil(m_ssrcData.src_ratio) * sizeof(float), 16);
-    m_ssrcData.output_frames = m_format.m_frames * (long)std::ceil(m_ssrcData.src_ratio);
-    m_ssrcData.end_of_input  = 0;
+    /* streams that are resampled to follow a clock need a resampler that can change its ratio */
+    m_resampler = CAEResampleFactory::Create(m_initChannelLayout.Count(), m_initSampleRate, AE.GetSampleRate(), m_forceResample);
+    if (!m_resampler)
+    {
+      m_valid = false;
+      return;
+    }
+
+    m_internalRatio  = (double)AE.GetSampleRate() / (double)m_initSampleRate;
+    m_resampleFrames = m_format.m_frames * (unsigned int)std::ceil(m_internalRatio);
+    m_resampleBuffer = (float*)_aligned_malloc(m_resampleFrames * m_initChannelLayout.Count() * sizeof(float), 16);
     // we must buffer the same amount as before but taking the source sample rate into account
     // there is no reason to decrease the buffer for upsampling
     if (m_internalRatio < 1)
@@ -228,9 +234,9 @@ CSoftAEStream::~CSoftAEStream()
 
   if (m_resample)
   {
-    _aligned_free(m_ssrcData.data_out);
-    src_delete(m_ssrc);
-    m_ssrc = NULL;
+    _aligned_free(m_resampleBuffer);
+    delete m_resampler;
+    m_resampler = NULL;
   }
 
   delete m_newPacket;
@@ -329,12 +335,11 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
   /* resample it if we need to */
   if (m_resample)
   {
-    m_ssrcData.input_frames = samples / m_chLayoutCount;
-    if (src_process(m_ssrc, &m_ssrcData) != 0)
+    unsigned int used;
+    if (!m_resampler->Process(m_convertBuffer, samples / m_chLayoutCount, m_resampleBuffer, m_resampleFrames, used, frames))
       return 0;
-    data     = (uint8_t*)m_ssrcData.data_out;
-    frames   = m_ssrcData.output_frames_gen;
-    consumed = m_ssrcData.input_frames_used * m_bytesPerFrame;
+    data     = (uint8_t*)m_resampleBuffer;
+    consumed = used * m_bytesPerFrame;
     if (!frames)
       return consumed;
 
@@ -414,74 +419,98 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
 }
 
 uint8_t* CSoftAEStream::GetFrame()
+{
+  uint8_t *frame;
+  float volume;
+  if (GetFrames(frame, 1, &volume) == 0)
+    return NULL;
+
+  return frame;
+}
+
+unsigned int CSoftAEStream::GetFrames(uint8_t *&data, unsigned int frames, float *volumes)
 {
   CExclusiveLock lock(m_lock);
 
-  /* if we are fading, this runs even if we have underrun as it is time based */
-  if (m_fadeRunning)
+  data = NULL;
+  unsigned int count = 0;
+
+  /* if we have been deleted or are refilling but not draining there is nothing to take */
+  if (m_valid && !m_delete && (!m_refillBuffer || m_draining))
   {
-    m_volume += m_fadeStep;
-    m_volume = std::min(1.0f, std::max(0.0f, m_volume));
-    if (m_fadeDirUp)
+    /* if the packet is empty, advance to the next one */
+    if (!m_packet || m_packet->data.CursorEnd())
     {
-      if (m_volume >= m_fadeTarget)
-        m_fadeRunning = false;
+      delete m_packet;
+      m_packet = NULL;
+
+      /* no more packets */
+      if (m_outBuffer.empty())
+      {
+        if (!m_draining)
+        {
+          /* underrun, we need to refill our buffers */
+          CLog::Log(LOGDEBUG, "CSoftAEStream::GetFrames - Underrun");
+          ASSERT(m_waterLevel > m_framesBuffered);
+          m_refillBuffer = m_waterLevel - m_framesBuffered;
+        }
+      }
+      else
+      {
+        /* get the next packet */
+        m_packet = m_outBuffer.front();
+        m_outBuffer.pop_front();
+      }
     }
-    else
+
+    if (m_packet)
     {
-      if (m_volume <= m_fadeTarget)
-        m_fadeRunning = false;
+      /* the frames left in this packet */
+      count = std::min(frames, (unsigned int)((m_packet->data.Used() - m_packet->data.CursorOffset()) / m_aeBytesPerFrame));
+      data  = (uint8_t*)m_packet->data.CursorRead(count * m_aeBytesPerFrame);
+
+      /* if we have a viz we need to hand the data to it */
+      for (unsigned int i = 0; i < count && m_audioCallback && !m_packet->vizData.CursorEnd(); ++i)
+      {
+        float *vizData = (float*)m_packet->vizData.CursorRead(2 * sizeof(float));
+        memcpy(m_vizBuffer + m_vizBufferSamples, vizData, 2 * sizeof(float));
+        m_vizBufferSamples += 2;
+        if (m_vizBufferSamples == 512)
+        {
+          m_audioCallback->OnAudioData(m_vizBuffer, 512);
+          m_vizBufferSamples = 0;
+        }
+      }
+
+      m_framesBuffered -= count;
     }
   }
 
-  /* if we have been deleted or are refilling but not draining */
-  if (!m_valid || m_delete || (m_refillBuffer && !m_draining))
-    return NULL;
-
-  /* if the packet is empty, advance to the next one */
-  if (!m_packet || m_packet->data.CursorEnd())
+  /* if we are fading, this runs even if we have underrun as it is time based */
+  unsigned int steps = count ? count : frames;
+  for (unsigned int i = 0; i < steps; ++i)
   {
-    delete m_packet;
-    m_packet = NULL;
-
-    /* no more packets, return null */
-    if (m_outBuffer.empty())
+    if (m_fadeRunning)
     {
-      if (m_draining)
-        return NULL;
+      m_volume += m_fadeStep;
+      m_volume = std::min(1.0f, std::max(0.0f, m_volume));
+      if (m_fadeDirUp)
+      {
+        if (m_volume >= m_fadeTarget)
+          m_fadeRunning = false;
+      }
       else
       {
-        /* underrun, we need to refill our buffers */
-        CLog::Log(LOGDEBUG, "CSoftAEStream::GetFrame - Underrun");
-        ASSERT(m_waterLevel > m_framesBuffered);
-        m_refillBuffer = m_waterLevel - m_framesBuffered;
-        return NULL;
+        if (m_volume <= m_fadeTarget)
+          m_fadeRunning = false;
       }
     }
 
-    /* get the next packet */
-    m_packet = m_outBuffer.front();
-    m_outBuffer.pop_front();
+    if (count)
+      volumes[i] = m_volume;
   }
 
-  /* fetch one frame of data */
-  uint8_t *ret = (uint8_t*)m_packet->data.CursorRead(m_aeBytesPerFrame);
-
-  /* we have a frame, if we have a viz we need to hand the data to it */
-  if (m_audioCallback && !m_packet->vizData.CursorEnd())
-  {
-    float *vizData = (float*)m_packet->vizData.CursorRead(2 * sizeof(float));
-    memcpy(m_vizBuffer + m_vizBufferSamples, vizData, 2 * sizeof(float));
-    m_vizBufferSamples += 2;
-    if (m_vizBufferSamples == 512)
-    {
-      m_audioCallback->OnAudioData(m_vizBuffer, 512);
-      m_vizBufferSamples = 0;
-    }
-  }
-
-  --m_framesBuffered;
-  return ret;
+  return count;
 }
 
 double CSoftAEStream::GetDelay()
@@ -561,8 +590,7 @@ void CSoftAEStream::InternalFlush()
   /* reset the resampler */
   if (m_resample)
   {
-    m_ssrcData.end_of_input = 0;
-    src_reset(m_ssrc);
+    m_resampler->Reset();
   }
 
   /* invalidate any incoming samples */
@@ -595,7 +623,7 @@ double CSoftAEStream::GetResampleRatio()
     return 1.0f;
 
   CSharedLock lock(m_lock);
-  return m_ssrcData.src_ratio;
+  return m_resampler->GetRatio();
 }
 
 bool CSoftAEStream::SetResampleRatio(double ratio)
@@ -603,21 +631,30 @@ bool CSoftAEStream::SetResampleRatio(double ratio)
   if (!m_resample)
     return false;
 
-  CSharedLock lock(m_lock);
+  CExclusiveLock lock(m_lock);
 
-  int oldRatioInt = (int)std::ceil(m_ssrcData.src_ratio);
+  int oldRatioInt = (int)std::ceil(m_resampler->GetRatio());
 
   m_resampleRatio = ratio;
 
-  src_set_ratio(m_ssrc, m_resampleRatio * m_internalRatio);
-  m_ssrcData.src_ratio = m_resampleRatio * m_internalRatio;
+  /* a fixed ratio resampler has to make way for one that can change it */
+  if (!m_resampler->SetRatio(m_resampleRatio * m_internalRatio))
+  {
+    IAEResample *resampler = CAEResampleFactory::Create(m_initChannelLayout.Count(), m_initSampleRate, AE.GetSampleRate(), true);
+    if (!resampler)
+      return false;
+
+    delete m_resampler;
+    m_resampler = resampler;
+    m_resampler->SetRatio(m_resampleRatio * m_internalRatio);
+  }
 
   //Check the resample buffer size and resize if necessary.
-  if (oldRatioInt < std::ceil(m_ssrcData.src_ratio))
+  if (oldRatioInt < std::ceil(m_resampler->GetRatio()))
   {
-    _aligned_free(m_ssrcData.data_out);
-    m_ssrcData.data_out      = (float*)_aligned_malloc(m_format.m_frameSamples * (int)std::ceil(m_ssrcData.src_ratio) * sizeof(float), 16);
-    m_ssrcData.output_frames = m_format.m_frames * (long)std::ceil(m_ssrcData.src_ratio);
+    _aligned_free(m_resampleBuffer);
+    m_resampleFrames = m_format.m_frames * (unsigned int)std::ceil(m_resampler->GetRatio());
+    m_resampleBuffer = (float*)_aligned_malloc(m_resampleFrames * m_initChannelLayout.Count() * sizeof(float), 16);
   }
   return true;
 }
@@ -19,13 +19,13 @@
  *
  */
 
-#include <samplerate.h>
 #include <list>
 
 #include "threads/SharedSection.h"
 
 #include "AEAudioFormat.h"
 #include "Interfaces/AEStream.h"
+#include "Interfaces/AEResample.h"
 #include "Utils/AEConvert.h"
 #include "Utils/AERemap.h"
 #include "Utils/AEBuffer.h"
@@ -44,6 +44,16 @@ protected:
   void Destroy();
   uint8_t* GetFrame();
 
+  /*! \brief take up to frames frames that follow each other in memory
+   Runs the fade for every frame taken, or for all of them on an underrun.
+   \param data receives the first frame
+   \param frames the most frames to take
+   \param volumes receives the volume of each frame taken
+   \return the number of frames taken
+   */
+  unsigned int GetFrames(uint8_t *&data, unsigned int frames, float *volumes);
+  void RunLimiter(const float* frames, int channels, unsigned int count, float* gains) { m_limiter.Run(frames, channels, count, gains); }
+
   bool IsPaused   () { return m_paused; }
   bool IsDestroyed() { return m_delete; }
   bool IsValid    () { return m_valid;  }
@@ -128,8 +138,9 @@ private:
   unsigned int        m_samplesPerFrame;
   CAEChannelInfo      m_aeChannelLayout;
   unsigned int        m_aeBytesPerFrame;
-  SRC_STATE          *m_ssrc;
-  SRC_DATA            m_ssrcData;
+  IAEResample        *m_resampler;
+  float              *m_resampleBuffer;
+  unsigned int        m_resampleFrames; /* frames m_resampleBuffer has room for */
   unsigned int        m_framesBuffered;
   std::list<PPacket*> m_outBuffer;
   unsigned int        ProcessFrameBuffer();
@@ -0,0 +1,90 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+enum AEResampleQuality
+{
+  AE_RESAMPLE_LOW = 0,
+  AE_RESAMPLE_MEDIUM,
+  AE_RESAMPLE_HIGH
+};
+
+/**
+ * IAEResample interface for sample rate conversion of interleaved float frames
+ */
+class IAEResample
+{
+public:
+  /**
+   * Constructor
+   */
+  IAEResample() {};
+
+  /**
+   * Destructor
+   */
+  virtual ~IAEResample() {};
+
+  /**
+   * Returns the name of the resampler
+   * @return the name
+   */
+  virtual const char *GetName() = 0;
+
+  /**
+   * Called to setup the resampler
+   * @param channels the number of channels per frame
+   * @param inRate the sample rate of the input
+   * @param outRate the sample rate of the output
+   * @param quality trades CPU time for quality
+   * @return true on success, false if the resampler can not convert between these rates
+   */
+  virtual bool Initialize(unsigned int channels, unsigned int inRate, unsigned int outRate, AEResampleQuality quality) = 0;
+
+  /**
+   * Reset the resampler for new data
+   */
+  virtual void Reset() = 0;
+
+  /**
+   * Returns the current ratio of output to input frames
+   * @return the ratio
+   */
+  virtual double GetRatio() = 0;
+
+  /**
+   * Changes the ratio of output to input frames
+   * @param ratio the new ratio
+   * @return false if the resampler only supports the ratio it was initialized with
+   */
+  virtual bool SetRatio(double ratio) = 0;
+
+  /**
+   * Resamples the supplied frames
+   * @param in the input frames
+   * @param inFrames the number of input frames
+   * @param out the buffer for the output frames
+   * @param outFrames the number of frames out has room for
+   * @param inUsed returns the number of input frames consumed
+   * @param outGenerated returns the number of frames written to out
+   * @return true on success, false on failure
+   */
+  virtual bool Process(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed, unsigned int &outGenerated) = 0;
+};
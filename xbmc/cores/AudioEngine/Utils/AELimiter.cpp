@@ -20,11 +20,14 @@
 
 #include "system.h"
 #include "AELimiter.h"
+#include "AEUtil.h"
 #include "settings/AdvancedSettings.h"
 #include "utils/MathUtils.h"
 #include <algorithm>
 #include <math.h>
 
+#define LIMITER_BLOCK 256 /* frames whose peaks are found in one go */
+
 CAELimiter::CAELimiter()
 {
   m_amplify = 1.0f;
@@ -41,6 +44,27 @@ float CAELimiter::Run(float* frame, int channels)
   while (frame != end)
     highest = std::max(highest, fabsf(*(frame++)));
 
+  return Step(highest);
+}
+
+void CAELimiter::Run(const float* frames, int channels, unsigned int count, float* gains)
+{
+  float peaks[LIMITER_BLOCK];
+  while (count > 0)
+  {
+    unsigned int block = std::min(count, (unsigned int)LIMITER_BLOCK);
+    CAEUtil::FramePeaks(frames, channels, block, peaks);
+    for (unsigned int i = 0; i < block; ++i)
+      gains[i] *= Step(peaks[i]);
+
+    frames += block * channels;
+    gains  += block;
+    count  -= block;
+  }
+}
+
+float CAELimiter::Step(float highest)
+{
   float sample = highest * m_amplify;
   if (sample * m_attenuation > 1.0f)
   {
@@ -49,4 +49,15 @@ class CAELimiter
     }
 
     float Run(float* frame, int channels);
+
+    /*! \brief run the limiter over a block of frames
+     \param frames the interleaved frames
+     \param channels the number of channels per frame
+     \param count the number of frames
+     \param gains the gain of each frame, multiplied by what the limiter returns for it
+     */
+    void Run(const float* frames, int channels, unsigned int count, float* gains);
+
+  private:
+    float Step(float highest);
 };
@@ -0,0 +1,213 @@
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEResamplePolyphase.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#define POLYPHASE_MAX_PHASES 640 /* enough for 11.025kHz to 48kHz, and 44.1kHz to 192kHz */
+#define POLYPHASE_MAX_TAPS   256
+#define POLYPHASE_PI         3.14159265358979323846
+
+static unsigned int GCD(unsigned int a, unsigned int b)
+{
+  while (b)
+  {
+    unsigned int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/* zeroth order modified bessel function of the first kind, for the kaiser window */
+static double BesselI0(double x)
+{
+  double sum  = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 50; ++k)
+  {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum  += term;
+    if (term < sum * 1e-12)
+      break;
+  }
+  return sum;
+}
+
+CAEResamplePolyphase::CAEResamplePolyphase() :
+  m_channels(0),
+  m_up      (1),
+  m_down    (1),
+  m_taps    (0),
+  m_pos     (0)
+{
+}
+
+CAEResamplePolyphase::~CAEResamplePolyphase()
+{
+}
+
+bool CAEResamplePolyphase::Initialize(unsigned int channels, unsigned int inRate, unsigned int outRate, AEResampleQuality quality)
+{
+  if (channels == 0 || inRate == 0 || outRate == 0)
+    return false;
+
+  unsigned int divisor = GCD(inRate, outRate);
+  unsigned int up      = outRate / divisor;
+  unsigned int down    = inRate  / divisor;
+  if (up > POLYPHASE_MAX_PHASES)
+    return false;
+
+  /* taps per phase, the stopband attenuation of the window and where the passband ends */
+  unsigned int taps;
+  double beta, rolloff;
+  switch (quality)
+  {
+    case AE_RESAMPLE_LOW : taps = 16; beta =  6.0; rolloff = 0.85; break;
+    case AE_RESAMPLE_HIGH: taps = 64; beta = 10.0; rolloff = 0.94; break;
+    default              : taps = 32; beta =  8.6; rolloff = 0.90; break;
+  }
+
+  /* when decimating, the cutoff drops with the output rate, so the filter needs to be longer */
+  if (down > up)
+    taps = (taps * down + up - 1) / up;
+  if (taps > POLYPHASE_MAX_TAPS)
+    return false;
+
+  m_channels = channels;
+  m_up       = up;
+  m_down     = down;
+  m_taps     = taps;
+
+  /*
+    design the prototype lowpass at the rate of the input times m_up, the
+    cutoff is the lower nyquist frequency of the two rates
+  */
+  unsigned int length = m_taps * m_up;
+  double cutoff = rolloff * 0.5 / std::max(m_up, m_down);
+  double center = (length - 1) / 2.0;
+  double norm   = BesselI0(beta);
+
+  std::vector<double> filter(length);
+  for (unsigned int n = 0; n < length; ++n)
+  {
+    double x = n - center;
+    double sinc = x == 0.0 ? 2.0 * cutoff : sin(2.0 * POLYPHASE_PI * cutoff * x) / (POLYPHASE_PI * x);
+    double r = x / (center + 1.0);
+    filter[n] = sinc * BesselI0(beta * sqrt(1.0 - r * r)) / norm;
+  }
+
+  /*
+    split it into phases, each one ordered from the oldest input frame to the
+    newest, and scale each to unity gain so that no phase is louder than another
+  */
+  m_coefs.resize(length);
+  for (unsigned int phase = 0; phase < m_up; ++phase)
+  {
+    double sum = 0.0;
+    for (unsigned int k = 0; k < m_taps; ++k)
+      sum += filter[phase + k * m_up];
+
+    float *coefs = &m_coefs[phase * m_taps];
+    for (unsigned int k = 0; k < m_taps; ++k)
+      coefs[m_taps - 1 - k] = (float)(filter[phase + k * m_up] / sum);
+  }
+
+  Reset();
+  return true;
+}
+
+void CAEResamplePolyphase::Reset()
+{
+  /* start with silence in the filter */
+  m_history.assign((m_taps - 1) * m_channels, 0.0f);
+  m_pos = (uint64_t)(m_taps - 1) * m_up;
+}
+
+bool CAEResamplePolyphase::SetRatio(double ratio)
+{
+  return fabs(ratio - GetRatio()) < 1e-9;
+}
+
+bool CAEResamplePolyphase::Process(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed, unsigned int &outGenerated)
+{
+  inUsed       = 0;
+  outGenerated = 0;
+
+  while (true)
+  {
+    /* filter every output frame whose input frames are all buffered */
+    unsigned int frames = m_history.size() / m_channels;
+    while (outGenerated < outFrames && m_pos / m_up < frames)
+    {
+      unsigned int newest = (unsigned int)(m_pos / m_up);
+      const float *coefs  = &m_coefs[(m_pos % m_up) * m_taps];
+      const float *src    = &m_history[(newest + 1 - m_taps) * m_channels];
+
+      if (m_channels == 2)
+      {
+        float left = 0.0f, right = 0.0f;
+        for (unsigned int k = 0; k < m_taps; ++k, src += 2)
+        {
+          left  += src[0] * coefs[k];
+          right += src[1] * coefs[k];
+        }
+        out[0] = left;
+        out[1] = right;
+      }
+      else
+      {
+        memset(out, 0, m_channels * sizeof(float));
+        for (unsigned int k = 0; k < m_taps; ++k, src += m_channels)
+        {
+          const float coef = coefs[k];
+          for (unsigned int c = 0; c < m_channels; ++c)
+            out[c] += src[c] * coef;
+        }
+      }
+
+      out   += m_channels;
+      m_pos += m_down;
+      ++outGenerated;
+    }
+
+    if (outGenerated == outFrames || inUsed == inFrames)
+      break;
+
+    /* drop the frames the filter has moved past */
+    unsigned int first = (unsigned int)(m_pos / m_up) + 1 - m_taps;
+    m_history.erase(m_history.begin(), m_history.begin() + first * m_channels);
+    m_pos -= (uint64_t)first * m_up;
+
+    /* and buffer only as much input as the space left in out calls for */
+    uint64_t last   = (m_pos + (uint64_t)(outFrames - outGenerated - 1) * m_down) / m_up;
+    unsigned int count = (unsigned int)std::min<uint64_t>(inFrames - inUsed, last + 1 - m_history.size() / m_channels);
+
+    const float *src = in + inUsed * m_channels;
+    m_history.insert(m_history.end(), src, src + count * m_channels);
+    inUsed += count;
+  }
+
+  return true;
+}
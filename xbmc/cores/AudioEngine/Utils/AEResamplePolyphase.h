@@ -0,0 +1,53 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Interfaces/AEResample.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Resamples between rates whose ratio reduces to a small fraction, such as
+ * 44.1kHz to 48kHz or 48kHz to 96kHz, with a polyphase windowed sinc filter.
+ * The coefficients of every phase are computed up front, so the ratio can not
+ * change once it has been initialized.
+ */
+class CAEResamplePolyphase : public IAEResample
+{
+public:
+  CAEResamplePolyphase();
+  virtual ~CAEResamplePolyphase();
+
+  virtual const char *GetName() { return "polyphase"; }
+  virtual bool Initialize(unsigned int channels, unsigned int inRate, unsigned int outRate, AEResampleQuality quality);
+  virtual void Reset();
+  virtual double GetRatio() { return (double)m_up / (double)m_down; }
+  virtual bool SetRatio(double ratio);
+  virtual bool Process(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed, unsigned int &outGenerated);
+
+private:
+  unsigned int       m_channels;
+  unsigned int       m_up;      /* the output rate divided by the common divisor of both rates */
+  unsigned int       m_down;    /* the input rate divided by the common divisor of both rates */
+  unsigned int       m_taps;    /* coefficients per phase */
+  std::vector<float> m_coefs;   /* the coefficients of each phase, oldest input frame first */
+  std::vector<float> m_history; /* the buffered input frames the filter still needs */
+  uint64_t           m_pos;     /* the newest input frame of the next output frame times m_up, plus its phase */
+};
@@ -0,0 +1,93 @@
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEResampleSRC.h"
+#include "utils/log.h"
+
+#include <string.h>
+
+CAEResampleSRC::CAEResampleSRC() :
+  m_state(NULL)
+{
+  memset(&m_data, 0, sizeof(m_data));
+  m_data.src_ratio = 1.0;
+}
+
+CAEResampleSRC::~CAEResampleSRC()
+{
+  if (m_state)
+    src_delete(m_state);
+}
+
+bool CAEResampleSRC::Initialize(unsigned int channels, unsigned int inRate, unsigned int outRate, AEResampleQuality quality)
+{
+  if (m_state)
+    src_delete(m_state);
+
+  int converter;
+  switch (quality)
+  {
+    case AE_RESAMPLE_LOW : converter = SRC_SINC_FASTEST       ; break;
+    case AE_RESAMPLE_HIGH: converter = SRC_SINC_BEST_QUALITY  ; break;
+    default              : converter = SRC_SINC_MEDIUM_QUALITY; break;
+  }
+
+  int err;
+  m_state = src_new(converter, channels, &err);
+  if (!m_state)
+  {
+    CLog::Log(LOGERROR, "CAEResampleSRC::Initialize - Failed to create a resampler: %s", src_strerror(err));
+    return false;
+  }
+
+  m_data.src_ratio    = (double)outRate / (double)inRate;
+  m_data.end_of_input = 0;
+  return true;
+}
+
+void CAEResampleSRC::Reset()
+{
+  m_data.end_of_input = 0;
+  src_reset(m_state);
+}
+
+bool CAEResampleSRC::SetRatio(double ratio)
+{
+  src_set_ratio(m_state, ratio);
+  m_data.src_ratio = ratio;
+  return true;
+}
+
+bool CAEResampleSRC::Process(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed, unsigned int &outGenerated)
+{
+  m_data.data_in       = (float*)in;
+  m_data.input_frames  = inFrames;
+  m_data.data_out      = out;
+  m_data.output_frames = outFrames;
+
+  inUsed       = 0;
+  outGenerated = 0;
+  if (src_process(m_state, &m_data) != 0)
+    return false;
+
+  inUsed       = m_data.input_frames_used;
+  outGenerated = m_data.output_frames_gen;
+  return true;
+}
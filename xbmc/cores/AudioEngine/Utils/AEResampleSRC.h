@@ -0,0 +1,44 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Interfaces/AEResample.h"
+#include <samplerate.h>
+
+/**
+ * Resamples with libsamplerate, for any ratio and for ratios that change
+ */
+class CAEResampleSRC : public IAEResample
+{
+public:
+  CAEResampleSRC();
+  virtual ~CAEResampleSRC();
+
+  virtual const char *GetName() { return "libsamplerate"; }
+  virtual bool Initialize(unsigned int channels, unsigned int inRate, unsigned int outRate, AEResampleQuality quality);
+  virtual void Reset();
+  virtual double GetRatio() { return m_data.src_ratio; }
+  virtual bool SetRatio(double ratio);
+  virtual bool Process(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed, unsigned int &outGenerated);
+
+private:
+  SRC_STATE *m_state;
+  SRC_DATA   m_data;
+};
@@ -25,6 +25,13 @@
 #include "AEUtil.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
+#include "utils/CPUInfo.h"
+
+#include <algorithm>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
 using namespace std;
 
@@ -372,6 +379,242 @@ void CAEUtil::ClampArray(float *data, uint32_t count)
 #endif
 }
 
+/*
+  Block kernels for the stream mixer. Each one has a plain C version and,
+  where the build allows, SSE and NEON versions which are picked at runtime
+  from the features of the CPU.
+*/
+typedef void (*MulAddFramesFn)(float *dst, const float *src, const float *gains, const float mul, unsigned int channels, unsigned int frames);
+typedef void (*FramePeaksFn  )(const float *src, unsigned int channels, unsigned int frames, float *peaks);
+
+static void MulAddFramesC(float *dst, const float *src, const float *gains, const float mul, unsigned int channels, unsigned int frames)
+{
+  for (unsigned int f = 0; f < frames; ++f)
+  {
+    const float g = gains[f] * mul;
+    for (unsigned int c = 0; c < channels; ++c)
+      *dst++ += *src++ * g;
+  }
+}
+
+static void FramePeaksC(const float *src, unsigned int channels, unsigned int frames, float *peaks)
+{
+  for (unsigned int f = 0; f < frames; ++f)
+  {
+    float highest = 0.0f;
+    for (unsigned int c = 0; c < channels; ++c)
+      highest = std::max(highest, fabsf(*src++));
+    peaks[f] = highest;
+  }
+}
+
+#ifdef __SSE__
+static void MulAddFramesSSE(float *dst, const float *src, const float *gains, const float mul, unsigned int channels, unsigned int frames)
+{
+  const __m128 m = _mm_set_ps1(mul);
+  unsigned int f = 0;
+
+  if (channels == 1)
+  {
+    for (; f + 4 <= frames; f += 4, dst += 4, src += 4)
+    {
+      __m128 g = _mm_mul_ps(_mm_loadu_ps(gains + f), m);
+      _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_mul_ps(_mm_loadu_ps(src), g)));
+    }
+  }
+  else if (channels == 2)
+  {
+    /* four stereo frames per pass, each gain covers two samples */
+    for (; f + 4 <= frames; f += 4, dst += 8, src += 8)
+    {
+      __m128 g  = _mm_mul_ps(_mm_loadu_ps(gains + f), m);
+      __m128 lo = _mm_unpacklo_ps(g, g);
+      __m128 hi = _mm_unpackhi_ps(g, g);
+      _mm_storeu_ps(dst    , _mm_add_ps(_mm_loadu_ps(dst    ), _mm_mul_ps(_mm_loadu_ps(src    ), lo)));
+      _mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4), _mm_mul_ps(_mm_loadu_ps(src + 4), hi)));
+    }
+  }
+  else if (channels >= 4)
+  {
+    for (; f < frames; ++f)
+    {
+      const float  g  = gains[f] * mul;
+      const __m128 gv = _mm_set_ps1(g);
+      unsigned int c = 0;
+      for (; c + 4 <= channels; c += 4, dst += 4, src += 4)
+        _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_mul_ps(_mm_loadu_ps(src), gv)));
+      for (; c < channels; ++c)
+        *dst++ += *src++ * g;
+    }
+  }
+
+  MulAddFramesC(dst, src, gains + f, mul, channels, frames - f);
+}
+
+static void FramePeaksSSE(const float *src, unsigned int channels, unsigned int frames, float *peaks)
+{
+  /* clearing the sign bit gives the absolute value */
+  const __m128 sign = _mm_set_ps1(-0.0f);
+  unsigned int f = 0;
+
+  if (channels == 1)
+  {
+    for (; f + 4 <= frames; f += 4, src += 4)
+      _mm_storeu_ps(peaks + f, _mm_andnot_ps(sign, _mm_loadu_ps(src)));
+  }
+  else if (channels == 2)
+  {
+    for (; f + 4 <= frames; f += 4, src += 8)
+    {
+      __m128 a = _mm_andnot_ps(sign, _mm_loadu_ps(src    ));
+      __m128 b = _mm_andnot_ps(sign, _mm_loadu_ps(src + 4));
+      /* the even lanes end up holding the peak of each frame */
+      a = _mm_max_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+      b = _mm_max_ps(b, _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)));
+      _mm_storeu_ps(peaks + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+  }
+  else if (channels >= 4)
+  {
+    for (; f < frames; ++f)
+    {
+      __m128 m = _mm_setzero_ps();
+      unsigned int c = 0;
+      for (; c + 4 <= channels; c += 4, src += 4)
+        m = _mm_max_ps(m, _mm_andnot_ps(sign, _mm_loadu_ps(src)));
+      m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+      m = _mm_max_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+
+      float highest = _mm_cvtss_f32(m);
+      for (; c < channels; ++c)
+        highest = std::max(highest, fabsf(*src++));
+      peaks[f] = highest;
+    }
+  }
+
+  FramePeaksC(src, channels, frames - f, peaks + f);
+}
+#endif
+
+#if defined(__ARM_NEON__)
+static void MulAddFramesNEON(float *dst, const float *src, const float *gains, const float mul, unsigned int channels, unsigned int frames)
+{
+  unsigned int f = 0;
+
+  if (channels == 1)
+  {
+    for (; f + 4 <= frames; f += 4, dst += 4, src += 4)
+    {
+      float32x4_t g = vmulq_n_f32(vld1q_f32(gains + f), mul);
+      vst1q_f32(dst, vmlaq_f32(vld1q_f32(dst), vld1q_f32(src), g));
+    }
+  }
+  else if (channels == 2)
+  {
+    /* four stereo frames per pass, each gain covers two samples */
+    for (; f + 4 <= frames; f += 4, dst += 8, src += 8)
+    {
+      float32x4_t   g = vmulq_n_f32(vld1q_f32(gains + f), mul);
+      float32x4x2_t z = vzipq_f32(g, g);
+      vst1q_f32(dst    , vmlaq_f32(vld1q_f32(dst    ), vld1q_f32(src    ), z.val[0]));
+      vst1q_f32(dst + 4, vmlaq_f32(vld1q_f32(dst + 4), vld1q_f32(src + 4), z.val[1]));
+    }
+  }
+  else if (channels >= 4)
+  {
+    for (; f < frames; ++f)
+    {
+      const float g = gains[f] * mul;
+      unsigned int c = 0;
+      for (; c + 4 <= channels; c += 4, dst += 4, src += 4)
+        vst1q_f32(dst, vmlaq_n_f32(vld1q_f32(dst), vld1q_f32(src), g));
+      for (; c < channels; ++c)
+        *dst++ += *src++ * g;
+    }
+  }
+
+  MulAddFramesC(dst, src, gains + f, mul, channels, frames - f);
+}
+
+static void FramePeaksNEON(const float *src, unsigned int channels, unsigned int frames, float *peaks)
+{
+  unsigned int f = 0;
+
+  if (channels == 1)
+  {
+    for (; f + 4 <= frames; f += 4, src += 4)
+      vst1q_f32(peaks + f, vabsq_f32(vld1q_f32(src)));
+  }
+  else if (channels == 2)
+  {
+    for (; f + 4 <= frames; f += 4, src += 8)
+    {
+      float32x4_t a = vabsq_f32(vld1q_f32(src    ));
+      float32x4_t b = vabsq_f32(vld1q_f32(src + 4));
+      /* pairwise max of neighbouring samples is the peak of each frame */
+      float32x2_t pa = vpmax_f32(vget_low_f32(a), vget_high_f32(a));
+      float32x2_t pb = vpmax_f32(vget_low_f32(b), vget_high_f32(b));
+      vst1q_f32(peaks + f, vcombine_f32(pa, pb));
+    }
+  }
+  else if (channels >= 4)
+  {
+    for (; f < frames; ++f)
+    {
+      float32x4_t m = vdupq_n_f32(0.0f);
+      unsigned int c = 0;
+      for (; c + 4 <= channels; c += 4, src += 4)
+        m = vmaxq_f32(m, vabsq_f32(vld1q_f32(src)));
+      float32x2_t p = vpmax_f32(vget_low_f32(m), vget_high_f32(m));
+      p = vpmax_f32(p, p);
+
+      float highest = vget_lane_f32(p, 0);
+      for (; c < channels; ++c)
+        highest = std::max(highest, fabsf(*src++));
+      peaks[f] = highest;
+    }
+  }
+
+  FramePeaksC(src, channels, frames - f, peaks + f);
+}
+#endif
+
+static MulAddFramesFn SelectMulAddFrames()
+{
+#if defined(__SSE__)
+  if (g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_SSE)
+    return MulAddFramesSSE;
+#elif defined(__ARM_NEON__)
+  if (g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_NEON)
+    return MulAddFramesNEON;
+#endif
+  return MulAddFramesC;
+}
+
+static FramePeaksFn SelectFramePeaks()
+{
+#if defined(__SSE__)
+  if (g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_SSE)
+    return FramePeaksSSE;
+#elif defined(__ARM_NEON__)
+  if (g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_NEON)
+    return FramePeaksNEON;
+#endif
+  return FramePeaksC;
+}
+
+void CAEUtil::MulAddFrames(float *dst, const float *src, const float *gains, const float mul, unsigned int channels, unsigned int frames)
+{
+  static const MulAddFramesFn fn = SelectMulAddFrames();
+  fn(dst, src, gains, mul, channels, frames);
+}
+
+void CAEUtil::FramePeaks(const float *src, unsigned int channels, unsigned int frames, float *peaks)
+{
+  static const FramePeaksFn fn = SelectFramePeaks();
+  fn(src, channels, frames, peaks);
+}
+
 /*
   Rand implementations based on:
   http://software.intel.com/en-us/articles/fast-random-number-generator-on-the-intel-pentiumr-4-processor/
@@ -112,6 +112,27 @@ public:
   #endif
   static void ClampArray(float *data, uint32_t count);
 
+  /*! \brief mix a block of interleaved frames into another one
+   Each frame of src is scaled by its own gain and by mul, then added to dst.
+   Uses SSE or NEON when the CPU supports it.
+   \param dst the frames to mix into
+   \param src the frames to mix in
+   \param gains the gain of each frame of src
+   \param mul a gain applied to all frames
+   \param channels the number of channels per frame
+   \param frames the number of frames
+   */
+  static void MulAddFrames(float *dst, const float *src, const float *gains, const float mul, unsigned int channels, unsigned int frames);
+
+  /*! \brief find the highest absolute sample of each frame in a block
+   Uses SSE or NEON when the CPU supports it.
+   \param src the interleaved frames
+   \param channels the number of channels per frame
+   \param frames the number of frames
+   \param peaks receives the peak of each frame
+   */
+  static void FramePeaks(const float *src, unsigned int channels, unsigned int frames, float *peaks);
+
   /*
     Rand implementations based on:
     http://software.intel.com/en-us/articles/fast-random-number-generator-on-the-intel-pentiumr-4-processor/
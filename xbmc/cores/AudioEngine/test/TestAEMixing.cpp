@@ -0,0 +1,233 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "cores/AudioEngine/Utils/AELimiter.h"
+#include "threads/SystemClock.h"
+
+#include <math.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define CHANNELS      8
+#define SAMPLERATE    192000
+#define SECONDS       10
+#define BLOCKFRAMES   256       // frames the engine mixes in one go
+#define BUFFERFRAMES  4096
+#define VOLUME        0.8f
+#define REPLAYGAIN    1.2f
+
+static void FillFrames(std::vector<float> &frames, unsigned int channels, unsigned int count, int seed)
+{
+  frames.resize(channels * count);
+  for (unsigned int i = 0; i < frames.size(); i++)
+  {
+    // loud enough for the limiter to kick in now and then
+    frames[i] = 1.5f * sinf((float)(i * (seed + 1)) * 0.001f) * cosf((float)i * 0.37f);
+  }
+}
+
+class CMixStream
+{
+public:
+  CMixStream(unsigned int channels, int seed)
+  {
+    FillFrames(m_frames, channels, BUFFERFRAMES, seed);
+    m_limiter.SetSamplerate(SAMPLERATE);
+    m_limiter.SetAmplification(1.5f);
+  }
+
+  std::vector<float> m_frames;
+  CAELimiter         m_limiter;
+};
+
+/* mixes the way the engine used to, a frame of each stream at a time */
+static void MixPerFrame(std::vector<CMixStream*> &streams, float *out, unsigned int channels, unsigned int frames)
+{
+  for (unsigned int f = 0; f < frames; f++)
+  {
+    float *dst = out + f * channels;
+    for (unsigned int s = 0; s < streams.size(); s++)
+    {
+      float *frame = &streams[s]->m_frames[(f % BUFFERFRAMES) * channels];
+      float volume = VOLUME * REPLAYGAIN * streams[s]->m_limiter.Run(frame, channels);
+#ifdef __SSE__
+      if (channels > 1)
+        CAEUtil::SSEMulAddArray(dst, frame, volume, channels);
+      else
+#endif
+      {
+        for (unsigned int c = 0; c < channels; c++)
+          dst[c] += frame[c] * volume;
+      }
+    }
+  }
+}
+
+/* mixes the way the engine does now, a block of each stream at a time */
+static void MixBlocks(std::vector<CMixStream*> &streams, float *out, unsigned int channels, unsigned int frames)
+{
+  float gains[BLOCKFRAMES];
+  for (unsigned int f = 0; f < frames; f += BLOCKFRAMES)
+  {
+    unsigned int count = std::min(frames - f, (unsigned int)BLOCKFRAMES);
+    for (unsigned int s = 0; s < streams.size(); s++)
+    {
+      const float *src = &streams[s]->m_frames[(f % BUFFERFRAMES) * channels];
+      std::fill(gains, gains + count, VOLUME);
+      streams[s]->m_limiter.Run(src, channels, count, gains);
+      CAEUtil::MulAddFrames(out + f * channels, src, gains, REPLAYGAIN, channels, count);
+    }
+  }
+}
+
+TEST(TestAEMixing, MulAddFrames)
+{
+  for (unsigned int channels = 1; channels <= CHANNELS; channels++)
+  {
+    // odd counts leave a tail the vector loops don't cover
+    unsigned int frames = 37;
+    std::vector<float> src, dst, expected;
+    FillFrames(src, channels, frames, 1);
+    FillFrames(dst, channels, frames, 2);
+    expected = dst;
+
+    std::vector<float> gains(frames);
+    for (unsigned int f = 0; f < frames; f++)
+      gains[f] = (float)f / frames;
+
+    for (unsigned int f = 0; f < frames; f++)
+    {
+      for (unsigned int c = 0; c < channels; c++)
+        expected[f * channels + c] += src[f * channels + c] * gains[f] * REPLAYGAIN;
+    }
+
+    CAEUtil::MulAddFrames(&dst[0], &src[0], &gains[0], REPLAYGAIN, channels, frames);
+    for (unsigned int i = 0; i < dst.size(); i++)
+      EXPECT_NEAR(expected[i], dst[i], 1e-5f) << "channels " << channels << " sample " << i;
+  }
+}
+
+TEST(TestAEMixing, FramePeaks)
+{
+  for (unsigned int channels = 1; channels <= CHANNELS; channels++)
+  {
+    unsigned int frames = 37;
+    std::vector<float> src;
+    FillFrames(src, channels, frames, 3);
+
+    std::vector<float> peaks(frames);
+    CAEUtil::FramePeaks(&src[0], channels, frames, &peaks[0]);
+    for (unsigned int f = 0; f < frames; f++)
+    {
+      float highest = 0.0f;
+      for (unsigned int c = 0; c < channels; c++)
+        highest = std::max(highest, fabsf(src[f * channels + c]));
+      EXPECT_EQ(highest, peaks[f]) << "channels " << channels << " frame " << f;
+    }
+  }
+}
+
+TEST(TestAEMixing, BlockLimiter)
+{
+  std::vector<float> src;
+  FillFrames(src, 2, BUFFERFRAMES, 4);
+
+  CAELimiter perFrame, block;
+  perFrame.SetAmplification(2.0f);
+  block.SetAmplification(2.0f);
+
+  std::vector<float> gains(BUFFERFRAMES, 1.0f);
+  block.Run(&src[0], 2, BUFFERFRAMES, &gains[0]);
+
+  bool limited = false;
+  for (unsigned int f = 0; f < BUFFERFRAMES; f++)
+  {
+    float gain = perFrame.Run(&src[f * 2], 2);
+    EXPECT_EQ(gain, gains[f]) << "frame " << f;
+    limited = limited || gain < 2.0f;
+  }
+  EXPECT_TRUE(limited);
+}
+
+TEST(TestAEMixing, BlocksMatchPerFrame)
+{
+  std::vector<CMixStream*> perFrame, blocks;
+  for (int s = 0; s < 3; s++)
+  {
+    perFrame.push_back(new CMixStream(CHANNELS, s));
+    blocks  .push_back(new CMixStream(CHANNELS, s));
+  }
+
+  unsigned int frames = BUFFERFRAMES - 3;
+  std::vector<float> expected(frames * CHANNELS, 0.0f), out(frames * CHANNELS, 0.0f);
+  MixPerFrame(perFrame, &expected[0], CHANNELS, frames);
+  MixBlocks(blocks, &out[0], CHANNELS, frames);
+
+  for (unsigned int i = 0; i < out.size(); i++)
+    EXPECT_NEAR(expected[i], out[i], 1e-4f) << "sample " << i;
+
+  for (unsigned int s = 0; s < perFrame.size(); s++)
+  {
+    delete perFrame[s];
+    delete blocks[s];
+  }
+}
+
+TEST(TestAEMixing, MixBenchmark)
+{
+  std::vector<float> out(BUFFERFRAMES * CHANNELS);
+  int streamCounts[] = { 1, 2, 4, 8 };
+  const char *modes[] = { "per frame", "block" };
+
+  for (unsigned int i = 0; i < sizeof(streamCounts) / sizeof(streamCounts[0]); i++)
+  {
+    for (unsigned int mode = 0; mode < 2; mode++)
+    {
+      std::vector<CMixStream*> streams;
+      for (int s = 0; s < streamCounts[i]; s++)
+        streams.push_back(new CMixStream(CHANNELS, s));
+
+      // mix the streams the sink would consume in SECONDS seconds
+      uint64_t frames = 0;
+      unsigned int start = XbmcThreads::SystemClockMillis();
+      for (; frames < SAMPLERATE * SECONDS; frames += BUFFERFRAMES)
+      {
+        std::fill(out.begin(), out.end(), 0.0f);
+        if (mode == 0)
+          MixPerFrame(streams, &out[0], CHANNELS, BUFFERFRAMES);
+        else
+          MixBlocks(streams, &out[0], CHANNELS, BUFFERFRAMES);
+      }
+      unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+      for (unsigned int s = 0; s < streams.size(); s++)
+        delete streams[s];
+
+      std::cout << "Streams: " << testing::PrintToString(streamCounts[i]) << " Mode: " << modes[mode] << std::endl;
+      std::cout << "  Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+      std::cout << "  Frames/sec: " << testing::PrintToString(elapsed ? frames * 1000 / elapsed : 0) << std::endl;
+      std::cout << "  CPU (%): " << testing::PrintToString((double)elapsed / (SECONDS * 10)) << std::endl;
+    }
+  }
+}
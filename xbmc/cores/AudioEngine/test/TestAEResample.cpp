@@ -0,0 +1,216 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/AEResampleFactory.h"
+#include "cores/AudioEngine/Utils/AEResamplePolyphase.h"
+#include "cores/AudioEngine/Utils/AEResampleSRC.h"
+#include "threads/SystemClock.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define CHANNELS    2
+#define TONE        1000.0    // Hz
+#define AMPLITUDE   0.9
+#define CHUNKFRAMES 1024      // frames handed to the resampler at a time
+#define SECONDS     10
+
+static void FillTone(std::vector<float> &frames, unsigned int channels, unsigned int rate, unsigned int count)
+{
+  frames.resize(count * channels);
+  for (unsigned int f = 0; f < count; f++)
+  {
+    float sample = (float)(AMPLITUDE * sin(2.0 * M_PI * TONE * f / rate));
+    for (unsigned int c = 0; c < channels; c++)
+      frames[f * channels + c] = sample;
+  }
+}
+
+/* feeds the input in chunks with a little less output room than needed, as the stream does */
+static void Resample(IAEResample &resampler, const std::vector<float> &in, unsigned int channels, std::vector<float> &out)
+{
+  unsigned int inFrames  = in.size() / channels;
+  unsigned int outFrames = (unsigned int)ceil(CHUNKFRAMES * resampler.GetRatio()) - 1;
+  std::vector<float> buffer(outFrames * channels);
+
+  out.clear();
+  unsigned int pos = 0;
+  while (pos < inFrames)
+  {
+    unsigned int used, generated;
+    ASSERT_TRUE(resampler.Process(&in[pos * channels], std::min(inFrames - pos, (unsigned int)CHUNKFRAMES), &buffer[0], outFrames, used, generated));
+    if (used == 0 && generated == 0)
+      break;
+    out.insert(out.end(), buffer.begin(), buffer.begin() + generated * channels);
+    pos += used;
+  }
+}
+
+/*
+  fits a sine of the tone's frequency to the first channel, and returns the
+  power of what is left, noise and distortion, relative to it in dB
+*/
+static double THDN(const std::vector<float> &frames, unsigned int channels, unsigned int rate, unsigned int skip)
+{
+  double ss = 0, sc = 0, s1 = 0, cc = 0, c1 = 0, n = 0;
+  double ys = 0, yc = 0, y1 = 0;
+  unsigned int count = frames.size() / channels;
+  for (unsigned int f = skip; f < count; f++)
+  {
+    double w = 2.0 * M_PI * TONE * f / rate;
+    double s = sin(w), c = cos(w), y = frames[f * channels];
+    ss += s * s; sc += s * c; s1 += s; cc += c * c; c1 += c; n += 1;
+    ys += y * s; yc += y * c; y1 += y;
+  }
+
+  /* solve the normal equations of y = a * sin + b * cos + d */
+  double m[3][4] = { { ss, sc, s1, ys }, { sc, cc, c1, yc }, { s1, c1, n, y1 } };
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = i + 1; j < 3; j++)
+    {
+      double k = m[j][i] / m[i][i];
+      for (int l = i; l < 4; l++)
+        m[j][l] -= k * m[i][l];
+    }
+  }
+  double x[3];
+  for (int i = 2; i >= 0; i--)
+  {
+    x[i] = m[i][3];
+    for (int j = i + 1; j < 3; j++)
+      x[i] -= m[i][j] * x[j];
+    x[i] /= m[i][i];
+  }
+
+  double signal = 0, residual = 0;
+  for (unsigned int f = skip; f < count; f++)
+  {
+    double w = 2.0 * M_PI * TONE * f / rate;
+    double fit = x[0] * sin(w) + x[1] * cos(w);
+    double r = frames[f * channels] - fit - x[2];
+    signal   += fit * fit;
+    residual += r * r;
+  }
+
+  return 10.0 * log10(residual / signal);
+}
+
+TEST(TestAEResample, PolyphaseRatios)
+{
+  unsigned int rates[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 48000, 96000 }, { 44100, 96000 }, { 96000, 48000 }, { 22050, 48000 } };
+  for (unsigned int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+  {
+    CAEResamplePolyphase resampler;
+    ASSERT_TRUE(resampler.Initialize(CHANNELS, rates[i][0], rates[i][1], AE_RESAMPLE_MEDIUM));
+    EXPECT_DOUBLE_EQ((double)rates[i][1] / rates[i][0], resampler.GetRatio());
+    EXPECT_TRUE(resampler.SetRatio((double)rates[i][1] / rates[i][0]));
+    EXPECT_FALSE(resampler.SetRatio((double)rates[i][1] / rates[i][0] * 1.001));
+
+    std::vector<float> in, out;
+    FillTone(in, CHANNELS, rates[i][0], rates[i][0]);
+    Resample(resampler, in, CHANNELS, out);
+
+    // every input frame is used up, and the filter only holds back its own length
+    int expected = rates[i][1];
+    EXPECT_NEAR(expected, (int)(out.size() / CHANNELS), 2) << rates[i][0] << " to " << rates[i][1];
+    EXPECT_LT(THDN(out, CHANNELS, rates[i][1], rates[i][1] / 10), -70.0) << rates[i][0] << " to " << rates[i][1];
+  }
+
+  // ratios that don't reduce to a few phases are left to libsamplerate
+  CAEResamplePolyphase resampler;
+  EXPECT_FALSE(resampler.Initialize(CHANNELS, 44100, 48001, AE_RESAMPLE_MEDIUM));
+}
+
+TEST(TestAEResample, Reset)
+{
+  CAEResamplePolyphase resampler;
+  ASSERT_TRUE(resampler.Initialize(CHANNELS, 44100, 48000, AE_RESAMPLE_MEDIUM));
+
+  std::vector<float> in, first, second;
+  FillTone(in, CHANNELS, 44100, 4410);
+  Resample(resampler, in, CHANNELS, first);
+  resampler.Reset();
+  Resample(resampler, in, CHANNELS, second);
+
+  ASSERT_EQ(first.size(), second.size());
+  EXPECT_EQ(0, memcmp(&first[0], &second[0], first.size() * sizeof(float)));
+}
+
+TEST(TestAEResample, Factory)
+{
+  IAEResample *resampler = CAEResampleFactory::Create(CHANNELS, 44100, 48000, false);
+  ASSERT_TRUE(resampler != NULL);
+  EXPECT_STREQ("polyphase", resampler->GetName());
+  delete resampler;
+
+  resampler = CAEResampleFactory::Create(CHANNELS, 44100, 48000, true);
+  ASSERT_TRUE(resampler != NULL);
+  EXPECT_STREQ("libsamplerate", resampler->GetName());
+  EXPECT_TRUE(resampler->SetRatio(48000.0 / 44100.0 * 1.001));
+  delete resampler;
+
+  resampler = CAEResampleFactory::Create(CHANNELS, 44100, 48001, false);
+  ASSERT_TRUE(resampler != NULL);
+  EXPECT_STREQ("libsamplerate", resampler->GetName());
+  delete resampler;
+}
+
+TEST(TestAEResample, ResampleBenchmark)
+{
+  AEResampleQuality qualities[] = { AE_RESAMPLE_LOW, AE_RESAMPLE_MEDIUM, AE_RESAMPLE_HIGH };
+  const char *qualityNames[] = { "low", "medium", "high" };
+  unsigned int rates[][2] = { { 44100, 48000 }, { 48000, 96000 } };
+
+  for (unsigned int r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+  {
+    std::vector<float> in;
+    FillTone(in, CHANNELS, rates[r][0], rates[r][0] * SECONDS);
+
+    for (unsigned int q = 0; q < sizeof(qualities) / sizeof(qualities[0]); q++)
+    {
+      IAEResample *engines[] = { new CAEResamplePolyphase(), new CAEResampleSRC() };
+      for (unsigned int e = 0; e < sizeof(engines) / sizeof(engines[0]); e++)
+      {
+        ASSERT_TRUE(engines[e]->Initialize(CHANNELS, rates[r][0], rates[r][1], qualities[q]));
+
+        std::vector<float> out;
+        unsigned int start = XbmcThreads::SystemClockMillis();
+        Resample(*engines[e], in, CHANNELS, out);
+        unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+        double thdn = THDN(out, CHANNELS, rates[r][1], rates[r][1] / 10);
+        EXPECT_LT(thdn, -50.0);
+
+        std::cout << "Engine: " << engines[e]->GetName() << " Quality: " << qualityNames[q]
+                  << " Rates: " << rates[r][0] << " to " << rates[r][1] << std::endl;
+        std::cout << "  Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+        std::cout << "  CPU per channel (%): " << testing::PrintToString((double)elapsed / (SECONDS * CHANNELS * 10)) << std::endl;
+        std::cout << "  THD+N (dB): " << testing::PrintToString(thdn) << std::endl;
+        delete engines[e];
+      }
+    }
+  }
+}
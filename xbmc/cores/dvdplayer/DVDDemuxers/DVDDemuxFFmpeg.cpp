@@ -598,6 +598,25 @@ void CDVDDemuxFFmpeg::SetSpeed(int iSpeed)
   }
 }
 
+DemuxPacket* CDVDDemuxFFmpeg::AllocateDemuxPacket(AVPacket &pkt)
+{
+  // a packet with a destructor has its own buffer, which we can take over.
+  // av_dup_packet only copies if that buffer is borrowed after all (nofree)
+  uint8_t *data = pkt.data;
+  if (pkt.data && pkt.destruct && m_dllAvCodec.av_dup_packet(&pkt) == 0)
+    return CDVDDemuxUtils::AllocateDemuxPacket(&pkt, pkt.data != data);
+
+  // the data belongs to the demuxer or parser, copy it into our own packet
+  DemuxPacket* pPacket = CDVDDemuxUtils::AllocateDemuxPacket(pkt.size);
+  if (pPacket)
+  {
+    pPacket->iSize = pkt.size;
+    if (pkt.data)
+      memcpy(pPacket->pData, pkt.data, pPacket->iSize);
+  }
+  return pPacket;
+}
+
 double CDVDDemuxFFmpeg::ConvertTimestamp(int64_t pts, int den, int num)
 {
   if (pts == (int64_t)AV_NOPTS_VALUE)
@@ -680,7 +699,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
         {
           if(pkt.stream_index == (int)m_pFormatContext->programs[m_program]->stream_index[i])
           {
-            pPacket = CDVDDemuxUtils::AllocateDemuxPacket(pkt.size);
+            pPacket = AllocateDemuxPacket(pkt);
             break;
           }
         }
@@ -689,7 +708,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           bReturnEmpty = true;
       }
       else
-        pPacket = CDVDDemuxUtils::AllocateDemuxPacket(pkt.size);
+        pPacket = AllocateDemuxPacket(pkt);
 
       if (pPacket)
       {
@@ -725,13 +744,6 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           pkt.pts = AV_NOPTS_VALUE;
         }
 
-        // copy contents into our own packet
-        pPacket->iSize = pkt.size;
-
-        // maybe we can avoid a memcpy here by detecting where pkt.destruct is pointing too?
-        if (pkt.data)
-          memcpy(pPacket->pData, pkt.data, pPacket->iSize);
-
         pPacket->pts = ConvertTimestamp(pkt.pts, stream->time_base.den, stream->time_base.num);
         pPacket->dts = ConvertTimestamp(pkt.dts, stream->time_base.den, stream->time_base.num);
         pPacket->duration =  DVD_SEC_TO_TIME((double)pkt.duration * stream->time_base.num / stream->time_base.den);
@@ -121,6 +121,7 @@ protected:
   int ReadFrame(AVPacket *packet);
   void AddStream(int iId);
 
+  DemuxPacket* AllocateDemuxPacket(AVPacket &pkt);
   double ConvertTimestamp(int64_t pts, int den, int num);
   void UpdateCurrentPTS();
 
@@ -24,6 +24,8 @@
 #include "DVDDemuxUtils.h"
 #include "DVDClock.h"
 #include "utils/log.h"
+#include "threads/SingleLock.h"
+#include <vector>
 extern "C" {
 #if (defined USE_EXTERNAL_FFMPEG)
   #if (defined HAVE_LIBAVCODEC_AVCODEC_H)
@@ -36,13 +38,84 @@ extern "C" {
 #endif
 }
 
+// payloads are recycled in power of two size classes from 1KB up to 1MB,
+// which covers nearly all audio and video packets
+#define POOL_MIN_SHIFT  10
+#define POOL_CLASSES    11
+#define POOL_MAX_BYTES  (32 * 1024 * 1024)
+
+// the packet handed out is the first member, so the pointers are interchangeable
+struct DemuxPacketEx
+{
+  DemuxPacket packet;
+  int         sizeClass; // -1 when the payload isn't pooled
+  AVPacket    source;    // owner of the payload when it wasn't copied
+};
+
+static CCriticalSection         s_poolSection;
+static std::vector<BYTE*>       s_pool[POOL_CLASSES];
+static unsigned int             s_poolBytes = 0;
+static DemuxPacketStats         s_stats = { 0, 0, 0, 0 };
+
+static int GetSizeClass(int iDataSize)
+{
+  for (int i = 0; i < POOL_CLASSES; i++)
+  {
+    if (iDataSize <= (1 << (POOL_MIN_SHIFT + i)))
+      return i;
+  }
+  return -1;
+}
+
+static BYTE* AllocatePayload(int iDataSize, int sizeClass)
+{
+  if (sizeClass < 0)
+    return (BYTE*)_aligned_malloc(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE, 16);
+
+  {
+    CSingleLock lock(s_poolSection);
+    s_stats.allocations++;
+    if (!s_pool[sizeClass].empty())
+    {
+      BYTE* data = s_pool[sizeClass].back();
+      s_pool[sizeClass].pop_back();
+      s_poolBytes -= 1 << (POOL_MIN_SHIFT + sizeClass);
+      s_stats.poolHits++;
+      return data;
+    }
+  }
+
+  return (BYTE*)_aligned_malloc((1 << (POOL_MIN_SHIFT + sizeClass)) + FF_INPUT_BUFFER_PADDING_SIZE, 16);
+}
+
+static void FreePayload(BYTE* data, int sizeClass)
+{
+  if (sizeClass >= 0)
+  {
+    CSingleLock lock(s_poolSection);
+    unsigned int size = 1 << (POOL_MIN_SHIFT + sizeClass);
+    if (s_poolBytes + size <= POOL_MAX_BYTES)
+    {
+      s_pool[sizeClass].push_back(data);
+      s_poolBytes += size;
+      return;
+    }
+  }
+
+  _aligned_free(data);
+}
+
 void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 {
   if (pPacket)
   {
+    DemuxPacketEx* pPacketEx = (DemuxPacketEx*)pPacket;
     try {
-      if (pPacket->pData) _aligned_free(pPacket->pData);
-      delete pPacket;
+      if (pPacketEx->source.destruct)
+        pPacketEx->source.destruct(&pPacketEx->source);
+      else if (pPacket->pData)
+        FreePayload(pPacket->pData, pPacketEx->sizeClass);
+      delete pPacketEx;
     }
     catch(...) {
       CLog::Log(LOGERROR, "%s - Exception thrown while freeing packet", __FUNCTION__);
@@ -52,12 +125,14 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 
 DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
 {
-  DemuxPacket* pPacket = new DemuxPacket;
-  if (!pPacket) return NULL;
+  DemuxPacketEx* pPacketEx = new DemuxPacketEx;
+  if (!pPacketEx) return NULL;
 
+  DemuxPacket* pPacket = &pPacketEx->packet;
   try
   {
-    memset(pPacket, 0, sizeof(DemuxPacket));
+    memset(pPacketEx, 0, sizeof(DemuxPacketEx));
+    pPacketEx->sizeClass = -1;
 
     if (iDataSize > 0)
     {
@@ -70,7 +145,8 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
         * Note, if the first 23 bits of the additional bytes are not 0 then damaged
         * MPEG bitstreams could cause overread and segfault
         */
-      pPacket->pData =(BYTE*)_aligned_malloc(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE, 16);
+      pPacketEx->sizeClass = GetSizeClass(iDataSize);
+      pPacket->pData = AllocatePayload(iDataSize, pPacketEx->sizeClass);
       if (!pPacket->pData)
       {
         FreeDemuxPacket(pPacket);
@@ -94,3 +170,36 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
   }
   return pPacket;
 }
+
+DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(AVPacket* pkt, bool copied)
+{
+  DemuxPacket* pPacket = AllocateDemuxPacket(0);
+  if (!pPacket) return NULL;
+
+  // the buffer is padded and owned by the AVPacket, so it can be used as is
+  DemuxPacketEx* pPacketEx = (DemuxPacketEx*)pPacket;
+  pPacketEx->source = *pkt;
+  pPacket->pData    = pkt->data;
+  pPacket->iSize    = pkt->size;
+
+  pkt->data      = NULL;
+  pkt->size      = 0;
+  pkt->destruct  = NULL;
+  pkt->side_data = NULL;
+  pkt->side_data_elems = 0;
+
+  if (!copied)
+  {
+    CSingleLock lock(s_poolSection);
+    s_stats.zeroCopy++;
+    s_stats.bytesNotCopied += pPacket->iSize;
+  }
+
+  return pPacket;
+}
+
+DemuxPacketStats CDVDDemuxUtils::GetStats()
+{
+  CSingleLock lock(s_poolSection);
+  return s_stats;
+}
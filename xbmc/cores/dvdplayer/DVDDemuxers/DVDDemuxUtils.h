@@ -21,11 +21,30 @@
  */
 
 #include "DVDDemuxPacket.h"
+#include <stdint.h>
+
+struct AVPacket;
+
+struct DemuxPacketStats
+{
+  uint64_t allocations;    // packets allocated with a payload that fits the pool
+  uint64_t poolHits;       // of which were recycled from the pool
+  uint64_t zeroCopy;       // packets that took over an AVPacket buffer
+  uint64_t bytesNotCopied; // payload those packets didn't have to copy
+};
 
 class CDVDDemuxUtils
 {
 public:
   static void FreeDemuxPacket(DemuxPacket* pPacket);
   static DemuxPacket* AllocateDemuxPacket(int iDataSize = 0);
+  /*! \brief Wrap the payload of an AVPacket without copying it.
+   The AVPacket has to own its buffer (see av_dup_packet), which is released
+   along with the demux packet. pkt is left without payload afterwards.
+   \param copied true if av_dup_packet had to copy the payload to own it, which doesn't count as zero copy
+   */
+  static DemuxPacket* AllocateDemuxPacket(AVPacket* pkt, bool copied = false);
+
+  static DemuxPacketStats GetStats();
 };
 
@@ -27,6 +27,8 @@
 
 using namespace std;
 
+#define MSGQ_NODE_BLOCK 256
+
 CDVDMessageQueue::CDVDMessageQueue(const string &owner) : m_hEvent(true)
 {
   m_owner = owner;
@@ -40,12 +42,43 @@ CDVDMessageQueue::CDVDMessageQueue(const string &owner) : m_hEvent(true)
   m_TimeFront     = DVD_NOPTS_VALUE;
   m_TimeSize      = 1.0 / 4.0; /* 4 seconds */
   m_iMaxDataSize  = 0;
+
+  for (int i = 0; i < MSGQ_PRIORITIES; i++)
+    m_lanes[i].head = m_lanes[i].tail = NULL;
+  m_count = 0;
+  m_free  = NULL;
 }
 
 CDVDMessageQueue::~CDVDMessageQueue()
 {
   // remove all remaining messages
-  Flush();
+  Flush(CDVDMsg::NONE);
+
+  for (vector<SNode*>::iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+    delete[] *it;
+}
+
+CDVDMessageQueue::SNode* CDVDMessageQueue::AllocNode()
+{
+  if (!m_free)
+  {
+    SNode* block = new SNode[MSGQ_NODE_BLOCK];
+    for (int i = 0; i < MSGQ_NODE_BLOCK; i++)
+      FreeNode(&block[i]);
+    m_blocks.push_back(block);
+  }
+
+  SNode* node = m_free;
+  m_free = node->next;
+  node->next = NULL;
+  return node;
+}
+
+void CDVDMessageQueue::FreeNode(SNode* node)
+{
+  node->message = NULL;
+  node->next    = m_free;
+  m_free        = node;
 }
 
 void CDVDMessageQueue::Init()
@@ -62,12 +95,30 @@ void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 {
   CSingleLock lock(m_section);
 
-  for(SList::iterator it = m_list.begin(); it != m_list.end();)
+  for (int i = 0; i < MSGQ_PRIORITIES; i++)
   {
-    if (it->message->IsType(type) ||  type == CDVDMsg::NONE)
-      it = m_list.erase(it);
-    else
-      it++;
+    SLane& lane = m_lanes[i];
+    SNode* prev = NULL;
+    for (SNode* node = lane.head; node;)
+    {
+      SNode* next = node->next;
+      if (node->message->IsType(type) ||  type == CDVDMsg::NONE)
+      {
+        if (prev)
+          prev->next = next;
+        else
+          lane.head = next;
+        if (lane.tail == node)
+          lane.tail = prev;
+
+        node->message->Release();
+        FreeNode(node);
+        m_count--;
+      }
+      else
+        prev = node;
+      node = next;
+    }
   }
 
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
@@ -116,14 +167,22 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority)
     return MSGQ_INVALID_MSG;
   }
 
-  SList::iterator it = m_list.begin();
-  while(it != m_list.end())
-  {
-    if(priority <= it->priority)
-      break;
-    it++;
-  }
-  m_list.insert(it, DVDMessageListItem(pMsg, priority));
+  if (priority < 0)
+    priority = 0;
+  else if (priority >= MSGQ_PRIORITIES)
+    priority = MSGQ_PRIORITIES - 1;
+
+  // the queue takes over the reference of the caller
+  SNode* node = AllocNode();
+  node->message = pMsg;
+
+  SLane& lane = m_lanes[priority];
+  if (lane.tail)
+    lane.tail->next = node;
+  else
+    lane.head = node;
+  lane.tail = node;
+  m_count++;
 
   if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
   {
@@ -140,8 +199,6 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority)
     }
   }
 
-  pMsg->Release();
-
   m_hEvent.Set(); // inform waiter for new packet
 
   return MSGQ_OK;
@@ -161,7 +218,7 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     return MSGQ_NOT_INITIALIZED;
   }
 
-  if(m_list.empty() && m_bEmptied == false && priority == 0 && m_owner != "teletext")
+  if(m_count == 0 && m_bEmptied == false && priority == 0 && m_owner != "teletext")
   {
 #if !defined(TARGET_RASPBERRY_PI)
     CLog::Log(LOGWARNING, "CDVDMessageQueue(%s)::Get - asked for new data packet, with nothing available", m_owner.c_str());
@@ -171,14 +228,19 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 
   while (!m_bAbortRequest)
   {
-    if(!m_list.empty() && m_list.back().priority >= priority && !m_bCaching)
+    // the most important lane holding a message
+    int lane = MSGQ_PRIORITIES - 1;
+    while (lane >= 0 && !m_lanes[lane].head)
+      lane--;
+
+    if(lane >= 0 && lane >= priority && !m_bCaching)
     {
-      DVDMessageListItem& item(m_list.back());
-      priority = item.priority;
+      SNode* node = m_lanes[lane].head;
+      priority = lane;
 
-      if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
+      if (node->message->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
       {
-        DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)item.message)->GetPacket();
+        DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)node->message)->GetPacket();
         if(packet)
         {
           m_iDataSize -= packet->iSize;
@@ -192,8 +254,12 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
           m_bEmptied = false;
       }
 
-      *pMsg = item.message->Acquire();
-      m_list.pop_back();
+      *pMsg = node->message;
+      m_lanes[lane].head = node->next;
+      if (!m_lanes[lane].head)
+        m_lanes[lane].tail = NULL;
+      FreeNode(node);
+      m_count--;
 
       ret = MSGQ_OK;
       break;
@@ -230,10 +296,13 @@ unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
     return 0;
 
   unsigned count = 0;
-  for(SList::iterator it = m_list.begin(); it != m_list.end();it++)
+  for (int i = 0; i < MSGQ_PRIORITIES; i++)
   {
-    if(it->message->IsType(type))
-      count++;
+    for (SNode* node = m_lanes[i].head; node; node = node->next)
+    {
+      if(node->message->IsType(type))
+        count++;
+    }
   }
 
   return count;
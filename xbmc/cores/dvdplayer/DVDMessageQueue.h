@@ -23,6 +23,7 @@
 #include "DVDMessage.h"
 #include <string>
 #include <list>
+#include <vector>
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
 
@@ -80,6 +81,9 @@ enum MsgQueueReturnCode
 
 #define MSGQ_IS_ERROR(c)    (c < 0)
 
+// priorities are clamped to 0 .. MSGQ_PRIORITIES - 1
+#define MSGQ_PRIORITIES     4
+
 class CDVDMessageQueue
 {
 public:
@@ -140,7 +144,29 @@ private:
   bool m_bEmptied;
   std::string m_owner;
 
-  typedef std::list<DVDMessageListItem> SList;
-  SList m_list;
+  struct SNode
+  {
+    CDVDMsg* message;
+    SNode*   next;
+  };
+
+  // messages of the same priority are kept in one fifo lane, so both
+  // Put and Get are constant time regardless of the queue length
+  struct SLane
+  {
+    SNode*   head;
+    SNode*   tail;
+  };
+
+  SNode* AllocNode();
+  void   FreeNode(SNode* node);
+
+  SLane m_lanes[MSGQ_PRIORITIES];
+  unsigned int m_count;
+
+  // nodes are recycled through a free list, blocks are only released
+  // when the queue is destroyed
+  SNode* m_free;
+  std::vector<SNode*> m_blocks;
 };
 
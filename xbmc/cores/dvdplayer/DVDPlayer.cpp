@@ -1953,6 +1953,11 @@ void CDVDPlayer::OnExit()
     }
     m_pDemuxer = NULL;
 
+    DemuxPacketStats stats = CDVDDemuxUtils::GetStats();
+    CLog::Log(LOGDEBUG, "CDVDPlayer::OnExit() demux packet pool: %"PRIu64" of %"PRIu64" allocations reused, "
+                        "%"PRIu64" packets (%"PRIu64" bytes) not copied",
+                        stats.poolHits, stats.allocations, stats.zeroCopy, stats.bytesNotCopied);
+
     if (m_pSubtitleDemuxer)
     {
       CLog::Log(LOGNOTICE, "CDVDPlayer::OnExit() deleting subtitle demuxer");
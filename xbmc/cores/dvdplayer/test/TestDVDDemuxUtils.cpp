@@ -0,0 +1,114 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#endif
+#include "cores/dvdplayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "cores/dvdplayer/DVDClock.h"
+
+#include <stdlib.h>
+#include <string.h>
+extern "C" {
+#if (defined USE_EXTERNAL_FFMPEG)
+  #if (defined HAVE_LIBAVCODEC_AVCODEC_H)
+    #include <libavcodec/avcodec.h>
+  #else
+    #include <ffmpeg/avcodec.h>
+  #endif
+#else
+  #include "libavcodec/avcodec.h"
+#endif
+}
+
+#include "gtest/gtest.h"
+
+TEST(TestDVDDemuxUtils, AllocateDemuxPacket)
+{
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(1000);
+  ASSERT_TRUE(packet != NULL);
+  ASSERT_TRUE(packet->pData != NULL);
+  EXPECT_EQ(DVD_NOPTS_VALUE, packet->pts);
+  EXPECT_EQ(DVD_NOPTS_VALUE, packet->dts);
+  EXPECT_EQ(-1, packet->iStreamId);
+  memset(packet->pData, 0xff, 1000);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  packet = CDVDDemuxUtils::AllocateDemuxPacket(0);
+  ASSERT_TRUE(packet != NULL);
+  EXPECT_TRUE(packet->pData == NULL);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+}
+
+TEST(TestDVDDemuxUtils, PoolReuse)
+{
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(3000);
+  memset(packet->pData, 0xff, 3000);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  // a smaller packet of the same size class gets the recycled payload,
+  // with its padding cleared again
+  DemuxPacketStats before = CDVDDemuxUtils::GetStats();
+  packet = CDVDDemuxUtils::AllocateDemuxPacket(2500);
+  DemuxPacketStats after = CDVDDemuxUtils::GetStats();
+  ASSERT_TRUE(packet != NULL);
+  EXPECT_EQ(before.allocations + 1, after.allocations);
+  EXPECT_EQ(before.poolHits + 1, after.poolHits);
+  EXPECT_EQ(0, packet->pData[2500]);
+  EXPECT_EQ(0, packet->pData[2507]);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+}
+
+static void FreeTestPacket(AVPacket *pkt)
+{
+  free(pkt->data);
+  pkt->data = NULL;
+  pkt->size = 0;
+}
+
+static DemuxPacket* WrapTestPacket(int size, bool copied)
+{
+  AVPacket pkt;
+  memset(&pkt, 0, sizeof(pkt));
+  pkt.data     = (uint8_t*)calloc(1, size + FF_INPUT_BUFFER_PADDING_SIZE);
+  pkt.size     = size;
+  pkt.destruct = FreeTestPacket;
+  return CDVDDemuxUtils::AllocateDemuxPacket(&pkt, copied);
+}
+
+TEST(TestDVDDemuxUtils, ZeroCopyStats)
+{
+  DemuxPacketStats before = CDVDDemuxUtils::GetStats();
+  DemuxPacket* packet = WrapTestPacket(1000, false);
+  DemuxPacketStats after = CDVDDemuxUtils::GetStats();
+  ASSERT_TRUE(packet != NULL);
+  EXPECT_EQ(before.zeroCopy + 1, after.zeroCopy);
+  EXPECT_EQ(before.bytesNotCopied + 1000, after.bytesNotCopied);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  // a payload av_dup_packet had to copy first is no zero copy
+  before = CDVDDemuxUtils::GetStats();
+  packet = WrapTestPacket(1000, true);
+  after = CDVDDemuxUtils::GetStats();
+  ASSERT_TRUE(packet != NULL);
+  EXPECT_EQ(before.zeroCopy, after.zeroCopy);
+  EXPECT_EQ(before.bytesNotCopied, after.bytesNotCopied);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+}
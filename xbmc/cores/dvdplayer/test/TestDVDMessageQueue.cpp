@@ -0,0 +1,163 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDMessageQueue.h"
+#include "cores/dvdplayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "cores/dvdplayer/DVDClock.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+#define PACKETSIZE  1024
+#define MESSAGES    200000
+
+static CDVDMsg* CreatePacket(int size, double pts)
+{
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(size);
+  packet->iSize = size;
+  packet->pts   = pts;
+  packet->dts   = pts;
+  return new CDVDMsgDemuxerPacket(packet);
+}
+
+TEST(TestDVDMessageQueue, PriorityOrder)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC), 0);
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESET), 0);
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_FLUSH), 1);
+
+  // higher priorities first, fifo within the same priority
+  CDVDMsg::Message expected[] = { CDVDMsg::GENERAL_FLUSH, CDVDMsg::GENERAL_RESYNC, CDVDMsg::GENERAL_RESET };
+  int priorities[] = { 1, 0, 0 };
+  for (unsigned int i = 0; i < 3; i++)
+  {
+    CDVDMsg* msg = NULL;
+    int priority = 0;
+    ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0, priority));
+    EXPECT_TRUE(msg->IsType(expected[i]));
+    EXPECT_EQ(priorities[i], priority);
+    msg->Release();
+  }
+
+  // only messages of at least the requested priority are returned
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC), 0);
+  CDVDMsg* msg = NULL;
+  int priority = 1;
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 0, priority));
+  EXPECT_EQ(1U, queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, FlushAndAccounting)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  for (int i = 0; i < 10; i++)
+    queue.Put(CreatePacket(PACKETSIZE, i * DVD_TIME_BASE));
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC));
+
+  EXPECT_EQ(10 * PACKETSIZE, queue.GetDataSize());
+  EXPECT_EQ(9, queue.GetTimeSize());
+  EXPECT_EQ(10U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+
+  // flushing packets keeps other messages around
+  queue.Flush();
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(1U, queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+
+  // and the lane is still usable after removing from its middle
+  queue.Put(CreatePacket(PACKETSIZE, 0));
+  CDVDMsg* msg = NULL;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+  EXPECT_TRUE(msg->IsType(CDVDMsg::GENERAL_RESYNC));
+  msg->Release();
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+  EXPECT_TRUE(msg->IsType(CDVDMsg::DEMUXER_PACKET));
+  msg->Release();
+  EXPECT_EQ(0, queue.GetDataSize());
+
+  queue.End();
+}
+
+class CPacketProducer : public CThread
+{
+public:
+  CPacketProducer(CDVDMessageQueue &queue) : CThread("TestDVDMessageQueueProducer"), m_queue(queue) { }
+
+protected:
+  virtual void Process()
+  {
+    for (int i = 0; i < MESSAGES && !m_bStop; i++)
+    {
+      // keep the queue at a realistic level of a few thousand packets
+      while (m_queue.GetDataSize() > 4000 * PACKETSIZE && !m_bStop)
+        Sleep(0);
+
+      m_queue.Put(CreatePacket(PACKETSIZE, i));
+      if (i % 1000 == 0)
+        m_queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC), 1);
+    }
+  }
+
+  CDVDMessageQueue &m_queue;
+};
+
+TEST(TestDVDMessageQueue, ProducerConsumerBenchmark)
+{
+  CDVDMessageQueue queue("test");
+  queue.SetMaxDataSize(8000 * PACKETSIZE);
+  queue.Init();
+
+  CPacketProducer producer(queue);
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  producer.Create();
+
+  unsigned int received = 0;
+  unsigned int packets = 0;
+  while (packets < MESSAGES)
+  {
+    CDVDMsg* msg = NULL;
+    if (queue.Get(&msg, 1000) != MSGQ_OK)
+      break;
+
+    if (msg->IsType(CDVDMsg::DEMUXER_PACKET))
+      packets++;
+    received++;
+    msg->Release();
+  }
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+  producer.StopThread(true);
+  EXPECT_EQ((unsigned int)MESSAGES, packets);
+  queue.End();
+
+  std::cout << "Messages: " << testing::PrintToString(received) << std::endl;
+  std::cout << "Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+  std::cout << "Messages/sec: " << testing::PrintToString(elapsed ? (uint64_t)received * 1000 / elapsed : 0) << std::endl;
+}
@@ -26,6 +26,7 @@
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include <math.h>
+#include <vector>
 
 CAudioDecoder::CAudioDecoder()
 {
@@ -35,6 +36,7 @@ CAudioDecoder::CAudioDecoder()
 
   m_status = STATUS_NO_FILE;
   m_canPlay = false;
+  m_shrinkSize = 0;
 }
 
 CAudioDecoder::~CAudioDecoder()
@@ -48,6 +50,7 @@ void CAudioDecoder::Destroy()
   m_status = STATUS_NO_FILE;
 
   m_pcmBuffer.Destroy();
+  m_shrinkSize = 0;
 
   if ( m_codec )
     delete m_codec;
@@ -56,7 +59,7 @@ void CAudioDecoder::Destroy()
   m_canPlay = false;
 }
 
-bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
+bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset, unsigned int bufferSeconds/* = 2 */, unsigned int maxBufferSize/* = 0 */)
 {
   Destroy();
 
@@ -92,8 +95,11 @@ bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
     return false;
   }
 
-  /* allocate the pcmBuffer for 2 seconds of audio */
-  m_pcmBuffer.Create(2 * blockSize * m_codec->m_SampleRate);
+  /* allocate the pcmBuffer for the requested seconds of audio, in whole frames */
+  unsigned int bufferSize = bufferSeconds * blockSize * m_codec->m_SampleRate;
+  if (maxBufferSize && bufferSize > maxBufferSize)
+    bufferSize = maxBufferSize - maxBufferSize % blockSize;
+  m_pcmBuffer.Create(bufferSize);
 
   // set total time from the given tag
   if (file.HasMusicInfoTag() && file.GetMusicInfoTag()->GetDuration())
@@ -107,6 +113,18 @@ bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
   return true;
 }
 
+void CAudioDecoder::ShrinkBuffer(unsigned int bufferSeconds)
+{
+  CSingleLock lock(m_critSection);
+  if (!m_codec)
+    return;
+
+  unsigned int blockSize = (m_codec->m_BitsPerSample >> 3) * m_codec->GetChannelInfo().Count();
+  unsigned int bufferSize = bufferSeconds * blockSize * m_codec->m_SampleRate;
+  if (bufferSize < m_pcmBuffer.getSize())
+    m_shrinkSize = bufferSize;
+}
+
 void CAudioDecoder::GetDataFormat(CAEChannelInfo *channelInfo, unsigned int *samplerate, unsigned int *encodedSampleRate, enum AEDataFormat *dataFormat)
 {
   if (!m_codec)
@@ -184,8 +202,29 @@ int CAudioDecoder::ReadSamples(int numsamples)
   // grab a lock to ensure the codec is created at this point.
   CSingleLock lock(m_critSection);
 
+  unsigned int writeSize = m_pcmBuffer.getMaxWriteSize();
+  if (m_shrinkSize)
+  {
+    // don't refill the large buffer, move to the smaller one once its content fits
+    unsigned int readSize = m_pcmBuffer.getMaxReadSize();
+    if (readSize <= m_shrinkSize)
+    {
+      std::vector<char> data(readSize);
+      if (readSize)
+        m_pcmBuffer.ReadData(&data[0], readSize);
+      m_pcmBuffer.Destroy();
+      m_pcmBuffer.Create(m_shrinkSize);
+      if (readSize)
+        m_pcmBuffer.WriteData(&data[0], readSize);
+      m_shrinkSize = 0;
+      writeSize = m_pcmBuffer.getMaxWriteSize();
+    }
+    else
+      writeSize = 0;
+  }
+
   // Read in more data
-  int maxsize = std::min<int>(INPUT_SAMPLES, m_pcmBuffer.getMaxWriteSize() / (m_codec->m_BitsPerSample >> 3));
+  int maxsize = std::min<int>(INPUT_SAMPLES, writeSize / (m_codec->m_BitsPerSample >> 3));
   numsamples = std::min<int>(numsamples, maxsize);
   numsamples -= (numsamples % m_codec->GetChannelInfo().Count());  // make sure it's divisible by our number of channels
   if ( numsamples )
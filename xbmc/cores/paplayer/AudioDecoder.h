@@ -56,9 +56,20 @@ public:
   CAudioDecoder();
   ~CAudioDecoder();
 
-  bool Create(const CFileItem &file, int64_t seekOffset);
+  /*! \brief open the file and set up the pcm buffer
+   \param file the file to decode
+   \param seekOffset where to start decoding, in ms
+   \param bufferSeconds how many seconds of audio the pcm buffer holds
+   \param maxBufferSize upper limit for the pcm buffer in bytes, 0 for no limit
+   */
+  bool Create(const CFileItem &file, int64_t seekOffset, unsigned int bufferSeconds = 2, unsigned int maxBufferSize = 0);
   void Destroy();
 
+  /*! \brief go back to a smaller pcm buffer once the audio beyond its size is played
+   \param bufferSeconds how many seconds of audio the pcm buffer holds afterwards
+   */
+  void ShrinkBuffer(unsigned int bufferSeconds);
+
   int ReadSamples(int numsamples);
 
   bool CanSeek() { if (m_codec) return m_codec->CanSeek(); else return false; };
@@ -72,6 +83,7 @@ public:
   unsigned int GetChannels() { if (m_codec) return m_codec->GetChannelInfo().Count(); else return 0; };
   // Data management
   unsigned int GetDataSize();
+  unsigned int GetBufferSize() { return m_pcmBuffer.getSize(); };
   void *GetData(unsigned int samples);
   ICodec *GetCodec() const { return m_codec; }
   float GetReplayGain();
@@ -79,6 +91,7 @@ public:
 private:
   // pcm buffer
   CRingBuffer m_pcmBuffer;
+  unsigned int m_shrinkSize;  // size to reallocate the pcm buffer to once it holds no more, 0 for none
 
   // output buffer (for transferring data from the Pcm Buffer to the rest of the audio chain)
   float m_outputBuffer[OUTPUT_SAMPLES];
@@ -21,15 +21,20 @@
 #include "PAPlayer.h"
 #include "CodecFactory.h"
 #include "FileItem.h"
+#include "PlayListPlayer.h"
+#include "playlists/PlayList.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/GUISettings.h"
 #include "settings/Settings.h"
 #include "music/tags/MusicInfoTag.h"
 #include "utils/TimeUtils.h"
+#include "utils/JobManager.h"
+#include "utils/URIUtils.h"
 #include "utils/log.h"
 #include "utils/MathUtils.h"
 
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "cores/AudioEngine/AEFactory.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #include "cores/AudioEngine/Interfaces/AEStream.h"
@@ -37,6 +42,10 @@
 #define TIME_TO_CACHE_NEXT_FILE 5000 /* 5 seconds before end of song, start caching the next song */
 #define FAST_XFADE_TIME           80 /* 80 milliseconds */
 #define MAX_SKIP_XFADE_TIME     2000 /* max 2 seconds crossfade on track skip */
+#define DECODER_BUFFER_SECONDS     2 /* seconds of audio a playing stream buffers */
+#define PREFETCH_MIN_SIZE     262144 /* don't prefetch into less than 256KB */
+
+using namespace PLAYLIST;
 
 CAEChannelInfo ICodec::GetChannelInfo()
 {
@@ -59,7 +68,11 @@ PAPlayer::PAPlayer(IPlayerCallback& callback) :
   m_upcomingCrossfadeMS(0),
   m_currentStream      (NULL ),
   m_audioCallback      (NULL ),
-  m_FileItem           (new CFileItem())
+  m_FileItem           (new CFileItem()),
+  m_prefetchHits       (0),
+  m_prefetchMisses     (0),
+  m_firstSampleMS      (0),
+  m_prefetchPrimeMS    (0)
 {
   memset(&m_playerGUIData, 0, sizeof(m_playerGUIData));
 }
@@ -72,6 +85,7 @@ PAPlayer::~PAPlayer()
 
   /* wait for the thread to terminate */
   StopThread(true);//true - wait for end of thread
+  ClearPrefetched();
   delete m_FileItem;
 }
 
@@ -291,36 +305,29 @@ bool PAPlayer::QueueNextFile(const CFileItem &file)
 
 bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */)
 {
-  StreamInfo *si = new StreamInfo();
+  unsigned int start = XbmcThreads::SystemClockMillis();
 
-  if (!si->m_decoder.Create(file, (file.m_lStartOffset * 1000) / 75))
+  /* use the stream primed in the background, or open it now */
+  StreamInfo *si = TakePrefetched(file);
+  if (si)
   {
-    CLog::Log(LOGWARNING, "PAPlayer::QueueNextFileEx - Failed to create the decoder");
-
-    delete si;
-    m_callback.OnQueueNextItem();
-    return false;
+    /* play out the primed audio, then go back to the buffer size of a stream opened here */
+    si->m_decoder.ShrinkBuffer(DECODER_BUFFER_SECONDS);
   }
-
-  /* decode until there is data-available */
-  si->m_decoder.Start();
-  while(si->m_decoder.GetDataSize() == 0)
+  else
   {
-    int status = si->m_decoder.GetStatus();
-    if (status == STATUS_ENDED   ||
-        status == STATUS_NO_FILE ||
-        si->m_decoder.ReadSamples(PACKET_SIZE) == RET_ERROR)
+    si = new StreamInfo();
+    if (!OpenDecoder(si->m_decoder, file, DECODER_BUFFER_SECONDS, 0, NULL))
     {
-      CLog::Log(LOGINFO, "PAPlayer::QueueNextFileEx - Error reading samples");
-
-      si->m_decoder.Destroy();
       delete si;
       m_callback.OnQueueNextItem();
       return false;
     }
+  }
 
-    /* yield our time so that the main PAP thread doesnt stall */
-    CThread::Sleep(1);
+  {
+    CSingleLock lock(m_prefetchSection);
+    m_firstSampleMS = XbmcThreads::SystemClockMillis() - start;
   }
 
   UpdateCrossfadeTime(file);
@@ -365,16 +372,302 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */)
   }
 
   /* add the stream to the list */
-  CExclusiveLock lock(m_streamsLock);
-  m_streams.push_back(si);
-  //update the current stream to start playing the next track at the correct frame.
-  UpdateStreamInfoPlayNextAtFrame(m_currentStream, m_upcomingCrossfadeMS);
+  {
+    CExclusiveLock lock(m_streamsLock);
+    m_streams.push_back(si);
+    //update the current stream to start playing the next track at the correct frame.
+    UpdateStreamInfoPlayNextAtFrame(m_currentStream, m_upcomingCrossfadeMS);
+
+    *m_FileItem = file;
+  }
+
+  /* get the files after this one ready while it plays */
+  PrefetchUpcoming(file);
+
+  return true;
+}
+
+bool PAPlayer::OpenDecoder(CAudioDecoder &decoder, const CFileItem &file, unsigned int bufferSeconds, unsigned int maxBufferSize, const CJob *job)
+{
+  if (!decoder.Create(file, (file.m_lStartOffset * 1000) / 75, bufferSeconds, maxBufferSize))
+  {
+    CLog::Log(LOGWARNING, "PAPlayer::OpenDecoder - Failed to create the decoder");
+    return false;
+  }
+
+  /*
+    decode until there is data available, the player is waiting on it. background
+    jobs keep decoding until the buffer is full, as the more they have ready the
+    less the share has to keep up
+  */
+  decoder.Start();
+  while (job || decoder.GetDataSize() == 0)
+  {
+    int status = decoder.GetStatus();
+    if (status == STATUS_ENDED || status == STATUS_NO_FILE)
+      break;
+
+    int result = decoder.ReadSamples(PACKET_SIZE);
+    if (result == RET_ERROR)
+    {
+      CLog::Log(LOGINFO, "PAPlayer::OpenDecoder - Error reading samples");
+
+      decoder.Destroy();
+      return false;
+    }
+
+    /* the whole file is decoded or the buffer is full */
+    if (status != STATUS_QUEUING && result != RET_SUCCESS)
+      break;
+
+    if (job)
+    {
+      /* background jobs decode flat out until they are no longer wanted */
+      if (job->ShouldCancel(0, 0))
+      {
+        decoder.Destroy();
+        return false;
+      }
+    }
+    else
+    {
+      /* yield our time so that the main PAP thread doesnt stall */
+      XbmcThreads::ThreadSleep(1);
+    }
+  }
 
-  *m_FileItem = file;
+  /* files that ended before anything was decoded */
+  if (decoder.GetDataSize() == 0)
+  {
+    CLog::Log(LOGINFO, "PAPlayer::OpenDecoder - Error reading samples");
+
+    decoder.Destroy();
+    return false;
+  }
 
   return true;
 }
 
+class PAPlayer::CPrefetchJob : public CJob
+{
+public:
+  CPrefetchJob(const CFileItem &file, unsigned int bufferSeconds, unsigned int maxBufferSize) :
+    m_file         (file),
+    m_bufferSeconds(bufferSeconds),
+    m_maxBufferSize(maxBufferSize),
+    m_stream       (NULL),
+    m_primeMS      (0)
+  {
+  }
+
+  virtual ~CPrefetchJob()
+  {
+    /* left over if the job failed or was cancelled */
+    delete m_stream;
+  }
+
+  virtual const char *GetType() const { return "paplayerprefetch"; }
+
+  virtual bool DoWork()
+  {
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    m_stream = new StreamInfo();
+    if (!OpenDecoder(m_stream->m_decoder, m_file, m_bufferSeconds, m_maxBufferSize, this))
+    {
+      CLog::Log(LOGDEBUG, "PAPlayer::CPrefetchJob - Unable to prefetch %s", m_file.GetPath().c_str());
+      delete m_stream;
+      m_stream = NULL;
+      return false;
+    }
+    m_primeMS = XbmcThreads::SystemClockMillis() - start;
+    return true;
+  }
+
+  CFileItem    m_file;
+  unsigned int m_bufferSeconds;
+  unsigned int m_maxBufferSize;
+  StreamInfo*  m_stream;
+  unsigned int m_primeMS;
+};
+
+PAPlayer::StreamInfo* PAPlayer::TakePrefetched(const CFileItem &file)
+{
+  if (g_advancedSettings.m_audioPrefetchTracks <= 0)
+    return NULL;
+
+  CSingleLock lock(m_prefetchSection);
+  for (PrefetchList::iterator itt = m_prefetched.begin(); itt != m_prefetched.end(); ++itt)
+  {
+    if (itt->m_path != file.GetPath() || itt->m_startOffset != file.m_lStartOffset)
+      continue;
+
+    /*
+      we're called on the GUI thread, so a job that is still underway isn't
+      waited for. the file is opened here instead, which only decodes up to
+      the first data
+    */
+    if (itt->m_jobID)
+      CJobManager::GetInstance().CancelJob(itt->m_jobID);
+
+    StreamInfo *si = itt->m_stream;
+    m_prefetched.erase(itt);
+
+    if (si)
+      m_prefetchHits++;
+    else
+      m_prefetchMisses++;
+    return si;
+  }
+
+  m_prefetchMisses++;
+  return NULL;
+}
+
+void PAPlayer::PrefetchUpcoming(const CFileItem &file)
+{
+  int tracks = g_advancedSettings.m_audioPrefetchTracks;
+
+  /* find the file in the music playlist, it is either playing or queued to play next */
+  std::vector<CFileItemPtr> upcoming;
+  if (tracks > 0 && g_playlistPlayer.GetCurrentPlaylist() == PLAYLIST_MUSIC)
+  {
+    const CPlayList &playlist = g_playlistPlayer.GetPlaylist(PLAYLIST_MUSIC);
+    int offset = -1;
+    for (int i = 0; i <= 1 && offset < 0; i++)
+    {
+      int song = g_playlistPlayer.GetNextSong(i);
+      if (song >= 0 && song < playlist.size() &&
+          playlist[song]->GetPath() == file.GetPath() && playlist[song]->m_lStartOffset == file.m_lStartOffset)
+        offset = i;
+    }
+
+    for (int i = 1; offset >= 0 && i <= tracks; i++)
+    {
+      int song = g_playlistPlayer.GetNextSong(offset + i);
+      if (song < 0 || song >= playlist.size())
+        break;
+
+      /* streams and items that still need resolving are opened as they come */
+      CFileItemPtr item = playlist[song];
+      if (item->IsInternetStream() || item->IsPlugin() || URIUtils::IsUPnP(item->GetPath()))
+        break;
+      upcoming.push_back(item);
+    }
+  }
+
+  CSingleLock lock(m_prefetchSection);
+
+  /* drop what is no longer coming up, and see how much memory the rest holds */
+  unsigned int used = 0;
+  for (PrefetchList::iterator itt = m_prefetched.begin(); itt != m_prefetched.end();)
+  {
+    bool wanted = false;
+    for (unsigned int i = 0; i < upcoming.size() && !wanted; i++)
+      wanted = itt->m_path == upcoming[i]->GetPath() && itt->m_startOffset == upcoming[i]->m_lStartOffset;
+
+    if (wanted)
+    {
+      used += itt->m_size;
+      ++itt;
+      continue;
+    }
+
+    if (itt->m_jobID)
+      CJobManager::GetInstance().CancelJob(itt->m_jobID);
+    delete itt->m_stream;
+    itt = m_prefetched.erase(itt);
+  }
+
+  /* start jobs for the new ones, splitting the budget between them */
+  unsigned int budget = g_advancedSettings.m_audioPrefetchSize;
+  for (unsigned int i = 0; i < upcoming.size(); i++)
+  {
+    bool queued = false;
+    for (PrefetchList::iterator itt = m_prefetched.begin(); itt != m_prefetched.end() && !queued; ++itt)
+      queued = itt->m_path == upcoming[i]->GetPath() && itt->m_startOffset == upcoming[i]->m_lStartOffset;
+    if (queued)
+      continue;
+
+    unsigned int size = std::min(budget - std::min(used, budget), budget / tracks);
+    if (size < PREFETCH_MIN_SIZE)
+      break;
+
+    PrefetchInfo info;
+    info.m_path        = upcoming[i]->GetPath();
+    info.m_startOffset = upcoming[i]->m_lStartOffset;
+    info.m_stream      = NULL;
+    info.m_size        = size;
+    info.m_jobID       = CJobManager::GetInstance().AddJob(new CPrefetchJob(*upcoming[i], g_advancedSettings.m_audioPrefetchSeconds, size), this, CJob::PRIORITY_HIGH);
+    if (!info.m_jobID)
+      break;
+
+    m_prefetched.push_back(info);
+    used += size;
+  }
+}
+
+void PAPlayer::ClearPrefetched()
+{
+  CSingleLock lock(m_prefetchSection);
+  while (!m_prefetched.empty())
+  {
+    PrefetchInfo &info = m_prefetched.front();
+    if (info.m_jobID)
+      CJobManager::GetInstance().CancelJob(info.m_jobID);
+    delete info.m_stream;
+    m_prefetched.pop_front();
+  }
+}
+
+void PAPlayer::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+{
+  CPrefetchJob *prefetch = (CPrefetchJob*)job;
+
+  CSingleLock lock(m_prefetchSection);
+  for (PrefetchList::iterator itt = m_prefetched.begin(); itt != m_prefetched.end(); ++itt)
+  {
+    if (itt->m_jobID != jobID)
+      continue;
+
+    /* take over the primed stream, it now holds what was set aside for it */
+    itt->m_jobID = 0;
+    if (success)
+    {
+      itt->m_stream = prefetch->m_stream;
+      itt->m_size   = itt->m_stream->m_decoder.GetBufferSize();
+      prefetch->m_stream = NULL;
+      m_prefetchPrimeMS = prefetch->m_primeMS;
+    }
+    else
+      itt->m_size = 0;
+    break;
+  }
+}
+
+void PAPlayer::GetGeneralInfo(CStdString& strGeneralInfo)
+{
+  CSingleLock lock(m_prefetchSection);
+  unsigned int queued = m_prefetchHits + m_prefetchMisses;
+  unsigned int ready = 0, size = 0;
+  for (PrefetchList::const_iterator itt = m_prefetched.begin(); itt != m_prefetched.end(); ++itt)
+  {
+    if (itt->m_stream)
+      ready++;
+    size += itt->m_size;
+  }
+
+  strGeneralInfo.Format("P( prefetch hits:%u/%u %.0f%%, first sample:%ums primed in:%ums, ready:%u/%u %uKB/%uKB )"
+                       , m_prefetchHits
+                       , queued
+                       , queued ? m_prefetchHits * 100.0f / queued : 0.0f
+                       , m_firstSampleMS
+                       , m_prefetchPrimeMS
+                       , ready
+                       , (unsigned int)m_prefetched.size()
+                       , size / 1024
+                       , g_advancedSettings.m_audioPrefetchSize / 1024);
+}
+
 void PAPlayer::UpdateStreamInfoPlayNextAtFrame(StreamInfo *si, unsigned int crossFadingTime)
 {
   if (si)
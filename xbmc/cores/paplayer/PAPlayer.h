@@ -26,6 +26,8 @@
 #include "threads/Thread.h"
 #include "AudioDecoder.h"
 #include "threads/SharedSection.h"
+#include "threads/CriticalSection.h"
+#include "utils/Job.h"
 
 #include "cores/IAudioCallback.h"
 #include "cores/AudioEngine/Utils/AEChannelInfo.h"
@@ -33,7 +35,7 @@
 class IAEStream;
 
 class CFileItem;
-class PAPlayer : public IPlayer, public CThread
+class PAPlayer : public IPlayer, public CThread, public IJobCallback
 {
 public:
   PAPlayer(IPlayerCallback& callback);
@@ -58,7 +60,7 @@ public:
   virtual void SetDynamicRangeCompression(long drc);
   virtual void GetAudioInfo( CStdString& strAudioInfo) {}
   virtual void GetVideoInfo( CStdString& strVideoInfo) {}
-  virtual void GetGeneralInfo( CStdString& strVideoInfo) {}
+  virtual void GetGeneralInfo( CStdString& strGeneralInfo);
   virtual void Update(bool bPauseDrawing = false) {}
   virtual void ToFFRW(int iSpeed = 0);
   virtual int GetCacheLevel() const;
@@ -74,6 +76,8 @@ public:
 
   static bool HandlesType(const CStdString &type);
 
+  virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job);
+
   struct
   {
     char         m_codec[21];
@@ -123,6 +127,18 @@ private:
 
   typedef std::list<StreamInfo*> StreamList;
 
+  class CPrefetchJob;
+
+  typedef struct {
+    CStdString        m_path;                /* the file being prefetched */
+    int64_t           m_startOffset;         /* where playback of the file starts */
+    unsigned int      m_jobID;               /* the job priming the stream, 0 once it is done */
+    StreamInfo*       m_stream;              /* the primed stream, NULL while the job runs or if it failed */
+    unsigned int      m_size;                /* memory set aside for the decoded audio */
+  } PrefetchInfo;
+
+  typedef std::list<PrefetchInfo> PrefetchList;
+
   bool                m_signalSpeedChange;   /* true if OnPlaybackSpeedChange needs to be called */
   int                 m_playbackSpeed;       /* the playback speed (1 = normal) */
   bool                m_isPlaying;
@@ -140,7 +156,18 @@ private:
   StreamList          m_streams;             /* playing streams */  
   StreamList          m_finishing;           /* finishing streams */
 
+  CCriticalSection    m_prefetchSection;     /* lock for the prefetch list and stats */
+  PrefetchList        m_prefetched;          /* upcoming files being primed in the background */
+  unsigned int        m_prefetchHits;        /* queued files that were primed already */
+  unsigned int        m_prefetchMisses;      /* queued files that had to be opened on the spot */
+  unsigned int        m_firstSampleMS;       /* time to the first sample of the last queued file */
+  unsigned int        m_prefetchPrimeMS;     /* time the last prefetch job took to fill its buffer */
+
   bool QueueNextFileEx(const CFileItem &file, bool fadeIn = true);
+  static bool OpenDecoder(CAudioDecoder &decoder, const CFileItem &file, unsigned int bufferSeconds, unsigned int maxBufferSize, const CJob *job);
+  StreamInfo* TakePrefetched(const CFileItem &file);
+  void PrefetchUpcoming(const CFileItem &file);
+  void ClearPrefetched();
   void SoftStart(bool wait = false);
   void SoftStop(bool wait = false, bool close = true);
   void CloseAllStreams(bool fade = true);
@@ -181,7 +181,9 @@ std::string CDatabase::GetSingleValue(const std::string &query, std::auto_ptr<Da
     if (!m_pDB.get() || !ds.get())
       return ret;
 
-    if (ds->query(query.c_str()) && ds->num_rows() > 0)
+    // only the first row is needed, so there's no point fetching the rest
+    ds->set_forward_only(true);
+    if (ds->query(query.c_str()) && !ds->eof())
       ret = ds->fv(0).get_asString();
 
     ds->close();
@@ -190,6 +192,29 @@ std::string CDatabase::GetSingleValue(const std::string &query, std::auto_ptr<Da
   {
     CLog::Log(LOGERROR, "%s - failed on query '%s'", __FUNCTION__, query.c_str());
   }
+  ds->set_forward_only(false);
+  return ret;
+}
+
+std::string CDatabase::GetSingleValue(const std::string &query, const ParamList &params, std::auto_ptr<Dataset> &ds)
+{
+  std::string ret;
+  try
+  {
+    if (!m_pDB.get() || !ds.get())
+      return ret;
+
+    ds->set_forward_only(true);
+    if (ds->query(query, params) && !ds->eof())
+      ret = ds->fv(0).get_asString();
+
+    ds->close();
+  }
+  catch(...)
+  {
+    CLog::Log(LOGERROR, "%s - failed on query '%s'", __FUNCTION__, query.c_str());
+  }
+  ds->set_forward_only(false);
   return ret;
 }
 
@@ -22,9 +22,14 @@
 
 #include "utils/StdString.h"
 
+#include <map>
+#include <string>
+
 namespace dbiplus {
   class Database;
   class Dataset;
+  class field_value;
+  typedef std::map<std::string, field_value> ParamList;
 }
 
 #include <memory>
@@ -93,6 +98,14 @@ public:
    */
   std::string GetSingleValue(const std::string &query, std::auto_ptr<dbiplus::Dataset> &ds);
 
+  /*! \brief Get a single value from a query with bound parameters on a dataset.
+   \param query the query in question, with its parameters named as :name.
+   \param params the values of the parameters.
+   \param ds the dataset to use for the query.
+   \return the value from the query, empty on failure.
+   */
+  std::string GetSingleValue(const std::string &query, const dbiplus::ParamList &params, std::auto_ptr<dbiplus::Dataset> &ds);
+
   /*!
    * @brief Delete values from a table.
    * @remarks The value of the strWhereClause parameter has to be FormatSQL'ed when used.
@@ -29,6 +29,7 @@
 #include "dataset.h"
 #include "utils/log.h"
 #include <cstring>
+#include <cctype>
 
 #ifndef __GNUC__
 #pragma warning (disable:4800)
@@ -84,6 +85,7 @@ Dataset::Dataset() {
   frecno = 0;
   fbof = feof = true;
   autocommit = true;
+  forward_only = false;
 
   select_sql = "";
 
@@ -101,6 +103,7 @@ Dataset::Dataset(Database *newDb) {
   frecno = 0;
   fbof = feof = true;
   autocommit = true;
+  forward_only = false;
 
   select_sql = "";
 
@@ -357,8 +360,78 @@ const field_value Dataset::get_field_value(int index) {
   //return fv;
 }
 
+bool Dataset::query(const std::string &sql, const ParamList &params) {
+  // databases without native binding get the values substituted as escaped literals
+  if (!db)
+    throw DbErrors("No Database Connection");
+
+  string q;
+  q.reserve(sql.size());
+  char quote = 0;
+  for (size_t i = 0; i < sql.size(); i++)
+  {
+    const char c = sql[i];
+    if (quote)
+    {
+      if (c == quote)
+        quote = 0;
+    }
+    else if (c == '\'' || c == '"')
+      quote = c;
+    else if (c == ':' && i + 1 < sql.size() && (isalnum((unsigned char)sql[i + 1]) || sql[i + 1] == '_'))
+    {
+      size_t end = i + 1;
+      while (end < sql.size() && (isalnum((unsigned char)sql[end]) || sql[end] == '_'))
+        end++;
+      string name = sql.substr(i + 1, end - i - 1);
+      ParamList::const_iterator param = params.find(name);
+      if (param == params.end())
+        param = params.find(":" + name);
+      if (param == params.end())
+        throw DbErrors("Unknown query parameter: :%s", name.c_str());
+
+      const field_value &v = param->second;
+      if (v.get_isNull())
+        q += "NULL";
+      else switch (v.get_fType())
+      {
+      case ft_Boolean:
+        q += v.get_asBool() ? "1" : "0";
+        break;
+      case ft_Short:
+      case ft_UShort:
+      case ft_Int:
+      case ft_UInt:
+      case ft_Int64:
+      case ft_Float:
+      case ft_Double:
+      case ft_LongDouble:
+        q += v.get_asString();
+        break;
+      default:
+        q += db->prepare("'%s'", v.get_asString().c_str());
+        break;
+      }
+      i = end - 1;
+      continue;
+    }
+    q += c;
+  }
+  return query(q.c_str());
+}
+
 const sql_record* const Dataset::get_sql_record()
 {
+  if (forward_only && ds_state == dsSelect)
+  { // the current row only lives in the fields object
+    if (feof)
+      return NULL;
+    stream_record.resize(fields_object->size());
+    for (unsigned int i = 0; i < fields_object->size(); i++)
+      stream_record[i] = (*fields_object)[i].val;
+    return &stream_record;
+  }
+
   if (result.records.size() == 0 || frecno >= (int)result.records.size())
     return NULL;
 
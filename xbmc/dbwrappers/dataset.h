@@ -199,6 +199,8 @@ protected:
   ParamList plist;              // Paramlist for locate
   bool fbof, feof;
   bool autocommit;		// for transactions
+  bool forward_only;		// stream rows from the server rather than fetching them all on query
+  sql_record stream_record;	// copy of the current row handed out by get_sql_record() in forward-only mode
 
 
 /* Variables to store SQL statements */
@@ -296,6 +298,8 @@ public:
   virtual const void* getExecRes()=0;
 /* as open, but with our query exept Sql */
   virtual bool query(const char *sql) = 0;
+/* as query, binding the named parameters (:name) of the statement to the given values */
+  virtual bool query(const std::string &sql, const ParamList &params);
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
@@ -384,6 +388,16 @@ public:
   void set_autocommit(bool v) { autocommit = v; }
   bool get_autocommit() { return autocommit; }
 
+/* ------------ for streaming --------------------- */
+/* In forward-only mode rows may be read from the server one at a time as the dataset
+   is advanced with next(), so the whole result is never held in memory. Only first(),
+   next() and eof() may be used to navigate, num_rows() counts the rows read so far,
+   get_result_set() isn't available and get_sql_record() returns a copy of the current
+   row that is only valid until next() is called. Databases that can't stream simply
+   fetch the whole result as usual. */
+  void set_forward_only(bool v) { forward_only = v; }
+  bool get_forward_only() { return forward_only; }
+
 /* ----------------- for debug -------------------- */
   Fields *get_fields_object() {return fields_object;};
   Fields *get_edit_object() {return edit_object;};
@@ -79,6 +79,30 @@ int callback(void* res_ptr,int ncol, char** reslt,char** cols)
   return 0;  
 }
 
+static void column_value(sqlite3_stmt *stmt, int i, field_value &v)
+{
+  switch (sqlite3_column_type(stmt, i))
+  {
+  case SQLITE_INTEGER:
+    v.set_asInt64(sqlite3_column_int64(stmt, i));
+    break;
+  case SQLITE_FLOAT:
+    v.set_asDouble(sqlite3_column_double(stmt, i));
+    break;
+  case SQLITE_TEXT:
+    v.set_asString((const char *)sqlite3_column_text(stmt, i));
+    break;
+  case SQLITE_BLOB:
+    v.set_asString((const char *)sqlite3_column_text(stmt, i));
+    break;
+  case SQLITE_NULL:
+  default:
+    v.set_asString("");
+    v.set_isNull();
+    break;
+  }
+}
+
 static int busy_callback(void*, int busyCount)
 {
 	Sleep(100);
@@ -99,6 +123,7 @@ SqliteDatabase::SqliteDatabase() {
   db = "sqlite.db";
   login = "root";
   passwd = "";
+  statement_cache_size = 32;
 }
 
 SqliteDatabase::~SqliteDatabase() {
@@ -260,6 +285,10 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
+  // statements of unfinished forward-only queries would keep the connection busy
+  while (!streams.empty())
+    (*streams.begin())->release_stream();
+  clearStatements();
   sqlite3_close(conn);
   active = false;
 }
@@ -405,6 +434,85 @@ string SqliteDatabase::vprepare(const char *format, va_list args)
 }
 
 
+// methods for the prepared statement cache
+// ---------------------------------------------
+sqlite3_stmt *SqliteDatabase::acquireStatement(const char *query)
+{
+  StatementIndex::iterator i = statement_index.find(query);
+  if (i != statement_index.end())
+  {
+    // take it out of the cache while it's in use, so nobody else can step it
+    sqlite3_stmt *stmt = i->second->second;
+    statements.erase(i->second);
+    statement_index.erase(i);
+    return stmt;
+  }
+
+  sqlite3_stmt *stmt = NULL;
+  if (setErr(sqlite3_prepare_v2(conn, query, -1, &stmt, NULL), query) != SQLITE_OK)
+    throw DbErrors(getErrorMsg());
+  return stmt;
+}
+
+void SqliteDatabase::releaseStatement(const char *query, sqlite3_stmt *stmt)
+{
+  if (!stmt)
+    return;
+
+  // the result of the last step has already been checked by the caller
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+
+  // drop it if we're not caching, or the same query is already cached
+  if (!active || statement_cache_size == 0 ||
+      statement_index.find(query) != statement_index.end())
+  {
+    sqlite3_finalize(stmt);
+    return;
+  }
+
+  statements.push_front(make_pair(string(query), stmt));
+  statement_index[query] = statements.begin();
+
+  // evict the least recently used statement
+  if (statements.size() > statement_cache_size)
+  {
+    sqlite3_finalize(statements.back().second);
+    statement_index.erase(statements.back().first);
+    statements.pop_back();
+  }
+}
+
+void SqliteDatabase::clearStatements()
+{
+  for (StatementList::iterator i = statements.begin(); i != statements.end(); ++i)
+    sqlite3_finalize(i->second);
+  statements.clear();
+  statement_index.clear();
+}
+
+void SqliteDatabase::addStream(SqliteDataset *ds)
+{
+  streams.insert(ds);
+}
+
+void SqliteDatabase::removeStream(SqliteDataset *ds)
+{
+  streams.erase(ds);
+}
+
+void SqliteDatabase::setStatementCacheSize(unsigned int size)
+{
+  statement_cache_size = size;
+  while (statements.size() > statement_cache_size)
+  {
+    sqlite3_finalize(statements.back().second);
+    statement_index.erase(statements.back().first);
+    statements.pop_back();
+  }
+}
+
+
 //************* SqliteDataset implementation ***************
 
 SqliteDataset::SqliteDataset():Dataset() {
@@ -412,6 +520,7 @@ SqliteDataset::SqliteDataset():Dataset() {
   db = NULL;
   errmsg = NULL;
   autorefresh = false;
+  stream_stmt = NULL;
 }
 
 
@@ -420,9 +529,11 @@ SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
   db = newDb;
   errmsg = NULL;
   autorefresh = false;
+  stream_stmt = NULL;
 }
 
  SqliteDataset::~SqliteDataset(){
+   release_stream();
    if (errmsg) sqlite3_free(errmsg);
  }
 
@@ -598,6 +709,18 @@ const void* SqliteDataset::getExecRes() {
 
 
 bool SqliteDataset::query(const char *query) {
+  return run_query(query, NULL);
+}
+
+bool SqliteDataset::query(const string &q){
+  return run_query(q.c_str(), NULL);
+}
+
+bool SqliteDataset::query(const string &q, const ParamList &params) {
+  return run_query(q.c_str(), &params);
+}
+
+bool SqliteDataset::run_query(const char *query, const ParamList *params) {
     if(!handle()) throw DbErrors("No Database Connection");
     std::string qry = query;
     int fs = qry.find("select");
@@ -607,9 +730,18 @@ bool SqliteDataset::query(const char *query) {
 
   close();
 
-  sqlite3_stmt *stmt = NULL;
-  if (db->setErr(sqlite3_prepare_v2(handle(),query,-1,&stmt, NULL),query) != SQLITE_OK)
-    throw DbErrors(db->getErrorMsg());
+  SqliteDatabase *sqlite = static_cast<SqliteDatabase*>(db);
+  sqlite3_stmt *stmt = sqlite->acquireStatement(query);
+  try
+  {
+    if (params)
+      bind_params(stmt, *params);
+  }
+  catch (...)
+  {
+    sqlite->releaseStatement(query, stmt);
+    throw;
+  }
 
   // column headers
   const unsigned int numColumns = sqlite3_column_count(stmt);
@@ -617,39 +749,34 @@ bool SqliteDataset::query(const char *query) {
   for (unsigned int i = 0; i < numColumns; i++)
     result.record_header[i].name = sqlite3_column_name(stmt, i);
 
+  if (forward_only)
+  { // rows are read as the caller steps through them
+    fields_object->resize(numColumns);
+    for (unsigned int i = 0; i < numColumns; i++)
+      (*fields_object)[i].props = result.record_header[i];
+    stream_stmt = stmt;
+    stream_sql = query;
+    sqlite->addStream(this);
+    active = true;
+    ds_state = dsSelect;
+    frecno = 0;
+    step_row();
+    return true;
+  }
+
   // returned rows
-  while (sqlite3_step(stmt) == SQLITE_ROW)
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
   { // have a row of data
     sql_record *res = new sql_record;
     res->resize(numColumns);
     for (unsigned int i = 0; i < numColumns; i++)
-    {
-      field_value &v = res->at(i);
-      switch (sqlite3_column_type(stmt, i))
-      {
-      case SQLITE_INTEGER:
-        v.set_asInt64(sqlite3_column_int64(stmt, i));
-        break;
-      case SQLITE_FLOAT:
-        v.set_asDouble(sqlite3_column_double(stmt, i));
-        break;
-      case SQLITE_TEXT:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_BLOB:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_NULL:
-      default:
-        v.set_asString("");
-        v.set_isNull();
-        break;
-      }
-    }
+      column_value(stmt, i, res->at(i));
     result.records.push_back(res);
   }
-  if (db->setErr(sqlite3_finalize(stmt),query) == SQLITE_OK)
+  if (db->setErr(rc == SQLITE_DONE ? SQLITE_OK : rc, query) == SQLITE_OK)
   {
+    sqlite->releaseStatement(query, stmt);
     active = true;
     ds_state = dsSelect;
     this->first();
@@ -657,12 +784,90 @@ bool SqliteDataset::query(const char *query) {
   }
   else
   {
+    sqlite3_finalize(stmt);
     throw DbErrors(db->getErrorMsg());
   }  
 }
 
-bool SqliteDataset::query(const string &q){
-  return query(q.c_str());
+void SqliteDataset::bind_params(sqlite3_stmt *stmt, const ParamList &params) {
+  for (ParamList::const_iterator i = params.begin(); i != params.end(); ++i)
+  {
+    string name = i->first;
+    if (name.empty() || (name[0] != ':' && name[0] != '@' && name[0] != '$'))
+      name = ":" + name;
+    int index = sqlite3_bind_parameter_index(stmt, name.c_str());
+    if (index == 0)
+      throw DbErrors("Unknown query parameter: %s", name.c_str());
+
+    const field_value &v = i->second;
+    int rc;
+    if (v.get_isNull())
+      rc = sqlite3_bind_null(stmt, index);
+    else switch (v.get_fType())
+    {
+    case ft_Boolean:
+    case ft_Char:
+    case ft_Short:
+    case ft_UShort:
+    case ft_Int:
+    case ft_UInt:
+    case ft_Int64:
+      rc = sqlite3_bind_int64(stmt, index, v.get_asInt64());
+      break;
+    case ft_Float:
+    case ft_Double:
+    case ft_LongDouble:
+      rc = sqlite3_bind_double(stmt, index, v.get_asDouble());
+      break;
+    default:
+      rc = sqlite3_bind_text(stmt, index, v.get_asString().c_str(), -1, SQLITE_TRANSIENT);
+      break;
+    }
+    if (db->setErr(rc, name.c_str()) != SQLITE_OK)
+      throw DbErrors(db->getErrorMsg());
+  }
+}
+
+void SqliteDataset::step_row() {
+  int rc = sqlite3_step(stream_stmt);
+  if (rc == SQLITE_ROW)
+  {
+    fbof = feof = false;
+    const unsigned int ncols = fields_object->size();
+    for (unsigned int i = 0; i < ncols; i++)
+      column_value(stream_stmt, i, (*fields_object)[i].val);
+    return;
+  }
+
+  // no more rows - hand the statement back so it can be reused while the caller finishes up
+  feof = true;
+  if (frecno == 0)
+    fbof = true;
+  if (rc == SQLITE_DONE)
+  {
+    release_stream();
+    return;
+  }
+  sqlite3_finalize(stream_stmt);
+  stream_stmt = NULL;
+  static_cast<SqliteDatabase*>(db)->removeStream(this);
+  db->setErr(rc, stream_sql.c_str());
+  throw DbErrors(db->getErrorMsg());
+}
+
+void SqliteDataset::release_stream() {
+  if (stream_stmt)
+  {
+    if (db)
+    {
+      static_cast<SqliteDatabase*>(db)->removeStream(this);
+      static_cast<SqliteDatabase*>(db)->releaseStatement(stream_sql.c_str(), stream_stmt);
+    }
+    else
+      sqlite3_finalize(stream_stmt);
+    stream_stmt = NULL;
+    feof = true;
+  }
 }
 
 void SqliteDataset::open(const string &sql) {
@@ -681,6 +886,7 @@ void SqliteDataset::open() {
 
 
 void SqliteDataset::close() {
+  release_stream();
   Dataset::close();
   result.clear();
   edit_object->clear();
@@ -701,6 +907,8 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
+  if (forward_only && ds_state == dsSelect)
+    return feof ? frecno : frecno + 1;
   return result.records.size();
 }
 
@@ -716,21 +924,40 @@ bool SqliteDataset::bof() {
 
 
 void SqliteDataset::first() {
+  if (forward_only && ds_state == dsSelect)
+  { // we're always positioned on the first row until next() is called
+    if (frecno > 0)
+      throw DbErrors("Can't rewind a forward-only dataset");
+    return;
+  }
   Dataset::first();
   this->fill_fields();
 }
 
 void SqliteDataset::last() {
+  if (forward_only && ds_state == dsSelect)
+    throw DbErrors("Can't seek in a forward-only dataset");
   Dataset::last();
   fill_fields();
 }
 
 void SqliteDataset::prev(void) {
+  if (forward_only && ds_state == dsSelect)
+    throw DbErrors("Can't seek in a forward-only dataset");
   Dataset::prev();
   fill_fields();
 }
 
 void SqliteDataset::next(void) {
+  if (forward_only && ds_state == dsSelect)
+  {
+    if (!feof && stream_stmt)
+    {
+      frecno++;
+      step_row();
+    }
+    return;
+  }
   Dataset::next();
   if (!eof()) 
       fill_fields();
@@ -750,6 +977,8 @@ void SqliteDataset::free_row(void)
 }
 
 bool SqliteDataset::seek(int pos) {
+  if (forward_only && ds_state == dsSelect)
+    throw DbErrors("Can't seek in a forward-only dataset");
   if (ds_state == dsSelect) {
     Dataset::seek(pos);
     fill_fields();
@@ -30,10 +30,14 @@
 #define _SQLITEDATASET_H
 
 #include <stdio.h>
+#include <list>
+#include <set>
 #include "dataset.h"
 #include <sqlite3.h>
 
 namespace dbiplus {
+class SqliteDataset;
+
 /***************** Class SqliteDatabase definition ******************
 
        class 'SqliteDatabase' connects with Sqlite-server
@@ -46,6 +50,16 @@ protected:
   bool _in_transaction;
   int last_err;
 
+/* cache of prepared statements not currently in use, most recently used first */
+  typedef std::list< std::pair<std::string, sqlite3_stmt*> > StatementList;
+  typedef std::map<std::string, StatementList::iterator> StatementIndex;
+  StatementList statements;
+  StatementIndex statement_index;
+  unsigned int statement_cache_size;
+
+/* datasets stepping a forward-only query, whose statements must be finalized before closing */
+  std::set<SqliteDataset*> streams;
+
 public:
 /* default constructor */
   SqliteDatabase();
@@ -94,6 +108,20 @@ public:
 
   bool in_transaction() {return _in_transaction;}; 	
 
+/* prepared statement cache */
+
+/* returns a prepared statement for the query, taking it from the cache if possible.
+   The statement must be handed back with releaseStatement() */
+  sqlite3_stmt *acquireStatement(const char *query);
+/* resets the statement and keeps it in the cache for the next time the query is run */
+  void releaseStatement(const char *query, sqlite3_stmt *stmt);
+/* finalizes all cached statements */
+  void clearStatements();
+/* sets the number of statements kept in the cache (0 disables caching) */
+  void setStatementCacheSize(unsigned int size);
+/* tracks datasets holding a statement of a forward-only query */
+  void addStream(SqliteDataset *ds);
+  void removeStream(SqliteDataset *ds);
 };
 
 
@@ -105,6 +133,7 @@ public:
 ******************************************************************/
 
 class SqliteDataset : public Dataset {
+  friend class SqliteDatabase;
 protected:
   sqlite3* handle();
 
@@ -125,6 +154,18 @@ protected:
 /* Changing field values during dataset navigation */
   virtual void free_row();  // free the memory allocated for the current row
 
+/* runs a select query, binding the given parameters if any */
+  bool run_query(const char *query, const ParamList *params);
+/* binds named parameters to a prepared statement */
+  void bind_params(sqlite3_stmt *stmt, const ParamList &params);
+/* reads the next row of a forward-only query into the fields object */
+  void step_row();
+/* hands the statement of a forward-only query back to the database */
+  void release_stream();
+
+  sqlite3_stmt *stream_stmt;  // statement being stepped in forward-only mode
+  std::string stream_sql;     // query of stream_stmt
+
 public:
 /* constructor */
   SqliteDataset();
@@ -147,6 +188,7 @@ or insert() operations default = false) */
 /* as open, but with our query exept Sql */
   virtual bool query(const char *query);
   virtual bool query(const std::string &query);
+  virtual bool query(const std::string &query, const ParamList &params);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
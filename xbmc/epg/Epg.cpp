@@ -95,8 +95,12 @@ CEpg &CEpg::operator =(const CEpg &right)
   m_lastScanTime      = right.m_lastScanTime;
   m_pvrChannel        = right.m_pvrChannel;
 
+  m_searchIndex.Invalidate();
   for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = right.m_tags.begin(); it != right.m_tags.end(); it++)
+  {
     m_tags.insert(make_pair(it->first, new CEpgInfoTag(*it->second)));
+    UpdateTagSpan(it->first, *it->second);
+  }
 
   return *this;
 }
@@ -155,6 +159,8 @@ void CEpg::Clear(void)
 {
   CSingleLock lock(m_critSection);
   m_tags.clear();
+  m_tagSpan = CDateTimeSpan();
+  m_searchIndex.Rebuild(m_tags);
 }
 
 void CEpg::Cleanup(void)
@@ -167,6 +173,7 @@ void CEpg::Cleanup(void)
 void CEpg::Cleanup(const CDateTime &Time)
 {
   CSingleLock lock(m_critSection);
+  bool bRemoved(false);
   for (map<CDateTime, CEpgInfoTagPtr>::iterator it = m_tags.begin(); it != m_tags.end(); it != m_tags.end() ? it++ : it)
   {
     if (it->second->EndAsUTC() < Time)
@@ -175,9 +182,14 @@ void CEpg::Cleanup(const CDateTime &Time)
         m_nowActiveStart.SetValid(false);
 
       it->second->ClearTimer();
+      m_searchIndex.Remove(it);
       m_tags.erase(it++);
+      bRemoved = true;
     }
   }
+
+  if (bRemoved)
+    RecalculateTagSpan();
 }
 
 bool CEpg::InfoTagNow(CEpgInfoTag &tag, bool bUpdateIfNeeded /* = true */)
@@ -195,10 +207,11 @@ bool CEpg::InfoTagNow(CEpgInfoTag &tag, bool bUpdateIfNeeded /* = true */)
 
   if (bUpdateIfNeeded)
   {
-    CDateTime lastActiveTag;
+    CDateTime now = CDateTime::GetUTCDateTime();
+    map<CDateTime, CEpgInfoTagPtr>::const_iterator first, last;
+    GetTagRange(now, now, first, last);
 
-    /* one of the first items will always match if the list is sorted */
-    for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = first; it != last; it++)
     {
       if (it->second->IsActive())
       {
@@ -206,16 +219,16 @@ bool CEpg::InfoTagNow(CEpgInfoTag &tag, bool bUpdateIfNeeded /* = true */)
         tag = *it->second;
         return true;
       }
-      else if (it->second->WasActive())
-        lastActiveTag = it->first;
     }
 
     /* there might be a gap between the last and next event. just return the last if found */
-    map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.find(lastActiveTag);
-    if (it != m_tags.end())
+    for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = last; it != m_tags.begin();)
     {
-      tag = *it->second;
-      return true;
+      if ((--it)->second->WasActive())
+      {
+        tag = *it->second;
+        return true;
+      }
     }
   }
 
@@ -237,8 +250,13 @@ bool CEpg::InfoTagNext(CEpgInfoTag &tag)
   }
   else if (Size() > 0)
   {
-    /* return the first event that is in the future */
-    for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    CSingleLock lock(m_critSection);
+    CDateTime now = CDateTime::GetUTCDateTime();
+    map<CDateTime, CEpgInfoTagPtr>::const_iterator first, last;
+    GetTagRange(now, now, first, last);
+
+    /* return the first event that is in the future. all tags after the range are */
+    for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = first; it != m_tags.end(); it++)
     {
       if (it->second->InTheFuture())
       {
@@ -285,7 +303,10 @@ CEpgInfoTagPtr CEpg::GetTag(const CDateTime &StartTime) const
 CEpgInfoTagPtr CEpg::GetTagBetween(const CDateTime &beginTime, const CDateTime &endTime) const
 {
   CSingleLock lock(m_critSection);
-  for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+  map<CDateTime, CEpgInfoTagPtr>::const_iterator first, last;
+  GetTagRange(beginTime, endTime, first, last);
+
+  for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = first; it != last; it++)
   {
     if (it->second->StartAsUTC() >= beginTime && it->second->EndAsUTC() <= endTime)
       return it->second;
@@ -298,7 +319,10 @@ CEpgInfoTagPtr CEpg::GetTagBetween(const CDateTime &beginTime, const CDateTime &
 CEpgInfoTagPtr CEpg::GetTagAround(const CDateTime &time) const
 {
   CSingleLock lock(m_critSection);
-  for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+  map<CDateTime, CEpgInfoTagPtr>::const_iterator first, last;
+  GetTagRange(time, time, first, last);
+
+  for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = first; it != last; it++)
   {
     if ((it->second->StartAsUTC() <= time) && (it->second->EndAsUTC() >= time))
       return it->second;
@@ -308,25 +332,71 @@ CEpgInfoTagPtr CEpg::GetTagAround(const CDateTime &time) const
   return retVal;
 }
 
+void CEpg::GetTagRange(const CDateTime &beginTime, const CDateTime &endTime, map<CDateTime, CEpgInfoTagPtr>::const_iterator &first, map<CDateTime, CEpgInfoTagPtr>::const_iterator &last) const
+{
+  /* tags that are stored more than m_tagSpan before the begin time have ended before it,
+     tags that are stored more than m_tagSpan after the end time start after it */
+  first = m_tags.lower_bound(beginTime - m_tagSpan);
+  last  = m_tags.upper_bound(endTime + m_tagSpan);
+}
+
+void CEpg::UpdateTagSpan(const CDateTime &start, const CEpgInfoTag &tag)
+{
+  /* fixing overlapping events moves the start of a tag, but not the start time it's stored under */
+  CDateTime tagStart = tag.StartAsUTC();
+  CDateTime tagEnd   = tag.EndAsUTC();
+  CDateTimeSpan span = (tagEnd > start ? tagEnd : start) - (tagStart < start ? tagStart : start);
+  if (span > m_tagSpan)
+    m_tagSpan = span;
+}
+
+void CEpg::RecalculateTagSpan(void)
+{
+  /* the span only ever widens as tags come in, so it's measured again once tags are gone */
+  m_tagSpan = CDateTimeSpan();
+  for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    UpdateTagSpan(it->first, *it->second);
+}
+
+bool CEpg::IsSearchableChange(const CEpgInfoTag &oldTag, const CEpgInfoTag &newTag)
+{
+  return oldTag.Title(true) != newTag.Title(true) ||
+      oldTag.PlotOutline(true) != newTag.PlotOutline(true) ||
+      oldTag.GenreType() != newTag.GenreType();
+}
+
+void CEpg::UpdateSearchIndex(map<CDateTime, CEpgInfoTagPtr>::const_iterator tag, bool bNewTag, bool bChanged)
+{
+  /* changed tags were taken out of the index before they were updated, so they're added again like new ones */
+  if (bNewTag || bChanged)
+    m_searchIndex.Add(tag);
+}
+
 void CEpg::AddEntry(const CEpgInfoTag &tag)
 {
   CEpgInfoTagPtr newTag;
   CSingleLock lock(m_critSection);
   map<CDateTime, CEpgInfoTagPtr>::iterator itr = m_tags.find(tag.StartAsUTC());
-  if (itr != m_tags.end())
+  bool bNewTag(itr == m_tags.end());
+  if (!bNewTag)
     newTag = itr->second;
   else
   {
     newTag = CEpgInfoTagPtr(new CEpgInfoTag(this, m_pvrChannel, m_strName, m_pvrChannel ? m_pvrChannel->IconPath() : StringUtils::EmptyString));
-    m_tags.insert(make_pair(tag.StartAsUTC(), newTag));
+    itr = m_tags.insert(make_pair(tag.StartAsUTC(), newTag)).first;
   }
 
   if (newTag)
   {
+    bool bSearchable(!bNewTag && IsSearchableChange(*newTag, tag));
+    if (bSearchable)
+      m_searchIndex.Remove(itr);
     newTag->Update(tag);
     newTag->SetPVRChannel(m_pvrChannel);
     newTag->m_epg          = this;
     newTag->m_bChanged     = false;
+    UpdateTagSpan(tag.StartAsUTC(), *newTag);
+    UpdateSearchIndex(itr, bNewTag, bSearchable);
   }
 }
 
@@ -345,13 +415,18 @@ bool CEpg::UpdateEntry(const CEpgInfoTag &tag, bool bUpdateDatabase /* = false *
     /* create a new tag if no tag with this ID exists */
     infoTag = CEpgInfoTagPtr(new CEpgInfoTag(this, m_pvrChannel, m_strName, m_pvrChannel ? m_pvrChannel->IconPath() : StringUtils::EmptyString));
     infoTag->SetUniqueBroadcastID(tag.UniqueBroadcastID());
-    m_tags.insert(make_pair(tag.StartAsUTC(), infoTag));
+    it = m_tags.insert(make_pair(tag.StartAsUTC(), infoTag)).first;
     bNewTag = true;
   }
 
+  bool bSearchable(!bNewTag && IsSearchableChange(*infoTag, tag));
+  if (bSearchable)
+    m_searchIndex.Remove(it);
   infoTag->Update(tag, bNewTag);
   infoTag->m_epg          = this;
   infoTag->m_pvrChannel   = m_pvrChannel;
+  UpdateTagSpan(tag.StartAsUTC(), *infoTag);
+  UpdateSearchIndex(it, bNewTag, bSearchable);
 
   if (bUpdateDatabase)
     m_changedTags.insert(make_pair<int, CEpgInfoTagPtr>(infoTag->UniqueBroadcastID(), infoTag));
@@ -519,10 +594,27 @@ int CEpg::Get(CFileItemList &results, const EpgSearchFilter &filter) const
 
   CSingleLock lock(m_critSection);
 
-  for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+  if (!m_searchIndex.IsValid())
+    m_searchIndex.Rebuild(m_tags);
+
+  /* only the tags with the words and genre searched for have to be checked. the texts of a locked
+     channel are replaced when it's parentally locked, so those are searched in full */
+  vector<CEpgSearchIndex::TagIterator> candidates;
+  if ((!m_pvrChannel || !m_pvrChannel->IsLocked()) && m_searchIndex.GetCandidates(filter, candidates))
   {
-    if (filter.FilterEntry(*it->second))
-      results.Add(CFileItemPtr(new CFileItem(*it->second)));
+    for (vector<CEpgSearchIndex::TagIterator>::const_iterator it = candidates.begin(); it != candidates.end(); it++)
+    {
+      if (filter.FilterEntry(*(*it)->second))
+        results.Add(CFileItemPtr(new CFileItem(*(*it)->second)));
+    }
+  }
+  else
+  {
+    for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    {
+      if (filter.FilterEntry(*it->second))
+        results.Add(CFileItemPtr(new CFileItem(*it->second)));
+    }
   }
 
   return results.Size() - iInitialSize;
@@ -602,13 +694,16 @@ CDateTime CEpg::GetLastDate(void) const
 bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
 {
   bool bReturn(true);
+  bool bRemoved(false);
   CEpgInfoTagPtr previousTag, currentTag;
+  CDateTime previousStart;
 
   for (map<CDateTime, CEpgInfoTagPtr>::iterator it = m_tags.begin(); it != m_tags.end(); it != m_tags.end() ? it++ : it)
   {
     if (!previousTag)
     {
       previousTag = it->second;
+      previousStart = it->first;
       continue;
     }
     currentTag = it->second;
@@ -623,15 +718,19 @@ bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
         m_nowActiveStart.SetValid(false);
 
       it->second->ClearTimer();
+      m_searchIndex.Remove(it);
       m_tags.erase(it++);
+      bRemoved = true;
     }
     else if (previousTag->EndAsUTC() > currentTag->StartAsUTC())
     {
       currentTag->SetStartFromUTC(previousTag->EndAsUTC());
+      UpdateTagSpan(it->first, *currentTag);
       if (bUpdateDb)
         m_changedTags.insert(make_pair<int, CEpgInfoTagPtr>(currentTag->UniqueBroadcastID(), currentTag));
 
       previousTag = it->second;
+      previousStart = it->first;
     }
     else if (previousTag->EndAsUTC() < currentTag->StartAsUTC())
     {
@@ -643,6 +742,8 @@ bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
 
       currentTag->SetStartFromUTC(newTime);
       previousTag->SetEndFromUTC(newTime);
+      UpdateTagSpan(it->first, *currentTag);
+      UpdateTagSpan(previousStart, *previousTag);
 
       if (m_nowActiveStart == it->first)
         m_nowActiveStart = currentTag->StartAsUTC();
@@ -654,13 +755,18 @@ bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
       }
 
       previousTag = it->second;
+      previousStart = it->first;
     }
     else
     {
       previousTag = it->second;
+      previousStart = it->first;
     }
   }
 
+  if (bRemoved)
+    RecalculateTagSpan();
+
   return bReturn;
 }
 
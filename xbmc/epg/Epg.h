@@ -26,6 +26,7 @@
 
 #include "EpgInfoTag.h"
 #include "EpgSearchFilter.h"
+#include "EpgSearchIndex.h"
 #include "utils/Observer.h"
 #include "pvr/channels/PVRChannel.h"
 
@@ -339,9 +340,45 @@ namespace EPG
 
     bool IsRemovableTag(const EPG::CEpgInfoTag &tag) const;
 
+    /*!
+     * @brief Widen m_tagSpan if the given tag covers more time than any tag before.
+     * @param start The start time the tag is stored under.
+     * @param tag The tag.
+     */
+    void UpdateTagSpan(const CDateTime &start, const CEpgInfoTag &tag);
+
+    /*!
+     * @brief Measure m_tagSpan again over all tags, after tags were removed.
+     */
+    void RecalculateTagSpan(void);
+
+    /*!
+     * @return True if updating a tag with the given one changes the text or genre it can be found by, false otherwise.
+     */
+    static bool IsSearchableChange(const CEpgInfoTag &oldTag, const CEpgInfoTag &newTag);
+
+    /*!
+     * @brief Keep the search index up to date after a tag was added or updated.
+     * A changed tag has to be removed from the index before it's updated.
+     * @param tag The tag.
+     * @param bNewTag True if the tag was added to the table.
+     * @param bChanged True if the text or genre the tag can be found by changed.
+     */
+    void UpdateSearchIndex(std::map<CDateTime, CEpgInfoTagPtr>::const_iterator tag, bool bNewTag, bool bChanged);
+
+    /*!
+     * @brief Get the part of the table that contains all tags covering any time between the given times.
+     * @param beginTime The begin time in UTC.
+     * @param endTime The end time in UTC.
+     * @param first The first tag of the part.
+     * @param last The tag after the last tag of the part.
+     */
+    void GetTagRange(const CDateTime &beginTime, const CDateTime &endTime, std::map<CDateTime, CEpgInfoTagPtr>::const_iterator &first, std::map<CDateTime, CEpgInfoTagPtr>::const_iterator &last) const;
+
     std::map<CDateTime, CEpgInfoTagPtr> m_tags;
     std::map<int, CEpgInfoTagPtr>       m_changedTags;
     std::map<int, CEpgInfoTagPtr>       m_deletedTags;
+    mutable CEpgSearchIndex             m_searchIndex;     /*!< the words and genres of the tags, updated as tags are added, changed and removed */
     bool                                m_bChanged;        /*!< true if anything changed that needs to be persisted, false otherwise */
     bool                                m_bTagsChanged;    /*!< true when any tags are changed and not persisted, false otherwise */
     bool                                m_bLoaded;         /*!< true when the initial entries have been loaded */
@@ -350,6 +387,7 @@ namespace EPG
     CStdString                          m_strName;         /*!< the name of this table */
     CStdString                          m_strScraperName;  /*!< the name of the scraper to use */
     CDateTime                           m_nowActiveStart;  /*!< the start time of the tag that is currently active */
+    CDateTimeSpan                       m_tagSpan;         /*!< the most time any tag covers before or after the start time it is stored under */
 
     CDateTime                           m_lastScanTime;    /*!< the last time the EPG has been updated */
 
@@ -32,6 +32,8 @@
 #include "pvr/recordings/PVRRecordings.h"
 #include "pvr/timers/PVRTimers.h"
 
+#include <set>
+
 using namespace std;
 using namespace EPG;
 using namespace PVR;
@@ -120,30 +122,23 @@ bool EpgSearchFilter::FilterEntry(const CEpgInfoTag &tag) const
 
 int EpgSearchFilter::RemoveDuplicates(CFileItemList &results)
 {
-  unsigned int iSize = results.Size();
+  typedef pair<CStdString, pair<CStdString, CStdString> > DuplicateKey;
+  set<DuplicateKey> found;
+  vector<int> duplicates;
 
-  for (unsigned int iResultPtr = 0; iResultPtr < iSize; iResultPtr++)
+  /* keep the first entry with a title, plot and plot outline */
+  for (int iResultPtr = 0; iResultPtr < results.Size(); iResultPtr++)
   {
-    const CEpgInfoTag *epgentry_1 = results.Get(iResultPtr)->GetEPGInfoTag();
-    for (unsigned int iTagPtr = 0; iTagPtr < iSize; iTagPtr++)
-    {
-      const CEpgInfoTag *epgentry_2 = results.Get(iTagPtr)->GetEPGInfoTag();
-      if (iResultPtr == iTagPtr)
-        continue;
-
-      if (epgentry_1->Title()       != epgentry_2->Title() ||
-          epgentry_1->Plot()        != epgentry_2->Plot() ||
-          epgentry_1->PlotOutline() != epgentry_2->PlotOutline())
-        continue;
-
-      results.Remove(iTagPtr);
-      iResultPtr--;
-      iTagPtr--;
-      iSize--;
-    }
+    const CEpgInfoTag *epgentry = results.Get(iResultPtr)->GetEPGInfoTag();
+    DuplicateKey key(epgentry->Title(), make_pair(epgentry->Plot(), epgentry->PlotOutline()));
+    if (!found.insert(key).second)
+      duplicates.push_back(iResultPtr);
   }
 
-  return iSize;
+  for (vector<int>::reverse_iterator it = duplicates.rbegin(); it != duplicates.rend(); it++)
+    results.Remove(*it);
+
+  return results.Size();
 }
 
 
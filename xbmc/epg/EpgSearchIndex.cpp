@@ -0,0 +1,274 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EpgSearchIndex.h"
+#include "EpgSearchFilter.h"
+#include "guilib/LocalizeStrings.h"
+#include "utils/TextSearch.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+using namespace EPG;
+
+static bool IsWordChar(unsigned char c)
+{
+  /* multi byte characters are always part of a word */
+  return c >= 0x80 || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool SortByStartTime(const CEpgSearchIndex::TagIterator &left, const CEpgSearchIndex::TagIterator &right)
+{
+  return left->first < right->first;
+}
+
+/* sorts the tags in the order of the table and removes doubles */
+static void SortUnique(vector<CEpgSearchIndex::TagIterator> &tags)
+{
+  sort(tags.begin(), tags.end(), SortByStartTime);
+  tags.erase(unique(tags.begin(), tags.end()), tags.end());
+}
+
+CEpgSearchIndex::CEpgSearchIndex(void) :
+    m_bValid(true)
+{
+}
+
+void CEpgSearchIndex::GetWords(const string &strText, vector<string> &words)
+{
+  string strWord;
+  for (string::const_iterator it = strText.begin(); it != strText.end(); it++)
+  {
+    if (IsWordChar(*it))
+    {
+      strWord += (*it >= 'A' && *it <= 'Z') ? *it - 'A' + 'a' : *it;
+    }
+    else if (!strWord.empty())
+    {
+      words.push_back(strWord);
+      strWord.clear();
+    }
+  }
+
+  if (!strWord.empty())
+    words.push_back(strWord);
+}
+
+void CEpgSearchIndex::AddWords(const string &strText, const TagIterator &tag)
+{
+  vector<string> words;
+  GetWords(strText, words);
+
+  for (vector<string>::const_iterator it = words.begin(); it != words.end(); it++)
+  {
+    Postings &postings = m_words[*it];
+    if (postings.empty() || postings.back() != tag)
+      postings.push_back(tag);
+  }
+}
+
+void CEpgSearchIndex::Add(const TagIterator &tag)
+{
+  if (!m_bValid)
+    return;
+
+  /* tags without a title are shown with a placeholder in the current language, that can match any term */
+  CStdString strTitle(tag->second->Title(true));
+  if (strTitle.empty() || strTitle == g_localizeStrings.Get(19055))
+    m_untitled.push_back(tag);
+  else
+    AddWords(strTitle, tag);
+  AddWords(tag->second->PlotOutline(true), tag);
+  m_genres[tag->second->GenreType()].push_back(tag);
+}
+
+void CEpgSearchIndex::RemovePosting(Postings &postings, const TagIterator &tag)
+{
+  Postings::iterator it = find(postings.begin(), postings.end(), tag);
+  if (it != postings.end())
+    postings.erase(it);
+}
+
+void CEpgSearchIndex::RemoveWords(const string &strText, const TagIterator &tag)
+{
+  vector<string> words;
+  GetWords(strText, words);
+
+  for (vector<string>::const_iterator it = words.begin(); it != words.end(); it++)
+  {
+    map<string, Postings>::iterator postings = m_words.find(*it);
+    if (postings == m_words.end())
+      continue;
+
+    RemovePosting(postings->second, tag);
+    if (postings->second.empty())
+      m_words.erase(postings);
+  }
+}
+
+void CEpgSearchIndex::Remove(const TagIterator &tag)
+{
+  if (!m_bValid)
+    return;
+
+  /* the tag is either untitled or indexed by the words of its title, looking in both is cheap */
+  RemovePosting(m_untitled, tag);
+  RemoveWords(tag->second->Title(true), tag);
+  RemoveWords(tag->second->PlotOutline(true), tag);
+
+  map<int, Postings>::iterator genre = m_genres.find(tag->second->GenreType());
+  if (genre != m_genres.end())
+  {
+    RemovePosting(genre->second, tag);
+    if (genre->second.empty())
+      m_genres.erase(genre);
+  }
+}
+
+void CEpgSearchIndex::Invalidate(void)
+{
+  m_words.clear();
+  m_genres.clear();
+  m_untitled.clear();
+  m_bValid = false;
+}
+
+void CEpgSearchIndex::Rebuild(const map<CDateTime, CEpgInfoTagPtr> &tags)
+{
+  m_words.clear();
+  m_genres.clear();
+  m_untitled.clear();
+  m_bValid = true;
+
+  for (TagIterator it = tags.begin(); it != tags.end(); it++)
+    Add(it);
+}
+
+static bool IsAscii(const string &strWord)
+{
+  for (string::const_iterator it = strWord.begin(); it != strWord.end(); it++)
+  {
+    if ((unsigned char)*it >= 0x80)
+      return false;
+  }
+  return true;
+}
+
+bool CEpgSearchIndex::GetTermCandidates(const string &strTerm, bool bCaseSensitive, Postings &candidates) const
+{
+  /* every word of the term is part of a word of a matching text. the first and last one may
+     only be the end and the start of one, so look for the longest in all words of the index.
+     the index only folds the case of ascii characters, other words can't be used when ignoring case */
+  vector<string> words;
+  GetWords(strTerm, words);
+
+  string strLongest;
+  for (vector<string>::const_iterator it = words.begin(); it != words.end(); it++)
+  {
+    if (it->length() > strLongest.length() && (bCaseSensitive || IsAscii(*it)))
+      strLongest = *it;
+  }
+
+  if (strLongest.empty())
+    return false;
+
+  for (map<string, Postings>::const_iterator it = m_words.begin(); it != m_words.end(); it++)
+  {
+    if (it->first.find(strLongest) != string::npos)
+      candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+  }
+  candidates.insert(candidates.end(), m_untitled.begin(), m_untitled.end());
+
+  SortUnique(candidates);
+  return true;
+}
+
+bool CEpgSearchIndex::GetCandidates(const EpgSearchFilter &filter, vector<TagIterator> &candidates) const
+{
+  if (!m_bValid)
+    return false;
+
+  bool bNarrowed(false);
+  Postings result;
+
+  if (filter.m_iGenreType != EPG_SEARCH_UNSET && !filter.m_bIncludeUnknownGenres)
+  {
+    map<int, Postings>::const_iterator it = m_genres.find(filter.m_iGenreType);
+    if (it != m_genres.end())
+      result = it->second;
+    SortUnique(result);
+    bNarrowed = true;
+  }
+
+  if (!filter.m_strSearchTerm.IsEmpty())
+  {
+    CTextSearch search(filter.m_strSearchTerm, filter.m_bIsCaseSensitive, SEARCH_DEFAULT_OR);
+
+    /* one of the "or" terms has to match */
+    const vector<CStdString> &orTerms = search.OrTerms();
+    if (!orTerms.empty())
+    {
+      Postings termsResult;
+      bool bAllTerms(true);
+      for (vector<CStdString>::const_iterator it = orTerms.begin(); it != orTerms.end() && bAllTerms; it++)
+        bAllTerms = GetTermCandidates(*it, filter.m_bIsCaseSensitive, termsResult);
+
+      /* a term without any usable words can match anything */
+      if (bAllTerms)
+      {
+        SortUnique(termsResult);
+        if (bNarrowed)
+        {
+          Postings intersection;
+          set_intersection(result.begin(), result.end(), termsResult.begin(), termsResult.end(), back_inserter(intersection), SortByStartTime);
+          result.swap(intersection);
+        }
+        else
+          result.swap(termsResult);
+        bNarrowed = true;
+      }
+    }
+
+    /* and all of the "and" terms */
+    const vector<CStdString> &andTerms = search.AndTerms();
+    for (vector<CStdString>::const_iterator it = andTerms.begin(); it != andTerms.end(); it++)
+    {
+      Postings termResult;
+      if (!GetTermCandidates(*it, filter.m_bIsCaseSensitive, termResult))
+        continue;
+
+      if (bNarrowed)
+      {
+        Postings intersection;
+        set_intersection(result.begin(), result.end(), termResult.begin(), termResult.end(), back_inserter(intersection), SortByStartTime);
+        result.swap(intersection);
+      }
+      else
+        result.swap(termResult);
+      bNarrowed = true;
+    }
+  }
+
+  if (bNarrowed)
+    candidates.swap(result);
+
+  return bNarrowed;
+}
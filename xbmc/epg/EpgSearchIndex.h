@@ -0,0 +1,103 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EpgInfoTag.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace EPG
+{
+  struct EpgSearchFilter;
+
+  /** Inverted index of the words in the titles and plot outlines and of the genres of the tags in an EPG table */
+
+  class CEpgSearchIndex
+  {
+  public:
+    typedef std::map<CDateTime, CEpgInfoTagPtr>::const_iterator TagIterator;
+
+    CEpgSearchIndex(void);
+
+    /*!
+     * @brief Add a tag that was added to the table.
+     * @param tag The tag.
+     */
+    void Add(const TagIterator &tag);
+
+    /*!
+     * @brief Remove a tag before it's removed from the table or its text or genre is changed.
+     * @param tag The tag, still with the text and genre it was added with.
+     */
+    void Remove(const TagIterator &tag);
+
+    /*!
+     * @brief Mark the index as out of date when the tags of the table were replaced.
+     */
+    void Invalidate(void);
+
+    /*!
+     * @return True if the index contains all tags of the table, false if it has to be rebuilt.
+     */
+    bool IsValid(void) const { return m_bValid; }
+
+    /*!
+     * @brief Rebuild the index from all tags of the table.
+     * @param tags The tags.
+     */
+    void Rebuild(const std::map<CDateTime, CEpgInfoTagPtr> &tags);
+
+    /*!
+     * @brief Get the tags that can match the search term and genre of a filter.
+     *
+     * The search term matches anywhere inside words, so this finds the words containing a part of each term.
+     * The candidates still have to be checked against the filter.
+     * The index holds the texts as they are without parental locking.
+     *
+     * @param filter The filter.
+     * @param candidates The tags that can match, in the order of the table.
+     * @return False if the filter doesn't narrow the search down and all tags have to be checked, true otherwise.
+     */
+    bool GetCandidates(const EpgSearchFilter &filter, std::vector<TagIterator> &candidates) const;
+
+    /*!
+     * @brief Split a text into the words the index is made of.
+     * @param strText The text.
+     * @param words The lower case words.
+     */
+    static void GetWords(const std::string &strText, std::vector<std::string> &words);
+
+  private:
+    typedef std::vector<TagIterator> Postings;
+
+    void AddWords(const std::string &strText, const TagIterator &tag);
+    void RemoveWords(const std::string &strText, const TagIterator &tag);
+    static void RemovePosting(Postings &postings, const TagIterator &tag);
+    bool GetTermCandidates(const std::string &strTerm, bool bCaseSensitive, Postings &candidates) const;
+
+    std::map<std::string, Postings> m_words;    /*!< the tags for each word */
+    std::map<int, Postings>         m_genres;   /*!< the tags for each genre type */
+    Postings                        m_untitled; /*!< the tags without a title */
+    bool                            m_bValid;   /*!< false if the index has to be rebuilt */
+  };
+}
@@ -89,7 +89,6 @@ CGUIEPGGridContainer::CGUIEPGGridContainer(int parentID, int controlID, float po
   m_cacheChannelItems     = preloadItems;
   m_cacheRulerItems       = preloadItems;
   m_cacheProgrammeItems   = preloadItems;
-  m_gridIndex             = NULL;
 }
 
 CGUIEPGGridContainer::~CGUIEPGGridContainer(void)
@@ -285,6 +284,9 @@ void CGUIEPGGridContainer::Render()
   int cacheBeforeProgramme, cacheAfterProgramme;
   GetProgrammeCacheOffsets(cacheBeforeProgramme, cacheAfterProgramme);
 
+  // build the rows of the channels that are about to scroll into view
+  BuildGridRows(chanOffset - cacheBeforeChannel, chanOffset + m_channelsPerPage + 1 + cacheAfterChannel);
+
   // Free memory not used on screen
   if ((int)m_programmeItems.size() > m_ProgrammesPerPage + cacheBeforeProgramme + cacheAfterProgramme)
     FreeProgrammeMemory(CorrectOffset(blockOffset - cacheBeforeProgramme, 0), CorrectOffset(blockOffset + m_ProgrammesPerPage + 1 + cacheAfterProgramme, 0));
@@ -316,26 +318,23 @@ void CGUIEPGGridContainer::Render()
     int block = blockOffset;
     float posA2 = posA;
 
-    CGUIListItemPtr item = m_gridIndex[channel][block].item;
-    if (blockOffset > 0 && item == m_gridIndex[channel][blockOffset-1].item)
+    GridItemsPtr *gridItem = GetGridItem(channel, block);
+    if (gridItem->item && gridItem->start < blockOffset)
     {
       /* first program starts before current view */
-      int startBlock = blockOffset - 1;
-      while (startBlock >= 0 && m_gridIndex[channel][startBlock].item == item)
-        startBlock--;
-
-      block = startBlock + 1;
+      block = gridItem->start;
       int missingSection = blockOffset - block;
       posA2 -= missingSection * m_blockSize;
     }
 
     while (posA2 < endA && m_programmeItems.size())   // FOR EACH ITEM ///////////////
     {
-      item = m_gridIndex[channel][block].item;
+      gridItem = GetGridItem(channel, block);
+      CGUIListItemPtr item = gridItem->item;
       if (!item || !item.get()->IsFileItem())
         break;
 
-      bool focused = (channel == m_channelOffset + m_channelCursor) && (item == m_gridIndex[m_channelOffset + m_channelCursor][m_blockOffset + m_blockCursor].item);
+      bool focused = (channel == m_channelOffset + m_channelCursor) && (item == GetGridItem(m_channelOffset + m_channelCursor, m_blockOffset + m_blockCursor)->item);
 
       // render our item
       if (focused)
@@ -351,28 +350,23 @@ void CGUIEPGGridContainer::Render()
           focusedPosY = posA2;
         }
         focusedItem = item;
-        focusedwidth = m_gridIndex[channel][block].width;
-        focusedheight = m_gridIndex[channel][block].height;
+        focusedwidth = gridItem->width;
+        focusedheight = gridItem->height;
       }
       else
       {
         if (m_orientation == VERTICAL)
-          RenderProgrammeItem(posA2, posB, m_gridIndex[channel][block].width, m_gridIndex[channel][block].height, item.get(), focused);
+          RenderProgrammeItem(posA2, posB, gridItem->width, gridItem->height, item.get(), focused);
         else
-          RenderProgrammeItem(posB, posA2, m_gridIndex[channel][block].width, m_gridIndex[channel][block].height, item.get(), focused);
+          RenderProgrammeItem(posB, posA2, gridItem->width, gridItem->height, item.get(), focused);
       }
 
       // increment our X position
       if (m_orientation == VERTICAL)
-      {
-        posA2 += m_gridIndex[channel][block].width; // assumes focused & unfocused layouts have equal length
-        block += (int)(m_gridIndex[channel][block].width / m_blockSize);
-      }
+        posA2 += gridItem->width; // assumes focused & unfocused layouts have equal length
       else
-      {
-        posA2 += m_gridIndex[channel][block].height; // assumes focused & unfocused layouts have equal length
-        block += (int)(m_gridIndex[channel][block].height / m_blockSize);
-      }
+        posA2 += gridItem->height; // assumes focused & unfocused layouts have equal length
+      block = gridItem->end;
     }
 
     // increment our Y position
@@ -708,16 +702,6 @@ bool CGUIEPGGridContainer::OnMessage(CGUIMessage& message)
       for (int i = 0; i < items->Size(); i++)
         m_programmeItems.push_back(items->Get(i));
 
-      ClearGridIndex();
-      m_gridIndex = (struct GridItemsPtr **) calloc(1,m_channelItems.size()*sizeof(struct GridItemsPtr*));
-      if (m_gridIndex != NULL)
-      {
-        for (unsigned int i = 0; i < m_channelItems.size(); i++)
-        {
-          m_gridIndex[i] = (struct GridItemsPtr*) calloc(1,MAXBLOCKS*sizeof(struct GridItemsPtr));
-        }
-      }
-
       UpdateLayout(true); // true to refresh all items
 
       /* Create Ruler items */
@@ -755,7 +739,7 @@ bool CGUIEPGGridContainer::OnMessage(CGUIMessage& message)
 
 void CGUIEPGGridContainer::UpdateItems()
 {
-  CDateTimeSpan blockDuration, gridDuration;
+  CDateTimeSpan gridDuration;
 
   /* check for invalid start and end time */
   if (m_gridStart >= m_gridEnd)
@@ -781,95 +765,12 @@ void CGUIEPGGridContainer::UpdateItems()
     return;
   }
 
-  blockDuration.SetDateTimeSpan(0, 0, MINSPERBLOCK, 0);
-
   long tick(XbmcThreads::SystemClockMillis());
 
-  for (unsigned int row = 0; row < m_channelItems.size(); ++row)
-  {
-    CDateTime gridCursor  = m_gridStart; //reset cursor for new channel
-    unsigned long progIdx = m_epgItemsPtr[row].start;
-    unsigned long lastIdx = m_epgItemsPtr[row].stop;
-    int iEpgId            = ((CFileItem *)m_programmeItems[progIdx].get())->GetEPGInfoTag()->EpgID();
-
-    /** FOR EACH BLOCK **********************************************************************/
-
-    for (int block = 0; block < m_blocks; block++)
-    {
-      while (progIdx <= lastIdx)
-      {
-        CGUIListItemPtr item = m_programmeItems[progIdx];
-        const CEpgInfoTag* tag = ((CFileItem *)item.get())->GetEPGInfoTag();
-        if (tag == NULL)
-          progIdx++;
-
-        if (tag->EpgID() != iEpgId)
-          break;
-
-        if (m_gridEnd <= tag->StartAsUTC())
-        {
-          break;
-        }
-        else if (gridCursor >= tag->EndAsUTC())
-        {
-          progIdx++;
-        }
-        else if (gridCursor < tag->EndAsUTC())
-        {
-          m_gridIndex[row][block].item = item;
-          break;
-        }
-        else
-        {
-          progIdx++;
-        }
-      }
-
-      gridCursor += blockDuration;
-    }
-
-    /** FOR EACH BLOCK **********************************************************************/
-    int itemSize = 1; // size of the programme in blocks
-    int savedBlock = 0;
-
-    for (int block = 0; block < m_blocks; block++)
-    {
-      if (m_gridIndex[row][block].item != m_gridIndex[row][block+1].item)
-      {
-        if (!m_gridIndex[row][block].item)
-        {
-          CEpgInfoTag broadcast;
-          CFileItemPtr unknown(new CFileItem(broadcast));
-          for (int i = block ; i > block - itemSize; i--)
-          {
-            m_gridIndex[row][i].item = unknown;
-          }
-        }
-
-        CGUIListItemPtr item = m_gridIndex[row][block].item;
-        CFileItem *fileItem = (CFileItem *)item.get();
-
-        m_gridIndex[row][savedBlock].item->SetProperty("GenreType", fileItem->GetEPGInfoTag()->GenreType());
-        if (m_orientation == VERTICAL)
-        {
-          m_gridIndex[row][savedBlock].width   = itemSize*m_blockSize;
-          m_gridIndex[row][savedBlock].height  = m_channelHeight;
-        }
-        else
-        {
-          m_gridIndex[row][savedBlock].width   = m_channelWidth;
-          m_gridIndex[row][savedBlock].height  = itemSize*m_blockSize;
-        }
-
-        itemSize = 1;
-        savedBlock = block+1;
-      }
-      else
-      {
-        itemSize++;
-      }
-    }
-  }
+  /* the rows are built when they are shown, only the visible channels are built here */
+  ClearGridIndex();
+  m_gridIndex.assign(m_channelItems.size(), GridRow());
+  BuildGridRows(m_channelOffset, m_channelOffset + m_channelsPerPage);
 
   /******************************************* END ******************************************/
 
@@ -957,7 +858,7 @@ bool CGUIEPGGridContainer::MoveChannel(bool direction, bool wrapAround)
 
 bool CGUIEPGGridContainer::MoveProgrammes(bool direction)
 {
-  if (!m_gridIndex || !m_item)
+  if (m_gridIndex.empty() || !m_item)
     return false;
 
   if (direction)
@@ -965,7 +866,7 @@ bool CGUIEPGGridContainer::MoveProgrammes(bool direction)
     if (m_channelCursor + m_channelOffset < 0 || m_blockOffset < 0)
       return false;
 
-    if (m_item->item != m_gridIndex[m_channelCursor + m_channelOffset][m_blockOffset].item)
+    if (m_item->item != GetGridItem(m_channelCursor + m_channelOffset, m_blockOffset)->item)
     {
       // this is not first item on page
       m_item = GetPrevItem(m_channelCursor);
@@ -1014,7 +915,7 @@ bool CGUIEPGGridContainer::MoveProgrammes(bool direction)
   }
   else
   {
-    if (m_item->item != m_gridIndex[m_channelCursor + m_channelOffset][m_blocksPerPage + m_blockOffset - 1].item)
+    if (m_item->item != GetGridItem(m_channelCursor + m_channelOffset, m_blocksPerPage + m_blockOffset - 1)->item)
     {
       // this is not last item on page
       m_item = GetNextItem(m_channelCursor);
@@ -1304,13 +1205,13 @@ bool CGUIEPGGridContainer::OnMouseWheel(char wheel, const CPoint &point)
 
 int CGUIEPGGridContainer::GetSelectedItem() const
 {
-  if (!m_gridIndex ||
+  if (m_gridIndex.empty() ||
       !m_epgItemsPtr.size() ||
       m_channelCursor + m_channelOffset >= (int)m_channelItems.size() ||
       m_blockCursor + m_blockOffset >= (int)m_programmeItems.size())
     return 0;
 
-  CGUIListItemPtr currentItem = m_gridIndex[m_channelCursor + m_channelOffset][m_blockCursor + m_blockOffset].item;
+  CGUIListItemPtr currentItem = GetGridItem(m_channelCursor + m_channelOffset, m_blockCursor + m_blockOffset)->item;
   if (!currentItem)
     return 0;
 
@@ -1397,9 +1298,9 @@ GridItemsPtr *CGUIEPGGridContainer::GetClosestItem(const int &channel)
   }
 
   if (right <= SHORTGAP && right <= left && m_blockCursor + right < m_blocksPerPage)
-    return &m_gridIndex[channel + m_channelOffset][m_blockCursor + right + m_blockOffset];
+    return GetGridItem(channel + m_channelOffset, m_blockCursor + right + m_blockOffset);
 
-  return &m_gridIndex[channel + m_channelOffset][m_blockCursor - left  + m_blockOffset];
+  return GetGridItem(channel + m_channelOffset, m_blockCursor - left  + m_blockOffset);
 }
 
 int CGUIEPGGridContainer::GetItemSize(GridItemsPtr *item)
@@ -1420,40 +1321,45 @@ int CGUIEPGGridContainer::GetBlock(const CGUIListItemPtr &item, const int &chann
 
 int CGUIEPGGridContainer::GetRealBlock(const CGUIListItemPtr &item, const int &channel)
 {
-  int block = 0;
-
-  while (m_gridIndex[channel + m_channelOffset][block].item != item && block < m_blocks)
-    block++;
+  GridRow *row = GetGridRow(channel + m_channelOffset);
+  if (row)
+  {
+    for (vector<GridItemsPtr>::const_iterator it = row->items.begin(); it != row->items.end(); ++it)
+    {
+      if (it->item == item)
+        return it->start;
+    }
+  }
 
-  return block;
+  return m_blocks;
 }
 
 GridItemsPtr *CGUIEPGGridContainer::GetNextItem(const int &channel)
 {
-  int i = m_blockCursor;
+  GridItemsPtr *current = GetGridItem(channel + m_channelOffset, m_blockCursor + m_blockOffset);
+  int i = m_blocksPerPage;
 
-  while (m_gridIndex[channel + m_channelOffset][i + m_blockOffset].item == m_gridIndex[channel + m_channelOffset][m_blockCursor + m_blockOffset].item && i < m_blocksPerPage)
-    i++;
+  if (current->item && current->end - m_blockOffset < m_blocksPerPage)
+    i = current->end - m_blockOffset;
 
-  return &m_gridIndex[channel + m_channelOffset][i + m_blockOffset];
+  return GetGridItem(channel + m_channelOffset, i + m_blockOffset);
 }
 
 GridItemsPtr *CGUIEPGGridContainer::GetPrevItem(const int &channel)
 {
-  int i = m_blockCursor;
-
-  while (m_gridIndex[channel + m_channelOffset][i + m_blockOffset].item == m_gridIndex[channel + m_channelOffset][m_blockCursor + m_blockOffset].item && i > 0)
-    i--;
+  GridItemsPtr *current = GetGridItem(channel + m_channelOffset, m_blockCursor + m_blockOffset);
+  int i = 0;
 
-  return &m_gridIndex[channel + m_channelOffset][i + m_blockOffset];
+  if (current->item && current->start - m_blockOffset > 0)
+    i = current->start - m_blockOffset - 1;
 
-//  return &m_gridIndex[channel + m_channelOffset][m_blockCursor + m_blockOffset - 1];
+  return GetGridItem(channel + m_channelOffset, i + m_blockOffset);
 }
 
 GridItemsPtr *CGUIEPGGridContainer::GetItem(const int &channel)
 {
   if ( (channel >= 0) && (channel < m_channels) )
-    return &m_gridIndex[channel + m_channelOffset][m_blockCursor + m_blockOffset];
+    return GetGridItem(channel + m_channelOffset, m_blockCursor + m_blockOffset);
   else
     return NULL;
 }
@@ -1634,19 +1540,134 @@ CStdString CGUIEPGGridContainer::GetDescription() const
 
 void CGUIEPGGridContainer::ClearGridIndex(void)
 {
-  if (m_gridIndex)
+  for (vector<GridRow>::iterator row = m_gridIndex.begin(); row != m_gridIndex.end(); ++row)
+  {
+    for (vector<GridItemsPtr>::iterator it = row->items.begin(); it != row->items.end(); ++it)
+      it->item->ClearProperties();
+  }
+  m_gridIndex.clear();
+}
+
+GridRow *CGUIEPGGridContainer::GetGridRow(int channel) const
+{
+  if (channel < 0 || channel >= (int)m_gridIndex.size())
+    return NULL;
+
+  GridRow &row = m_gridIndex[channel];
+  if (!row.built)
+    BuildGridRow(channel, row);
+
+  return &row;
+}
+
+GridItemsPtr *CGUIEPGGridContainer::GetGridItem(int channel, int block) const
+{
+  static GridItemsPtr empty = { CGUIListItemPtr(), 0, 0, 0, 0 };
+
+  GridRow *row = GetGridRow(channel);
+  if (!row || block < 0 || block >= m_blocks)
+    return &empty;
+
+  /* the last programme that starts at or before the block */
+  int first = 0;
+  int last  = (int)row->items.size() - 1;
+  while (first < last)
+  {
+    int middle = (first + last + 1) / 2;
+    if (row->items[middle].start <= block)
+      first = middle;
+    else
+      last = middle - 1;
+  }
+
+  return &row->items[first];
+}
+
+int CGUIEPGGridContainer::GetBlockAtOrAfter(const CDateTime &time) const
+{
+  if (time <= m_gridStart)
+    return 0;
+
+  CDateTimeSpan offset = time - m_gridStart;
+  int seconds = ((offset.GetDays() * 24 + offset.GetHours()) * 60 + offset.GetMinutes()) * 60 + offset.GetSeconds();
+  int block   = (seconds + MINSPERBLOCK * 60 - 1) / (MINSPERBLOCK * 60);
+
+  return block < m_blocks ? block : m_blocks;
+}
+
+void CGUIEPGGridContainer::BuildGridRow(int channel, GridRow &row) const
+{
+  row.built = true;
+  row.items.clear();
+
+  /* a programme takes the blocks from the end of the previous one until its own end, so gaps
+     are shown as part of the next programme and the blocks after the last one as unknown */
+  int block = 0;
+  if (channel < (int)m_epgItemsPtr.size())
   {
-    for (unsigned int i = 0; i < m_channelItems.size(); i++)
+    unsigned long progIdx = m_epgItemsPtr[channel].start;
+    unsigned long lastIdx = m_epgItemsPtr[channel].stop;
+    int iEpgId = -1;
+
+    for (; progIdx <= lastIdx && block < m_blocks; progIdx++)
     {
-      for (int block = 0; block < m_blocks; block++)
-      {
-        if (m_gridIndex[i][block].item)
-          m_gridIndex[i][block].item.get()->ClearProperties();
-      }
-      free(m_gridIndex[i]);
+      CGUIListItemPtr item = m_programmeItems[progIdx];
+      const CEpgInfoTag* tag = ((CFileItem *)item.get())->GetEPGInfoTag();
+      if (tag == NULL)
+        continue;
+
+      if (iEpgId == -1)
+        iEpgId = tag->EpgID();
+      else if (tag->EpgID() != iEpgId)
+        break;
+
+      if (m_gridEnd <= tag->StartAsUTC())
+        break;
+
+      int end = GetBlockAtOrAfter(tag->EndAsUTC());
+      if (end <= block)
+        continue;
+
+      GridItemsPtr gridItem;
+      gridItem.item  = item;
+      gridItem.start = block;
+      gridItem.end   = end;
+      row.items.push_back(gridItem);
+      block = end;
     }
-    free(m_gridIndex);
   }
+
+  if (block < m_blocks || row.items.empty())
+  {
+    CEpgInfoTag broadcast;
+    GridItemsPtr gridItem;
+    gridItem.item  = CFileItemPtr(new CFileItem(broadcast));
+    gridItem.start = block;
+    gridItem.end   = m_blocks;
+    row.items.push_back(gridItem);
+  }
+
+  for (vector<GridItemsPtr>::iterator it = row.items.begin(); it != row.items.end(); ++it)
+  {
+    int itemSize = it->end - it->start;
+    it->item->SetProperty("GenreType", ((CFileItem *)it->item.get())->GetEPGInfoTag()->GenreType());
+    if (m_orientation == VERTICAL)
+    {
+      it->width  = itemSize*m_blockSize;
+      it->height = m_channelHeight;
+    }
+    else
+    {
+      it->width  = m_channelWidth;
+      it->height = itemSize*m_blockSize;
+    }
+  }
+}
+
+void CGUIEPGGridContainer::BuildGridRows(int firstChannel, int lastChannel) const
+{
+  for (int channel = max(firstChannel, 0); channel <= lastChannel && channel < (int)m_gridIndex.size(); channel++)
+    GetGridRow(channel);
 }
 
 void CGUIEPGGridContainer::Reset()
@@ -1661,7 +1682,7 @@ void CGUIEPGGridContainer::Reset()
 
   m_lastItem    = NULL;
   m_lastChannel = NULL;
-  m_gridIndex   = NULL;
+  m_item        = NULL;
 }
 
 void CGUIEPGGridContainer::GoToBegin()
@@ -1675,13 +1696,11 @@ void CGUIEPGGridContainer::GoToEnd()
   int blocksEnd = 0;   // the end block of the last epg element for the selected channel
   int blocksStart = 0; // the start block of the last epg element for the selected channel
   int blockOffset = 0; // the block offset to scroll to
-  for (int blockIndex = m_blocks; blockIndex >= 0 && (!blocksEnd || !blocksStart); blockIndex--)
+  GridItemsPtr *last = GetGridItem(m_channelCursor + m_channelOffset, m_blocks - 1);
+  if (last->item)
   {
-    if (!blocksEnd && m_gridIndex[m_channelCursor + m_channelOffset][blockIndex].item != NULL)
-      blocksEnd = blockIndex;
-    if (blocksEnd && m_gridIndex[m_channelCursor + m_channelOffset][blocksEnd].item != 
-                     m_gridIndex[m_channelCursor + m_channelOffset][blockIndex].item)
-      blocksStart = blockIndex + 1;
+    blocksEnd   = m_blocks - 1;
+    blocksStart = last->start;
   }
   if (blocksEnd - blocksStart > m_blocksPerPage)
     blockOffset = blocksStart;
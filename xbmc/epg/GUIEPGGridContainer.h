@@ -41,6 +41,16 @@ namespace EPG
     CGUIListItemPtr item;
     float width;
     float height;
+    int start; //! first block of the programme
+    int end;   //! block after the last block of the programme
+  };
+
+  struct GridRow
+  {
+    GridRow() : built(false) {}
+
+    bool built;                       //! false until the row is needed
+    std::vector<GridItemsPtr> items;  //! the programmes of a channel, covering all blocks of the grid
   };
 
   class CGUIEPGGridContainer : public IGUIContainer
@@ -112,6 +122,12 @@ namespace EPG
     void Reset();
     void ClearGridIndex(void);
 
+    GridRow *GetGridRow(int channel) const;
+    GridItemsPtr *GetGridItem(int channel, int block) const;
+    void BuildGridRow(int channel, GridRow &row) const;
+    void BuildGridRows(int firstChannel, int lastChannel) const;
+    int  GetBlockAtOrAfter(const CDateTime &time) const;
+
     GridItemsPtr *GetItem(const int &channel);
     GridItemsPtr *GetNextItem(const int &channel);
     GridItemsPtr *GetPrevItem(const int &channel);
@@ -206,7 +222,7 @@ namespace EPG
     CDateTime m_gridStart;
     CDateTime m_gridEnd;
 
-    struct GridItemsPtr **m_gridIndex;
+    mutable std::vector<GridRow> m_gridIndex; //! rows are only built for the channels that are shown
     GridItemsPtr *m_item;
     CGUIListItem *m_lastItem;
     CGUIListItem *m_lastChannel;
@@ -0,0 +1,201 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "epg/Epg.h"
+#include "epg/EpgInfoTag.h"
+#include "threads/SystemClock.h"
+
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+#define CHANNELS  500
+#define DAYS      7
+#define TICKS     20
+
+using namespace EPG;
+
+// durations in minutes of the programmes in a guide, one channel starts where the previous one did
+static const int durations[] = { 30, 60, 25, 5, 90, 45, 120, 15, 30, 55 };
+
+class CTestEpg : public CEpg
+{
+public:
+  CTestEpg(int iEpgID) : CEpg(iEpgID, "test") {}
+
+  /* fills the table with consecutive programmes, with a gap of iGap minutes between them */
+  void Fill(const CDateTime &start, int iDays, int iFirst, int iGap = 0)
+  {
+    CDateTime end = start + CDateTimeSpan(iDays, 0, 0, 0);
+    CDateTime time = start;
+    for (int i = iFirst; time < end; i++)
+    {
+      CEpgInfoTag tag;
+      tag.SetUniqueBroadcastID(i + 1);
+      tag.SetStartFromUTC(time);
+      time += CDateTimeSpan(0, 0, durations[i % (sizeof(durations) / sizeof(durations[0]))], 0);
+      tag.SetEndFromUTC(time);
+      UpdateEntry(tag);
+      time += CDateTimeSpan(0, 0, iGap, 0);
+    }
+  }
+
+  bool Fix(void) { return FixOverlappingEvents(); }
+  const CDateTimeSpan &TagSpan(void) const { return m_tagSpan; }
+
+  /* what GetTagAround did before the table was indexed */
+  CEpgInfoTagPtr ScanTagAround(const CDateTime &time) const
+  {
+    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    {
+      if (it->second->StartAsUTC() <= time && it->second->EndAsUTC() >= time)
+        return it->second;
+    }
+    return CEpgInfoTagPtr();
+  }
+
+  /* what GetTagBetween did before the table was indexed */
+  CEpgInfoTagPtr ScanTagBetween(const CDateTime &beginTime, const CDateTime &endTime) const
+  {
+    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    {
+      if (it->second->StartAsUTC() >= beginTime && it->second->EndAsUTC() <= endTime)
+        return it->second;
+    }
+    return CEpgInfoTagPtr();
+  }
+};
+
+static void ExpectSameLookups(const CTestEpg &epg, const CDateTime &start, int iDays)
+{
+  CDateTime end = start + CDateTimeSpan(iDays, 0, 0, 0);
+  for (CDateTime time = start - CDateTimeSpan(0, 3, 0, 0); time < end + CDateTimeSpan(0, 3, 0, 0); time += CDateTimeSpan(0, 0, 7, 0))
+  {
+    EXPECT_EQ(epg.ScanTagAround(time).get(), epg.GetTagAround(time).get());
+
+    CDateTime windowEnd = time + CDateTimeSpan(0, 1, 0, 0);
+    EXPECT_EQ(epg.ScanTagBetween(time, windowEnd).get(), epg.GetTagBetween(time, windowEnd).get());
+  }
+}
+
+TEST(TestEpg, TagAroundAndBetween)
+{
+  CDateTime start(2013, 1, 7, 0, 0, 0);
+  CTestEpg epg(1);
+  epg.Fill(start, 2, 0);
+  ASSERT_LT(0U, epg.Size());
+
+  CEpgInfoTagPtr tag = epg.GetTagAround(start + CDateTimeSpan(0, 0, 40, 0));
+  ASSERT_TRUE(tag);
+  EXPECT_EQ(start + CDateTimeSpan(0, 0, 30, 0), tag->StartAsUTC());
+  EXPECT_FALSE(epg.GetTagAround(start - CDateTimeSpan(0, 0, 1, 0)));
+
+  ExpectSameLookups(epg, start, 2);
+}
+
+TEST(TestEpg, TagAroundAfterFixingGaps)
+{
+  // fixing the gaps moves the start of tags before the time they are stored under
+  CDateTime start(2013, 1, 7, 0, 0, 0);
+  CTestEpg epg(1);
+  epg.Fill(start, 2, 3, 50);
+  epg.Fix();
+
+  // the second tag is stored under 00:55, but now starts halfway the gap before it
+  CEpgInfoTagPtr tag = epg.GetTagAround(start + CDateTimeSpan(0, 0, 40, 0));
+  ASSERT_TRUE(tag);
+  EXPECT_EQ(start + CDateTimeSpan(0, 0, 30, 0), tag->StartAsUTC());
+  EXPECT_EQ(5, tag->UniqueBroadcastID());
+
+  ExpectSameLookups(epg, start, 2);
+}
+
+TEST(TestEpg, TagSpanAfterCleanup)
+{
+  CDateTime start(2013, 1, 7, 0, 0, 0);
+  CTestEpg epg(1);
+
+  // a day long tag first, the regular guide after it
+  CEpgInfoTag tag;
+  tag.SetUniqueBroadcastID(1000);
+  tag.SetStartFromUTC(start - CDateTimeSpan(1, 0, 0, 0));
+  tag.SetEndFromUTC(start);
+  epg.UpdateEntry(tag);
+  epg.Fill(start, 2, 0);
+  EXPECT_EQ(CDateTimeSpan(1, 0, 0, 0), epg.TagSpan());
+
+  // once it's cleaned up, the span is that of the longest programme left
+  epg.Cleanup(start + CDateTimeSpan(0, 0, 1, 0));
+  EXPECT_EQ(CDateTimeSpan(0, 2, 0, 0), epg.TagSpan());
+
+  ExpectSameLookups(epg, start, 2);
+}
+
+TEST(TestEpg, NowAndNext)
+{
+  CDateTime now = CDateTime::GetUTCDateTime();
+  CTestEpg epg(1);
+  epg.Fill(now - CDateTimeSpan(1, 0, 0, 0), 2, 0);
+
+  CEpgInfoTag tagNow, tagNext;
+  ASSERT_TRUE(epg.InfoTagNow(tagNow));
+  EXPECT_TRUE(tagNow.StartAsUTC() <= now && tagNow.EndAsUTC() > now);
+  ASSERT_TRUE(epg.InfoTagNext(tagNext));
+  EXPECT_EQ(tagNow.EndAsUTC(), tagNext.StartAsUTC());
+}
+
+TEST(TestEpg, GuideLookupBenchmark)
+{
+  CDateTime start(2013, 1, 7, 0, 0, 0);
+  std::vector<CTestEpg*> guide;
+  for (int i = 0; i < CHANNELS; i++)
+  {
+    guide.push_back(new CTestEpg(i + 1));
+    guide.back()->Fill(start, DAYS, i);
+  }
+
+  // every tick asks every channel what is on, like the guide window and the osd do
+  const char *modes[] = { "scan", "indexed" };
+  for (int mode = 0; mode < 2; mode++)
+  {
+    unsigned int found = 0;
+    unsigned int begin = XbmcThreads::SystemClockMillis();
+    for (int tick = 0; tick < TICKS; tick++)
+    {
+      CDateTime time = start + CDateTimeSpan(tick * DAYS / TICKS, tick % 24, 0, 0);
+      for (int i = 0; i < CHANNELS; i++)
+      {
+        CEpgInfoTagPtr tag = mode == 0 ? guide[i]->ScanTagAround(time) : guide[i]->GetTagAround(time);
+        if (tag)
+          found++;
+      }
+    }
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - begin;
+    EXPECT_EQ((unsigned int)(TICKS * CHANNELS), found);
+
+    std::cout << "Mode: " << modes[mode] << std::endl;
+    std::cout << "  Tags per channel: " << testing::PrintToString(guide[0]->Size()) << std::endl;
+    std::cout << "  Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+    std::cout << "  Lookups/sec: " << testing::PrintToString(elapsed ? (uint64_t)TICKS * CHANNELS * 1000 / elapsed : 0) << std::endl;
+  }
+
+  for (int i = 0; i < CHANNELS; i++)
+    delete guide[i];
+}
@@ -0,0 +1,318 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "epg/Epg.h"
+#include "epg/EpgInfoTag.h"
+#include "epg/EpgSearchFilter.h"
+#include "epg/EpgSearchIndex.h"
+#include "threads/SystemClock.h"
+#include "FileItem.h"
+
+#include <iostream>
+#include <set>
+
+#include "gtest/gtest.h"
+
+#define CHANNELS  500
+#define DAYS      3
+#define SEARCHES  5
+
+using namespace EPG;
+
+static const char *adjectives[] = { "Great", "Hidden", "Wild", "Deadly", "Ancient", "Modern", "Secret", "Frozen", "Royal", "Lost", "Naked", "Urban" };
+static const char *nouns[]      = { "Planet", "Kitchen", "Detectives", "Empire", "Railways", "Island", "Garden", "Chef", "Ocean", "Cities", "Ballroom", "Motors" };
+static const char *verbs[]      = { "explores", "cooks", "investigates", "rebuilds", "visits", "follows", "races", "dances" };
+
+class CSearchTestEpg : public CEpg
+{
+public:
+  CSearchTestEpg(int iEpgID) : CEpg(iEpgID, "test") {}
+
+  /* fills the table with half hour programmes made of words picked with iSeed, that are repeated every 20 hours */
+  void Fill(const CDateTime &start, int iDays, int iSeed)
+  {
+    CDateTime end = start + CDateTimeSpan(iDays, 0, 0, 0);
+    CDateTime time = start;
+    for (int i = 0; time < end; i++)
+    {
+      int iPick = (i % 40) * 7 + iSeed * 13;
+      CStdString strTitle, strOutline;
+      strTitle.Format("%s %s", adjectives[iPick % 12], nouns[(iPick / 12) % 12]);
+      strOutline.Format("The host %s the %s %s", verbs[(iPick / 3) % 8], adjectives[(iPick / 5) % 12], nouns[(iPick / 7) % 12]);
+
+      CEpgInfoTag tag;
+      tag.SetUniqueBroadcastID(i + 1);
+      tag.SetStartFromUTC(time);
+      time += CDateTimeSpan(0, 0, 30, 0);
+      tag.SetEndFromUTC(time);
+      tag.SetTitle(strTitle);
+      tag.SetPlotOutline(strOutline);
+      tag.SetPlot(strOutline);
+      tag.SetGenre(((iPick / 11) % 10 + 1) * 0x10, 0, NULL);
+      UpdateEntry(tag);
+    }
+  }
+
+  void Remove(const CDateTime &start)
+  {
+    std::map<CDateTime, CEpgInfoTagPtr>::iterator it = m_tags.find(start);
+    if (it == m_tags.end())
+      return;
+    m_searchIndex.Remove(it);
+    m_tags.erase(it);
+  }
+
+  bool IsIndexValid(void) const { return m_searchIndex.IsValid(); }
+
+  /* what searching did before the table was indexed */
+  int ScanSearch(CFileItemList &results, const EpgSearchFilter &filter) const
+  {
+    int iInitialSize = results.Size();
+    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    {
+      if (filter.FilterEntry(*it->second))
+        results.Add(CFileItemPtr(new CFileItem(*it->second)));
+    }
+    return results.Size() - iInitialSize;
+  }
+};
+
+static void InitFilter(EpgSearchFilter &filter, const CStdString &strSearchTerm, bool bCaseSensitive = false, int iGenreType = EPG_SEARCH_UNSET)
+{
+  filter.m_strSearchTerm            = strSearchTerm;
+  filter.m_bIsCaseSensitive         = bCaseSensitive;
+  filter.m_bSearchInDescription     = false;
+  filter.m_iGenreType               = iGenreType;
+  filter.m_iGenreSubType            = EPG_SEARCH_UNSET;
+  filter.m_iMinimumDuration         = EPG_SEARCH_UNSET;
+  filter.m_iMaximumDuration         = EPG_SEARCH_UNSET;
+  filter.m_startDateTime            = CDateTime(1980, 1, 1, 0, 0, 0);
+  filter.m_endDateTime              = CDateTime(2100, 1, 1, 0, 0, 0);
+  filter.m_bIncludeUnknownGenres    = false;
+  filter.m_bPreventRepeats          = false;
+  filter.m_iChannelNumber           = EPG_SEARCH_UNSET;
+  filter.m_bFTAOnly                 = false;
+  filter.m_iChannelGroup            = EPG_SEARCH_UNSET;
+  filter.m_bIgnorePresentTimers     = false;
+  filter.m_bIgnorePresentRecordings = false;
+}
+
+static std::set<int> GetBroadcastIDs(const CFileItemList &results)
+{
+  std::set<int> ids;
+  for (int i = 0; i < results.Size(); i++)
+    ids.insert(results.Get(i)->GetEPGInfoTag()->UniqueBroadcastID());
+  return ids;
+}
+
+static void ExpectSameResults(const CSearchTestEpg &epg, const EpgSearchFilter &filter)
+{
+  CFileItemList scanned, indexed;
+  epg.ScanSearch(scanned, filter);
+  epg.Get(indexed, filter);
+
+  EXPECT_EQ(GetBroadcastIDs(scanned), GetBroadcastIDs(indexed)) << "search term: " << filter.m_strSearchTerm;
+}
+
+static CDateTime GetStart(void)
+{
+  // the table is only searched when it has entries that didn't end yet
+  return CDateTime::GetCurrentDateTime().GetAsUTCDateTime() - CDateTimeSpan(1, 0, 0, 0);
+}
+
+TEST(TestEpgSearchIndex, GetWords)
+{
+  std::vector<std::string> words;
+  CEpgSearchIndex::GetWords("The (Great) Kitchen-Motors, 2nd \xc3\x9c" "ber", words);
+
+  ASSERT_EQ(6U, words.size());
+  EXPECT_EQ("the", words[0]);
+  EXPECT_EQ("great", words[1]);
+  EXPECT_EQ("kitchen", words[2]);
+  EXPECT_EQ("motors", words[3]);
+  EXPECT_EQ("2nd", words[4]);
+  EXPECT_EQ("\xc3\x9c" "ber", words[5]);
+}
+
+TEST(TestEpgSearchIndex, SameResultsAsScan)
+{
+  CSearchTestEpg epg(1);
+  epg.Fill(GetStart(), DAYS, 1);
+  ASSERT_LT(0U, epg.Size());
+
+  const char *terms[] = {
+    "kitchen",                 // a word
+    "itche",                   // the inside of a word
+    "KITCHEN",                 // case is ignored
+    "Wild Island",             // one of the words
+    "Wild + Island",           // both words
+    "\"Wild Island\"",         // the phrase
+    "nd isl",                  // the end and start of two words
+    "host",                    // a word in the plot outline
+    "secret ! chef",           // without a word
+    "tch | xyz",               // one of two terms, one not found
+    "xyz",                     // not found at all
+    "-",                       // no words at all
+    "\xc3\x9c" "ber"           // not in the index
+  };
+
+  for (unsigned int i = 0; i < sizeof(terms) / sizeof(terms[0]); i++)
+  {
+    EpgSearchFilter filter;
+    InitFilter(filter, terms[i]);
+    ExpectSameResults(epg, filter);
+  }
+
+  // case sensitive searches only find the words as they're written
+  EpgSearchFilter filter;
+  InitFilter(filter, "Kitchen", true);
+  ExpectSameResults(epg, filter);
+  InitFilter(filter, "kitchen", true);
+  ExpectSameResults(epg, filter);
+
+  // genres, alone and with a term
+  InitFilter(filter, "", false, 0x30);
+  ExpectSameResults(epg, filter);
+  InitFilter(filter, "Royal", false, 0x30);
+  ExpectSameResults(epg, filter);
+  InitFilter(filter, "Royal", false, 0x30);
+  filter.m_bIncludeUnknownGenres = true;
+  ExpectSameResults(epg, filter);
+}
+
+TEST(TestEpgSearchIndex, ChangedTags)
+{
+  CDateTime start = GetStart();
+  CSearchTestEpg epg(1);
+  epg.Fill(start, DAYS, 1);
+
+  EpgSearchFilter filter;
+  InitFilter(filter, "Zeppelin");
+  CFileItemList results;
+  EXPECT_EQ(0, epg.Get(results, filter));
+
+  // a new tag is added to the index
+  CEpgInfoTag tag;
+  tag.SetUniqueBroadcastID(10000);
+  tag.SetStartFromUTC(start + CDateTimeSpan(DAYS, 0, 0, 0));
+  tag.SetEndFromUTC(start + CDateTimeSpan(DAYS, 1, 0, 0));
+  tag.SetTitle("Zeppelin Motors");
+  epg.UpdateEntry(tag);
+  EXPECT_EQ(1, epg.Get(results, filter));
+
+  // a changed title replaces the words of the old one
+  tag.SetTitle("Airship Motors");
+  epg.UpdateEntry(tag);
+  results.Clear();
+  EXPECT_EQ(0, epg.Get(results, filter));
+  InitFilter(filter, "Airship");
+  EXPECT_EQ(1, epg.Get(results, filter));
+
+  // a changed genre moves the tag to the new one
+  tag.SetGenre(0xF0, 0, NULL);
+  epg.UpdateEntry(tag);
+  InitFilter(filter, "", false, 0xF0);
+  results.Clear();
+  EXPECT_EQ(1, epg.Get(results, filter));
+  ExpectSameResults(epg, filter);
+
+  // and a removed tag isn't found anymore
+  epg.Remove(tag.StartAsUTC());
+  InitFilter(filter, "Airship");
+  results.Clear();
+  EXPECT_EQ(0, epg.Get(results, filter));
+  ExpectSameResults(epg, filter);
+  InitFilter(filter, "Motors");
+  ExpectSameResults(epg, filter);
+
+  // none of it needed the index to be rebuilt
+  EXPECT_TRUE(epg.IsIndexValid());
+}
+
+TEST(TestEpgSearchIndex, RemoveDuplicates)
+{
+  CSearchTestEpg epg(1);
+  epg.Fill(GetStart(), DAYS, 1);
+
+  EpgSearchFilter filter;
+  InitFilter(filter, "Royal");
+  CFileItemList results;
+  epg.Get(results, filter);
+  ASSERT_LT(0, results.Size());
+
+  // the first of the programmes with the same text is kept, in the order of the results
+  std::set<std::string> texts;
+  std::vector<int> expected;
+  for (int i = 0; i < results.Size(); i++)
+  {
+    const CEpgInfoTag *tag = results.Get(i)->GetEPGInfoTag();
+    if (texts.insert(tag->Title() + "|" + tag->Plot() + "|" + tag->PlotOutline()).second)
+      expected.push_back(tag->UniqueBroadcastID());
+  }
+  ASSERT_GT((size_t)results.Size(), expected.size());
+
+  EXPECT_EQ((int)expected.size(), EpgSearchFilter::RemoveDuplicates(results));
+  ASSERT_EQ((int)expected.size(), results.Size());
+  for (int i = 0; i < results.Size(); i++)
+    EXPECT_EQ(expected[i], results.Get(i)->GetEPGInfoTag()->UniqueBroadcastID());
+}
+
+TEST(TestEpgSearchIndex, SearchBenchmark)
+{
+  CDateTime start = GetStart();
+  std::vector<CSearchTestEpg*> epgs;
+  for (int i = 0; i < CHANNELS; i++)
+  {
+    epgs.push_back(new CSearchTestEpg(i + 1));
+    epgs.back()->Fill(start, DAYS, i);
+  }
+
+  const char *terms[] = { "detectives", "Frozen Ocean", "rail", "Ballroom + Wild", "Zeppelin" };
+  const char *modes[] = { "Scan", "Index" };
+  unsigned int found[2] = { 0, 0 };
+  for (unsigned int mode = 0; mode < 2; mode++)
+  {
+    unsigned int startTime = XbmcThreads::SystemClockMillis();
+    for (int iSearch = 0; iSearch < SEARCHES; iSearch++)
+    {
+      EpgSearchFilter filter;
+      InitFilter(filter, terms[iSearch % (sizeof(terms) / sizeof(terms[0]))]);
+
+      CFileItemList results;
+      for (std::vector<CSearchTestEpg*>::const_iterator it = epgs.begin(); it != epgs.end(); it++)
+      {
+        if (mode == 0)
+          (*it)->ScanSearch(results, filter);
+        else
+          (*it)->Get(results, filter);
+      }
+      found[mode] += results.Size();
+    }
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - startTime;
+
+    std::cout << "Mode: " << modes[mode] << std::endl;
+    std::cout << "  Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+    std::cout << "  Results: " << testing::PrintToString(found[mode]) << std::endl;
+  }
+  EXPECT_EQ(found[0], found[1]);
+
+  for (std::vector<CSearchTestEpg*>::iterator it = epgs.begin(); it != epgs.end(); it++)
+    delete *it;
+}
@@ -30,6 +30,7 @@
 #endif
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
+#include "IFileTypes.h"
 
 namespace XFILE {
 
@@ -57,6 +58,18 @@ public:
   virtual bool IsEndOfInput();
   virtual void ClearEndOfInput();
 
+  // strategies that keep more than one range of the file cached
+  /**
+   * Returns where the cached data that can be read without a gap from
+   * iFilePosition ends, or -1 if only data up to the source position is kept
+   */
+  virtual int64_t CachedDataEndPosIfSeekTo(int64_t iFilePosition) { return -1; }
+  /**
+   * The source continues at iSourcePosition, the read position stays where it is
+   */
+  virtual void ResetWritePosition(int64_t iSourcePosition) { }
+  virtual bool GetStats(SCacheStats &stats) { return false; }
+
   CEvent m_space;
 protected:
   bool  m_bEndOfInput;
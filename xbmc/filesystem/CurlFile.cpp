@@ -339,6 +339,7 @@ CCurlFile::CCurlFile()
   m_password = "";
   m_httpauth = "";
   m_state = new CReadState();
+  m_segmented = NULL;
   m_skipshout = false;
   m_httpresponse = -1;
 }
@@ -351,6 +352,8 @@ void CCurlFile::SetBufferSize(unsigned int size)
 
 void CCurlFile::Close()
 {
+  delete m_segmented;
+  m_segmented = NULL;
   m_state->Disconnect();
 
   m_url.Empty();
@@ -437,8 +440,8 @@ void CCurlFile::SetCommonOptions(CReadState* state)
   g_curlInterface.easy_setopt(h, CURLOPT_SSL_VERIFYPEER, 0);
   g_curlInterface.easy_setopt(h, CURLOPT_SSL_VERIFYHOST, 0);
 
-  g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_URL, m_url.c_str());
-  g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_TRANSFERTEXT, FALSE);
+  g_curlInterface.easy_setopt(h, CURLOPT_URL, m_url.c_str());
+  g_curlInterface.easy_setopt(h, CURLOPT_TRANSFERTEXT, FALSE);
 
   // setup POST data if it is set (and it may be empty)
   if (m_postdataset)
@@ -840,6 +843,8 @@ bool CCurlFile::IsInternet(bool checkDNS /* = true */)
 void CCurlFile::Cancel()
 {
   m_state->m_cancelled = true;
+  if (m_segmented)
+    m_segmented->m_cancelled = true;
   while (m_opened)
     Sleep(1);
 }
@@ -847,6 +852,8 @@ void CCurlFile::Cancel()
 void CCurlFile::Reset()
 {
   m_state->m_cancelled = false;
+  if (m_segmented)
+    m_segmented->m_cancelled = false;
 }
 
 bool CCurlFile::Open(const CURL& url)
@@ -921,6 +928,34 @@ bool CCurlFile::Open(const CURL& url)
   if (CURLE_OK == g_curlInterface.easy_getinfo(m_state->m_easyHandle, CURLINFO_EFFECTIVE_URL,&efurl) && efurl)
     m_url = efurl;
 
+  // a server that answered the initial range request can be read in parallel ranges
+  if (m_seekable && m_httpresponse == 206
+  &&  g_advancedSettings.m_curlSegments > 1
+  &&  m_contentencoding.IsEmpty() && !m_postdataset
+  && (url2.GetProtocol().Equals("http") || url2.GetProtocol().Equals("https")))
+    OpenSegmented();
+
+  return true;
+}
+
+bool CCurlFile::OpenSegmented()
+{
+  if (m_state->m_fileSize <= (int64_t)g_advancedSettings.m_curlSegmentSize)
+    return false;
+
+  m_segmented = new CSegmentedReadState(this, m_state->m_fileSize, g_advancedSettings.m_curlSegmentSize, g_advancedSettings.m_curlSegments);
+  if (!m_segmented->Connect(m_state->m_filePos))
+  {
+    CLog::Log(LOGWARNING, "CurlFile::Open(%p) unable to start segmented read, using a single stream", (void*)this);
+    delete m_segmented;
+    m_segmented = NULL;
+    return false;
+  }
+
+  // the initial connection is only kept for its headers
+  m_state->Disconnect();
+
+  CLog::Log(LOGDEBUG, "CurlFile::Open(%p) reading in %d segments of %d bytes", (void*)this, g_advancedSettings.m_curlSegments, g_advancedSettings.m_curlSegmentSize);
   return true;
 }
 
@@ -999,7 +1034,8 @@ bool CCurlFile::Exists(const CURL& url)
 
 int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
 {
-  int64_t nextPos = m_state->m_filePos;
+  int64_t fileSize = GetLength();
+  int64_t nextPos = GetPosition();
   switch(iWhence)
   {
     case SEEK_SET:
@@ -1009,8 +1045,8 @@ int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
       nextPos += iFilePosition;
       break;
     case SEEK_END:
-      if (m_state->m_fileSize)
-        nextPos = m_state->m_fileSize + iFilePosition;
+      if (fileSize)
+        nextPos = fileSize + iFilePosition;
       else
         return -1;
       break;
@@ -1019,7 +1055,10 @@ int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
   }
 
   // We can't seek beyond EOF
-  if (m_state->m_fileSize && nextPos > m_state->m_fileSize) return -1;
+  if (fileSize && nextPos > fileSize) return -1;
+
+  if(m_segmented)
+    return m_segmented->Seek(nextPos) ? nextPos : -1;
 
   if(m_state->Seek(nextPos))
     return nextPos;
@@ -1070,15 +1109,31 @@ int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
 int64_t CCurlFile::GetLength()
 {
   if (!m_opened) return 0;
+  if (m_segmented) return m_segmented->m_fileSize;
   return m_state->m_fileSize;
 }
 
 int64_t CCurlFile::GetPosition()
 {
   if (!m_opened) return 0;
+  if (m_segmented) return m_segmented->m_filePos;
   return m_state->m_filePos;
 }
 
+unsigned int CCurlFile::Read(void* lpBuf, int64_t uiBufSize)
+{
+  if (m_segmented)
+    return m_segmented->Read(lpBuf, uiBufSize);
+  return m_state->Read(lpBuf, uiBufSize);
+}
+
+bool CCurlFile::ReadString(char *szLine, int iLineLength)
+{
+  if (m_segmented)
+    return m_segmented->ReadString(szLine, iLineLength);
+  return m_state->ReadString(szLine, iLineLength);
+}
+
 int CCurlFile::Stat(const CURL& url, struct __stat64* buffer)
 {
   // if file is already running, get info from it
@@ -1381,6 +1436,292 @@ bool CCurlFile::CReadState::FillBuffer(unsigned int want)
   return true;
 }
 
+CCurlFile::CSegmentedReadState::CSegmentedReadState(CCurlFile* file, int64_t fileSize, unsigned int segmentSize, unsigned int segments)
+{
+  m_file = file;
+  m_fileSize = fileSize;
+  m_segmentSize = segmentSize;
+  m_segmentCount = segments;
+  m_filePos = 0;
+  m_nextPos = 0;
+  m_cancelled = false;
+  m_multiHandle = g_curlInterface.multi_init();
+}
+
+CCurlFile::CSegmentedReadState::~CSegmentedReadState()
+{
+  Disconnect();
+
+  for (std::deque<SSegment>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+    delete it->state;
+
+  if (m_multiHandle)
+    g_curlInterface.multi_cleanup(m_multiHandle);
+}
+
+/* (re)starts all segments with consecutive ranges from pos onwards */
+bool CCurlFile::CSegmentedReadState::Connect(int64_t pos)
+{
+  if (!m_multiHandle)
+    return false;
+
+  Disconnect();
+
+  if (m_segments.empty())
+  {
+    CURL url(m_file->m_url);
+    for (unsigned int i = 0; i < m_segmentCount; i++)
+    {
+      SSegment segment = {};
+      segment.state = new CReadState();
+      segment.done  = true;
+      m_segments.push_back(segment);
+
+      CReadState* state = segment.state;
+      g_curlInterface.easy_aquire(url.GetProtocol(), url.GetHostName(), &state->m_easyHandle, NULL);
+      if (!state->m_easyHandle || !state->m_buffer.Create(m_segmentSize))
+        return false;
+
+      // the header list is shared by all segments, so it's not rebuilt per handle
+      m_file->SetCommonOptions(state);
+      if (m_file->m_curlHeaderList)
+        g_curlInterface.easy_setopt(state->m_easyHandle, CURLOPT_HTTPHEADER, m_file->m_curlHeaderList);
+    }
+  }
+
+  m_filePos = pos;
+  m_nextPos = pos;
+  for (std::deque<SSegment>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+  {
+    if (!Request(*it, m_nextPos))
+      return false;
+  }
+  return true;
+}
+
+void CCurlFile::CSegmentedReadState::Disconnect()
+{
+  for (std::deque<SSegment>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+    Cancel(*it);
+}
+
+void CCurlFile::CSegmentedReadState::Cancel(SSegment& segment)
+{
+  if (!segment.done)
+    g_curlInterface.multi_remove_handle(m_multiHandle, segment.state->m_easyHandle);
+  segment.done = true;
+}
+
+/* gives the segment the range starting at start */
+bool CCurlFile::CSegmentedReadState::Request(SSegment& segment, int64_t start)
+{
+  Cancel(segment);
+
+  segment.state->m_buffer.Clear();
+  segment.state->m_filePos = start;
+  segment.end     = std::min(start + (int64_t)m_segmentSize, m_fileSize);
+  segment.retries = 0;
+  m_nextPos       = std::max(m_nextPos, segment.end);
+
+  return Resume(segment);
+}
+
+/* fetches the part of the range that isn't buffered yet */
+bool CCurlFile::CSegmentedReadState::Resume(SSegment& segment)
+{
+  CReadState* state = segment.state;
+  Cancel(segment);
+
+  // past the end of the file there is nothing left to fetch
+  int64_t start = state->m_filePos + state->m_buffer.getMaxReadSize();
+  if (start >= segment.end)
+    return true;
+
+  CStdString range;
+  range.Format("%"PRId64"-%"PRId64, start, segment.end - 1);
+  g_curlInterface.easy_setopt(state->m_easyHandle, CURLOPT_RANGE, range.c_str());
+  state->m_headerdone = false;
+
+  if (g_curlInterface.multi_add_handle(m_multiHandle, state->m_easyHandle) != CURLM_OK)
+    return false;
+
+  segment.done = false;
+  return true;
+}
+
+/* gives the ranges that were read completely a new range after the last one */
+void CCurlFile::CSegmentedReadState::Advance()
+{
+  while (m_segments.front().end <= m_filePos && m_segments.front().end < m_fileSize)
+  {
+    SSegment segment = m_segments.front();
+    m_segments.pop_front();
+
+    if (!Request(segment, std::min(m_nextPos, m_fileSize)))
+      CLog::Log(LOGERROR, "%s - unable to request range at %"PRId64, __FUNCTION__, m_nextPos);
+    m_segments.push_back(segment);
+  }
+}
+
+/* lets curl do its work without blocking and handles finished ranges */
+bool CCurlFile::CSegmentedReadState::Perform()
+{
+  int running;
+  CURLMcode result;
+  while ((result = g_curlInterface.multi_perform(m_multiHandle, &running)) == CURLM_CALL_MULTI_PERFORM);
+
+  if (result != CURLM_OK)
+  {
+    CLog::Log(LOGERROR, "%s - curl multi perform failed with code %d, aborting", __FUNCTION__, result);
+    return false;
+  }
+
+  for (std::deque<SSegment>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+  {
+    // the buffer holds the whole range, so anything more means the range was ignored
+    if (it->state->m_overflowSize)
+    {
+      CLog::Log(LOGERROR, "%s - server returned more than the requested range, aborting", __FUNCTION__);
+      return false;
+    }
+  }
+
+  int msgs;
+  CURLMsg* msg;
+  while ((msg = g_curlInterface.multi_info_read(m_multiHandle, &msgs)))
+  {
+    if (msg->msg != CURLMSG_DONE)
+      continue;
+
+    for (std::deque<SSegment>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+    {
+      if (it->done || it->state->m_easyHandle != msg->easy_handle)
+        continue;
+
+      CURLcode code = msg->data.result;
+      Cancel(*it);
+
+      int64_t received = it->state->m_filePos + it->state->m_buffer.getMaxReadSize();
+      if (code == CURLE_OK && received == it->end)
+        break;
+
+      if (++it->retries > g_advancedSettings.m_curlretries)
+      {
+        CLog::Log(LOGWARNING, "%s: range ending at %"PRId64" failed with code %i, giving up", __FUNCTION__, it->end, code);
+        break;
+      }
+
+      CLog::Log(LOGWARNING, "%s: range ending at %"PRId64" failed with code %i, (re)try %i", __FUNCTION__, it->end, code, it->retries);
+      Resume(*it);
+      break;
+    }
+  }
+  return true;
+}
+
+/* waits until the front segment has data or can't get any more */
+bool CCurlFile::CSegmentedReadState::FillFront()
+{
+  fd_set fdread;
+  fd_set fdwrite;
+  fd_set fdexcep;
+
+  SSegment& front = m_segments.front();
+  while (front.state->m_buffer.getMaxReadSize() == 0)
+  {
+    if (m_cancelled || front.done || !Perform())
+      return false;
+
+    if (front.state->m_buffer.getMaxReadSize() > 0 || front.done)
+      continue;
+
+    int maxfd = -1;
+    FD_ZERO(&fdread);
+    FD_ZERO(&fdwrite);
+    FD_ZERO(&fdexcep);
+
+    g_curlInterface.multi_fdset(m_multiHandle, &fdread, &fdwrite, &fdexcep, &maxfd);
+
+    long timeout = 0;
+    if (CURLM_OK != g_curlInterface.multi_timeout(m_multiHandle, &timeout) || timeout == -1)
+      timeout = 200;
+
+    struct timeval t = { timeout / 1000, (timeout % 1000) * 1000 };
+    if (SOCKET_ERROR == dllselect(maxfd + 1, &fdread, &fdwrite, &fdexcep, &t))
+    {
+      CLog::Log(LOGERROR, "%s - curl failed with socket error", __FUNCTION__);
+      return false;
+    }
+  }
+  return true;
+}
+
+unsigned int CCurlFile::CSegmentedReadState::Read(void* lpBuf, int64_t uiBufSize)
+{
+  if (m_filePos >= m_fileSize)
+    return 0;
+
+  Advance();
+
+  // keep the ranges behind the front moving even when the front has data
+  if (!Perform() || !FillFront())
+  {
+    if (!m_cancelled)
+      CLog::Log(LOGWARNING, "%s - Transfer ended before entire file was retrieved pos %"PRId64", size %"PRId64, __FUNCTION__, m_filePos, m_fileSize);
+    return 0;
+  }
+
+  CReadState* front = m_segments.front().state;
+  unsigned int want = (unsigned int)XMIN(front->m_buffer.getMaxReadSize(), uiBufSize);
+  if (!front->m_buffer.ReadData((char *)lpBuf, want))
+    return 0;
+
+  front->m_filePos += want;
+  m_filePos += want;
+  return want;
+}
+
+bool CCurlFile::CSegmentedReadState::ReadString(char *szLine, int iLineLength)
+{
+  int len = 0;
+  while (len < iLineLength - 1 && Read(szLine + len, 1) == 1)
+  {
+    if (szLine[len++] == '\n')
+      break;
+  }
+  szLine[len] = 0;
+  return len > 0;
+}
+
+bool CCurlFile::CSegmentedReadState::Seek(int64_t pos)
+{
+  if (pos == m_filePos)
+    return true;
+
+  // the ring buffers can't go back, and anything past the last requested
+  // range means starting over as well
+  if (pos < m_filePos || pos >= m_segments.back().end)
+    return Connect(pos);
+
+  m_filePos = pos;
+  Advance();
+
+  SSegment& segment = m_segments.front();
+  CReadState* front = segment.state;
+  int64_t skip = pos - front->m_filePos;
+  if (skip <= front->m_buffer.getMaxReadSize())
+  {
+    front->m_buffer.SkipBytes((int)skip);
+    front->m_filePos = pos;
+    return true;
+  }
+
+  // the range hasn't arrived that far yet, so request the rest of it directly
+  front->m_buffer.Clear();
+  front->m_filePos = pos;
+  return Resume(segment);
+}
+
 void CCurlFile::ClearRequestHeaders()
 {
   m_requestheaders.clear();
@@ -22,6 +22,7 @@
 #include "IFile.h"
 #include "utils/RingBuffer.h"
 #include <map>
+#include <deque>
 #include "utils/HttpHeader.h"
 
 namespace XCURL
@@ -47,8 +48,8 @@ namespace XFILE
       virtual int64_t  GetLength();
       virtual int  Stat(const CURL& url, struct __stat64* buffer);
       virtual void Close();
-      virtual bool ReadString(char *szLine, int iLineLength)     { return m_state->ReadString(szLine, iLineLength); }
-      virtual unsigned int Read(void* lpBuf, int64_t uiBufSize)  { return m_state->Read(lpBuf, uiBufSize); }
+      virtual bool ReadString(char *szLine, int iLineLength);
+      virtual unsigned int Read(void* lpBuf, int64_t uiBufSize);
       virtual CStdString GetMimeType()                           { return m_state->m_httpheader.GetMimeType(); }
       virtual int IoControl(EIoControl request, void* param);
 
@@ -119,15 +120,59 @@ namespace XFILE
           void         Disconnect();
       };
 
+      /* reads a seekable http stream as consecutive byte ranges that are
+       * fetched in parallel over one multi handle. each segment is a
+       * read state of its own with a buffer holding the whole range. */
+      class CSegmentedReadState
+      {
+      public:
+          CSegmentedReadState(CCurlFile* file, int64_t fileSize, unsigned int segmentSize, unsigned int segments);
+          ~CSegmentedReadState();
+
+          struct SSegment
+          {
+            CReadState* state;  // state->m_filePos is the next byte to read
+            int64_t     end;    // index in file after the last byte of the range
+            int         retries;
+            bool        done;
+          };
+
+          XCURL::CURLM*        m_multiHandle;
+          std::deque<SSegment> m_segments;    // in file order, the front is being read
+          CCurlFile*           m_file;
+          unsigned int         m_segmentSize;
+          unsigned int         m_segmentCount;
+          int64_t              m_fileSize;
+          int64_t              m_filePos;
+          int64_t              m_nextPos;     // start of the next range to request
+          bool                 m_cancelled;
+
+          bool         Seek(int64_t pos);
+          unsigned int Read(void* lpBuf, int64_t uiBufSize);
+          bool         ReadString(char *szLine, int iLineLength);
+          bool         Connect(int64_t pos);
+          void         Disconnect();
+
+      private:
+          bool         Request(SSegment& segment, int64_t start);
+          bool         Resume(SSegment& segment);
+          void         Cancel(SSegment& segment);
+          bool         FillFront();
+          bool         Perform();
+          void         Advance();
+      };
+
     protected:
       void ParseAndCorrectUrl(CURL &url);
       void SetCommonOptions(CReadState* state);
       void SetRequestHeaders(CReadState* state);
       void SetCorrectHeaders(CReadState* state);
       bool Service(const CStdString& strURL, CStdString& strHTML);
+      bool OpenSegmented();
 
     protected:
       CReadState*     m_state;
+      CSegmentedReadState* m_segmented;
       unsigned int    m_bufferSize;
 
       CStdString      m_url;
@@ -115,6 +115,15 @@ CDirectory::CDirectory()
 CDirectory::~CDirectory()
 {}
 
+/* whether the item is left out of the listing, the mask must be set on the directory */
+static bool IsFiltered(IDirectory *directory, const CFileItem &item, const CDirectory::CHints &hints)
+{
+  // TODO: we shouldn't be checking the gui setting here;
+  // callers should use getHidden instead
+  return (!item.m_bIsFolder && !directory->IsAllowed(item.GetPath())) ||
+         (item.GetProperty("file:hidden").asBoolean() && !(hints.flags & DIR_FLAG_GET_HIDDEN) && !g_guiSettings.GetBool("filelists.showhidden"));
+}
+
 bool CDirectory::GetDirectory(const CStdString& strPath, CFileItemList &items, const CStdString &strMask /*=""*/, int flags /*=DIR_FLAG_DEFAULTS*/, bool allowThreads /* = false */)
 {
   CHints hints;
@@ -132,9 +141,20 @@ bool CDirectory::GetDirectory(const CStdString& strPath, CFileItemList &items, c
     if (!pDirectory.get())
       return false;
 
-    // check our cache for this path
-    if (g_directoryCache.GetDirectory(strPath, items, (hints.flags & DIR_FLAG_READ_CACHE) == DIR_FLAG_READ_CACHE))
+    // check our cache for this path, only the items that aren't filtered are copied
+    boost::shared_ptr<const CFileItemList> cached;
+    if (g_directoryCache.GetDirectory(strPath, cached, (hints.flags & DIR_FLAG_READ_CACHE) == DIR_FLAG_READ_CACHE))
+    {
+      pDirectory->SetMask(hints.mask);
+      items.Copy(*cached, false);
+      for (int i = 0; i < cached->Size(); ++i)
+      {
+        const CFileItemPtr item = cached->Get(i);
+        if (!IsFiltered(pDirectory.get(), *item, hints))
+          items.Add(CFileItemPtr(new CFileItem(*item)));
+      }
       items.SetPath(strPath);
+    }
     else
     {
       // need to clear the cache (in case the directory fetch fails)
@@ -199,20 +219,16 @@ bool CDirectory::GetDirectory(const CStdString& strPath, CFileItemList &items, c
       // cache the directory, if necessary
       if (!(hints.flags & DIR_FLAG_BYPASS_CACHE))
         g_directoryCache.SetDirectory(strPath, items, pDirectory->GetCacheType(strPath));
-    }
 
-    // now filter for allowed files
-    pDirectory->SetMask(hints.mask);
-    for (int i = 0; i < items.Size(); ++i)
-    {
-      CFileItemPtr item = items[i];
-      // TODO: we shouldn't be checking the gui setting here;
-      // callers should use getHidden instead
-      if ((!item->m_bIsFolder && !pDirectory->IsAllowed(item->GetPath())) ||
-          (item->GetProperty("file:hidden").asBoolean() && !(hints.flags & DIR_FLAG_GET_HIDDEN) && !g_guiSettings.GetBool("filelists.showhidden")))
+      // now filter for allowed files
+      pDirectory->SetMask(hints.mask);
+      for (int i = 0; i < items.Size(); ++i)
       {
-        items.Remove(i);
-        i--; // don't confuse loop
+        if (IsFiltered(pDirectory.get(), *items[i], hints))
+        {
+          items.Remove(i);
+          i--; // don't confuse loop
+        }
       }
     }
 
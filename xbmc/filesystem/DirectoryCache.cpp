@@ -19,6 +19,7 @@
  */
 
 #include "DirectoryCache.h"
+#include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "FileItem.h"
 #include "threads/SingleLock.h"
@@ -32,28 +33,20 @@ using namespace XFILE;
 CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
 {
   m_cacheType = cacheType;
-  m_lastAccess = 0;
-  m_Items = new CFileItemList;
+  m_size = 0;
+  m_Items.reset(new CFileItemList);
   m_Items->SetFastLookup(true);
 }
 
 CDirectoryCache::CDir::~CDir()
 {
-  delete m_Items;
-}
-
-void CDirectoryCache::CDir::SetLastAccess(unsigned int &accessCounter)
-{
-  m_lastAccess = accessCounter++;
 }
 
 CDirectoryCache::CDirectoryCache(void)
 {
-  m_accessCounter = 0;
-#ifdef _DEBUG
+  m_size = 0;
   m_cacheHits = 0;
   m_cacheMisses = 0;
-#endif
 }
 
 CDirectoryCache::~CDirectoryCache(void)
@@ -61,12 +54,24 @@ CDirectoryCache::~CDirectoryCache(void)
 }
 
 bool CDirectoryCache::GetDirectory(const CStdString& strPath, CFileItemList &items, bool retrieveAll)
+{
+  boost::shared_ptr<const CFileItemList> listing;
+  if (!GetDirectory(strPath, listing, retrieveAll))
+    return false;
+
+  // the caller gets a copy it can change, but other callers don't have to wait for it
+  items.Copy(*listing);
+  return true;
+}
+
+bool CDirectoryCache::GetDirectory(const CStdString& strPath, boost::shared_ptr<const CFileItemList> &listing, bool retrieveAll)
 {
   CSingleLock lock (m_cs);
 
   CStdString storedPath = URIUtils::SubstitutePath(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
+  listing.reset();
   ciCache i = m_cache.find(storedPath);
   if (i != m_cache.end())
   {
@@ -74,15 +79,17 @@ bool CDirectoryCache::GetDirectory(const CStdString& strPath, CFileItemList &ite
     if (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
        (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
     {
-      items.Copy(*dir->m_Items);
-      dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-      m_cacheHits+=items.Size();
-#endif
-      return true;
+      listing = dir->m_Items;
+      SetLastAccess(dir);
     }
   }
-  return false;
+
+  if (listing)
+    m_cacheHits++;
+  else
+    m_cacheMisses++;
+
+  return listing != NULL;
 }
 
 void CDirectoryCache::SetDirectory(const CStdString& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType)
@@ -101,6 +108,10 @@ void CDirectoryCache::SetDirectory(const CStdString& strPath, const CFileItemLis
   // IDEALLY, any further processing on the item would actually create a new item
   // instead of altering it, but we can't really enforce that in an easy way, so
   // this is the best solution for now.
+  CDir* dir = new CDir(cacheType);
+  dir->m_Items->Copy(items);
+  dir->m_size = GetSize(*dir->m_Items);
+
   CSingleLock lock (m_cs);
 
   CStdString storedPath = URIUtils::SubstitutePath(strPath);
@@ -108,12 +119,11 @@ void CDirectoryCache::SetDirectory(const CStdString& strPath, const CFileItemLis
 
   ClearDirectory(storedPath);
 
-  CheckIfFull();
-
-  CDir* dir = new CDir(cacheType);
-  dir->m_Items->Copy(items);
-  dir->SetLastAccess(m_accessCounter);
+  dir->m_lruPos = m_lru.insert(m_lru.end(), storedPath);
+  m_size += dir->m_size;
   m_cache.insert(pair<CStdString, CDir*>(storedPath, dir));
+
+  CheckIfFull(storedPath);
 }
 
 void CDirectoryCache::ClearFile(const CStdString& strFile)
@@ -165,9 +175,26 @@ void CDirectoryCache::AddFile(const CStdString& strFile)
   if (i != m_cache.end())
   {
     CDir *dir = i->second;
+
+    // a reader is still copying the listing, so change a new one. the items
+    // themselves are never changed and can be shared by both
+    if (!dir->m_Items.unique())
+    {
+      boost::shared_ptr<CFileItemList> listing(new CFileItemList);
+      listing->Copy(*dir->m_Items, false);
+      listing->SetFastLookup(true);
+      listing->Append(*dir->m_Items);
+      dir->m_Items = listing;
+    }
+
     CFileItemPtr item(new CFileItem(strFile, false));
     dir->m_Items->Add(item);
-    dir->SetLastAccess(m_accessCounter);
+
+    m_size -= dir->m_size;
+    dir->m_size = GetSize(*dir->m_Items);
+    m_size += dir->m_size;
+    SetLastAccess(dir);
+    CheckIfFull(strPath);
   }
 }
 
@@ -185,15 +212,11 @@ bool CDirectoryCache::FileExists(const CStdString& strFile, bool& bInCache)
   {
     bInCache = true;
     CDir *dir = i->second;
-    dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
+    SetLastAccess(dir);
     m_cacheHits++;
-#endif
     return dir->m_Items->Contains(strFile);
   }
-#ifdef _DEBUG
   m_cacheMisses++;
-#endif
   return false;
 }
 
@@ -231,51 +254,71 @@ void CDirectoryCache::ClearCache(set<CStdString>& dirs)
   }
 }
 
-void CDirectoryCache::CheckIfFull()
+/**
+ * Drops the least recently used listings until the cached listings fit in
+ * the budget. Listings that are always cached and the one that was just
+ * stored or changed are kept.
+ */
+void CDirectoryCache::CheckIfFull(const CStdString& strKeep)
 {
   CSingleLock lock (m_cs);
-  static const unsigned int max_cached_dirs = 10;
 
-  // find the last accessed folder, and remove if the number of cached folders is too many
-  iCache lastAccessed = m_cache.end();
-  unsigned int numCached = 0;
-  for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
+  list<CStdString>::iterator it = m_lru.begin();
+  while (m_size > g_advancedSettings.m_directoryCacheSize && it != m_lru.end())
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
-    {
-      if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
-        lastAccessed = i;
-      numCached++;
-    }
+    iCache i = m_cache.find(*it++);
+    if (i->second->m_cacheType != DIR_CACHE_ALWAYS && i->first != strKeep)
+      Delete(i);
+  }
+}
+
+void CDirectoryCache::SetLastAccess(CDir *dir)
+{
+  m_lru.splice(m_lru.end(), m_lru, dir->m_lruPos);
+}
+
+/**
+ * Estimates the memory held by a listing from its items and their most
+ * common strings
+ */
+size_t CDirectoryCache::GetSize(const CFileItemList &items)
+{
+  size_t size = sizeof(CFileItemList);
+  for (int i = 0; i < items.Size(); i++)
+  {
+    const CFileItemPtr item = items[i];
+    size += sizeof(CFileItem) + item->GetPath().size() + item->GetLabel().size() + item->GetLabel2().size();
   }
-  if (lastAccessed != m_cache.end() && numCached >= max_cached_dirs)
-    Delete(lastAccessed);
+  return size;
 }
 
 void CDirectoryCache::Delete(iCache it)
 {
   CDir* dir = it->second;
+  m_size -= dir->m_size;
+  m_lru.erase(dir->m_lruPos);
   delete dir;
   m_cache.erase(it);
 }
 
-#ifdef _DEBUG
-void CDirectoryCache::PrintStats() const
+void CDirectoryCache::GetStats(SStats &stats) const
 {
   CSingleLock lock (m_cs);
-  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
-  // run through and find the oldest and the number of items cached
-  unsigned int oldest = UINT_MAX;
-  unsigned int numItems = 0;
-  unsigned int numDirs = 0;
+  stats.hits   = m_cacheHits;
+  stats.misses = m_cacheMisses;
+  stats.dirs   = m_cache.size();
+  stats.bytes  = m_size;
+  stats.items  = 0;
   for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
-  {
-    CDir *dir = i->second;
-    oldest = min(oldest, dir->GetLastAccess());
-    numItems += dir->m_Items->Size();
-    numDirs++;
-  }
-  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+    stats.items += i->second->m_Items->Size();
+}
+
+#ifdef _DEBUG
+void CDirectoryCache::PrintStats() const
+{
+  SStats stats;
+  GetStats(stats);
+  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, stats.hits, stats.misses);
+  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total and about %u bytes", __FUNCTION__, stats.dirs, stats.items, (unsigned int)stats.bytes);
 }
 #endif
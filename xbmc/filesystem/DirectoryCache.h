@@ -23,8 +23,10 @@
 #include "Directory.h"
 #include "threads/CriticalSection.h"
 
+#include <list>
 #include <map>
 #include <set>
+#include <boost/shared_ptr.hpp>
 
 class CFileItem;
 
@@ -38,18 +40,30 @@ namespace XFILE
       CDir(DIR_CACHE_TYPE cacheType);
       virtual ~CDir();
 
-      void SetLastAccess(unsigned int &accessCounter);
-      unsigned int GetLastAccess() const { return m_lastAccess; };
-
-      CFileItemList* m_Items;
+      // the listing is shared with readers copying it and never changed while it is,
+      // it's replaced by a copy instead (copy on write)
+      boost::shared_ptr<CFileItemList> m_Items;
       DIR_CACHE_TYPE m_cacheType;
-    private:
-      unsigned int m_lastAccess;
+      size_t m_size;                              // estimated memory held by the listing
+      std::list<CStdString>::iterator m_lruPos;   // position in the least recently used list
     };
   public:
+    struct SStats
+    {
+      unsigned int hits;
+      unsigned int misses;
+      unsigned int dirs;
+      unsigned int items;
+      size_t bytes;     // estimated memory held by the cached listings
+    };
+
     CDirectoryCache(void);
     virtual ~CDirectoryCache(void);
     bool GetDirectory(const CStdString& strPath, CFileItemList &items, bool retrieveAll = false);
+    /*! \brief Hands out the cached listing itself rather than a copy of it
+     The listing is never changed once it is cached, callers copy the items they want to change.
+     */
+    bool GetDirectory(const CStdString& strPath, boost::shared_ptr<const CFileItemList> &listing, bool retrieveAll = false);
     void SetDirectory(const CStdString& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType);
     void ClearDirectory(const CStdString& strPath);
     void ClearFile(const CStdString& strFile);
@@ -57,27 +71,30 @@ namespace XFILE
     void Clear();
     void AddFile(const CStdString& strFile);
     bool FileExists(const CStdString& strPath, bool& bInCache);
+    void GetStats(SStats &stats) const;
 #ifdef _DEBUG
     void PrintStats() const;
 #endif
   protected:
     void InitCache(std::set<CStdString>& dirs);
     void ClearCache(std::set<CStdString>& dirs);
-    void CheckIfFull();
+    void CheckIfFull(const CStdString& strKeep);
 
     std::map<CStdString, CDir*> m_cache;
     typedef std::map<CStdString, CDir*>::iterator iCache;
     typedef std::map<CStdString, CDir*>::const_iterator ciCache;
     void Delete(iCache i);
+    void SetLastAccess(CDir *dir);
+
+    static size_t GetSize(const CFileItemList &items);
 
     CCriticalSection m_cs;
 
-    unsigned int m_accessCounter;
+    std::list<CStdString> m_lru;  // cached paths, least recently used first
+    size_t m_size;                // estimated memory held by all listings
 
-#ifdef _DEBUG
     unsigned int m_cacheHits;
     unsigned int m_cacheMisses;
-#endif
   };
 }
 extern XFILE::CDirectoryCache g_directoryCache;
@@ -26,6 +26,7 @@
 #include "URL.h"
 
 #include "CircularCache.h"
+#include "SparseCache.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
@@ -35,6 +36,7 @@ using namespace AUTOPTR;
 using namespace XFILE;
 
 #define READ_CACHE_CHUNK_SIZE (64*1024)
+#define SEEK_TIMEOUT          30000   // ms to wait for the source to seek
 
 class CWriteRate
 {
@@ -87,11 +89,16 @@ CFileCache::CFileCache() : CThread("CFileCache")
    m_writePos = 0;
    if (g_advancedSettings.m_cacheMemBufferSize == 0)
      m_pCache = new CSimpleFileCache();
+   else if (g_advancedSettings.m_cacheSparse)
+     m_pCache = new CSparseCache(g_advancedSettings.m_cacheMemBufferSize);
    else
      m_pCache = new CCircularCache(g_advancedSettings.m_cacheMemBufferSize
                                  , std::max<unsigned int>( g_advancedSettings.m_cacheMemBufferSize / 4, 1024 * 1024));
    m_seekPossible = 0;
    m_cacheFull = false;
+   m_seekRequest = false;
+   m_prefetch = false;
+   m_prefetchPos = 0;
 }
 
 CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache) : CThread("CFileCache")
@@ -103,6 +110,9 @@ CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache) : CThread("CFi
   m_writePos = 0;
   m_nSeekResult = 0;
   m_chunkSize = 0;
+  m_seekRequest = false;
+  m_prefetch = false;
+  m_prefetchPos = 0;
 }
 
 CFileCache::~CFileCache()
@@ -172,6 +182,8 @@ bool CFileCache::Open(const CURL& url)
   m_writeRate = 1024 * 1024;
   m_writeRateActual = 0;
   m_cacheFull = false;
+  m_seekRequest = false;
+  m_prefetch = false;
   m_seekEvent.Reset();
   m_seekEnded.Reset();
 
@@ -205,20 +217,55 @@ void CFileCache::Process()
     if (m_seekEvent.WaitMSec(0))
     {
       m_seekEvent.Reset();
-      CLog::Log(LOGDEBUG,"%s, request seek on source to %"PRId64, __FUNCTION__, m_seekPos);
-      m_nSeekResult = m_source.Seek(m_seekPos, SEEK_SET);
-      if (m_nSeekResult != m_seekPos)
+
+      // a seek asked for by the reader always wins over moving the source ahead
+      bool seek, prefetch;
+      int64_t pos;
+      {
+        CSingleLock lock(m_requestSync);
+        seek = m_seekRequest;
+        prefetch = !seek && m_prefetch;
+        pos = seek ? m_seekPos : m_prefetchPos;
+        m_seekRequest = false;
+        m_prefetch = false;
+      }
+
+      if (prefetch)
+      {
+        // the reader continues in data we already have, so move the source
+        // to where that data ends instead of reading it once more
+        if (m_source.Seek(pos, SEEK_SET) == pos)
+        {
+          m_pCache->ResetWritePosition(pos);
+          average.Reset(pos);
+          limiter.Reset(pos);
+          m_writePos = pos;
+          m_cacheFull = false;
+        }
+        else
+        {
+          CLog::Log(LOGDEBUG, "%s, failed to move source to cached data end %"PRId64, __FUNCTION__, pos);
+          m_source.Seek(m_writePos, SEEK_SET);
+        }
+        continue;
+      }
+      else if (!seek)
+        continue;
+
+      CLog::Log(LOGDEBUG,"%s, request seek on source to %"PRId64, __FUNCTION__, pos);
+      m_nSeekResult = m_source.Seek(pos, SEEK_SET);
+      if (m_nSeekResult != pos)
       {
         CLog::Log(LOGERROR,"%s, error %d seeking. seek returned %"PRId64, __FUNCTION__, (int)GetLastError(), m_nSeekResult);
         m_seekPossible = m_source.IoControl(IOCTRL_SEEK_POSSIBLE, NULL);
       }
       else
       {
-        m_pCache->Reset(m_seekPos);
-        average.Reset(m_seekPos);
-        limiter.Reset(m_seekPos);
-        m_writePos = m_seekPos;
-        m_readPos = m_seekPos;
+        m_pCache->Reset(pos);
+        average.Reset(pos);
+        limiter.Reset(pos);
+        m_writePos = pos;
+        m_readPos = pos;
         m_cacheFull = false;
       }
 
@@ -297,6 +344,14 @@ void CFileCache::Process()
 
     m_writePos += iTotalWrite;
 
+    // skip over what a sparse cache holds already rather than fetching it again
+    if (m_seekPossible)
+    {
+      int64_t cachedEnd = m_pCache->CachedDataEndPosIfSeekTo(m_writePos);
+      if (cachedEnd > m_writePos && cachedEnd < m_source.GetLength())
+        RequestPrefetch(cachedEnd);
+    }
+
     // under estimate write rate by a second, to
     // avoid uncertainty at start of caching
     m_writeRateActual = average.Rate(m_writePos, 1000);
@@ -394,10 +449,16 @@ int64_t CFileCache::Seek(int64_t iFilePosition, int iWhence)
       return m_nSeekResult;
 
     /* never request closer to end than 2k, speeds up tag reading */
-    m_seekPos = std::min(iTarget, std::max((int64_t)0, m_source.GetLength() - m_chunkSize));
+    {
+      CSingleLock lock(m_requestSync);
+      m_seekRequest = true;
+      m_prefetch = false;
+      m_seekPos = std::min(iTarget, std::max((int64_t)0, m_source.GetLength() - m_chunkSize));
+    }
 
+    m_seekEnded.Reset();
     m_seekEvent.Set();
-    if (!m_seekEnded.Wait())
+    if (!m_seekEnded.WaitMSec(SEEK_TIMEOUT))
     {
       CLog::Log(LOGWARNING,"%s - seek to %"PRId64" failed.", __FUNCTION__, m_seekPos);
       return -1;
@@ -415,14 +476,31 @@ int64_t CFileCache::Seek(int64_t iFilePosition, int iWhence)
       m_pCache->Seek(iTarget);
     }
     m_readPos = iTarget;
-    m_seekEvent.Reset();
   }
   else
+  {
     m_readPos = iTarget;
 
+    // the data we landed in may end before the source position, move the
+    // source there in the background so reading doesn't stall at its end
+    int64_t cachedEnd = m_pCache->CachedDataEndPosIfSeekTo(iTarget);
+    if (m_seekPossible && cachedEnd >= 0 && cachedEnd != m_writePos && cachedEnd < m_source.GetLength())
+      RequestPrefetch(cachedEnd);
+  }
+
   return m_nSeekResult;
 }
 
+void CFileCache::RequestPrefetch(int64_t pos)
+{
+  CSingleLock lock(m_requestSync);
+  if (m_seekRequest)
+    return;
+  m_prefetchPos = pos;
+  m_prefetch = true;
+  m_seekEvent.Set();
+}
+
 void CFileCache::Close()
 {
   StopThread();
@@ -481,5 +559,8 @@ int CFileCache::IoControl(EIoControl request, void* param)
   if (request == IOCTRL_SEEK_POSSIBLE)
     return m_seekPossible;
 
+  if (request == IOCTRL_CACHE_STATS)
+    return m_pCache->GetStats(*(SCacheStats*)param) ? 0 : -1;
+
   return -1;
 }
@@ -61,6 +61,10 @@ namespace XFILE
     virtual CStdString GetContent();
 
   private:
+    /*! \brief Ask the cache thread to move the source to pos, unless the reader is waiting for a seek
+     */
+    void RequestPrefetch(int64_t pos);
+
     CCacheStrategy *m_pCache;
     bool      m_bDeleteCache;
     int        m_seekPossible;
@@ -76,6 +80,10 @@ namespace XFILE
     unsigned     m_writeRate;
     unsigned     m_writeRateActual;
     bool         m_cacheFull;
+    bool         m_seekRequest; // the reader waits for the source to seek to m_seekPos
+    bool         m_prefetch;    // move the source to m_prefetchPos without disturbing the reader
+    int64_t      m_prefetchPos;
+    CCriticalSection m_requestSync; // guards the seek and prefetch requests, m_sync is held by a waiting reader
     CCriticalSection m_sync;
   };
 
@@ -0,0 +1,384 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/SystemClock.h"
+#include "system.h"
+#include "utils/log.h"
+#include "threads/SingleLock.h"
+#include "SparseCache.h"
+
+#include <string.h>
+
+using namespace XFILE;
+
+#define SPARSE_BLOCK_SIZE (64 * 1024)
+
+CSparseCache::CSparseCache(size_t size)
+ : CCacheStrategy()
+ , m_cur(0)
+ , m_write(0)
+ , m_size(std::max<size_t>(size, 4 * SPARSE_BLOCK_SIZE))
+ , m_used(0)
+ , m_use(0)
+ , m_hits(0)
+ , m_misses(0)
+{
+}
+
+CSparseCache::~CSparseCache()
+{
+  Close();
+}
+
+int CSparseCache::Open()
+{
+  CSingleLock lock(m_sync);
+  m_cur    = 0;
+  m_write  = 0;
+  m_use    = 0;
+  m_hits   = 0;
+  m_misses = 0;
+  return CACHE_RC_OK;
+}
+
+void CSparseCache::Close()
+{
+  CSingleLock lock(m_sync);
+  while (!m_ranges.empty())
+    FreeRange(m_ranges.begin());
+}
+
+/**
+ * Returns the range holding the byte at pos
+ */
+CSparseCache::RangeMap::iterator CSparseCache::Find(int64_t pos)
+{
+  RangeMap::iterator it = m_ranges.upper_bound(pos);
+  if (it == m_ranges.begin())
+    return m_ranges.end();
+
+  --it;
+  if (pos < it->second->end)
+    return it;
+
+  return m_ranges.end();
+}
+
+/**
+ * Ranges can touch without being merged, this follows them to the
+ * end of the data that can be read without a gap
+ */
+int64_t CSparseCache::ChainEnd(RangeMap::iterator it)
+{
+  int64_t end = it->second->end;
+  while ((it = m_ranges.find(end)) != m_ranges.end())
+    end = it->second->end;
+  return end;
+}
+
+void CSparseCache::FreeRange(RangeMap::iterator it)
+{
+  CRange *range = it->second;
+  for (size_t i = 0; i < range->blocks.size(); i++)
+    delete[] range->blocks[i];
+
+  m_used -= range->blocks.size() * SPARSE_BLOCK_SIZE;
+  m_ranges.erase(it);
+  delete range;
+}
+
+/**
+ * Makes room for one more block. The least recently used range goes
+ * first, the start and the end of the file last. The ranges that are
+ * being read and written are only trimmed behind the read position.
+ */
+bool CSparseCache::FreeBlock(const CRange *writer, const CRange *reader)
+{
+  RangeMap::iterator victim = m_ranges.end();
+  bool victimPinned = true;
+  for (RangeMap::iterator it = m_ranges.begin(); it != m_ranges.end(); ++it)
+  {
+    const CRange *range = it->second;
+    if (range == writer || range == reader)
+      continue;
+
+    bool pinned = range->start == 0 || range->tail;
+    if (victim == m_ranges.end()
+    || (victimPinned && !pinned)
+    || (victimPinned == pinned && range->lastUse < victim->second->lastUse))
+    {
+      victim = it;
+      victimPinned = pinned;
+    }
+  }
+
+  if (victim != m_ranges.end())
+  {
+    FreeRange(victim);
+    return true;
+  }
+
+  // nothing else to drop, so give up data behind the reader
+  if (reader == NULL)
+    return false;
+
+  RangeMap::iterator it = m_ranges.find(reader->start);
+  CRange *range = it->second;
+  if ((uint64_t)(range->start + SPARSE_BLOCK_SIZE) > m_cur)
+    return false;
+
+  delete[] range->blocks.front();
+  range->blocks.erase(range->blocks.begin());
+  range->start += SPARSE_BLOCK_SIZE;
+  m_used -= SPARSE_BLOCK_SIZE;
+
+  m_ranges.erase(it);
+  m_ranges[range->start] = range;
+  return true;
+}
+
+/**
+ * Appends to the range that ends where the source currently is. Data
+ * that is already cached is skipped, and a write never crosses a block
+ * or the start of the next range, so multiple calls may be needed.
+ */
+int CSparseCache::WriteToCache(const char *buf, size_t len)
+{
+  CSingleLock lock(m_sync);
+
+  RangeMap::iterator it = Find(m_write);
+  if (it != m_ranges.end())
+  {
+    size_t skip = (size_t)std::min<int64_t>(len, it->second->end - m_write);
+    m_write += skip;
+    m_written.Set();
+    return skip;
+  }
+
+  RangeMap::iterator next = m_ranges.lower_bound(m_write);
+  if (next != m_ranges.end() && (uint64_t)(next->first - m_write) < len)
+    len = (size_t)(next->first - m_write);
+
+  CRange *range = NULL;
+  if (next != m_ranges.begin())
+  {
+    RangeMap::iterator prev = next;
+    --prev;
+    if ((uint64_t)prev->second->end == m_write)
+      range = prev->second;
+  }
+
+  if (len == 0)
+    return 0;
+
+  size_t offset = (size_t)(m_write - (range ? range->start : m_write));
+  size_t index  = offset / SPARSE_BLOCK_SIZE;
+  size_t within = offset % SPARSE_BLOCK_SIZE;
+
+  if (range == NULL || index == range->blocks.size())
+  {
+    RangeMap::iterator reader = Find(m_cur);
+    while (m_used + SPARSE_BLOCK_SIZE > m_size)
+    {
+      if (!FreeBlock(range, reader != m_ranges.end() ? reader->second : NULL))
+        return 0;
+      reader = Find(m_cur);
+    }
+
+    // trimming may have moved the start of the range
+    if (range)
+    {
+      offset = (size_t)(m_write - range->start);
+      index  = offset / SPARSE_BLOCK_SIZE;
+    }
+    else
+    {
+      range = new CRange;
+      range->start = range->end = m_write;
+      range->tail  = false;
+      m_ranges[range->start] = range;
+      index  = 0;
+      within = 0;
+    }
+
+    range->blocks.push_back(new uint8_t[SPARSE_BLOCK_SIZE]);
+    m_used += SPARSE_BLOCK_SIZE;
+  }
+
+  if (len > SPARSE_BLOCK_SIZE - within)
+    len = SPARSE_BLOCK_SIZE - within;
+
+  memcpy(range->blocks[index] + within, buf, len);
+  range->end    += len;
+  range->lastUse = ++m_use;
+  m_write       += len;
+
+  m_written.Set();
+
+  return len;
+}
+
+/**
+ * Reads data from cache. Will only read up till the end of
+ * a block, so multiple calls may be needed
+ */
+int CSparseCache::ReadFromCache(char *buf, size_t len)
+{
+  CSingleLock lock(m_sync);
+
+  RangeMap::iterator it = Find(m_cur);
+  if (it == m_ranges.end())
+  {
+    if (IsEndOfInput() && m_cur >= m_write)
+      return 0;
+    else
+      return CACHE_RC_WOULD_BLOCK;
+  }
+
+  CRange *range = it->second;
+  size_t offset = (size_t)(m_cur - range->start);
+  size_t within = offset % SPARSE_BLOCK_SIZE;
+  size_t avail  = (size_t)std::min<int64_t>(SPARSE_BLOCK_SIZE - within, range->end - m_cur);
+
+  if (len > avail)
+    len = avail;
+
+  if (len == 0)
+    return 0;
+
+  memcpy(buf, range->blocks[offset / SPARSE_BLOCK_SIZE] + within, len);
+  m_cur += len;
+  range->lastUse = ++m_use;
+
+  m_space.Set();
+
+  return len;
+}
+
+int64_t CSparseCache::WaitForData(unsigned int minimum, unsigned int millis)
+{
+  CSingleLock lock(m_sync);
+  RangeMap::iterator it = Find(m_cur);
+  uint64_t avail = it != m_ranges.end() ? ChainEnd(it) - m_cur : 0;
+
+  if (millis == 0 || IsEndOfInput())
+    return avail;
+
+  if (minimum > m_size / 2)
+    minimum = m_size / 2;
+
+  XbmcThreads::EndTime endtime(millis);
+  while (!IsEndOfInput() && avail < minimum && !endtime.IsTimePast() )
+  {
+    lock.Leave();
+    m_written.WaitMSec(50); // may miss the deadline. shouldn't be a problem.
+    lock.Enter();
+    it = Find(m_cur);
+    avail = it != m_ranges.end() ? ChainEnd(it) - m_cur : 0;
+  }
+
+  return avail;
+}
+
+int64_t CSparseCache::Seek(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+
+  // if seek is a bit over what the source delivered, try to wait a few seconds for the data to be available.
+  // we try to avoid a (heavy) seek on the source
+  if (Find(pos) == m_ranges.end() && (uint64_t)pos >= m_write && (uint64_t)pos < m_write + 100000)
+  {
+    XbmcThreads::EndTime endtime(5000);
+    while (!IsEndOfInput() && (uint64_t)pos >= m_write && !endtime.IsTimePast())
+    {
+      lock.Leave();
+      m_written.WaitMSec(50);
+      lock.Enter();
+    }
+  }
+
+  RangeMap::iterator it = Find(pos);
+  if (it != m_ranges.end())
+  {
+    it->second->lastUse = ++m_use;
+    m_hits++;
+    m_cur = pos;
+    return pos;
+  }
+
+  if ((uint64_t)pos == m_write)
+  {
+    m_cur = pos;
+    return pos;
+  }
+
+  m_misses++;
+  return CACHE_RC_ERROR;
+}
+
+/**
+ * Unlike the other strategies, the cached ranges survive a source seek
+ */
+void CSparseCache::Reset(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+  m_write = pos;
+  m_cur   = pos;
+}
+
+void CSparseCache::ResetWritePosition(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+  m_write = pos;
+}
+
+void CSparseCache::EndOfInput()
+{
+  CSingleLock lock(m_sync);
+  CCacheStrategy::EndOfInput();
+
+  // remember which range holds the end of the file
+  RangeMap::iterator it = m_ranges.lower_bound(m_write);
+  if (it != m_ranges.begin() && (uint64_t)(--it)->second->end == m_write)
+    it->second->tail = true;
+
+  m_written.Set();
+}
+
+int64_t CSparseCache::CachedDataEndPosIfSeekTo(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+  RangeMap::iterator it = Find(pos);
+  if (it == m_ranges.end())
+    return pos;
+  return ChainEnd(it);
+}
+
+bool CSparseCache::GetStats(SCacheStats &stats)
+{
+  CSingleLock lock(m_sync);
+  stats.hits   = m_hits;
+  stats.misses = m_misses;
+  stats.ranges = m_ranges.size();
+  stats.cached = 0;
+  for (RangeMap::const_iterator it = m_ranges.begin(); it != m_ranges.end(); ++it)
+    stats.cached += it->second->end - it->second->start;
+  return true;
+}
@@ -0,0 +1,91 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CACHESPARSE_H
+#define CACHESPARSE_H
+
+#include "CacheStrategy.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+
+#include <map>
+#include <vector>
+
+namespace XFILE {
+
+/**
+ * Keeps any number of disjoint ranges of the file in memory, so seeking
+ * back to data that was read before (the header and index, the tail, a
+ * previous chapter) doesn't need the source. Ranges are filled in blocks
+ * from a shared budget and the least recently used range is dropped when
+ * the budget runs out. The ranges at the start and at the end of the file
+ * are only dropped when nothing else is left.
+ */
+class CSparseCache : public CCacheStrategy
+{
+public:
+    CSparseCache(size_t size);
+    virtual ~CSparseCache();
+
+    virtual int Open() ;
+    virtual void Close();
+
+    virtual int WriteToCache(const char *buf, size_t len) ;
+    virtual int ReadFromCache(char *buf, size_t len) ;
+    virtual int64_t WaitForData(unsigned int minimum, unsigned int iMillis) ;
+
+    virtual int64_t Seek(int64_t pos) ;
+    virtual void Reset(int64_t pos) ;
+    virtual void EndOfInput();
+
+    virtual int64_t CachedDataEndPosIfSeekTo(int64_t pos);
+    virtual void ResetWritePosition(int64_t pos);
+    virtual bool GetStats(SCacheStats &stats);
+
+protected:
+    struct CRange
+    {
+      int64_t  start;               /**< index in file of the first byte */
+      int64_t  end;                 /**< index in file after the last byte */
+      unsigned lastUse;             /**< sequence number of the last access */
+      bool     tail;                /**< the range reaches the end of the file */
+      std::vector<uint8_t*> blocks; /**< block i holds start + i * block size onwards */
+    };
+    typedef std::map<int64_t, CRange*> RangeMap;
+
+    RangeMap::iterator Find(int64_t pos);
+    int64_t ChainEnd(RangeMap::iterator it);
+    bool    FreeBlock(const CRange *writer, const CRange *reader);
+    void    FreeRange(RangeMap::iterator it);
+
+    RangeMap          m_ranges;
+    uint64_t          m_cur;       /**< current reading index in file */
+    uint64_t          m_write;     /**< index in file of the next byte the source delivers */
+    size_t            m_size;      /**< memory budget for all ranges */
+    size_t            m_used;      /**< memory held in blocks */
+    unsigned          m_use;       /**< access counter for lru */
+    uint64_t          m_hits;
+    uint64_t          m_misses;
+    CCriticalSection  m_sync;
+    CEvent            m_written;
+};
+
+} // namespace XFILE
+#endif
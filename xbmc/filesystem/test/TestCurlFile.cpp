@@ -0,0 +1,287 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/CurlFile.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+#include "URL.h"
+
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+#define TESTPORT      18081
+#define TESTURL       "http://127.0.0.1:18081/file"
+#define FILESIZE      (4 * 1024 * 1024)
+#define LATENCY       50000       // us before a request is answered
+#define CHUNKSIZE     (32 * 1024)
+#define CHUNKDELAY    10000       // us between chunks, a stream limited by its round trip
+#define SEGMENTSIZE   (256 * 1024)
+#define SEGMENTS      4
+
+static char Pattern(int64_t pos)
+{
+  return (char)(pos * 31 % 251);
+}
+
+static bool MatchesPattern(const char *buffer, int64_t pos, unsigned int size)
+{
+  for (unsigned int i = 0; i < size; i++)
+  {
+    if (buffer[i] != Pattern(pos + i))
+      return false;
+  }
+  return true;
+}
+
+// answers one request on a connection of its own, slowly
+class CLatencyConnection : public CThread
+{
+public:
+  CLatencyConnection(int fd) : CThread("TestCurlFileConnection"), m_fd(fd) { }
+
+protected:
+  virtual void Process()
+  {
+    std::string request;
+    char buffer[4096];
+    int res;
+    while (request.find("\r\n\r\n") == std::string::npos && (res = recv(m_fd, buffer, sizeof(buffer), 0)) > 0)
+      request.append(buffer, res);
+
+    int64_t start = 0;
+    int64_t end = FILESIZE - 1;
+    size_t range = request.find("Range: bytes=");
+    bool partial = range != std::string::npos;
+    if (partial)
+    {
+      long long first = 0, last = end;
+      if (sscanf(request.c_str() + range, "Range: bytes=%lld-%lld", &first, &last) >= 1)
+      {
+        start = first;
+        end = std::min((int64_t)last, end);
+      }
+    }
+
+    usleep(LATENCY);
+
+    char header[512];
+    if (partial)
+      snprintf(header, sizeof(header), "HTTP/1.1 206 Partial Content\r\n"
+                                       "Content-Type: application/octet-stream\r\n"
+                                       "Content-Length: %lld\r\n"
+                                       "Content-Range: bytes %lld-%lld/%d\r\n"
+                                       "Connection: close\r\n\r\n",
+                                       (long long)(end - start + 1), (long long)start, (long long)end, FILESIZE);
+    else
+      snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\n"
+                                       "Content-Type: application/octet-stream\r\n"
+                                       "Content-Length: %d\r\n"
+                                       "Connection: close\r\n\r\n", FILESIZE);
+
+    if (send(m_fd, header, strlen(header), MSG_NOSIGNAL) > 0)
+    {
+      char chunk[CHUNKSIZE];
+      for (int64_t pos = start; pos <= end && !m_bStop; pos += CHUNKSIZE)
+      {
+        unsigned int size = (unsigned int)std::min((int64_t)CHUNKSIZE, end - pos + 1);
+        for (unsigned int i = 0; i < size; i++)
+          chunk[i] = Pattern(pos + i);
+
+        if (send(m_fd, chunk, size, MSG_NOSIGNAL) != (ssize_t)size)
+          break;
+        usleep(CHUNKDELAY);
+      }
+    }
+    close(m_fd);
+  }
+
+  int m_fd;
+};
+
+class CLatencyServer : public CThread
+{
+public:
+  CLatencyServer() : CThread("TestCurlFileServer"), m_fd(-1) { }
+
+  bool Start()
+  {
+    m_fd = socket(PF_INET, SOCK_STREAM, 0);
+    if (m_fd < 0)
+      return false;
+
+    int yes = 1;
+    setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TESTPORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(m_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(m_fd, 16) < 0)
+    {
+      close(m_fd);
+      m_fd = -1;
+      return false;
+    }
+
+    Create();
+    return true;
+  }
+
+  void Stop()
+  {
+    StopThread(true);
+    if (m_fd >= 0)
+      close(m_fd);
+    m_fd = -1;
+  }
+
+protected:
+  virtual void Process()
+  {
+    while (!m_bStop)
+    {
+      fd_set fds;
+      FD_ZERO(&fds);
+      FD_SET(m_fd, &fds);
+      struct timeval timeout = { 0, 100000 };
+      if (select(m_fd + 1, &fds, NULL, NULL, &timeout) <= 0)
+        continue;
+
+      int client = accept(m_fd, NULL, NULL);
+      if (client >= 0)
+        (new CLatencyConnection(client))->Create(true);
+    }
+  }
+
+  int m_fd;
+};
+
+class TestCurlFile : public testing::Test
+{
+protected:
+  TestCurlFile()
+  {
+    m_segments = g_advancedSettings.m_curlSegments;
+    m_segmentSize = g_advancedSettings.m_curlSegmentSize;
+    g_advancedSettings.m_curlSegmentSize = SEGMENTSIZE;
+    m_started = m_server.Start();
+  }
+
+  ~TestCurlFile()
+  {
+    m_server.Stop();
+    g_advancedSettings.m_curlSegments = m_segments;
+    g_advancedSettings.m_curlSegmentSize = m_segmentSize;
+  }
+
+  CLatencyServer m_server;
+  bool m_started;
+  int m_segments;
+  int m_segmentSize;
+};
+
+static unsigned int ReadAll(XFILE::CCurlFile &file, int64_t &bytes, bool &matches)
+{
+  char buffer[CHUNKSIZE];
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  unsigned int res;
+  bytes = 0;
+  matches = true;
+  while ((res = file.Read(buffer, sizeof(buffer))) > 0)
+  {
+    matches = matches && MatchesPattern(buffer, bytes, res);
+    bytes += res;
+  }
+  return XbmcThreads::SystemClockMillis() - start;
+}
+
+TEST_F(TestCurlFile, SegmentedRead)
+{
+  ASSERT_TRUE(m_started);
+  g_advancedSettings.m_curlSegments = SEGMENTS;
+
+  XFILE::CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(TESTURL)));
+  EXPECT_EQ(FILESIZE, file.GetLength());
+  EXPECT_EQ(1, file.IoControl(XFILE::IOCTRL_SEEK_POSSIBLE, NULL));
+
+  int64_t bytes;
+  bool matches;
+  ReadAll(file, bytes, matches);
+  EXPECT_EQ(FILESIZE, bytes);
+  EXPECT_TRUE(matches);
+
+  // seeks within the requested ranges, backwards and past them
+  int64_t positions[] = { 1000, 1000 + SEGMENTSIZE + 17, 3 * SEGMENTSIZE - 5, 100, FILESIZE - 1000 };
+  for (unsigned int i = 0; i < sizeof(positions) / sizeof(positions[0]); i++)
+  {
+    char buffer[2000];
+    unsigned int size = (unsigned int)std::min((int64_t)sizeof(buffer), FILESIZE - positions[i]);
+    ASSERT_EQ(positions[i], file.Seek(positions[i], SEEK_SET));
+
+    unsigned int received = 0;
+    unsigned int res;
+    while (received < size && (res = file.Read(buffer + received, size - received)) > 0)
+      received += res;
+
+    EXPECT_EQ(size, received);
+    EXPECT_TRUE(MatchesPattern(buffer, positions[i], received));
+    EXPECT_EQ(positions[i] + received, file.GetPosition());
+  }
+
+  file.Close();
+}
+
+TEST_F(TestCurlFile, SegmentedReadBenchmark)
+{
+  ASSERT_TRUE(m_started);
+
+  int segments[] = { 1, SEGMENTS };
+  for (unsigned int i = 0; i < sizeof(segments) / sizeof(segments[0]); i++)
+  {
+    g_advancedSettings.m_curlSegments = segments[i];
+
+    XFILE::CCurlFile file;
+    ASSERT_TRUE(file.Open(CURL(TESTURL)));
+
+    int64_t bytes;
+    bool matches;
+    unsigned int elapsed = ReadAll(file, bytes, matches);
+    file.Close();
+
+    EXPECT_EQ(FILESIZE, bytes);
+    EXPECT_TRUE(matches);
+
+    std::cout << "Segments: " << testing::PrintToString(segments[i]) << std::endl;
+    std::cout << "  Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+    std::cout << "  KB/sec: " << testing::PrintToString(elapsed ? bytes * 1000 / 1024 / elapsed : 0) << std::endl;
+  }
+}
@@ -0,0 +1,249 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/DirectoryCache.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+#include "FileItem.h"
+
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+#define ITEMS     5000
+#define THREADS   4
+#define LOOKUPS   50
+
+static void FillListing(CFileItemList &items, const CStdString &strPath, int count)
+{
+  items.SetPath(strPath);
+  for (int i = 0; i < count; i++)
+  {
+    CStdString strFile;
+    strFile.Format("%sfile%05d.mkv", strPath.c_str(), i);
+    CFileItemPtr item(new CFileItem(strFile, false));
+    item->SetLabel(strFile.Mid(strPath.size()));
+    items.Add(item);
+  }
+}
+
+class TestDirectoryCache : public testing::Test
+{
+protected:
+  TestDirectoryCache()
+  {
+    m_size = g_advancedSettings.m_directoryCacheSize;
+  }
+
+  ~TestDirectoryCache()
+  {
+    g_advancedSettings.m_directoryCacheSize = m_size;
+  }
+
+  unsigned int m_size;
+};
+
+TEST_F(TestDirectoryCache, CopiesAreIndependent)
+{
+  XFILE::CDirectoryCache cache;
+  CFileItemList items;
+  FillListing(items, "/media/movies/", 10);
+  cache.SetDirectory("/media/movies/", items, XFILE::DIR_CACHE_ALWAYS);
+
+  // changing the stored or returned items doesn't change the cache
+  items[0]->SetPath("/media/movies/changed.mkv");
+
+  CFileItemList first;
+  ASSERT_TRUE(cache.GetDirectory("/media/movies/", first));
+  ASSERT_EQ(10, first.Size());
+  EXPECT_STREQ("/media/movies/file00000.mkv", first[0]->GetPath().c_str());
+  first[1]->SetPath("/media/movies/changed.mkv");
+
+  CFileItemList second;
+  ASSERT_TRUE(cache.GetDirectory("/media/movies/", second));
+  EXPECT_STREQ("/media/movies/file00001.mkv", second[1]->GetPath().c_str());
+
+  bool bInCache;
+  EXPECT_TRUE(cache.FileExists("/media/movies/file00005.mkv", bInCache));
+  EXPECT_TRUE(bInCache);
+  EXPECT_FALSE(cache.FileExists("/media/movies/changed.mkv", bInCache));
+
+  // listings only cached once need to be asked for
+  cache.SetDirectory("/media/music/", items, XFILE::DIR_CACHE_ONCE);
+  EXPECT_FALSE(cache.GetDirectory("/media/music/", first));
+  EXPECT_TRUE(cache.GetDirectory("/media/music/", first, true));
+}
+
+TEST_F(TestDirectoryCache, AddFileCopyOnWrite)
+{
+  XFILE::CDirectoryCache cache;
+  CFileItemList items;
+  FillListing(items, "/media/movies/", 10);
+  cache.SetDirectory("/media/movies/", items, XFILE::DIR_CACHE_ALWAYS);
+
+  CFileItemList before;
+  ASSERT_TRUE(cache.GetDirectory("/media/movies/", before));
+
+  cache.AddFile("/media/movies/new.mkv");
+
+  bool bInCache;
+  EXPECT_TRUE(cache.FileExists("/media/movies/new.mkv", bInCache));
+  EXPECT_EQ(10, before.Size());
+
+  CFileItemList after;
+  ASSERT_TRUE(cache.GetDirectory("/media/movies/", after));
+  EXPECT_EQ(11, after.Size());
+}
+
+TEST_F(TestDirectoryCache, SharedListing)
+{
+  XFILE::CDirectoryCache cache;
+  CFileItemList items;
+  FillListing(items, "/media/movies/", 10);
+  cache.SetDirectory("/media/movies/", items, XFILE::DIR_CACHE_ALWAYS);
+
+  // hits hand out the same listing without copying it
+  boost::shared_ptr<const CFileItemList> first, second;
+  ASSERT_TRUE(cache.GetDirectory("/media/movies/", first));
+  ASSERT_TRUE(cache.GetDirectory("/media/movies/", second));
+  EXPECT_EQ(first.get(), second.get());
+
+  // and a listing that is handed out is replaced rather than changed
+  cache.AddFile("/media/movies/new.mkv");
+  EXPECT_EQ(10, first->Size());
+
+  boost::shared_ptr<const CFileItemList> after;
+  ASSERT_TRUE(cache.GetDirectory("/media/movies/", after));
+  EXPECT_NE(first.get(), after.get());
+  EXPECT_EQ(11, after->Size());
+}
+
+TEST_F(TestDirectoryCache, MemoryBudget)
+{
+  XFILE::CDirectoryCache cache;
+  XFILE::CDirectoryCache::SStats stats;
+
+  CFileItemList items;
+  FillListing(items, "/media/a/", 1000);
+  cache.SetDirectory("/media/a/", items, XFILE::DIR_CACHE_ONCE);
+  cache.GetStats(stats);
+  size_t listingSize = stats.bytes;
+  ASSERT_LT(1000U * sizeof(CFileItem), listingSize);
+
+  // room for a bit more than three listings of this size
+  g_advancedSettings.m_directoryCacheSize = listingSize * 7 / 2;
+
+  CFileItemList always;
+  FillListing(always, "/media/e/", 1000);
+  cache.SetDirectory("/media/e/", always, XFILE::DIR_CACHE_ALWAYS);
+
+  const char *paths[] = { "/media/b/", "/media/c/", "/media/d/" };
+  for (unsigned int i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+  {
+    // using the first one keeps it around
+    CFileItemList first;
+    EXPECT_TRUE(cache.GetDirectory("/media/a/", first, true));
+
+    CFileItemList listing;
+    FillListing(listing, paths[i], 1000);
+    cache.SetDirectory(paths[i], listing, XFILE::DIR_CACHE_ONCE);
+  }
+
+  // the least recently used ones are gone, the ones always cached stay
+  bool bInCache;
+  cache.FileExists("/media/a/file00000.mkv", bInCache);
+  EXPECT_TRUE(bInCache);
+  cache.FileExists("/media/b/file00000.mkv", bInCache);
+  EXPECT_FALSE(bInCache);
+  cache.FileExists("/media/c/file00000.mkv", bInCache);
+  EXPECT_FALSE(bInCache);
+  cache.FileExists("/media/d/file00000.mkv", bInCache);
+  EXPECT_TRUE(bInCache);
+  cache.FileExists("/media/e/file00000.mkv", bInCache);
+  EXPECT_TRUE(bInCache);
+
+  cache.GetStats(stats);
+  EXPECT_EQ(3U, stats.dirs);
+  EXPECT_EQ(3000U, stats.items);
+  EXPECT_EQ(listingSize * 3, stats.bytes);
+  EXPECT_EQ(2U, stats.misses);
+
+  cache.Clear();
+  cache.GetStats(stats);
+  EXPECT_EQ(0U, stats.dirs);
+  EXPECT_EQ(0U, stats.bytes);
+}
+
+class CDirectoryCacheReader : public CThread
+{
+public:
+  CDirectoryCacheReader(XFILE::CDirectoryCache &cache) : CThread("TestDirectoryCacheReader"), m_found(0), m_cache(cache) { }
+
+  unsigned int m_found;
+
+protected:
+  virtual void Process()
+  {
+    for (int i = 0; i < LOOKUPS && !m_bStop; i++)
+    {
+      CFileItemList items;
+      if (m_cache.GetDirectory("/media/movies/", items))
+        m_found += items.Size();
+    }
+  }
+
+  XFILE::CDirectoryCache &m_cache;
+};
+
+TEST_F(TestDirectoryCache, ConcurrentLookupBenchmark)
+{
+  XFILE::CDirectoryCache cache;
+  CFileItemList items;
+  FillListing(items, "/media/movies/", ITEMS);
+  cache.SetDirectory("/media/movies/", items, XFILE::DIR_CACHE_ALWAYS);
+
+  int threads[] = { 1, THREADS };
+  for (unsigned int i = 0; i < sizeof(threads) / sizeof(threads[0]); i++)
+  {
+    std::vector<CDirectoryCacheReader*> readers;
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (int j = 0; j < threads[i]; j++)
+    {
+      readers.push_back(new CDirectoryCacheReader(cache));
+      readers.back()->Create();
+    }
+
+    unsigned int found = 0;
+    for (int j = 0; j < threads[i]; j++)
+    {
+      readers[j]->WaitForThreadExit(60000);
+      found += readers[j]->m_found;
+      delete readers[j];
+    }
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+    EXPECT_EQ((unsigned int)(threads[i] * LOOKUPS * ITEMS), found);
+
+    std::cout << "Threads: " << testing::PrintToString(threads[i]) << std::endl;
+    std::cout << "  Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+    std::cout << "  Lookups/sec: " << testing::PrintToString(elapsed ? (uint64_t)threads[i] * LOOKUPS * 1000 / elapsed : 0) << std::endl;
+  }
+}
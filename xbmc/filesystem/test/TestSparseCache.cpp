@@ -0,0 +1,123 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/SparseCache.h"
+
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+#define BLOCK (64 * 1024)
+
+// fill the cache with the bytes of a file where every byte is its position
+static void Fill(XFILE::CSparseCache &cache, int64_t pos, size_t len)
+{
+  cache.Reset(pos);
+  std::vector<char> data(len);
+  for (size_t i = 0; i < len; i++)
+    data[i] = (char)(pos + i);
+
+  size_t written = 0;
+  while (written < len)
+  {
+    int res = cache.WriteToCache(&data[written], len - written);
+    ASSERT_GT(res, 0);
+    written += res;
+  }
+}
+
+static bool Verify(XFILE::CSparseCache &cache, int64_t pos, size_t len)
+{
+  if (cache.Seek(pos) != pos)
+    return false;
+
+  char buffer[1024];
+  while (len > 0)
+  {
+    int res = cache.ReadFromCache(buffer, std::min(len, sizeof(buffer)));
+    if (res <= 0)
+      return false;
+    for (int i = 0; i < res; i++, pos++)
+    {
+      if (buffer[i] != (char)pos)
+        return false;
+    }
+    len -= res;
+  }
+  return true;
+}
+
+TEST(TestSparseCache, KeepsRangesAcrossSeeks)
+{
+  XFILE::CSparseCache cache(16 * BLOCK);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  // header, a chapter in the middle and the tail
+  Fill(cache, 0, 100000);
+  Fill(cache, 5000000, 200000);
+  Fill(cache, 9000000, 50000);
+  cache.EndOfInput();
+
+  EXPECT_TRUE(Verify(cache, 10, 1000));
+  EXPECT_TRUE(Verify(cache, 5100000, 50000));
+  EXPECT_TRUE(Verify(cache, 9040000, 10000));
+  EXPECT_EQ(CACHE_RC_ERROR, cache.Seek(200000));
+
+  EXPECT_EQ(100000, cache.CachedDataEndPosIfSeekTo(50));
+  EXPECT_EQ(9050000, cache.CachedDataEndPosIfSeekTo(9000000));
+
+  XFILE::SCacheStats stats;
+  ASSERT_TRUE(cache.GetStats(stats));
+  EXPECT_EQ(3U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(3U, stats.ranges);
+  EXPECT_EQ(350000U, stats.cached);
+}
+
+TEST(TestSparseCache, SkipsCachedData)
+{
+  XFILE::CSparseCache cache(16 * BLOCK);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  Fill(cache, 100000, 100000);
+
+  // writing over what we have only advances the source position
+  Fill(cache, 0, 300000);
+  EXPECT_EQ(300000, cache.CachedDataEndPosIfSeekTo(0));
+  EXPECT_TRUE(Verify(cache, 0, 300000));
+}
+
+TEST(TestSparseCache, EvictsLeastRecentlyUsed)
+{
+  XFILE::CSparseCache cache(8 * BLOCK);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  Fill(cache, 0, BLOCK);
+  Fill(cache, 10 * BLOCK, 2 * BLOCK);
+  Fill(cache, 20 * BLOCK, 2 * BLOCK);
+  EXPECT_TRUE(Verify(cache, 10 * BLOCK, 100));
+
+  // needs more room than is left, the range at 20 was used least recently
+  Fill(cache, 30 * BLOCK, 4 * BLOCK);
+  EXPECT_TRUE(Verify(cache, 0, 100));
+  EXPECT_TRUE(Verify(cache, 10 * BLOCK, 100));
+  EXPECT_EQ(CACHE_RC_ERROR, cache.Seek(20 * BLOCK));
+  EXPECT_TRUE(Verify(cache, 30 * BLOCK, 4 * BLOCK));
+}
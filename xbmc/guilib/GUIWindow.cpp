@@ -85,10 +85,9 @@ bool CGUIWindow::Load(const CStdString& strFileName, bool bContainsPath)
   if (m_windowLoaded || g_SkinInfo == NULL)
     return true;      // no point loading if it's already there
 
-#ifdef _DEBUG
   int64_t start;
   start = CurrentHostCounter();
-#endif
+
   const char* strLoadType;
   switch (m_loadType)
   {
@@ -119,12 +118,11 @@ bool CGUIWindow::Load(const CStdString& strFileName, bool bContainsPath)
 
   bool ret = LoadXML(strPath.c_str(), strLowerPath.c_str());
 
-#ifdef _DEBUG
+  // windows loaded every time they're opened pay this on each activation, so always log it
   int64_t end, freq;
   end = CurrentHostCounter();
   freq = CurrentHostFrequency();
   CLog::Log(LOGDEBUG,"Load %s: %.2fms", GetProperty("xmlfile").c_str(), 1000.f * (end - start) / freq);
-#endif
   return ret;
 }
 
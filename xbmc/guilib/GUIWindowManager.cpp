@@ -954,6 +954,17 @@ void CGUIWindowManager::GetActiveModelessWindows(vector<int> &ids)
   }
 }
 
+void CGUIWindowManager::GetActiveWindowState(vector<int> &state) const
+{
+  CSingleLock lock(g_graphicsContext);
+  state.push_back(GetActiveWindow());
+  for (ciDialog it = m_activeDialogs.begin(); it != m_activeDialogs.end(); ++it)
+  {
+    state.push_back((*it)->GetID());
+    state.push_back((*it)->IsAnimating(ANIM_TYPE_WINDOW_CLOSE) ? 1 : 0);
+  }
+}
+
 CGUIWindow *CGUIWindowManager::GetTopMostDialog() const
 {
   CSingleLock lock(g_graphicsContext);
@@ -135,6 +135,11 @@ public:
   bool IsOverlayAllowed() const;
   void ShowOverlay(CGUIWindow::OVERLAY_STATE state);
   void GetActiveModelessWindows(std::vector<int> &ids);
+  /*! \brief Get the active window and dialogs, and whether the dialogs are closing
+   Used to tell when the result of any of the window visibility checks may have changed.
+   \param state vector to fill with the active window id followed by each dialog id and its closing flag
+   */
+  void GetActiveWindowState(std::vector<int> &state) const;
 #ifdef _DEBUG
   void DumpTextureUse();
 #endif
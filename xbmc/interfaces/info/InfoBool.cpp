@@ -30,11 +30,12 @@ InfoSingle::InfoSingle(const CStdString &expression, int context)
 : InfoBool(expression, context)
 {
   m_condition = g_infoManager.TranslateSingleString(expression);
+  m_sources = g_infoManager.GetConditionSources(m_condition);
 }
 
-void InfoSingle::Update(const CGUIListItem *item)
+bool InfoSingle::Evaluate(const CGUIListItem *item)
 {
-  m_value = g_infoManager.GetBool(m_condition, m_context, item);
+  return g_infoManager.GetBool(m_condition, m_context, item);
 }
 
 InfoExpression::InfoExpression(const CStdString &expression, int context)
@@ -43,9 +44,11 @@ InfoExpression::InfoExpression(const CStdString &expression, int context)
   Parse(expression);
 }
 
-void InfoExpression::Update(const CGUIListItem *item)
+bool InfoExpression::Evaluate(const CGUIListItem *item)
 {
-  Evaluate(item, m_value);
+  if (m_nodes.empty())
+    return false;
+  return EvaluateNode(m_nodes.size() - 1, item);
 }
 
 #define OPERATOR_LB   5
@@ -142,45 +145,120 @@ void InfoExpression::Parse(const CStdString &expression)
     operators.pop();
   }
 
-  // test evaluate
-  bool test;
-  if (!Evaluate(NULL, test))
+  if (!Compile())
+  {
     CLog::Log(LOGERROR, "Error evaluating boolean expression %s", expression.c_str());
+    m_nodes.clear();
+    m_sources = 0;
+  }
+}
+
+/* operands that are cached are cheap to ask for, so should be tried first */
+static bool IsCached(unsigned int sources)
+{
+  return !(sources & (INFO_SOURCE_VOLATILE | INFO_SOURCE_CONTAINER | INFO_SOURCE_LISTITEM));
 }
 
-bool InfoExpression::Evaluate(const CGUIListItem *item, bool &result)
+bool InfoExpression::Compile()
 {
-  stack<bool> save;
+  stack<unsigned int> save;
   for (vector<short>::const_iterator it = m_postfix.begin(); it != m_postfix.end(); ++it)
   {
     short expr = *it;
     if (expr == -OPERATOR_NOT)
-    { // NOT the top item on the stack
+    { // a double negative is the operand itself
       if (save.size() < 1) return false;
-      bool expr = save.top();
-      save.pop();
-      save.push(!expr);
+      unsigned int node = save.top(); save.pop();
+      if (m_nodes[node].m_type == OPERATOR_NOT)
+        save.push(m_nodes[node].m_children[0]);
+      else
+      {
+        m_nodes.push_back(Node(OPERATOR_NOT, 0, m_nodes[node].m_sources));
+        m_nodes.back().m_children.push_back(node);
+        save.push(m_nodes.size() - 1);
+      }
     }
-    else if (expr == -OPERATOR_AND)
-    { // AND the top two items on the stack
+    else if (expr == -OPERATOR_AND || expr == -OPERATOR_OR)
+    {
       if (save.size() < 2) return false;
-      bool right = save.top(); save.pop();
-      bool left = save.top(); save.pop();
-      save.push(left && right);
+      unsigned int right = save.top(); save.pop();
+      unsigned int left = save.top(); save.pop();
+      save.push(AddOperator(-expr, left, right));
     }
-    else if (expr == -OPERATOR_OR)
-    { // OR the top two items on the stack
-      if (save.size() < 2) return false;
-      bool right = save.top(); save.pop();
-      bool left = save.top(); save.pop();
-      save.push(left || right);
+    else if (expr >= 0)
+    {
+      unsigned int info = m_operands[expr];
+      m_nodes.push_back(Node(0, info, g_infoManager.GetBoolSources(info)));
+      save.push(m_nodes.size() - 1);
     }
-    else  // operand
-      save.push(g_infoManager.GetBoolValue(m_operands[expr], item));
+    else
+      return false;
   }
   if (save.size() != 1)
     return false;
-  result = save.top();
+
+  // the root is evaluated as the last node, so move it there if needed
+  if (save.top() != m_nodes.size() - 1)
+  {
+    Node root = m_nodes[save.top()];
+    m_nodes.push_back(root);
+  }
+
+  m_sources = m_nodes.back().m_sources;
   return true;
 }
 
+unsigned int InfoExpression::AddOperator(short type, unsigned int left, unsigned int right)
+{
+  Node node(type, 0, m_nodes[left].m_sources | m_nodes[right].m_sources);
+  unsigned int operands[] = { left, right };
+  for (unsigned int i = 0; i < 2; i++)
+  { // flatten runs of the same operator, so [a + b] + c is a single node
+    const Node &operand = m_nodes[operands[i]];
+    if (operand.m_type == type)
+      node.m_children.insert(node.m_children.end(), operand.m_children.begin(), operand.m_children.end());
+    else
+      node.m_children.push_back(operands[i]);
+  }
+
+  // reorder the children so the cheap ones come first, keeping the order otherwise
+  vector<unsigned int> children;
+  for (unsigned int pass = 0; pass < 2; pass++)
+  {
+    for (vector<unsigned int>::const_iterator it = node.m_children.begin(); it != node.m_children.end(); ++it)
+    {
+      if (IsCached(m_nodes[*it].m_sources) == (pass == 0))
+        children.push_back(*it);
+    }
+  }
+  node.m_children = children;
+
+  m_nodes.push_back(node);
+  return m_nodes.size() - 1;
+}
+
+bool InfoExpression::EvaluateNode(unsigned int node, const CGUIListItem *item) const
+{
+  const Node &n = m_nodes[node];
+  if (n.m_type == OPERATOR_NOT)
+    return !EvaluateNode(n.m_children[0], item);
+  else if (n.m_type == OPERATOR_AND)
+  {
+    for (vector<unsigned int>::const_iterator it = n.m_children.begin(); it != n.m_children.end(); ++it)
+    {
+      if (!EvaluateNode(*it, item))
+        return false;
+    }
+    return true;
+  }
+  else if (n.m_type == OPERATOR_OR)
+  {
+    for (vector<unsigned int>::const_iterator it = n.m_children.begin(); it != n.m_children.end(); ++it)
+    {
+      if (EvaluateNode(*it, item))
+        return true;
+    }
+    return false;
+  }
+  return g_infoManager.GetBoolValue(n.m_info, item);
+}
@@ -28,6 +28,21 @@ class CGUIListItem;
 
 namespace INFO
 {
+/*! \name Info bool sources
+ The parts of the application a condition depends on.  The info manager tracks when each
+ of these last changed, so that a condition is only re-evaluated once one of its sources has.
+ A condition without any sources is constant.
+ */
+//@{
+#define INFO_SOURCE_PLAYER     0x01   ///< depends on the player state, only while playing
+#define INFO_SOURCE_WINDOW     0x02   ///< depends on the active window and dialogs
+#define INFO_SOURCE_CONTAINER  0x04   ///< depends on the contents or focus of a container
+#define INFO_SOURCE_LISTITEM   0x08   ///< depends on a listitem, which may be passed in
+#define INFO_SOURCE_SKIN       0x10   ///< depends on skin settings
+#define INFO_SOURCE_VOLATILE   0x20   ///< may change at any time, updated every frame
+#define INFO_SOURCE_COUNT      6
+//@}
+
 /*!
  \ingroup info
  \brief Base class, wrapping boolean conditions and expressions
@@ -38,26 +53,35 @@ public:
   InfoBool(const CStdString &expression, int context)
     : m_value(false),
       m_context(context),
+      m_sources(INFO_SOURCE_VOLATILE),
       m_expression(expression),
-      m_lastUpdate(0)
+      m_lastUpdate(0),
+      m_requests(0),
+      m_evaluations(0)
   {
   };
 
   virtual ~InfoBool() {};
 
   /*! \brief Get the value of this info bool
-   This is called to update (if necessary) and fetch the value of the info bool
-   \param time current time (used to test if we need to update yet)
+   This is called to update (if necessary) and fetch the value of the info bool.
+   Bools that depend on a listitem are evaluated against the item without touching the cached value.
+   \param changed the last time any of the sources of this bool changed (used to test if we need to update)
    \param item the item used to evaluate the bool
    */
-  inline bool Get(unsigned int time, const CGUIListItem *item = NULL)
+  inline bool Get(unsigned int changed, const CGUIListItem *item = NULL)
   {
-    if (item)
-      Update(item);
-    else if (time - m_lastUpdate > 0)
+    m_requests++;
+    if (item && (m_sources & INFO_SOURCE_LISTITEM))
+    {
+      m_evaluations++;
+      return Evaluate(item);
+    }
+    if (changed != m_lastUpdate)
     {
-      Update(NULL);
-      m_lastUpdate = time;
+      m_evaluations++;
+      m_value = Evaluate(NULL);
+      m_lastUpdate = changed;
     }
     return m_value;
   }
@@ -68,19 +92,29 @@ public:
             m_expression.CompareNoCase(right.m_expression) == 0);
   }
 
-  /*! \brief Update the value of this info bool
-   This is called if and only if the info bool is dirty, allowing it to update it's current value
+  /*! \brief Evaluate the value of this info bool
+   This is called if and only if the info bool is dirty, or depends on the given item
+   \param item the item used to evaluate the bool
+   \return the current value
    */
-  virtual void Update(const CGUIListItem *item) {};
+  virtual bool Evaluate(const CGUIListItem *item) { return false; };
+
+  unsigned int GetSources() const { return m_sources; };
+  const CStdString &GetExpression() const { return m_expression; };
+  unsigned int GetRequests() const { return m_requests; };
+  unsigned int GetEvaluations() const { return m_evaluations; };
 
 protected:
 
   bool m_value;                ///< current value
   int m_context;               ///< contextual information to go with the condition
+  unsigned int m_sources;      ///< INFO_SOURCE_* flags this bool depends on
 
 private:
   CStdString m_expression;     ///< original expression
-  unsigned int m_lastUpdate;   ///< last update time (to determine dirty status)
+  unsigned int m_lastUpdate;   ///< change time of our sources at the last update (to determine dirty status)
+  unsigned int m_requests;     ///< number of times the value was asked for
+  unsigned int m_evaluations;  ///< number of times the value was evaluated
 };
 
 /*! \brief Class to wrap active boolean conditions
@@ -91,12 +125,15 @@ public:
   InfoSingle(const CStdString &condition, int context);
   virtual ~InfoSingle() {};
 
-  virtual void Update(const CGUIListItem *item);
+  virtual bool Evaluate(const CGUIListItem *item);
 private:
   int m_condition;             ///< actual condition this represents
 };
 
 /*! \brief Class to wrap active boolean expressions
+ The expression is compiled into a tree with runs of the same operator flattened into a
+ single node.  Operands that are cached are tried first, so the ones evaluated every frame
+ can often be skipped.
  */
 class InfoExpression : public InfoBool
 {
@@ -104,14 +141,30 @@ public:
   InfoExpression(const CStdString &expression, int context);
   virtual ~InfoExpression() {};
 
-  virtual void Update(const CGUIListItem *item);
+  virtual bool Evaluate(const CGUIListItem *item);
 private:
+  /*! \brief A node of the compiled expression, either an operand or an operator on its children
+   */
+  class Node
+  {
+  public:
+    Node(short type, unsigned int info, unsigned int sources) : m_type(type), m_info(info), m_sources(sources) {};
+
+    short m_type;                         ///< 0 for an operand, else the operator
+    unsigned int m_info;                  ///< the operand's registered bool
+    unsigned int m_sources;               ///< INFO_SOURCE_* flags of the node and its children
+    std::vector<unsigned int> m_children; ///< indices of the child nodes
+  };
+
   void Parse(const CStdString &expression);
-  bool Evaluate(const CGUIListItem *item, bool &result);
+  bool Compile();
+  unsigned int AddOperator(short type, unsigned int left, unsigned int right);
+  bool EvaluateNode(unsigned int node, const CGUIListItem *item) const;
   short GetOperator(const char ch) const;
 
   std::vector<short> m_postfix;         ///< the postfix form of the expression (operators and operand indicies)
   std::vector<unsigned int> m_operands; ///< the operands in the expression
+  std::vector<Node> m_nodes;            ///< the compiled expression, the root being the last node
 };
 
 };
@@ -89,7 +89,7 @@ JSONRPC_STATUS CAudioLibrary::GetArtists(const CStdString &method, ITransportLay
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("artistid", false, "artists", items, param, result, size, false);
+  HandleStreamedFileItemList("artistid", false, "artists", items, param, result, size, false);
   return OK;
 }
 
@@ -165,7 +165,7 @@ JSONRPC_STATUS CAudioLibrary::GetAlbums(const CStdString &method, ITransportLaye
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("albumid", false, "albums", items, parameterObject, result, size, false);
+  HandleStreamedFileItemList("albumid", false, "albums", items, parameterObject, result, size, false);
 
   return OK;
 }
@@ -247,7 +247,7 @@ JSONRPC_STATUS CAudioLibrary::GetSongs(const CStdString &method, ITransportLayer
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("songid", true, "songs", items, parameterObject, result, size, false);
+  HandleStreamedFileItemList("songid", true, "songs", items, parameterObject, result, size, false);
 
   return OK;
 }
@@ -299,7 +299,7 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyAddedAlbums(const CStdString &method, I
   if (ret != OK)
     return ret;
 
-  HandleFileItemList("albumid", false, "albums", items, parameterObject, result);
+  HandleStreamedFileItemList("albumid", false, "albums", items, parameterObject, result);
   return OK;
 }
 
@@ -321,7 +321,7 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyAddedSongs(const CStdString &method, IT
   if (ret != OK)
     return ret;
 
-  HandleFileItemList("songid", true, "songs", items, parameterObject, result);
+  HandleStreamedFileItemList("songid", true, "songs", items, parameterObject, result);
   return OK;
 }
 
@@ -350,7 +350,7 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyPlayedAlbums(const CStdString &method,
   if (ret != OK)
     return ret;
 
-  HandleFileItemList("albumid", false, "albums", items, parameterObject, result);
+  HandleStreamedFileItemList("albumid", false, "albums", items, parameterObject, result);
   return OK;
 }
 
@@ -368,7 +368,7 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyPlayedSongs(const CStdString &method, I
   if (ret != OK)
     return ret;
 
-  HandleFileItemList("songid", true, "songs", items, parameterObject, result);
+  HandleStreamedFileItemList("songid", true, "songs", items, parameterObject, result);
   return OK;
 }
 
@@ -386,7 +386,7 @@ JSONRPC_STATUS CAudioLibrary::GetGenres(const CStdString &method, ITransportLaye
   for (unsigned int i = 0; i < (unsigned int)items.Size(); i++)
     items[i]->GetMusicInfoTag()->SetTitle(items[i]->GetLabel());
 
-  HandleFileItemList("genreid", false, "genres", items, parameterObject, result);
+  HandleStreamedFileItemList("genreid", false, "genres", items, parameterObject, result);
   return OK;
 }
 
@@ -200,6 +200,21 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
 }
 
 void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit /* = true */)
+{
+  HandleFileItems(ID, allowFile, resultname, items, parameterObject, result, size, sortLimit, false);
+}
+
+void CFileItemHandler::HandleStreamedFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, bool sortLimit /* = true */)
+{
+  HandleFileItems(ID, allowFile, resultname, items, parameterObject, result, items.Size(), sortLimit, true);
+}
+
+void CFileItemHandler::HandleStreamedFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit /* = true */)
+{
+  HandleFileItems(ID, allowFile, resultname, items, parameterObject, result, size, sortLimit, true);
+}
+
+void CFileItemHandler::HandleFileItems(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit, bool stream)
 {
   int start, end;
   HandleLimits(parameterObject, result, size, start, end);
@@ -212,6 +227,25 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
     end = items.Size();
   }
 
+  std::set<std::string> fields;
+  if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
+  {
+    for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
+      fields.insert(field->asString());
+  }
+
+  // Try to have the items converted one by one while the response
+  // is written instead of holding all of them in the result
+  if (stream && end - start > 0 && resultname != NULL)
+  {
+    JSONRPCStreamedArrayPtr streamedItems(new CStreamedFileItemList(ID, allowFile, items, start, end, parameterObject, fields));
+    if (CJSONRPC::AddStreamedArray(result, resultname, streamedItems))
+    {
+      result[resultname] = CVariant(CVariant::VariantTypeArray);
+      return;
+    }
+  }
+
   CThumbLoader *thumbLoader = NULL;
   if (end - start > 0)
   {
@@ -224,13 +258,6 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
       thumbLoader->Initialize();
   }
 
-  std::set<std::string> fields;
-  if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
-  {
-    for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
-      fields.insert(field->asString());
-  }
-
   for (int i = start; i < end; i++)
   {
     CVariant object;
@@ -241,6 +268,47 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
   delete thumbLoader;
 }
 
+CFileItemHandler::CStreamedFileItemList::CStreamedFileItemList(const char *ID, bool allowFile, const CFileItemList &items, int start, int end, const CVariant &parameterObject, const std::set<std::string> &fields)
+  : m_ID(ID != NULL ? ID : ""), m_hasID(ID != NULL), m_allowFile(allowFile),
+    m_parameterObject(parameterObject), m_fields(fields), m_thumbLoader(NULL)
+{
+  m_items.reserve(end - start);
+  for (int i = start; i < end; i++)
+    m_items.push_back(items.Get(i));
+}
+
+CFileItemHandler::CStreamedFileItemList::~CStreamedFileItemList()
+{
+  delete m_thumbLoader;
+}
+
+unsigned int CFileItemHandler::CStreamedFileItemList::Size() const
+{
+  return m_items.size();
+}
+
+void CFileItemHandler::CStreamedFileItemList::Get(unsigned int index, CVariant &value)
+{
+  // the thumb loader is created by the thread writing the response
+  if (m_thumbLoader == NULL && index == 0)
+  {
+    if (m_items[0]->HasVideoInfoTag())
+      m_thumbLoader = new CVideoThumbLoader();
+    else if (m_items[0]->HasMusicInfoTag())
+      m_thumbLoader = new CMusicThumbLoader();
+
+    if (m_thumbLoader != NULL)
+      m_thumbLoader->Initialize();
+  }
+
+  CVariant object;
+  HandleFileItem(m_hasID ? m_ID.c_str() : NULL, m_allowFile, "item", m_items[index], m_parameterObject, m_fields, object, false, m_thumbLoader);
+  value.swap(object["item"]);
+
+  // the item isn't needed anymore once it has been written
+  m_items[index].reset();
+}
+
 void CFileItemHandler::HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const CVariant &validFields, CVariant &result, bool append /* = true */, CThumbLoader *thumbLoader /* = NULL */)
 {
   std::set<std::string> fields;
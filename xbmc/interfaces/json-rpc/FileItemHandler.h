@@ -20,6 +20,7 @@
  */
 
 #include <set>
+#include <vector>
 
 #include "JSONRPC.h"
 #include "JSONUtils.h"
@@ -36,12 +37,43 @@ namespace JSONRPC
     static void FillDetails(const ISerializable *info, const CFileItemPtr &item, std::set<std::string> &fields, CVariant &result, CThumbLoader *thumbLoader = NULL);
     static void HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, bool sortLimit = true);
     static void HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit = true);
+    /*!
+     \brief Same as HandleFileItemList() but the items may be converted
+     while the response is written, so result[resultname] stays empty.
+     Only use it if the caller doesn't touch result[resultname] afterwards.
+     */
+    static void HandleStreamedFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, bool sortLimit = true);
+    static void HandleStreamedFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit = true);
     static void HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const CVariant &validFields, CVariant &result, bool append = true, CThumbLoader *thumbLoader = NULL);
     static void HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const std::set<std::string> &validFields, CVariant &result, bool append = true, CThumbLoader *thumbLoader = NULL);
 
     static bool FillFileItemList(const CVariant &parameterObject, CFileItemList &list);
   private:
     static void Sort(CFileItemList &items, const CVariant& parameterObject);
+    static void HandleFileItems(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit, bool stream);
     static bool GetField(const std::string &field, const CVariant &info, const CFileItemPtr &item, CVariant &result, bool &fetchedArt, CThumbLoader *thumbLoader = NULL);
+
+    /*!
+     \brief Items of a file item list which are only
+     converted when the response is being written
+     */
+    class CStreamedFileItemList : public IJSONRPCStreamedArray
+    {
+    public:
+      CStreamedFileItemList(const char *ID, bool allowFile, const CFileItemList &items, int start, int end, const CVariant &parameterObject, const std::set<std::string> &fields);
+      virtual ~CStreamedFileItemList();
+
+      virtual unsigned int Size() const;
+      virtual void Get(unsigned int index, CVariant &value);
+
+    private:
+      std::string m_ID;
+      bool m_hasID;
+      bool m_allowFile;
+      std::vector<CFileItemPtr> m_items;
+      CVariant m_parameterObject;
+      std::set<std::string> m_fields;
+      CThumbLoader *m_thumbLoader;
+    };
   };
 }
@@ -18,7 +18,9 @@
  *
  */
 
+#include <algorithm>
 #include <string.h>
+#include <vector>
 
 #include "JSONRPC.h"
 #include "ServiceDescription.h"
@@ -26,6 +28,10 @@
 #include "interfaces/AnnouncementManager.h"
 #include "playlists/SmartPlayList.h"
 #include "settings/AdvancedSettings.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "threads/ThreadLocal.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
@@ -223,7 +229,18 @@ JSONRPC_STATUS CJSONRPC::NotifyAll(const CStdString &method, ITransportLayer *tr
 
 CStdString CJSONRPC::MethodCall(const CStdString &inputString, ITransportLayer *transport, IClient *client)
 {
-  CVariant inputroot, outputroot, result;
+  std::string str;
+  CJSONRPCResponse response;
+  if (MethodCall(inputString, transport, client, response))
+    response.Read(str);
+
+  return str;
+}
+
+bool CJSONRPC::MethodCall(const CStdString &inputString, ITransportLayer *transport, IClient *client, CJSONRPCResponse &response)
+{
+  CVariant inputroot;
+  CVariant &outputroot = response.m_response;
   bool hasResponse = false;
 
   CLog::Log(LOGDEBUG, "JSONRPC: Incoming request: %s", inputString.c_str());
@@ -239,20 +256,10 @@ CStdString CJSONRPC::MethodCall(const CStdString &inputString, ITransportLayer *
         hasResponse = true;
       }
       else
-      {
-        for (CVariant::const_iterator_array itr = inputroot.begin_array(); itr != inputroot.end_array(); itr++)
-        {
-          CVariant response;
-          if (HandleMethodCall(*itr, response, transport, client))
-          {
-            outputroot.append(response);
-            hasResponse = true;
-          }
-        }
-      }
+        hasResponse = HandleBatch(inputroot, outputroot, transport, client);
     }
     else
-      hasResponse = HandleMethodCall(inputroot, outputroot, transport, client);
+      hasResponse = HandleMethodCall(inputroot, outputroot, transport, client, &response.m_streamedArrays);
   }
   else
   {
@@ -261,11 +268,205 @@ CStdString CJSONRPC::MethodCall(const CStdString &inputString, ITransportLayer *
     hasResponse = true;
   }
 
-  CStdString str = hasResponse ? CJSONVariantWriter::Write(outputroot, g_advancedSettings.m_jsonOutputCompact) : "";
-  return str;
+  return hasResponse;
 }
 
-bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client)
+namespace JSONRPC
+{
+  /*!
+   \brief Result of the method which is currently executed
+   by the calling thread and which may contain streamed arrays
+   */
+  typedef struct
+  {
+    const CVariant *result;
+    JSONRPCStreamedArrays *arrays;
+  } StreamedResult;
+
+  static XbmcThreads::ThreadLocal<StreamedResult> tlsStreamedResult;
+
+  /*!
+   \brief Makes a result the one of the calling thread while
+   in scope, also if the method executed meanwhile throws
+   */
+  class CStreamedResultScope
+  {
+  public:
+    CStreamedResultScope(StreamedResult *streamedResult)
+      : m_previous(tlsStreamedResult.get())
+    {
+      tlsStreamedResult.set(streamedResult);
+    }
+
+    ~CStreamedResultScope() { tlsStreamedResult.set(m_previous); }
+
+  private:
+    StreamedResult *m_previous;
+  };
+}
+
+bool CJSONRPC::AddStreamedArray(const CVariant &result, const std::string &name, JSONRPCStreamedArrayPtr values)
+{
+  StreamedResult *streamedResult = tlsStreamedResult.get();
+  if (streamedResult == NULL || streamedResult->result != &result ||
+      result.isMember(name) || streamedResult->arrays->find(name) != streamedResult->arrays->end())
+    return false;
+
+  (*streamedResult->arrays)[name] = values;
+  return true;
+}
+
+namespace JSONRPC
+{
+  /*!
+   \brief Single call of a batch request
+   */
+  typedef struct
+  {
+    CVariant response;
+    bool hasResponse;
+    bool handled;
+  } BatchCall;
+
+  /*!
+   \brief Keeps track of the calls of a batch request
+   which have been handed to the job manager
+   */
+  class CBatchCalls
+  {
+  public:
+    CBatchCalls() : m_pending(0) { }
+
+    void Add()
+    {
+      CSingleLock lock(m_section);
+      m_pending++;
+    }
+
+    void Done()
+    {
+      CSingleLock lock(m_section);
+      if (--m_pending == 0)
+        m_done.Set();
+    }
+
+    void Wait()
+    {
+      CSingleLock lock(m_section);
+      while (m_pending > 0)
+      {
+        CSingleExit exit(m_section);
+        m_done.Wait();
+      }
+    }
+
+  private:
+    CCriticalSection m_section;
+    CEvent m_done;
+    unsigned int m_pending;
+  };
+
+  /*!
+   \brief Executes a single call of a batch request on the job manager
+
+   The job reports back to its batch when it is destroyed so that the
+   batch is also released for jobs which are cancelled before they run.
+   */
+  class CJSONRPCBatchJob : public CJob
+  {
+  public:
+    CJSONRPCBatchJob(const CVariant &request, BatchCall &call, CBatchCalls &batch, ITransportLayer *transport, IClient *client)
+      : m_request(request), m_call(call), m_batch(batch), m_transport(transport), m_client(client)
+    {
+      m_batch.Add();
+    }
+
+    virtual ~CJSONRPCBatchJob()
+    {
+      m_batch.Done();
+    }
+
+    virtual const char *GetType() const { return "jsonrpcbatch"; }
+
+    virtual bool DoWork()
+    {
+      m_call.hasResponse = CJSONRPC::HandleMethodCall(m_request, m_call.response, m_transport, m_client);
+      m_call.handled = true;
+      return true;
+    }
+
+  private:
+    const CVariant &m_request;
+    BatchCall &m_call;
+    CBatchCalls &m_batch;
+    ITransportLayer *m_transport;
+    IClient *m_client;
+  };
+}
+
+bool CJSONRPC::HandleBatch(const CVariant& batch, CVariant& responses, ITransportLayer *transport, IClient *client)
+{
+  std::vector<BatchCall> calls(batch.size());
+  for (unsigned int index = 0; index < calls.size(); index++)
+  {
+    calls[index].hasResponse = false;
+    calls[index].handled = false;
+  }
+
+  // Consecutive calls which are safe to run concurrently are handed
+  // to the job manager while the first one of them is handled by the
+  // calling thread. Any other call acts as a barrier so that its side
+  // effects are visible to all the calls following it in the batch.
+  unsigned int index = 0;
+  while (index < calls.size())
+  {
+    unsigned int end = index + 1;
+    if (g_advancedSettings.m_jsonParallelBatch && IsParallelCall(batch[index]))
+    {
+      while (end < calls.size() && IsParallelCall(batch[end]))
+        end++;
+    }
+
+    if (end - index > 1)
+    {
+      CBatchCalls pending;
+      for (unsigned int parallelIndex = index + 1; parallelIndex < end; parallelIndex++)
+      {
+        CJob *job = new CJSONRPCBatchJob(batch[parallelIndex], calls[parallelIndex], pending, transport, client);
+        if (CJobManager::GetInstance().AddJob(job, NULL, CJob::PRIORITY_HIGH) == 0)
+          delete job;
+      }
+
+      calls[index].hasResponse = HandleMethodCall(batch[index], calls[index].response, transport, client);
+      calls[index].handled = true;
+      pending.Wait();
+    }
+
+    // handle anything the job manager didn't take care of (e.g. while shutting down)
+    for (; index < end; index++)
+    {
+      if (!calls[index].handled)
+      {
+        calls[index].hasResponse = HandleMethodCall(batch[index], calls[index].response, transport, client);
+        calls[index].handled = true;
+      }
+    }
+  }
+
+  bool hasResponse = false;
+  for (index = 0; index < calls.size(); index++)
+  {
+    if (calls[index].hasResponse)
+    {
+      responses.append(calls[index].response);
+      hasResponse = true;
+    }
+  }
+
+  return hasResponse;
+}
+
+bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client, JSONRPCStreamedArrays *streamedArrays /* = NULL */)
 {
   JSONRPC_STATUS errorCode = OK;
   CVariant result;
@@ -283,7 +484,20 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
 
     CLog::Log(LOGDEBUG, "JSONRPC: Calling %s", methodName.c_str());
     if ((errorCode = CJSONServiceDescription::CheckCall(methodName, request["params"], transport, client, isNotification, method, params)) == OK)
-      errorCode = method(methodName, transport, client, params, result);
+    {
+      if (streamedArrays != NULL)
+      {
+        StreamedResult streamedResult = { &result, streamedArrays };
+        CStreamedResultScope scope(&streamedResult);
+        errorCode = method(methodName, transport, client, params, result);
+
+        // streamed arrays are only part of a successful result
+        if (errorCode != OK || isNotification)
+          streamedArrays->clear();
+      }
+      else
+        errorCode = method(methodName, transport, client, params, result);
+    }
     else
       result = params;
   }
@@ -298,6 +512,17 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
   return !isNotification;
 }
 
+bool CJSONRPC::IsParallelCall(const CVariant& request)
+{
+  if (!IsProperJSONRPC(request))
+    return false;
+
+  CStdString methodName = request["method"].asString();
+  methodName = methodName.ToLower();
+
+  return CJSONServiceDescription::IsParallel(methodName);
+}
+
 inline bool CJSONRPC::IsProperJSONRPC(const CVariant& inputroot)
 {
   return inputroot.isObject() && inputroot.isMember("jsonrpc") && inputroot["jsonrpc"].isString() && inputroot["jsonrpc"] == CVariant("2.0") && inputroot.isMember("method") && inputroot["method"].isString() && (!inputroot.isMember("params") || inputroot["params"].isArray() || inputroot["params"].isObject());
@@ -348,3 +573,144 @@ inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code
       break;
   }
 }
+
+CJSONRPCResponse::CJSONRPCResponse()
+  : m_writer(g_advancedSettings.m_jsonOutputCompact),
+    m_state(ResponseStart),
+    m_index(0),
+    m_outputPosition(0)
+{ }
+
+size_t CJSONRPCResponse::Read(char *buffer, size_t size)
+{
+  if (m_outputPosition > 0)
+  {
+    m_output.erase(0, m_outputPosition);
+    m_outputPosition = 0;
+  }
+
+  while (m_output.size() < size && writeNext())
+    m_writer.TakeOutput(m_output);
+  m_writer.TakeOutput(m_output);
+
+  size_t length = std::min(size, m_output.size());
+  memcpy(buffer, m_output.c_str(), length);
+  m_outputPosition = length;
+
+  return length;
+}
+
+void CJSONRPCResponse::Read(std::string &output)
+{
+  output.append(m_output, m_outputPosition, std::string::npos);
+  m_output.clear();
+  m_outputPosition = 0;
+
+  while (writeNext())
+    m_writer.TakeOutput(output);
+  m_writer.TakeOutput(output);
+}
+
+bool CJSONRPCResponse::writeNext()
+{
+  bool success = true;
+  switch (m_state)
+  {
+    case ResponseStart:
+      // without streamed arrays the response is written in one go
+      if (!IsStreamed() || !m_response.isObject())
+      {
+        success = m_writer.Write(m_response);
+        m_state = ResponseDone;
+      }
+      else
+      {
+        success = m_writer.OpenObject();
+        m_envelope = m_response.begin_map();
+        m_state = ResponseEnvelope;
+      }
+      break;
+
+    case ResponseEnvelope:
+      if (m_envelope == m_response.end_map())
+      {
+        success = m_writer.CloseObject();
+        m_state = ResponseDone;
+      }
+      else
+      {
+        success = m_writer.WriteKey(m_envelope->first);
+        if (m_envelope->first == "result" && m_envelope->second.isObject())
+        {
+          success &= m_writer.OpenObject();
+          m_member = m_envelope->second.begin_map();
+          m_state = ResponseResult;
+        }
+        else
+        {
+          success &= m_writer.Write(m_envelope->second);
+          ++m_envelope;
+        }
+      }
+      break;
+
+    case ResponseResult:
+      if (m_member == m_envelope->second.end_map())
+      {
+        success = m_writer.CloseObject();
+        ++m_envelope;
+        m_state = ResponseEnvelope;
+      }
+      else
+      {
+        success = m_writer.WriteKey(m_member->first);
+        JSONRPCStreamedArrays::iterator array = m_streamedArrays.find(m_member->first);
+        if (array != m_streamedArrays.end())
+        {
+          success &= m_writer.OpenArray();
+          m_array = array->second;
+          m_streamedArrays.erase(array);
+          m_index = 0;
+          m_state = ResponseArray;
+        }
+        else
+        {
+          success &= m_writer.Write(m_member->second);
+          ++m_member;
+        }
+      }
+      break;
+
+    case ResponseArray:
+      if (m_index < m_array->Size())
+      {
+        CVariant value;
+        m_array->Get(m_index++, value);
+        success = m_writer.Write(value);
+      }
+      else
+      {
+        // values which have been appended to the array by the method itself
+        for (CVariant::const_iterator_array value = m_member->second.begin_array(); value != m_member->second.end_array() && success; ++value)
+          success &= m_writer.Write(*value);
+
+        success &= m_writer.CloseArray();
+        m_array.reset();
+        ++m_member;
+        m_state = ResponseResult;
+      }
+      break;
+
+    case ResponseDone:
+    default:
+      return false;
+  }
+
+  if (!success)
+  {
+    CLog::Log(LOGERROR, "JSONRPC: Failed to write the response");
+    m_state = ResponseDone;
+  }
+
+  return true;
+}
@@ -23,14 +23,95 @@
 #include <map>
 #include <stdio.h>
 #include <string>
+#include <boost/shared_ptr.hpp>
 
 #include "JSONRPCUtils.h"
 #include "JSONServiceDescription.h"
 #include "interfaces/IAnnouncer.h"
+#include "utils/JSONVariantWriter.h"
 #include "utils/StdString.h"
 
 namespace JSONRPC
 {
+  class CJSONRPCBatchJob;
+
+  /*!
+   \ingroup jsonrpc
+   \brief Array in the result of a method whose values
+   are only created one at a time while the response is
+   being written.
+   */
+  class IJSONRPCStreamedArray
+  {
+  public:
+    virtual ~IJSONRPCStreamedArray() { }
+
+    virtual unsigned int Size() const = 0;
+    virtual void Get(unsigned int index, CVariant &value) = 0;
+  };
+
+  typedef boost::shared_ptr<IJSONRPCStreamedArray> JSONRPCStreamedArrayPtr;
+  typedef std::map<std::string, JSONRPCStreamedArrayPtr> JSONRPCStreamedArrays;
+
+  /*!
+   \ingroup jsonrpc
+   \brief JSON-RPC response which is serialized piece by piece
+
+   Arrays of the result which have been registered through
+   CJSONRPC::AddStreamedArray() are written value by value
+   so that neither the whole CVariant tree nor the whole
+   serialized response have to be kept in memory.
+   */
+  class CJSONRPCResponse
+  {
+  public:
+    CJSONRPCResponse();
+
+    /*!
+     \brief Whether the response contains streamed arrays
+     */
+    bool IsStreamed() const { return !m_streamedArrays.empty(); }
+
+    /*!
+     \brief Reads the next part of the serialized response
+     \param buffer Buffer to fill
+     \param size Size of the buffer
+     \return Number of bytes written to the buffer or 0 at the end of the response
+     */
+    size_t Read(char *buffer, size_t size);
+    /*!
+     \brief Appends the (remaining) serialized response to the given string
+     */
+    void Read(std::string &output);
+
+  private:
+    friend class CJSONRPC;
+
+    bool writeNext();
+
+    enum ResponseState
+    {
+      ResponseStart,
+      ResponseEnvelope,
+      ResponseResult,
+      ResponseArray,
+      ResponseDone
+    };
+
+    CJSONStreamWriter m_writer;
+    CVariant m_response;
+    JSONRPCStreamedArrays m_streamedArrays;
+
+    ResponseState m_state;
+    CVariant::const_iterator_map m_envelope;
+    CVariant::const_iterator_map m_member;
+    JSONRPCStreamedArrayPtr m_array;
+    unsigned int m_index;
+
+    std::string m_output;
+    size_t m_outputPosition;
+  };
+
   /*!
    \ingroup jsonrpc
    \brief JSON RPC handler
@@ -64,6 +145,35 @@ namespace JSONRPC
      */
     static CStdString MethodCall(const CStdString &inputString, ITransportLayer *transport, IClient *client);
 
+    /*
+     \brief Handles an incoming JSON-RPC request
+     \param inputString received JSON-RPC request
+     \param transport Transport protocol on which the request arrived
+     \param client Client which sent the request
+     \param response JSON-RPC response to be read and sent back to the client
+     \return True if there is a response to be sent back otherwise false
+
+     Same as MethodCall() above but allows large results to be
+     sent back to the client without serializing them in one go.
+     */
+    static bool MethodCall(const CStdString &inputString, ITransportLayer *transport, IClient *client, CJSONRPCResponse &response);
+
+    /*!
+     \brief Registers an array of the result of the currently executed method
+     to be streamed into the response
+     \param result Result object of the currently executed method
+     \param name Name of the array in the result object
+     \param values Streamed array providing the values
+     \return True if the array will be streamed otherwise false
+
+     Streaming is only possible for members of the top level result object
+     of a single (non-batch) request which haven't been set yet. If the
+     array is accepted, the caller must set result[name] to an (empty)
+     array. Any values appended to it will be written after the streamed
+     values.
+     */
+    static bool AddStreamedArray(const CVariant &result, const std::string &name, JSONRPCStreamedArrayPtr values);
+
     static JSONRPC_STATUS Introspect(const CStdString &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Version(const CStdString &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Permission(const CStdString &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
@@ -73,8 +183,12 @@ namespace JSONRPC
     static JSONRPC_STATUS NotifyAll(const CStdString &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
   
   private:
+    friend class CJSONRPCBatchJob;
+
     static void setup();
-    static bool HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client);
+    static bool HandleBatch(const CVariant& batch, CVariant& responses, ITransportLayer *transport, IClient *client);
+    static bool HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client, JSONRPCStreamedArrays *streamedArrays = NULL);
+    static bool IsParallelCall(const CVariant& request);
     static inline bool IsProperJSONRPC(const CVariant& inputroot);
 
     inline static void BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response);
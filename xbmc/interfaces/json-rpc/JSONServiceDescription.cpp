@@ -1153,7 +1153,7 @@ unsigned int JSONSchemaTypeDefinition::CJsonSchemaPropertiesMap::size() const
 }
 
 JsonRpcMethod::JsonRpcMethod()
-  : missingReference(""), method(NULL),
+  : missingReference(""), method(NULL), parallel(false),
     returns(new JSONSchemaTypeDefinition())
 { }
 
@@ -1182,6 +1182,8 @@ bool JsonRpcMethod::Parse(const CVariant &value)
   else
     permission = StringToPermission(value.isMember("permission") ? value["permission"].asString() : "");
 
+  parallel = value.isMember("parallel") && value["parallel"].isBoolean() && value["parallel"].asBoolean();
+
   description = GetString(value["description"], "");
 
   // Check whether there are parameters defined
@@ -1826,6 +1828,12 @@ JSONRPC_STATUS CJSONServiceDescription::CheckCall(const char* const method, cons
   return MethodNotFound;
 }
 
+bool CJSONServiceDescription::IsParallel(const std::string &method)
+{
+  CJsonRpcMethodMap::JsonRpcMethodIterator iter = m_actionMap.find(method);
+  return iter != m_actionMap.end() && iter->second.parallel;
+}
+
 JSONSchemaTypeDefinitionPtr CJSONServiceDescription::GetType(const std::string &identification)
 {
   std::map<std::string, JSONSchemaTypeDefinitionPtr>::iterator iter = m_types.find(identification);
@@ -261,6 +261,14 @@ namespace JSONRPC
      to execute the method
      */
     OperationPermission permission;
+    /*!
+     \brief Whether the method only reads data
+     and can be executed concurrently with other
+     calls of the same batch request. Methods looking
+     up info labels or booleans aren't, as the info
+     manager isn't thread safe.
+     */
+    bool parallel;
     /*!
      \brief Description of the method
      */
@@ -390,6 +398,13 @@ namespace JSONRPC
      */
     static JSONRPC_STATUS CheckCall(const char* method, const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters);
     
+    /*!
+     \brief Checks whether the given method may be executed concurrently
+     \param method Name of the method (in lower case)
+     \return True if the method is flagged as "parallel" otherwise false
+     */
+    static bool IsParallel(const std::string &method);
+
     static JSONSchemaTypeDefinitionPtr GetType(const std::string &identification);
 
     static void Cleanup();
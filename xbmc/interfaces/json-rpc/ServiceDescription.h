@@ -1417,6 +1417,7 @@ namespace JSONRPC
       "\"description\": \"Returns all active players\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": [],"
       "\"returns\": {"
         "\"type\": \"array\","
@@ -1435,6 +1436,7 @@ namespace JSONRPC
       "\"description\": \"Retrieves the values of the given properties\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"playerid\", \"$ref\": \"Player.Id\", \"required\": true },"
         "{ \"name\": \"properties\", \"type\": \"array\", \"uniqueItems\": true, \"required\": true, \"items\": { \"$ref\": \"Player.Property.Name\" } }"
@@ -1826,6 +1828,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all artists\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"albumartistsonly\", \"$ref\": \"Optional.Boolean\", \"description\": \"Whether or not to include artists only appearing in compilations. If the parameter is not passed or is passed as null the GUI setting will be used\" },"
         "{ \"name\": \"properties\", \"$ref\": \"Audio.Fields.Artist\" },"
@@ -1857,6 +1860,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve details about a specific artist\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"artistid\", \"$ref\": \"Library.Id\", \"required\": true },"
         "{ \"name\": \"properties\", \"$ref\": \"Audio.Fields.Artist\" }"
@@ -1872,6 +1876,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all albums from specified artist or genre\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Audio.Fields.Album\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -1901,6 +1906,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve details about a specific album\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"albumid\", \"$ref\": \"Library.Id\", \"required\": true },"
         "{ \"name\": \"properties\", \"$ref\": \"Audio.Fields.Album\" }"
@@ -1916,6 +1922,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all songs from specified album, artist or genre\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Audio.Fields.Song\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -1947,6 +1954,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve details about a specific song\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"songid\", \"$ref\": \"Library.Id\", \"required\": true },"
         "{ \"name\": \"properties\", \"$ref\": \"Audio.Fields.Song\" }"
@@ -1962,6 +1970,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve recently added albums\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Audio.Fields.Album\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -1982,6 +1991,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve recently added songs\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"albumlimit\", \"$ref\": \"List.Amount\", \"description\": \"The amount of recently added albums from which to return the songs\" },"
         "{ \"name\": \"properties\", \"$ref\": \"Audio.Fields.Song\" },"
@@ -2023,6 +2033,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve recently played songs\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Audio.Fields.Song\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -2043,6 +2054,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all genres\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Library.Fields.Genre\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -2171,6 +2183,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all movies\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.Movie\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -2206,6 +2219,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve details about a specific movie\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"movieid\", \"$ref\": \"Library.Id\", \"required\": true },"
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.Movie\" }"
@@ -2221,6 +2235,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all movie sets\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.MovieSet\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -2240,6 +2255,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve details about a specific movie set\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"setid\", \"$ref\": \"Library.Id\", \"required\": true },"
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.MovieSet\" },"
@@ -2262,6 +2278,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all tv shows\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.TVShow\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -2292,6 +2309,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve details about a specific tv show\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"tvshowid\", \"$ref\": \"Library.Id\", \"required\": true },"
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.TVShow\" }"
@@ -2307,6 +2325,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all tv seasons\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"tvshowid\", \"$ref\": \"Library.Id\", \"required\": true },"
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.Season\" },"
@@ -2327,6 +2346,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all tv show episodes\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"tvshowid\", \"$ref\": \"Library.Id\" },"
         "{ \"name\": \"season\", \"type\": \"integer\", \"minimum\": 0, \"default\": -1 },"
@@ -2358,6 +2378,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve details about a specific tv show episode\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"episodeid\", \"$ref\": \"Library.Id\", \"required\": true },"
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.Episode\" }"
@@ -2373,6 +2394,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all music videos\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.MusicVideo\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -2404,6 +2426,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve details about a specific music video\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"musicvideoid\", \"$ref\": \"Library.Id\", \"required\": true },"
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.MusicVideo\" }"
@@ -2419,6 +2442,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all recently added movies\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.Movie\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -2438,6 +2462,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all recently added tv episodes\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.Episode\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -2457,6 +2482,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all recently added music videos\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"$ref\": \"Video.Fields.MusicVideo\" },"
         "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" },"
@@ -2476,6 +2502,7 @@ namespace JSONRPC
       "\"description\": \"Retrieve all genres\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"type\", \"type\": \"string\", \"required\": true, \"enum\": [ \"movie\", \"tvshow\", \"musicvideo\"] },"
         "{ \"name\": \"properties\", \"$ref\": \"Library.Fields.Genre\" },"
@@ -3074,6 +3101,7 @@ namespace JSONRPC
       "\"description\": \"Retrieves the values of the given properties\","
       "\"transport\": \"Response\","
       "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
       "\"params\": ["
         "{ \"name\": \"properties\", \"type\": \"array\", \"uniqueItems\": true, \"required\": true, \"items\": { \"$ref\": \"Application.Property.Name\" } }"
       "],"
@@ -109,7 +109,7 @@ JSONRPC_STATUS CVideoLibrary::GetMovieSets(const CStdString &method, ITransportL
   if (!videodatabase.GetSetsNav("videodb://1/7/", items, VIDEODB_CONTENT_MOVIES))
     return InternalError;
 
-  HandleFileItemList("setid", false, "sets", items, parameterObject, result);
+  HandleStreamedFileItemList("setid", false, "sets", items, parameterObject, result);
   return OK;
 }
 
@@ -193,7 +193,7 @@ JSONRPC_STATUS CVideoLibrary::GetTVShows(const CStdString &method, ITransportLay
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("tvshowid", true, "tvshows", items, parameterObject, result, size, false);
+  HandleStreamedFileItemList("tvshowid", true, "tvshows", items, parameterObject, result, size, false);
 
   return OK;
 }
@@ -228,7 +228,7 @@ JSONRPC_STATUS CVideoLibrary::GetSeasons(const CStdString &method, ITransportLay
   if (!videodatabase.GetSeasonsNav(strPath, items, -1, -1, -1, -1, tvshowID, false))
     return InternalError;
 
-  HandleFileItemList(NULL, false, "seasons", items, parameterObject, result);
+  HandleStreamedFileItemList(NULL, false, "seasons", items, parameterObject, result);
   return OK;
 }
 
@@ -450,7 +450,7 @@ JSONRPC_STATUS CVideoLibrary::GetGenres(const CStdString &method, ITransportLaye
   for (unsigned int i = 0; i < (unsigned int)items.Size(); i++)
     items[i]->GetVideoInfoTag()->m_strTitle = items[i]->GetLabel();
 
-  HandleFileItemList("genreid", false, "genres", items, parameterObject, result);
+  HandleStreamedFileItemList("genreid", false, "genres", items, parameterObject, result);
   return OK;
 }
 
@@ -777,7 +777,7 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalMovieDetails(const CVariant &paramete
   int size = items.Size();
   if (!limit && items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("movieid", true, "movies", items, parameterObject, result, size, limit);
+  HandleStreamedFileItemList("movieid", true, "movies", items, parameterObject, result, size, limit);
 
   return OK;
 }
@@ -807,7 +807,7 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalEpisodeDetails(const CVariant &parame
   int size = items.Size();
   if (!limit && items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("episodeid", true, "episodes", items, parameterObject, result, size, limit);
+  HandleStreamedFileItemList("episodeid", true, "episodes", items, parameterObject, result, size, limit);
 
   return OK;
 }
@@ -833,7 +833,7 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalMusicVideoDetails(const CVariant &par
   int size = items.Size();
   if (!limit && items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("musicvideoid", true, "musicvideos", items, parameterObject, result, size, limit);
+  HandleStreamedFileItemList("musicvideoid", true, "musicvideos", items, parameterObject, result, size, limit);
 
   return OK;
 }
@@ -0,0 +1,146 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "interfaces/json-rpc/IClient.h"
+#include "interfaces/json-rpc/ITransportLayer.h"
+#include "filesystem/File.h"
+#include "filesystem/Directory.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/URIUtils.h"
+#include "utils/Variant.h"
+
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+using namespace JSONRPC;
+
+class CTestClient : public IClient
+{
+public:
+  virtual int GetPermissionFlags() { return OPERATION_PERMISSION_ALL; }
+  virtual int GetAnnouncementFlags() { return 0; }
+  virtual bool SetAnnouncementFlags(int flags) { return false; }
+};
+
+class CTestTransport : public ITransportLayer
+{
+public:
+  virtual bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) { return false; }
+  virtual bool Download(const char *path, CVariant &result) { return false; }
+  virtual int GetCapabilities() { return Response; }
+};
+
+class TestFileOperations : public testing::Test
+{
+protected:
+  TestFileOperations() : m_tmpfile(NULL) { }
+
+  virtual void SetUp()
+  {
+    CJSONRPC::Initialize();
+
+    // a directory with one sub directory and one file
+    ASSERT_TRUE((m_tmpfile = XBMC_CREATETEMPFILE("")) != NULL);
+    m_tmpfile->Close();
+    CStdString tmpdir;
+    URIUtils::GetDirectory(XBMC_TEMPFILEPATH(m_tmpfile), tmpdir);
+    m_directory = URIUtils::AddFileToFolder(tmpdir, "jsonrpc");
+    m_subdirectory = URIUtils::AddFileToFolder(m_directory, "subdir");
+    m_file = URIUtils::AddFileToFolder(m_directory, "file.txt");
+
+    ASSERT_TRUE(XFILE::CDirectory::Create(m_directory));
+    ASSERT_TRUE(XFILE::CDirectory::Create(m_subdirectory));
+    XFILE::CFile file;
+    ASSERT_TRUE(file.OpenForWrite(m_file, true));
+    EXPECT_EQ(4, file.Write("test", 4));
+    file.Close();
+  }
+
+  virtual void TearDown()
+  {
+    XFILE::CFile::Delete(m_file);
+    XFILE::CDirectory::Remove(m_subdirectory);
+    XFILE::CDirectory::Remove(m_directory);
+    if (m_tmpfile != NULL)
+      XBMC_DELETETEMPFILE(m_tmpfile);
+  }
+
+  CStdString GetDirectoryRequest() const
+  {
+    CVariant request;
+    request["jsonrpc"] = "2.0";
+    request["method"] = "Files.GetDirectory";
+    request["params"]["directory"] = m_directory;
+    request["params"]["media"] = "files";
+    request["id"] = 1;
+    return CJSONVariantWriter::Write(request, true);
+  }
+
+  void CheckDirectoryResponse(const std::string &output)
+  {
+    CVariant response = CJSONVariantParser::Parse((const unsigned char *)output.c_str(), output.size());
+    ASSERT_TRUE(response.isMember("result"));
+
+    const CVariant &files = response["result"]["files"];
+    ASSERT_TRUE(files.isArray());
+    ASSERT_EQ(2U, files.size());
+    EXPECT_EQ(2, response["result"]["limits"]["total"].asInteger());
+
+    for (unsigned int index = 0; index < files.size(); index++)
+    {
+      ASSERT_TRUE(files[index].isMember("filetype"));
+      if (URIUtils::GetFileName(files[index]["file"].asString()) == "file.txt")
+        EXPECT_STREQ("file", files[index]["filetype"].asString().c_str());
+      else
+        EXPECT_STREQ("directory", files[index]["filetype"].asString().c_str());
+    }
+    EXPECT_STREQ("directory", files[0]["filetype"].asString().c_str());
+    EXPECT_STREQ("file", files[1]["filetype"].asString().c_str());
+  }
+
+  XFILE::CFile *m_tmpfile;
+  CStdString m_directory;
+  CStdString m_subdirectory;
+  CStdString m_file;
+  CTestClient m_client;
+  CTestTransport m_transport;
+};
+
+TEST_F(TestFileOperations, GetDirectoryTagsFilesAndDirectories)
+{
+  CheckDirectoryResponse(CJSONRPC::MethodCall(GetDirectoryRequest(), &m_transport, &m_client));
+}
+
+TEST_F(TestFileOperations, GetDirectoryTagsFilesAndDirectoriesStreamed)
+{
+  // the result of Files.GetDirectory is post-processed so it
+  // must not be streamed even if the transport supports it
+  CJSONRPCResponse response;
+  ASSERT_TRUE(CJSONRPC::MethodCall(GetDirectoryRequest(), &m_transport, &m_client, response));
+  EXPECT_FALSE(response.IsStreamed());
+
+  std::string output;
+  response.Read(output);
+  CheckDirectoryResponse(output);
+}
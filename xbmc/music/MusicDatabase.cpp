@@ -5225,8 +5225,11 @@ bool CMusicDatabase::GetArtForItem(int mediaId, const string &mediaType, map<str
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS2.get()) return false; // using dataset 2 as we're likely called in loops on dataset 1
 
-    CStdString sql = PrepareSQL("SELECT type,url FROM art WHERE media_id=%i AND media_type='%s'", mediaId, mediaType.c_str());
-    m_pDS2->query(sql.c_str());
+    // bound, so the statement is prepared once for the whole listing
+    dbiplus::ParamList params;
+    params["id"] = mediaId;
+    params["type"] = mediaType;
+    m_pDS2->query("SELECT type,url FROM art WHERE media_id=:id AND media_type=:type", params);
     while (!m_pDS2->eof())
     {
       art.insert(make_pair(m_pDS2->fv(0).get_asString(), m_pDS2->fv(1).get_asString()));
@@ -5244,8 +5247,11 @@ bool CMusicDatabase::GetArtForItem(int mediaId, const string &mediaType, map<str
 
 string CMusicDatabase::GetArtForItem(int mediaId, const string &mediaType, const string &artType)
 {
-  std::string query = PrepareSQL("SELECT url FROM art WHERE media_id=%i AND media_type='%s' AND type='%s'", mediaId, mediaType.c_str(), artType.c_str());
-  return GetSingleValue(query, m_pDS2);
+  dbiplus::ParamList params;
+  params["id"] = mediaId;
+  params["mediatype"] = mediaType;
+  params["type"] = artType;
+  return GetSingleValue("SELECT url FROM art WHERE media_id=:id AND media_type=:mediatype AND type=:type", params, m_pDS2);
 }
 
 bool CMusicDatabase::GetArtistArtForItem(int mediaId, const std::string &mediaType, std::map<std::string, std::string> &art)
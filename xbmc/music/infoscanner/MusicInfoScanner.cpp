@@ -51,6 +51,8 @@
 #include "music/MusicThumbLoader.h"
 #include "interfaces/AnnouncementManager.h"
 #include "GUIUserMessages.h"
+#include "threads/Atomics.h"
+#include "utils/JobManager.h"
 
 #include <algorithm>
 
@@ -59,6 +61,89 @@ using namespace MUSIC_INFO;
 using namespace XFILE;
 using namespace MUSIC_GRABBER;
 
+namespace MUSIC_INFO
+{
+/*! \brief A changed directory whose tags are being read
+ */
+class CMusicScanDirectory
+{
+public:
+  CMusicScanDirectory(const CStdString &path, const CStdString &hash)
+    : m_path(path), m_hash(hash), m_pending(0), m_songs(0)
+  {
+  }
+
+  CStdString m_path;
+  CStdString m_hash;
+  CFileItemList m_items;
+  std::vector<CStdString> m_thumbs; ///< user thumbs of the items, read along with the tags
+  volatile long m_pending;          ///< number of tags still being read
+  VECALBUMS m_albums;               ///< albums to add to the database, once the tags are read
+  int m_songs;                      ///< number of songs in m_albums
+};
+
+/*! \brief Reads the tag of a single song of a CMusicScanDirectory
+ The job signals its completion when it's destroyed, so cancelled jobs
+ are accounted for as well.
+ */
+class CMusicTagReaderJob : public CJob
+{
+public:
+  CMusicTagReaderJob(CMusicInfoScanner *scanner, CMusicScanDirectory *directory, int item)
+    : m_scanner(scanner), m_directory(directory), m_item(item)
+  {
+  }
+
+  virtual ~CMusicTagReaderJob()
+  {
+    // the directory may be written and freed as soon as it has no pending tags
+    AtomicDecrement(&m_directory->m_pending);
+    AtomicDecrement(&m_scanner->m_tagJobs);
+    m_scanner->m_tagsRead.Set();
+  }
+
+  virtual const char *GetType() const { return "musictagreader"; }
+
+  virtual bool DoWork()
+  {
+    if (m_scanner->m_bStop)
+      return false;
+
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    CFileItemPtr pItem = m_directory->m_items[m_item];
+    CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
+    if (!tag.Loaded())
+    { // read the tag from a file
+      auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(pItem->GetPath()));
+      if (NULL != pLoader.get())
+        pLoader->Load(pItem->GetPath(), tag);
+    }
+
+    if (tag.Loaded())
+      m_directory->m_thumbs[m_item] = pItem->GetUserMusicThumb(true);
+
+    AtomicIncrement(&m_scanner->m_tagsLoaded);
+    AtomicAdd(&m_scanner->m_tagTime, XbmcThreads::SystemClockMillis() - start);
+    return true;
+  }
+
+private:
+  CMusicInfoScanner *m_scanner;
+  CMusicScanDirectory *m_directory;
+  int m_item;
+};
+}
+
+static bool IsSong(const CFileItemPtr &pItem, const CStdStringArray &regexps)
+{
+  // Discard all excluded files defined by m_musicExcludeRegExps
+  if (CUtil::ExcludeFileOrFolder(pItem->GetPath(), regexps))
+    return false;
+
+  // dont try reading id3tags for folders, playlists or shoutcast streams
+  return !pItem->m_bIsFolder && !pItem->IsPlayList() && !pItem->IsPicture() && !pItem->IsLyrics();
+}
+
 CMusicInfoScanner::CMusicInfoScanner() : CThread("CMusicInfoScanner")
 {
   m_bRunning = false;
@@ -68,6 +153,14 @@ CMusicInfoScanner::CMusicInfoScanner() : CThread("CMusicInfoScanner")
   m_currentItem=0;
   m_itemCount=0;
   m_flags = 0;
+  m_tagJobs = 0;
+  m_songsToCommit = 0;
+  m_directoriesScanned = 0;
+  m_songsWritten = 0;
+  m_enumerateTime = 0;
+  m_writeTime = 0;
+  m_tagsLoaded = 0;
+  m_tagTime = 0;
 }
 
 CMusicInfoScanner::~CMusicInfoScanner()
@@ -115,6 +208,13 @@ void CMusicInfoScanner::Process()
       m_bCanInterrupt = false;
       m_needsCleanup = false;
 
+      m_directoriesScanned = 0;
+      m_songsWritten = 0;
+      m_enumerateTime = 0;
+      m_writeTime = 0;
+      m_tagsLoaded = 0;
+      m_tagTime = 0;
+
       bool commit = false;
       bool cancelled = false;
       while (!cancelled && m_pathsToScan.size())
@@ -131,6 +231,9 @@ void CMusicInfoScanner::Process()
         commit = !cancelled;
       }
 
+      // add what's still being read, or wait for the readers if we were cancelled
+      WriteDirectories(true);
+
       if (commit)
       {
         g_infoManager.ResetLibraryBools();
@@ -161,6 +264,11 @@ void CMusicInfoScanner::Process()
 
       tick = XbmcThreads::SystemClockMillis() - tick;
       CLog::Log(LOGNOTICE, "My Music: Scanning for music info using worker thread, operation took %s", StringUtils::SecondsToTimeString(tick / 1000).c_str());
+      CLog::Log(LOGNOTICE, "My Music: Scanned %d directories and added %d songs (%.1f songs/s), "
+                           "enumeration took %u ms, reading %ld tags took %ld ms (%.1f ms per tag), adding to the database took %u ms",
+                m_directoriesScanned, m_songsWritten, tick ? m_songsWritten * 1000.0f / tick : 0.0f,
+                m_enumerateTime, m_tagsLoaded, m_tagTime, m_tagsLoaded ? (float)m_tagTime / m_tagsLoaded : 0.0f,
+                m_writeTime);
     }
     bool bCanceled;
     if (m_scanType == 1) // load album info
@@ -390,6 +498,9 @@ bool CMusicInfoScanner::DoScan(const CStdString& strDirectory)
   if (CUtil::ExcludeFileOrFolder(strDirectory, regexps))
     return true;
 
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  m_directoriesScanned++;
+
   // load subfolder
   CFileItemList items;
   CDirectory::GetDirectory(strDirectory, items, g_settings.m_musicExtensions + "|.jpg|.tbn|.lrc|.cdg");
@@ -413,19 +524,14 @@ bool CMusicInfoScanner::DoScan(const CStdString& strDirectory)
     // filter items in the sub dir (for .cue sheet support)
     items.FilterCueItems();
     items.Sort(SORT_METHOD_LABEL, SortOrderAscending);
+    m_enumerateTime += XbmcThreads::SystemClockMillis() - start;
 
-    // and then scan in the new information
-    if (RetrieveMusicInfo(items, strDirectory) > 0)
-    {
-      if (m_handle)
-        OnDirectoryScanned(strDirectory);
-    }
-
-    // save information about this folder
-    m_musicDatabase.SetPathHash(strDirectory, hash);
+    // and then scan in the new information while we carry on with the subfolders
+    QueueDirectory(strDirectory, hash, items);
   }
   else
   { // path is the same - no need to rescan
+    m_enumerateTime += XbmcThreads::SystemClockMillis() - start;
     CLog::Log(LOGDEBUG, "%s Skipping dir '%s' due to no change", __FUNCTION__, strDirectory.c_str());
     m_currentItem += CountFiles(items, false);  // false for non-recursive
 
@@ -459,131 +565,252 @@ bool CMusicInfoScanner::DoScan(const CStdString& strDirectory)
   return !m_bStop;
 }
 
-int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString& strDirectory)
+void CMusicInfoScanner::QueueDirectory(const CStdString& strDirectory, const CStdString& hash, const CFileItemList& items)
 {
-  CSongMap songsMap;
+  CMusicScanDirectory *directory = new CMusicScanDirectory(strDirectory, hash);
+  directory->m_items.Append(items);
+  directory->m_thumbs.resize(items.Size());
+  m_directoriesToWrite.push_back(directory);
 
-  // get all information for all files in current directory from database, and remove them
-  if (m_musicDatabase.RemoveSongsFromPath(strDirectory, songsMap))
-    m_needsCleanup = true;
+  CStdStringArray regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
+
+  for (int i = 0; i < directory->m_items.Size() && !m_bStop; ++i)
+  {
+    if (!IsSong(directory->m_items[i], regexps))
+      continue;
+
+    // add what we can while the readers are busy
+    while (m_tagJobs >= g_advancedSettings.m_musicScanTagReaders)
+    {
+      WriteDirectories(false);
+      if (m_tagJobs >= g_advancedSettings.m_musicScanTagReaders)
+        m_tagsRead.Wait();
+    }
+
+    AtomicIncrement(&directory->m_pending);
+    AtomicIncrement(&m_tagJobs);
+    CMusicTagReaderJob *job = new CMusicTagReaderJob(this, directory, i);
+    if (!CJobManager::GetInstance().AddJob(job, NULL, CJob::PRIORITY_NORMAL))
+    { // the job manager isn't running, read the tag ourselves
+      job->DoWork();
+      delete job;
+    }
+  }
+
+  WriteDirectories(false);
+}
+
+void CMusicInfoScanner::WriteDirectories(bool wait)
+{
+  while (!m_directoriesToWrite.empty())
+  {
+    CMusicScanDirectory *directory = m_directoriesToWrite.front();
+    if (directory->m_pending > 0)
+    {
+      if (!wait)
+        break;
+
+      m_tagsRead.Wait();
+      continue;
+    }
+
+    m_directoriesToWrite.pop_front();
+    if (m_bStop)
+    {
+      delete directory;
+      continue;
+    }
+
+    if (RetrieveMusicInfo(*directory) > 0 && m_handle)
+      OnDirectoryScanned(directory->m_path);
+
+    // directories without songs are committed as well, to store their hash
+    m_directoriesToCommit.push_back(directory);
+    m_songsToCommit += directory->m_songs;
+    if (m_songsToCommit >= g_advancedSettings.m_musicScanBatchSize)
+      CommitSongs();
+  }
+
+  if (wait)
+    CommitSongs();
+}
+
+int CMusicInfoScanner::RetrieveMusicInfo(CMusicScanDirectory& directory)
+{
+  // get all information for all files in current directory from database,
+  // they are replaced once the directory is committed
+  CSongMap songsMap;
+  m_musicDatabase.GetSongsByPath(directory.m_path, songsMap);
 
   VECSONGS songsToAdd;
 
   CStdStringArray regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
 
   // for every file found, but skip folder
+  CFileItemList& items = directory.m_items;
   for (int i = 0; i < items.Size(); ++i)
   {
     CFileItemPtr pItem = items[i];
-    CStdString strExtension;
-    URIUtils::GetExtension(pItem->GetPath(), strExtension);
+    if (!IsSong(pItem, regexps))
+      continue;
 
-    if (m_bStop)
-      return 0;
+    m_currentItem++;
 
-    // Discard all excluded files defined by m_musicExcludeRegExps
-    if (CUtil::ExcludeFileOrFolder(pItem->GetPath(), regexps))
-      continue;
+    // grab info from the song
+    CSong *dbSong = songsMap.Find(pItem->GetPath());
 
-    // dont try reading id3tags for folders, playlists or shoutcast streams
-    if (!pItem->m_bIsFolder && !pItem->IsPlayList() && !pItem->IsPicture() && !pItem->IsLyrics() )
-    {
-      m_currentItem++;
-//      CLog::Log(LOGDEBUG, "%s - Reading tag for: %s", __FUNCTION__, pItem->GetPath().c_str());
-
-      // grab info from the song
-      CSong *dbSong = songsMap.Find(pItem->GetPath());
-
-      CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
-      if (!tag.Loaded() )
-      { // read the tag from a file
-        auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(pItem->GetPath()));
-        if (NULL != pLoader.get())
-          pLoader->Load(pItem->GetPath(), tag);
-      }
+    // the tag has been read by a CMusicTagReaderJob
+    CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
 
-      // if we have the itemcount, update our
-      // dialog with the progress we made
-      if (m_handle && m_itemCount>0)
-        m_handle->SetPercentage(m_currentItem/(float)m_itemCount*100);
+    // if we have the itemcount, update our
+    // dialog with the progress we made
+    if (m_handle && m_itemCount>0)
+      m_handle->SetPercentage(m_currentItem/(float)m_itemCount*100);
+
+    if (tag.Loaded())
+    {
+      CSong song(tag);
 
-      if (tag.Loaded())
+      // ensure our song has a valid filename or else it will assert in AddSong()
+      if (song.strFileName.IsEmpty())
       {
-        CSong song(tag);
+        // copy filename from path in case UPnP or other tag loaders didn't specify one (FIXME?)
+        song.strFileName = pItem->GetPath();
 
-        // ensure our song has a valid filename or else it will assert in AddSong()
+        // if we still don't have a valid filename, skip the song
         if (song.strFileName.IsEmpty())
         {
-          // copy filename from path in case UPnP or other tag loaders didn't specify one (FIXME?)
-          song.strFileName = pItem->GetPath();
-
-          // if we still don't have a valid filename, skip the song
-          if (song.strFileName.IsEmpty())
-          {
-            // this shouldn't ideally happen!
-            CLog::Log(LOGERROR, "Skipping song since it doesn't seem to have a filename");
-            continue;
-          }
+          // this shouldn't ideally happen!
+          CLog::Log(LOGERROR, "Skipping song since it doesn't seem to have a filename");
+          continue;
         }
+      }
 
-        song.iStartOffset = pItem->m_lStartOffset;
-        song.iEndOffset = pItem->m_lEndOffset;
-        song.strThumb = pItem->GetUserMusicThumb(true);
-        if (dbSong)
-        { // keep the db-only fields intact on rescan...
-          song.iTimesPlayed = dbSong->iTimesPlayed;
-          song.lastPlayed = dbSong->lastPlayed;
-          song.iKaraokeNumber = dbSong->iKaraokeNumber;
-
-          if (song.rating == '0') song.rating = dbSong->rating;
-          if (song.strThumb.empty())
-            song.strThumb = dbSong->strThumb;
-        }
-        songsToAdd.push_back(song);
-//        CLog::Log(LOGDEBUG, "%s - Tag loaded for: %s", __FUNCTION__, pItem->GetPath().c_str());
+      song.iStartOffset = pItem->m_lStartOffset;
+      song.iEndOffset = pItem->m_lEndOffset;
+      song.strThumb = directory.m_thumbs[i];
+      if (dbSong)
+      { // keep the db-only fields intact on rescan...
+        song.iTimesPlayed = dbSong->iTimesPlayed;
+        song.lastPlayed = dbSong->lastPlayed;
+        song.iKaraokeNumber = dbSong->iKaraokeNumber;
+
+        if (song.rating == '0') song.rating = dbSong->rating;
+        if (song.strThumb.empty())
+          song.strThumb = m_musicDatabase.GetArtForItem(dbSong->idSong, "song", "thumb");
       }
-      else
-        CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, pItem->GetPath().c_str());
+      songsToAdd.push_back(song);
     }
+    else
+      CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, pItem->GetPath().c_str());
   }
 
-  VECALBUMS albums;
-  CategoriseAlbums(songsToAdd, albums);
-  FindArtForAlbums(albums, items.GetPath());
+  // looking for art touches the filesystem, so it's done before the directory is committed
+  CategoriseAlbums(songsToAdd, directory.m_albums);
+  FindArtForAlbums(directory.m_albums, directory.m_path);
+  directory.m_songs = songsToAdd.size();
+
+  // only the albums are needed from here on
+  directory.m_items.Clear();
+  directory.m_thumbs.clear();
+
+  return directory.m_songs;
+}
+
+void CMusicInfoScanner::AddDirectory(const CMusicScanDirectory& directory)
+{
+  // remove the songs we're replacing
+  CSongMap songsMap;
+  if (m_musicDatabase.RemoveSongsFromPath(directory.m_path, songsMap))
+    m_needsCleanup = true;
 
   // finally, add these to the database
-  m_musicDatabase.BeginTransaction();
-  int numAdded = 0;
-  set<int> albumsToScan;
-  set<int> artistsToScan;
-  for (VECALBUMS::iterator i = albums.begin(); i != albums.end(); ++i)
+  for (VECALBUMS::const_iterator i = directory.m_albums.begin(); i != directory.m_albums.end(); ++i)
   {
     vector<int> songIDs;
     int idAlbum = m_musicDatabase.AddAlbum(*i, songIDs);
-    numAdded += i->songs.size();
-    if (m_bStop)
-    {
-      m_musicDatabase.RollbackTransaction();
-      return numAdded;
-    }
 
     // Build the artist & album sets
-    albumsToScan.insert(idAlbum);
+    m_albumsAdded.insert(idAlbum);
     for (vector<int>::iterator j = songIDs.begin(); j != songIDs.end(); ++j)
     {
       vector<int> songArtists;
       m_musicDatabase.GetArtistsBySong(*j, false, songArtists);
-      artistsToScan.insert(songArtists.begin(), songArtists.end());
+      m_artistsAdded.insert(songArtists.begin(), songArtists.end());
     }
     std::vector<int> albumArtists;
     m_musicDatabase.GetArtistsByAlbum(idAlbum, false, albumArtists);
-    artistsToScan.insert(albumArtists.begin(), albumArtists.end());
+    m_artistsAdded.insert(albumArtists.begin(), albumArtists.end());
+  }
+
+  // save information about this folder
+  m_musicDatabase.SetPathHash(directory.m_path, directory.m_hash);
+}
+
+void CMusicInfoScanner::DiscardDirectories()
+{
+  for (deque<CMusicScanDirectory*>::iterator it = m_directoriesToCommit.begin(); it != m_directoriesToCommit.end(); ++it)
+    delete *it;
+  m_directoriesToCommit.clear();
+  m_songsToCommit = 0;
+}
+
+void CMusicInfoScanner::CommitSongs()
+{
+  if (m_directoriesToCommit.empty())
+    return;
+
+  // a cancelled scan doesn't add the directories it hasn't committed yet,
+  // they're scanned again next time as their hash isn't stored
+  if (m_bStop)
+  {
+    DiscardDirectories();
+    return;
+  }
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  int songs = 0;
+  bool cancelled = false;
+  m_musicDatabase.BeginTransaction();
+  try
+  {
+    for (deque<CMusicScanDirectory*>::iterator it = m_directoriesToCommit.begin(); it != m_directoriesToCommit.end(); ++it)
+    {
+      if (m_bStop)
+      {
+        cancelled = true;
+        break;
+      }
+      AddDirectory(**it);
+      songs += (*it)->m_songs;
+    }
+  }
+  catch (...)
+  {
+    m_musicDatabase.RollbackTransaction();
+    DiscardDirectories();
+    m_albumsAdded.clear();
+    m_artistsAdded.clear();
+    throw;
+  }
+
+  DiscardDirectories();
+  if (cancelled)
+  {
+    m_musicDatabase.RollbackTransaction();
+    m_albumsAdded.clear();
+    m_artistsAdded.clear();
+    m_writeTime += XbmcThreads::SystemClockMillis() - start;
+    return;
   }
+
   m_musicDatabase.CommitTransaction();
+  m_songsWritten += songs;
+  m_writeTime += XbmcThreads::SystemClockMillis() - start;
 
   // Download info & artwork
   bool bCanceled;
-  for (set<int>::iterator it = artistsToScan.begin(); it != artistsToScan.end(); ++it)
+  for (set<int>::iterator it = m_artistsAdded.begin(); it != m_artistsAdded.end(); ++it)
   {
     bCanceled = false;
     if (find(m_artistsScanned.begin(),m_artistsScanned.end(), *it) == m_artistsScanned.end())
@@ -605,13 +832,14 @@ int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString&
       }
     }
   }
+  m_artistsAdded.clear();
 
   if (m_flags & SCAN_ONLINE)
   {
-    for (set<int>::iterator it = albumsToScan.begin(); it != albumsToScan.end(); ++it)
+    for (set<int>::iterator it = m_albumsAdded.begin(); it != m_albumsAdded.end(); ++it)
     {
       if (m_bStop)
-        return songsToAdd.size();
+        break;
 
       CStdString strPath;
       strPath.Format("musicdb://3/%u/",*it);
@@ -627,10 +855,10 @@ int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString&
       }
     }
   }
+  m_albumsAdded.clear();
+
   if (m_handle)
     m_handle->SetTitle(g_localizeStrings.Get(505));
-
-  return songsToAdd.size();
 }
 
 static bool SortSongsByTrack(CSong *song, CSong *song2)
@@ -19,15 +19,21 @@
  *
  */
 #include "threads/Thread.h"
+#include "threads/Event.h"
 #include "music/MusicDatabase.h"
 #include "MusicAlbumInfo.h"
 
+#include <deque>
+
 class CAlbum;
 class CArtist;
 class CGUIDialogProgressBarHandle;
 
 namespace MUSIC_INFO
 {
+class CMusicScanDirectory;
+class CMusicTagReaderJob;
+
 class CMusicInfoScanner : CThread, public IRunnable
 {
 public:
@@ -95,13 +101,44 @@ public:
 
   std::map<std::string, std::string> GetArtistArtwork(long id, const CArtist *artist = NULL);
 protected:
+  friend class CMusicTagReaderJob;
+
   virtual void Process();
-  int RetrieveMusicInfo(CFileItemList& items, const CStdString& strDirectory);
+  int RetrieveMusicInfo(CMusicScanDirectory& directory);
   int GetPathHash(const CFileItemList &items, CStdString &hash);
   void GetAlbumArtwork(long id, const CAlbum &artist);
 
   bool DoScan(const CStdString& strDirectory);
 
+  /*! \brief Read the tags of the songs in a changed directory in the background
+   The tags are read by up to m_musicScanTagReaders jobs while the enumeration
+   continues, the directory is added to the database by WriteDirectories().
+   \param strDirectory path of the directory.
+   \param hash hash of the directory contents to store once the directory has been added.
+   \param items the (filtered) items of the directory.
+   */
+  void QueueDirectory(const CStdString& strDirectory, const CStdString& hash, const CFileItemList& items);
+
+  /*! \brief Add directories whose tags have been read to the database
+   Directories are prepared in the order they were queued, and committed in
+   transactions of m_musicScanBatchSize songs.
+   \param wait whether to wait for all queued directories or stop at the first one still being read.
+   */
+  void WriteDirectories(bool wait);
+
+  /*! \brief Add a prepared directory to the database, within the transaction of CommitSongs()
+   */
+  void AddDirectory(const CMusicScanDirectory& directory);
+
+  /*! \brief Free the prepared directories without adding them
+   */
+  void DiscardDirectories();
+
+  /*! \brief Add the prepared directories in a single transaction and fetch artwork and info
+   for the artists and albums added in it. The transaction is rolled back if the scan is cancelled.
+   */
+  void CommitSongs();
+
   virtual void Run();
   int CountFiles(const CFileItemList& items, bool recursive);
   int CountFilesRecursively(const CStdString& strPath);
@@ -124,5 +161,21 @@ protected:
   std::vector<long> m_artistsScanned;
   std::vector<long> m_albumsScanned;
   int m_flags;
+
+  std::deque<CMusicScanDirectory*> m_directoriesToWrite;
+  std::deque<CMusicScanDirectory*> m_directoriesToCommit;
+  CEvent m_tagsRead;
+  volatile long m_tagJobs;
+  int m_songsToCommit;
+  std::set<int> m_albumsAdded;
+  std::set<int> m_artistsAdded;
+
+  // statistics of the last scan
+  int m_directoriesScanned;
+  int m_songsWritten;
+  unsigned int m_enumerateTime;
+  unsigned int m_writeTime;
+  volatile long m_tagsLoaded;
+  volatile long m_tagTime;
 };
 }
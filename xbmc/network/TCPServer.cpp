@@ -24,6 +24,12 @@
 #include <memory.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#ifdef HAS_TCPSERVER_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #include "settings/AdvancedSettings.h"
 #include "interfaces/json-rpc/JSONRPC.h"
@@ -55,6 +61,33 @@ using namespace ANNOUNCEMENT;
 //using namespace std; On VS2010, bind conflicts with std::bind
 
 #define RECEIVEBUFFER 1024
+#define SENDBUFFER    65536
+#define MAXSENDQUEUE  16777216  // data queued for a client which doesn't read it before it is dropped
+#define MAXINPUT      65536     // unprocessed input read while a response is pending
+#define EPOLLEVENTS   64
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#ifdef _WIN32
+#define SOCKET_WOULDBLOCK()   (WSAGetLastError() == WSAEWOULDBLOCK)
+#define SOCKET_INTERRUPTED()  (WSAGetLastError() == WSAEINTR)
+#else
+#define SOCKET_WOULDBLOCK()   (errno == EAGAIN || errno == EWOULDBLOCK)
+#define SOCKET_INTERRUPTED()  (errno == EINTR)
+#endif
+
+static bool SetNonBlocking(SOCKET socket)
+{
+#ifdef _WIN32
+  u_long nonblocking = 1;
+  return ioctlsocket(socket, FIONBIO, &nonblocking) == 0;
+#else
+  int flags = fcntl(socket, F_GETFL, 0);
+  return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
 
 CTCPServer *CTCPServer::ServerInstance = NULL;
 
@@ -90,6 +123,7 @@ CTCPServer::CTCPServer(int port, bool nonlocal) : CThread("CTCPServer")
   m_port = port;
   m_nonlocal = nonlocal;
   m_sdpd = NULL;
+  m_epoll = -1;
 }
 
 void CTCPServer::Process()
@@ -98,110 +132,282 @@ void CTCPServer::Process()
 
   while (!m_bStop)
   {
-    SOCKET          max_fd = 0;
-    fd_set          rfds;
-    struct timeval  to     = {1, 0};
-    FD_ZERO(&rfds);
+    bool success;
+#ifdef HAS_TCPSERVER_EPOLL
+    if (m_epoll >= 0)
+      success = ProcessEpoll();
+    else
+#endif
+      success = ProcessSelect();
+
+    if (!success)
+    {
+      Sleep(1000);
+      Initialize();
+    }
+  }
+
+  Deinitialize();
+}
+
+bool CTCPServer::ProcessSelect()
+{
+  SOCKET          max_fd = 0;
+  fd_set          rfds, wfds;
+  struct timeval  to     = {1, 0};
+  FD_ZERO(&rfds);
+  FD_ZERO(&wfds);
+
+  for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); it++)
+  {
+    FD_SET(*it, &rfds);
+    if ((intptr_t)*it > (intptr_t)max_fd)
+      max_fd = *it;
+  }
+
+  for (unsigned int i = 0; i < m_connections.size(); i++)
+  {
+    if (m_connections[i]->CanReceive())
+      FD_SET(m_connections[i]->m_socket, &rfds);
+    if (m_connections[i]->HasQueuedData())
+      FD_SET(m_connections[i]->m_socket, &wfds);
+    if ((intptr_t)m_connections[i]->m_socket > (intptr_t)max_fd)
+      max_fd = m_connections[i]->m_socket;
+  }
+
+  int res = select((intptr_t)max_fd+1, &rfds, &wfds, NULL, &to);
+  if (res < 0)
+  {
+    CLog::Log(LOGERROR, "JSONRPC Server: Select failed");
+    return false;
+  }
+
+  if (res > 0)
+  {
+    for (int i = m_connections.size() - 1; i >= 0; i--)
+    {
+      CTCPClient *client = m_connections[i];
+      SOCKET socket = client->m_socket;
+      bool close = false;
+      if (FD_ISSET(socket, &rfds))
+        close = !ReadConnection(client);
+      if (!close && FD_ISSET(socket, &wfds))
+        client->Flush(this);
+      if (close || client->m_socket == INVALID_SOCKET)
+        RemoveConnection(client);
+    }
 
     for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); it++)
     {
-      FD_SET(*it, &rfds);
-      if ((intptr_t)*it > (intptr_t)max_fd)
-        max_fd = *it;
+      if (FD_ISSET(*it, &rfds) && !AcceptConnection(*it))
+        return false;
     }
+  }
 
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+  return true;
+}
+
+#ifdef HAS_TCPSERVER_EPOLL
+bool CTCPServer::InitializeEpoll()
+{
+  m_epoll = epoll_create(EPOLLEVENTS);
+  if (m_epoll < 0)
+  {
+    CLog::Log(LOGWARNING, "JSONRPC Server: Failed to create epoll instance, falling back to select");
+    return false;
+  }
+
+  // events carry a pointer to the server socket or the connection they are for
+  for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); it++)
+  {
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = &(*it);
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, *it, &event) < 0)
     {
-      FD_SET(m_connections[i]->m_socket, &rfds);
-      if ((intptr_t)m_connections[i]->m_socket > (intptr_t)max_fd)
-        max_fd = m_connections[i]->m_socket;
+      CLog::Log(LOGWARNING, "JSONRPC Server: Failed to add serversocket to epoll, falling back to select");
+      close(m_epoll);
+      m_epoll = -1;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool CTCPServer::ProcessEpoll()
+{
+  struct epoll_event events[EPOLLEVENTS];
+  int res = epoll_wait(m_epoll, events, EPOLLEVENTS, 1000);
+  if (res < 0)
+  {
+    if (errno == EINTR)
+      return true;
+
+    CLog::Log(LOGERROR, "JSONRPC Server: epoll_wait failed");
+    return false;
+  }
+
+  for (int event = 0; event < res; event++)
+  {
+    void *ptr = events[event].data.ptr;
+    SOCKET *server = NULL;
+    for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end() && server == NULL; it++)
+    {
+      if (ptr == &(*it))
+        server = &(*it);
     }
 
-    int res = select((intptr_t)max_fd+1, &rfds, NULL, NULL, &to);
-    if (res < 0)
+    if (server != NULL)
     {
-      CLog::Log(LOGERROR, "JSONRPC Server: Select failed");
-      Sleep(1000);
-      Initialize();
+      if (!AcceptConnection(*server))
+        return false;
+      continue;
     }
-    else if (res > 0)
+
+    // client sockets are edge triggered so they are read and
+    // written until they would block
+    CTCPClient *client = (CTCPClient*)ptr;
+    bool close = false;
+    if (events[event].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+      close = !ReadConnection(client);
+    if (!close && (events[event].events & EPOLLOUT))
     {
-      for (int i = m_connections.size() - 1; i >= 0; i--)
+      // input which was left unread while a response was pending won't
+      // trigger another event, so read it once the response is out
+      bool blocked = !client->CanReceive();
+      client->Flush(this);
+      if (blocked && client->CanReceive())
+        close = !ReadConnection(client);
+    }
+    if (close || client->m_socket == INVALID_SOCKET)
+      RemoveConnection(client);
+  }
+
+  return true;
+}
+#endif
+
+bool CTCPServer::AcceptConnection(SOCKET server)
+{
+  CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
+  CTCPClient *newconnection = new CTCPClient();
+  newconnection->m_socket = accept(server, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
+
+  if (newconnection->m_socket == INVALID_SOCKET)
+  {
+    CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
+    delete newconnection;
+    return EBADF != errno;
+  }
+
+  if (!SetNonBlocking(newconnection->m_socket))
+    CLog::Log(LOGWARNING, "JSONRPC Server: Failed to make connection non-blocking");
+
+#ifdef HAS_TCPSERVER_EPOLL
+  if (m_epoll >= 0)
+  {
+    if (!WatchConnection(newconnection, EPOLL_CTL_ADD))
+    {
+      CLog::Log(LOGERROR, "JSONRPC Server: Failed to add new connection to epoll");
+      newconnection->Disconnect();
+      delete newconnection;
+      return true;
+    }
+  }
+#endif
+
+  CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
+  CSingleLock lock(m_connectionsSection);
+  m_connections.push_back(newconnection);
+  return true;
+}
+
+#ifdef HAS_TCPSERVER_EPOLL
+bool CTCPServer::WatchConnection(CTCPClient *client, int operation)
+{
+  struct epoll_event event = {};
+  event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+  event.data.ptr = client;
+  return epoll_ctl(m_epoll, operation, client->m_socket, &event) == 0;
+}
+#endif
+
+bool CTCPServer::ReadConnection(CTCPClient *&client)
+{
+  char buffer[RECEIVEBUFFER] = {};
+  while (true)
+  {
+    // a client which sends requests faster than it reads the responses is
+    // read from again once the pending response has been sent
+    if (!client->CanReceive())
+      return true;
+
+    int nread = recv(client->m_socket, (char*)&buffer, RECEIVEBUFFER, 0);
+    if (nread < 0 && SOCKET_INTERRUPTED())
+      continue;
+    if (nread < 0 && SOCKET_WOULDBLOCK())
+      return true;
+    if (nread <= 0)
+      return false;
+
+    std::string response;
+    if (client->IsNew())
+    {
+      CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
+
+      if (websocket != NULL)
       {
-        int socket = m_connections[i]->m_socket;
-        if (FD_ISSET(socket, &rfds))
+        // Replace the CTCPClient with a CWebSocketClient
+        CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *client);
         {
-          char buffer[RECEIVEBUFFER] = {};
-          int  nread = 0;
-          nread = recv(socket, (char*)&buffer, RECEIVEBUFFER, 0);
-          bool close = false;
-          if (nread > 0)
-          {
-            std::string response;
-            if (m_connections[i]->IsNew())
-            {
-              CWebSocket *websocket = CWebSocketManager::Handle(buffer, nread, response);
-
-              if (response.size() > 0)
-                m_connections[i]->Send(response.c_str(), response.size());
-
-              if (websocket != NULL)
-              {
-                // Replace the CTCPClient with a CWebSocketClient
-                CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *(m_connections[i]));
-                delete m_connections[i];
-                m_connections.erase(m_connections.begin() + i);
-                m_connections.insert(m_connections.begin() + i, websocketClient);
-              }
-            }
-
-            if (response.size() <= 0)
-              m_connections[i]->PushBuffer(this, buffer, nread);
-
-            close = m_connections[i]->Closing();
-          }
-          else
-            close = true;
-
-          if (close)
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
-            m_connections[i]->Disconnect();
-            delete m_connections[i];
-            m_connections.erase(m_connections.begin() + i);
-          }
+          CSingleLock lock(m_connectionsSection);
+          std::replace(m_connections.begin(), m_connections.end(), client, (CTCPClient*)websocketClient);
+          delete client;
         }
-      }
+        client = websocketClient;
 
-      for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); it++)
-      {
-        if (FD_ISSET(*it, &rfds))
+#ifdef HAS_TCPSERVER_EPOLL
+        if (m_epoll >= 0 && !WatchConnection(client, EPOLL_CTL_MOD))
         {
-          CLog::Log(LOGDEBUG, "JSONRPC Server: New connection detected");
-          CTCPClient *newconnection = new CTCPClient();
-          newconnection->m_socket = accept(*it, (sockaddr*)&newconnection->m_cliaddr, &newconnection->m_addrlen);
-
-          if (newconnection->m_socket == INVALID_SOCKET)
-          {
-            CLog::Log(LOGERROR, "JSONRPC Server: Accept of new connection failed: %d", errno);
-            if (EBADF == errno)
-            {
-              Sleep(1000);
-              Initialize();
-              break;
-            }
-          }
-          else
-          {
-            CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
-            m_connections.push_back(newconnection);
-          }
+          CLog::Log(LOGERROR, "JSONRPC Server: Failed to update the connection in epoll");
+          return false;
         }
+#endif
       }
+
+      // the handshake must not be sent as a websocket frame
+      if (response.size() > 0)
+        client->CTCPClient::Send(response.c_str(), response.size());
     }
+
+    if (response.size() <= 0)
+      client->PushBuffer(this, buffer, nread);
+
+    if (client->Closing() || client->m_socket == INVALID_SOCKET)
+      return false;
+
+    // everything available has been read
+    if (nread < RECEIVEBUFFER)
+      return true;
   }
+}
 
-  Deinitialize();
+void CTCPServer::RemoveConnection(CTCPClient *client)
+{
+  CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+#ifdef HAS_TCPSERVER_EPOLL
+  if (m_epoll >= 0 && client->m_socket != INVALID_SOCKET)
+  {
+    struct epoll_event event = {};
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, client->m_socket, &event);
+  }
+#endif
+  client->Disconnect();
+
+  CSingleLock lock(m_connectionsSection);
+  m_connections.erase(std::remove(m_connections.begin(), m_connections.end(), client), m_connections.end());
+  delete client;
 }
 
 bool CTCPServer::PrepareDownload(const char *path, CVariant &details, std::string &protocol)
@@ -221,18 +427,12 @@ int CTCPServer::GetCapabilities()
 
 void CTCPServer::Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
 {
+  // serialize the announcement once for all clients
   std::string str = IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact);
 
+  CSingleLock lock(m_connectionsSection);
   for (unsigned int i = 0; i < m_connections.size(); i++)
-  {
-    {
-      CSingleLock lock (m_connections[i]->m_critSection);
-      if ((m_connections[i]->GetAnnouncementFlags() & flag) == 0)
-        continue;
-    }
-
-    m_connections[i]->Send(str.c_str(), str.size());
-  }
+    m_connections[i]->SendAnnouncement(flag, str);
 }
 
 bool CTCPServer::Initialize()
@@ -246,6 +446,9 @@ bool CTCPServer::Initialize()
 
   if(started)
   {
+#ifdef HAS_TCPSERVER_EPOLL
+    InitializeEpoll();
+#endif
     CAnnouncementManager::AddAnnouncer(this);
     CLog::Log(LOGINFO, "JSONRPC Server: Successfully initialized");
     return true;
@@ -289,7 +492,7 @@ bool CTCPServer::InitializeBlue()
   if(getsockname(fd, (SOCKADDR*)&sa, &len) < 0)
     CLog::Log(LOGERROR, "JSONRPC Server: Failed to get bluetooth port");
 
-  if (listen(fd, 10) < 0)
+  if (listen(fd, SOMAXCONN) < 0)
   {
     CLog::Log(LOGERROR, "JSONRPC Server: Failed to listen to bluetooth port");
     closesocket(fd);
@@ -346,7 +549,7 @@ bool CTCPServer::InitializeBlue()
   if(getsockname(fd, (struct sockaddr*)&sa, &len) < 0)
     CLog::Log(LOGERROR, "JSONRPC Server: Failed to get bluetooth port");
 
-  if (listen(fd, 10) < 0)
+  if (listen(fd, SOMAXCONN) < 0)
   {
     CLog::Log(LOGERROR, "JSONRPC Server: Failed to listen to bluetooth port %d", sa.rc_channel);
     closesocket(fd);
@@ -463,7 +666,7 @@ bool CTCPServer::InitializeTCP()
     return false;
   }
 
-  if (listen(fd, 10) < 0)
+  if (listen(fd, SOMAXCONN) < 0)
   {
     CLog::Log(LOGERROR, "JSONRPC Server: Failed to set listen");
     closesocket(fd);
@@ -475,13 +678,24 @@ bool CTCPServer::InitializeTCP()
 
 void CTCPServer::Deinitialize()
 {
-  for (unsigned int i = 0; i < m_connections.size(); i++)
+  CAnnouncementManager::RemoveAnnouncer(this);
+
   {
-    m_connections[i]->Disconnect();
-    delete m_connections[i];
+    CSingleLock lock(m_connectionsSection);
+    for (unsigned int i = 0; i < m_connections.size(); i++)
+    {
+      m_connections[i]->Disconnect();
+      delete m_connections[i];
+    }
+
+    m_connections.clear();
   }
 
-  m_connections.clear();
+#ifdef HAS_TCPSERVER_EPOLL
+  if (m_epoll >= 0)
+    close(m_epoll);
+  m_epoll = -1;
+#endif
 
   for (unsigned int i = 0; i < m_servers.size(); i++)
     closesocket(m_servers[i]);
@@ -493,8 +707,6 @@ void CTCPServer::Deinitialize()
     sdp_close( (sdp_session_t*)m_sdpd );
   m_sdpd = NULL;
 #endif
-
-  CAnnouncementManager::RemoveAnnouncer(this);
 }
 
 CTCPServer::CTCPClient::CTCPClient()
@@ -502,10 +714,12 @@ CTCPServer::CTCPClient::CTCPClient()
   m_new = true;
   m_announcementflags = ANNOUNCE_ALL;
   m_socket = INVALID_SOCKET;
-  m_beginBrackets = 0;
-  m_endBrackets = 0;
-  m_beginChar = 0;
-  m_endChar = 0;
+  m_scanPosition = 0;
+  m_messageStart = 0;
+  m_depth = 0;
+  m_inString = false;
+  m_escaped = false;
+  m_response = NULL;
 
   m_addrlen = sizeof(m_cliaddr);
 }
@@ -521,6 +735,11 @@ CTCPServer::CTCPClient& CTCPServer::CTCPClient::operator=(const CTCPClient& clie
   return *this;
 }
 
+CTCPServer::CTCPClient::~CTCPClient()
+{
+  delete m_response;
+}
+
 int CTCPServer::CTCPClient::GetPermissionFlags()
 {
   return OPERATION_PERMISSION_ALL;
@@ -539,49 +758,266 @@ bool CTCPServer::CTCPClient::SetAnnouncementFlags(int flags)
 
 void CTCPServer::CTCPClient::Send(const char *data, unsigned int size)
 {
+  if (!Write(data, size))
+  {
+    CLog::Log(LOGWARNING, "JSONRPC Server: Client doesn't read its data, closing the connection");
+    CSingleLock lock (m_critSection);
+    if (m_socket != INVALID_SOCKET)
+      shutdown(m_socket, SHUT_RDWR);
+  }
+}
+
+bool CTCPServer::CTCPClient::Write(const char *data, unsigned int size)
+{
+  CSingleLock lock (m_critSection);
+  if (m_socket == INVALID_SOCKET)
+    return false;
+
+  // data can only be sent right away if nothing is queued
   unsigned int sent = 0;
-  do
+  if (FlushQueue())
+  {
+    while (sent < size)
+    {
+      int res = send(m_socket, data + sent, size - sent, MSG_NOSIGNAL);
+      if (res < 0 && SOCKET_INTERRUPTED())
+        continue;
+      if (res <= 0)
+        break;
+      sent += res;
+    }
+  }
+
+  // queue whatever the socket didn't accept, it is sent once the socket is writable
+  if (sent < size)
+  {
+    if (m_sendBuffer.getBuffer() == NULL)
+      m_sendBuffer.Create(SENDBUFFER);
+
+    if (m_sendBuffer.getMaxWriteSize() < size - sent && !GrowQueue(size - sent))
+      return false;
+
+    m_sendBuffer.WriteData((char *)data + sent, size - sent);
+  }
+
+  return true;
+}
+
+bool CTCPServer::CTCPClient::GrowQueue(unsigned int size)
+{
+  CSingleLock lock (m_critSection);
+  unsigned int queued = m_sendBuffer.getMaxReadSize();
+  if (queued + size > MAXSENDQUEUE)
+    return false;
+
+  std::string data(queued, '\0');
+  if (queued > 0)
+    m_sendBuffer.ReadData(&data[0], queued);
+
+  m_sendBuffer.Destroy();
+  if (!m_sendBuffer.Create(std::min(std::max(2 * (queued + size), (unsigned int)SENDBUFFER), (unsigned int)MAXSENDQUEUE)))
+    return false;
+
+  if (queued > 0)
+    m_sendBuffer.WriteData(&data[0], queued);
+  return true;
+}
+
+bool CTCPServer::CTCPClient::FlushQueue()
+{
+  CSingleLock lock (m_critSection);
+  while (m_sendBuffer.getMaxReadSize() > 0)
+  {
+    unsigned int readPtr = m_sendBuffer.getReadPtr();
+    unsigned int chunk = std::min(m_sendBuffer.getMaxReadSize(), m_sendBuffer.getSize() - readPtr);
+    int res = send(m_socket, m_sendBuffer.getBuffer() + readPtr, chunk, MSG_NOSIGNAL);
+    if (res < 0 && SOCKET_INTERRUPTED())
+      continue;
+    if (res <= 0)
+      return false;
+
+    m_sendBuffer.SkipBytes(res);
+  }
+
+  // don't hold on to a queue which had to grow for a large message
+  if (m_sendBuffer.getSize() > SENDBUFFER)
+    m_sendBuffer.Destroy();
+
+  return true;
+}
+
+bool CTCPServer::CTCPClient::Flush(CTCPServer *host)
+{
+  {
+    CSingleLock lock (m_critSection);
+    if (m_socket == INVALID_SOCKET || !FlushQueue())
+      return false;
+  }
+
+  // continue with the pending response and any requests received meanwhile
+  if (m_response != NULL)
+  {
+    if (!WriteResponse())
+      return false;
+
+    ProcessInput(host);
+  }
+
+  return !HasQueuedData();
+}
+
+bool CTCPServer::CTCPClient::CanReceive()
+{
+  return m_response == NULL || m_buffer.size() < MAXINPUT;
+}
+
+bool CTCPServer::CTCPClient::HasQueuedData()
+{
+  CSingleLock lock (m_critSection);
+  return m_response != NULL || m_sendBuffer.getMaxReadSize() > 0;
+}
+
+void CTCPServer::CTCPClient::SendAnnouncement(AnnouncementFlag flag, const std::string &announcement)
+{
+  CSingleLock lock (m_critSection);
+  if ((m_announcementflags & flag) == 0 || m_socket == INVALID_SOCKET)
+    return;
+
+  // announcements must not end up in the middle of a response
+  if (m_response != NULL)
+  {
+    if (m_deferred.size() + announcement.size() <= SENDBUFFER)
+      m_deferred.append(announcement);
+    else
+      CLog::Log(LOGDEBUG, "JSONRPC Server: Dropping announcement for slow client");
+    return;
+  }
+
+  // don't let a client which doesn't read its data hold up the announcer,
+  // leave some room for the framing of websocket messages
+  if (!FlushQueue() && m_sendBuffer.getMaxWriteSize() < announcement.size() + 16)
+  {
+    CLog::Log(LOGDEBUG, "JSONRPC Server: Dropping announcement for slow client");
+    return;
+  }
+
+  Send(announcement.c_str(), announcement.size());
+}
+
+void CTCPServer::CTCPClient::SendResponse(CJSONRPCResponse *response)
+{
   {
     CSingleLock lock (m_critSection);
-    sent += send(m_socket, data, size - sent, 0);
-  } while (sent < size);
+    m_response = response;
+  }
+
+  // the response is serialized as the client reads it
+  WriteResponse();
+}
+
+bool CTCPServer::CTCPClient::WriteResponse()
+{
+  char buffer[16384];
+  while (true)
+  {
+    unsigned int available;
+    {
+      CSingleLock lock (m_critSection);
+      if (m_socket == INVALID_SOCKET || !FlushQueue())
+        return false;
+
+      if (m_sendBuffer.getBuffer() == NULL)
+        m_sendBuffer.Create(SENDBUFFER);
+      available = m_sendBuffer.getMaxWriteSize();
+    }
+
+    // only this thread writes to the queue while there is a pending response
+    size_t size = m_response->Read(buffer, std::min((size_t)available, sizeof(buffer)));
+    if (size == 0)
+      break;
+
+    CSingleLock lock (m_critSection);
+    m_sendBuffer.WriteData(buffer, size);
+  }
+
+  CSingleLock lock (m_critSection);
+  delete m_response;
+  m_response = NULL;
+
+  if (!m_deferred.empty())
+  {
+    Write(m_deferred.c_str(), m_deferred.size());
+    m_deferred.clear();
+  }
+
+  return true;
 }
 
 void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
 {
   m_new = false;
 
-  for (int i = 0; i < length; i++)
+  m_buffer.append(buffer, length);
+  ProcessInput(host);
+}
+
+void CTCPServer::CTCPClient::ProcessInput(CTCPServer *host)
+{
+  // requests are only handled once the previous response has been sent
+  std::string request;
+  while (m_response == NULL && NextMessage(request))
   {
-    char c = buffer[i];
+    CJSONRPCResponse *response = new CJSONRPCResponse();
+    if (CJSONRPC::MethodCall(request, host, this, *response))
+      SendResponse(response);
+    else
+      delete response;
+  }
+}
 
-    if (m_beginChar == 0 && c == '{')
+bool CTCPServer::CTCPClient::NextMessage(std::string &message)
+{
+  for (; m_scanPosition < m_buffer.size(); m_scanPosition++)
+  {
+    char c = m_buffer[m_scanPosition];
+    if (m_depth == 0)
     {
-      m_beginChar = '{';
-      m_endChar = '}';
+      // ignore anything in between two messages
+      if (c != '{' && c != '[')
+        continue;
+
+      m_messageStart = m_scanPosition;
     }
-    else if (m_beginChar == 0 && c == '[')
+
+    if (m_inString)
     {
-      m_beginChar = '[';
-      m_endChar = ']';
+      if (m_escaped)
+        m_escaped = false;
+      else if (c == '\\')
+        m_escaped = true;
+      else if (c == '"')
+        m_inString = false;
     }
-
-    if (m_beginChar != 0)
+    else if (c == '"')
+      m_inString = true;
+    else if (c == '{' || c == '[')
+      m_depth++;
+    else if ((c == '}' || c == ']') && --m_depth == 0)
     {
-      m_buffer.push_back(c);
-      if (c == m_beginChar)
-        m_beginBrackets++;
-      else if (c == m_endChar)
-        m_endBrackets++;
-      if (m_beginBrackets > 0 && m_endBrackets > 0 && m_beginBrackets == m_endBrackets)
-      {
-        std::string line = CJSONRPC::MethodCall(m_buffer, host, this);
-        Send(line.c_str(), line.size());
-        m_beginChar = m_beginBrackets = m_endBrackets = 0;
-        m_buffer.clear();
-      }
+      message = m_buffer.substr(m_messageStart, m_scanPosition + 1 - m_messageStart);
+      m_buffer.erase(0, m_scanPosition + 1);
+      m_scanPosition = 0;
+      return true;
     }
   }
+
+  if (m_depth == 0)
+  {
+    m_buffer.clear();
+    m_scanPosition = 0;
+  }
+
+  return false;
 }
 
 void CTCPServer::CTCPClient::Disconnect()
@@ -602,11 +1038,14 @@ void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
   m_cliaddr           = client.m_cliaddr;
   m_addrlen           = client.m_addrlen;
   m_announcementflags = client.m_announcementflags;
-  m_beginBrackets     = client.m_beginBrackets;
-  m_endBrackets       = client.m_endBrackets;
-  m_beginChar         = client.m_beginChar;
-  m_endChar           = client.m_endChar;
   m_buffer            = client.m_buffer;
+  m_scanPosition      = client.m_scanPosition;
+  m_messageStart      = client.m_messageStart;
+  m_depth             = client.m_depth;
+  m_inString          = client.m_inString;
+  m_escaped           = client.m_escaped;
+  // neither queued data nor a pending response are taken over
+  m_response          = NULL;
 }
 
 CTCPServer::CWebSocketClient::CWebSocketClient(CWebSocket *websocket)
@@ -651,6 +1090,16 @@ void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
     CTCPClient::Send(frames.at(index)->GetFrameData(), (unsigned int)frames.at(index)->GetFrameLength());
 }
 
+void CTCPServer::CWebSocketClient::SendResponse(CJSONRPCResponse *response)
+{
+  // every response has to be sent as a single websocket message
+  std::string output;
+  response->Read(output);
+  delete response;
+
+  Send(output.c_str(), output.size());
+}
+
 void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
 {
   bool send;
@@ -27,10 +27,17 @@
 #include "interfaces/json-rpc/ITransportLayer.h"
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
+#include "utils/RingBuffer.h"
 #include "websocket/WebSocket.h"
 
+#if defined(TARGET_LINUX)
+#define HAS_TCPSERVER_EPOLL
+#endif
+
 namespace JSONRPC
 {
+  class CJSONRPCResponse;
+
   class CTCPServer : public ITransportLayer, public JSONRPC::IJSONRPCAnnouncer, public CThread
   {
   public:
@@ -51,6 +58,22 @@ namespace JSONRPC
     bool InitializeTCP();
     void Deinitialize();
 
+    bool ProcessSelect();
+    class CTCPClient;
+
+#ifdef HAS_TCPSERVER_EPOLL
+    bool InitializeEpoll();
+    bool ProcessEpoll();
+    bool WatchConnection(CTCPClient *client, int operation);
+#endif
+    bool AcceptConnection(SOCKET server);
+    /*!
+     \brief Reads what the client sent, the client is replaced if it turns out to be a websocket
+     \return False if the connection is to be removed
+     */
+    bool ReadConnection(CTCPClient *&client);
+    void RemoveConnection(CTCPClient *client);
+
     class CTCPClient : public IClient
     {
     public:
@@ -59,7 +82,7 @@ namespace JSONRPC
       //when adding a member variable, make sure to copy it in CTCPClient::Copy
       CTCPClient(const CTCPClient& client);
       CTCPClient& operator=(const CTCPClient& client);
-      virtual ~CTCPClient() { };
+      virtual ~CTCPClient();
 
       virtual int  GetPermissionFlags();
       virtual int  GetAnnouncementFlags();
@@ -69,6 +92,24 @@ namespace JSONRPC
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
+      /*!
+       \brief Sends an already serialized announcement unless the client
+       doesn't keep up with reading the data which has been sent to it
+       */
+      void SendAnnouncement(ANNOUNCEMENT::AnnouncementFlag flag, const std::string &announcement);
+      /*!
+       \brief Sends as much of the queued data (and of a pending
+       response) as the socket accepts without blocking
+       \return True if there is no more data to be sent
+       */
+      bool Flush(CTCPServer *host);
+      bool HasQueuedData();
+      /*!
+       \brief Whether to read from the client, input is only buffered
+       up to a limit while a response is pending
+       */
+      bool CanReceive();
+
       virtual bool IsNew() const { return m_new; }
       virtual bool Closing() const { return false; }
 
@@ -79,12 +120,41 @@ namespace JSONRPC
 
     protected:
       void Copy(const CTCPClient& client);
+      /*!
+       \brief Sends the given response (takes ownership of it)
+       */
+      virtual void SendResponse(CJSONRPCResponse *response);
+
+      /*!
+       \brief Sends the data or queues what the socket doesn't accept
+       \return False if the client has too much data queued already
+       */
+      bool Write(const char *data, unsigned int size);
+
     private:
+      void ProcessInput(CTCPServer *host);
+      bool NextMessage(std::string &message);
+      bool WriteResponse();
+      bool FlushQueue();
+      bool GrowQueue(unsigned int size);
+
       bool m_new;
       int m_announcementflags;
-      int m_beginBrackets, m_endBrackets;
-      char m_beginChar, m_endChar;
+
+      // unprocessed input and state of the message scanner
       std::string m_buffer;
+      size_t m_scanPosition;
+      size_t m_messageStart;
+      int m_depth;
+      bool m_inString;
+      bool m_escaped;
+
+      // data which couldn't be sent without blocking
+      CRingBuffer m_sendBuffer;
+      // response which is sent as the client reads it
+      CJSONRPCResponse *m_response;
+      // announcements waiting for m_response to be sent
+      std::string m_deferred;
     };
 
     class CWebSocketClient : public CTCPClient
@@ -103,11 +173,16 @@ namespace JSONRPC
       virtual bool IsNew() const { return m_websocket == NULL; }
       virtual bool Closing() const { return m_websocket != NULL && m_websocket->GetState() == WebSocketStateClosed; }
 
+    protected:
+      virtual void SendResponse(CJSONRPCResponse *response);
+
     private:
       CWebSocket *m_websocket;
     };
 
     std::vector<CTCPClient*> m_connections;
+    CCriticalSection m_connectionsSection;
+    int m_epoll;
     std::vector<SOCKET> m_servers;
     int m_port;
     bool m_nonlocal;
@@ -25,15 +25,31 @@
 #include "utils/URIUtils.h"
 #include "utils/Variant.h"
 #include "utils/Base64.h"
+#include "utils/StringUtils.h"
+#include "filesystem/SpecialProtocol.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "settings/AdvancedSettings.h"
 #include "XBDateTime.h"
 #include "URL.h"
 
+#include <algorithm>
+
 #ifdef _WIN32
 #pragma comment(lib, "libmicrohttpd.dll.lib")
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #define MAX_POST_BUFFER_SIZE 2048
+#define BULK_SLOT_TIMEOUT    30000
+#define BULK_BUFFER_SIZE     64 * 1024
+
+#ifndef MHD_SIZE_UNKNOWN
+#define MHD_SIZE_UNKNOWN  ((uint64_t) -1)
+#endif
 
 #define PAGE_FILE_NOT_FOUND "<html><head><title>File not found</title></head><body>File not found</body></html>"
 #define NOT_SUPPORTED       "<html><head><title>Not Supported</title></head><body>The method you are trying to use is not supported by this server</body></html>"
@@ -48,6 +64,10 @@ CWebServer::CWebServer()
 {
   m_running = false;
   m_daemon = NULL;
+  m_threadPerConnection = false;
+  m_bulkLimit = 0;
+  m_bulkTransfers = 0;
+  m_bulkStopping = false;
   m_needcredentials = true;
   m_Credentials64Encoded = "eGJtYzp4Ym1j"; // xbmc:xbmc
 }
@@ -178,7 +198,21 @@ int CWebServer::AnswerToConnection(void *cls, struct MHD_Connection *connection,
         }
         // No POST request so nothing special to handle
         else
+        {
+          if (handler->GetHTTPRequestLane() == HTTPLaneBulk && server->m_bulkLimit > 0)
+          {
+            // the request keeps its handler until it gets a transfer slot,
+            // both are handed back in RequestCompleted
+            ConnectionHandler *conHandler = new ConnectionHandler();
+            conHandler->requestHandler = handler;
+            conHandler->bulk = true;
+
+            *con_cls = (void*)conHandler;
+            return HandleBulkRequest(server, conHandler, request);
+          }
+
           return HandleRequest(handler, request);
+        }
       }
     }
   }
@@ -228,6 +262,11 @@ int CWebServer::AnswerToConnection(void *cls, struct MHD_Connection *connection,
     // requests, but let's handle it anyway
     else
     {
+      // bulk requests are asked again until they get a transfer slot
+      ConnectionHandler *conHandler = (ConnectionHandler *)*con_cls;
+      if (conHandler->bulk)
+        return HandleBulkRequest(server, conHandler, request);
+
       for (vector<IHTTPRequestHandler *>::const_iterator it = m_requestHandlers.begin(); it != m_requestHandlers.end(); it++)
       {
         IHTTPRequestHandler *requestHandler = *it;
@@ -261,7 +300,7 @@ int CWebServer::HandlePostField(void *cls, enum MHD_ValueKind kind, const char *
   return MHD_YES;
 }
 
-int CWebServer::HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &request)
+int CWebServer::HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &request, CWebServer *bulkServer /* = NULL */)
 {
   if (handler == NULL)
     return SendErrorResponse(request.connection, MHD_HTTP_INTERNAL_SERVER_ERROR, request.method);
@@ -286,7 +325,7 @@ int CWebServer::HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &r
       break;
 
     case HTTPFileDownload:
-      ret = CreateFileDownloadResponse(request.connection, handler->GetHTTPResponseFile(), request.method, response, responseCode);
+      ret = CreateFileDownloadResponse(request.connection, handler->GetHTTPResponseFile(), handler->GetHTTPResponseETag(), request.method, response, responseCode, bulkServer);
       break;
 
     case HTTPMemoryDownloadNoFreeNoCopy:
@@ -305,6 +344,17 @@ int CWebServer::HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &r
       ret = CreateMemoryDownloadResponse(request.connection, handler->GetHTTPResponseData(), handler->GetHTTPResonseDataLength(), true, true, response);
       break;
 
+    case HTTPStreamDownload:
+      // the handler only belongs to the response once it has been created
+      // so it has to be freed here if creating the response failed
+      ret = CreateStreamDownloadResponse(request.connection, handler, response, bulkServer);
+      if (ret == MHD_NO)
+      {
+        delete handler;
+        return SendErrorResponse(request.connection, MHD_HTTP_INTERNAL_SERVER_ERROR, request.method);
+      }
+      break;
+
     case HTTPError:
       ret = CreateErrorResponse(request.connection, handler->GetHTTPResonseCode(), request.method, response);
       break;
@@ -324,9 +374,13 @@ int CWebServer::HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &r
   for (multimap<string, string>::const_iterator it = header.begin(); it != header.end(); it++)
     MHD_add_response_header(response, it->first.c_str(), it->second.c_str());
 
+  // a streamed response owns its handler (see StreamReaderFreeCallback)
+  bool ownsHandler = handler->GetHTTPResponseType() == HTTPStreamDownload;
+
   MHD_queue_response(request.connection, responseCode, response);
   MHD_destroy_response(response);
-  delete handler;
+  if (!ownsHandler)
+    delete handler;
 
   return MHD_YES;
 }
@@ -354,110 +408,270 @@ int CWebServer::CreateRedirect(struct MHD_Connection *connection, const string &
   return MHD_NO;
 }
 
-int CWebServer::CreateFileDownloadResponse(struct MHD_Connection *connection, const string &strURL, HTTPMethod methodType, struct MHD_Response *&response, int &responseCode)
+bool CWebServer::MatchesETag(const string &header, const string &etag)
 {
-  CFile *file = new CFile();
+  if (header.empty() || etag.empty())
+    return false;
 
-  if (file->Open(strURL, READ_NO_CACHE))
+  // If-None-Match may hold a list of entity tags
+  size_t start = 0;
+  while (start < header.size())
   {
-    bool getData = true;
-    if (methodType != HEAD)
-    {
-      if (methodType == GET)
-      {
-        string ifModifiedSince = GetRequestHeaderValue(connection, MHD_HEADER_KIND, "If-Modified-Since");
-        if (!ifModifiedSince.empty())
-        {
-          CDateTime ifModifiedSinceDate;
-          ifModifiedSinceDate.SetFromRFC1123DateTime(ifModifiedSince);
+    size_t end = header.find(',', start);
+    if (end == string::npos)
+      end = header.size();
 
-          struct __stat64 statBuffer;
-          if (file->Stat(&statBuffer) == 0)
-          {
-            struct tm *time = localtime((time_t *)&statBuffer.st_mtime);
-            if (time != NULL)
-            {
-              CDateTime lastModified = *time;
-              if (lastModified.GetAsUTCDateTime() <= ifModifiedSinceDate)
-              {
-                getData = false;
-                response = MHD_create_response_from_data (0, NULL, MHD_NO, MHD_NO);
-                responseCode = MHD_HTTP_NOT_MODIFIED;
-              }
-            }
-          }
-        }
-      }
+    string tag = header.substr(start, end - start);
+    StringUtils::Trim(tag);
+    if (tag == "*" || tag == etag)
+      return true;
 
-      if (getData)
-        response = MHD_create_response_from_callback(file->GetLength(),
-                                                     2048,
-                                                     &CWebServer::ContentReaderCallback, file,
-                                                     &CWebServer::ContentReaderFreeCallback);
-      if (response == NULL)
-      {
-        file->Close();
-        delete file;
-        return MHD_NO;
-      }
-    }
-    else
-    {
-      getData = false;
+    start = end + 1;
+  }
 
-      CStdString contentLength;
-      contentLength.Format("%I64d", file->GetLength());
+  return false;
+}
 
-      response = MHD_create_response_from_data (0, NULL, MHD_NO, MHD_NO);
-      if (response == NULL)
-      {
-        file->Close();
-        delete file;
-        return MHD_NO;
-      }
-      MHD_add_response_header(response, "Content-Length", contentLength);
+int CWebServer::ParseRange(const string &range, int64_t length, int64_t &start, int64_t &end)
+{
+  // only a single byte range is supported, anything else gets the whole file
+  if (range.compare(0, 6, "bytes=") != 0 || range.find(',') != string::npos)
+    return 0;
+
+  string spec = range.substr(6);
+  StringUtils::Trim(spec);
+  size_t dash = spec.find('-');
+  if (dash == string::npos)
+    return 0;
+
+  string first = spec.substr(0, dash);
+  string last = spec.substr(dash + 1);
+  if (first.empty())
+  { // the last n bytes
+    if (last.empty())
+      return 0;
+    int64_t suffix = strtoll(last.c_str(), NULL, 10);
+    if (suffix <= 0)
+      return -1;
+    start = suffix < length ? length - suffix : 0;
+    end = length - 1;
+  }
+  else
+  {
+    start = strtoll(first.c_str(), NULL, 10);
+    end = last.empty() ? length - 1 : strtoll(last.c_str(), NULL, 10);
+    if (end >= length)
+      end = length - 1;
+  }
+
+  if (start < 0 || start >= length || end < start)
+    return -1;
+
+  return 1;
+}
+
+int CWebServer::CreateFileDownloadResponse(struct MHD_Connection *connection, const string &strURL, const string &etag, HTTPMethod methodType, struct MHD_Response *&response, int &responseCode, CWebServer *bulkServer /* = NULL */)
+{
+  // an unchanged file doesn't even need to be opened
+  if (methodType == GET &&
+      MatchesETag(GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH), etag))
+  {
+    response = MHD_create_response_from_data (0, NULL, MHD_NO, MHD_NO);
+    if (response == NULL)
+      return MHD_NO;
+
+    MHD_add_response_header(response, MHD_HTTP_HEADER_ETAG, etag.c_str());
+    responseCode = MHD_HTTP_NOT_MODIFIED;
+    return MHD_YES;
+  }
+
+  int64_t length = 0;
+  time_t modified = 0;
+  CFile *file = NULL;
+  int fd = -1;
+
+#if defined(TARGET_POSIX) && (MHD_VERSION >= 0x00091800)
+  // files on the local disk are handed to libmicrohttpd as a file descriptor
+  // so they are sent without being copied through user space
+  CStdString localPath = CSpecialProtocol::TranslatePath(strURL);
+  if (CURL(localPath).GetProtocol().IsEmpty())
+  {
+    fd = open(localPath.c_str(), O_RDONLY);
+    struct stat statBuffer;
+    if (fd >= 0 && fstat(fd, &statBuffer) == 0 && S_ISREG(statBuffer.st_mode))
+    {
+      length = statBuffer.st_size;
+      modified = statBuffer.st_mtime;
+    }
+    else if (fd >= 0)
+    {
+      close(fd);
+      fd = -1;
     }
+  }
+#endif
 
-    // set the Content-Type header
-    CStdString ext = URIUtils::GetExtension(strURL);
-    ext = ext.ToLower();
-    const char *mime = CreateMimeTypeFromExtension(ext.c_str());
-    if (mime)
-      MHD_add_response_header(response, "Content-Type", mime);
+  if (fd < 0)
+  {
+    file = new CFile();
+    if (!file->Open(strURL, READ_NO_CACHE))
+    {
+      delete file;
+      CLog::Log(LOGERROR, "WebServer: Failed to open %s", strURL.c_str());
+      return SendErrorResponse(connection, MHD_HTTP_NOT_FOUND, GET); /* GET Assumed Temporarily */
+    }
 
-    // set the Last-Modified header
+    length = file->GetLength();
     struct __stat64 statBuffer;
     if (file->Stat(&statBuffer) == 0)
+      modified = (time_t)statBuffer.st_mtime;
+  }
+
+  bool getData = false;
+  int64_t start = 0;
+  int64_t end = length - 1;
+  int range = 0;
+  if (methodType == GET)
+  {
+    getData = true;
+
+    string ifModifiedSince = GetRequestHeaderValue(connection, MHD_HEADER_KIND, "If-Modified-Since");
+    if (!ifModifiedSince.empty() && modified != 0)
     {
-      struct tm *time = localtime((time_t *)&statBuffer.st_mtime);
+      CDateTime ifModifiedSinceDate;
+      ifModifiedSinceDate.SetFromRFC1123DateTime(ifModifiedSince);
+
+      struct tm *time = localtime(&modified);
       if (time != NULL)
       {
         CDateTime lastModified = *time;
-        MHD_add_response_header(response, "Last-Modified", lastModified.GetAsRFC1123DateTime());
+        if (lastModified.GetAsUTCDateTime() <= ifModifiedSinceDate)
+        {
+          getData = false;
+          responseCode = MHD_HTTP_NOT_MODIFIED;
+        }
       }
     }
 
-    // set the Expires header
-    CDateTime expiryTime = CDateTime::GetCurrentDateTime();
-    if (mime && strncmp(mime, "text/html", 9) == 0)
-      expiryTime += CDateTimeSpan(1, 0, 0, 0);
-    else
-      expiryTime += CDateTimeSpan(365, 0, 0, 0);
-    MHD_add_response_header(response, "Expires", expiryTime.GetAsRFC1123DateTime());
+    // a range only applies if the client still has the version we're about to send
+    string ifRange = GetRequestHeaderValue(connection, MHD_HEADER_KIND, "If-Range");
+    if (getData && (ifRange.empty() || ifRange == etag))
+    {
+      range = ParseRange(GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_RANGE), length, start, end);
+      if (range > 0)
+        responseCode = MHD_HTTP_PARTIAL_CONTENT;
+      else if (range < 0)
+      {
+        getData = false;
+        responseCode = MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE;
+      }
+    }
+  }
 
-    // only close the CFile instance if libmicrohttpd doesn't have to grab the data of the file
-    if (!getData)
+  if (getData)
+  {
+    if (fd >= 0)
     {
-      file->Close();
-      delete file;
+#if defined(TARGET_POSIX) && (MHD_VERSION >= 0x00091800)
+      // libmicrohttpd closes the file descriptor along with the response
+      response = MHD_create_response_from_fd_at_offset(end - start + 1, fd, start);
+      if (response != NULL)
+        fd = -1;
+#endif
+    }
+    else if (bulkServer != NULL)
+    {
+      // the file is read by the bulk readers
+      CBulkDownload *download = new CBulkDownload(bulkServer, connection);
+      download->file = file;
+      download->offset = start;
+      download->remaining = end - start + 1;
+      response = CreateBulkResponse(end - start + 1, download);
+      if (response != NULL)
+        file = NULL;
+      else
+      {
+        download->file = NULL;
+        delete download;
+      }
+    }
+    else
+    {
+      FileDownload *download = new FileDownload;
+      download->file = file;
+      download->offset = start;
+      response = MHD_create_response_from_callback(end - start + 1,
+                                                   2048,
+                                                   &CWebServer::ContentReaderCallback, download,
+                                                   &CWebServer::ContentReaderFreeCallback);
+      if (response != NULL)
+        file = NULL;
+      else
+        delete download;
     }
   }
   else
+    response = MHD_create_response_from_data (0, NULL, MHD_NO, MHD_NO);
+
+  // only close the file if libmicrohttpd doesn't have to grab its data
+  if (fd >= 0)
+    close(fd);
+  if (file != NULL)
   {
+    file->Close();
     delete file;
-    CLog::Log(LOGERROR, "WebServer: Failed to open %s", strURL.c_str());
-    return SendErrorResponse(connection, MHD_HTTP_NOT_FOUND, GET); /* GET Assumed Temporarily */
   }
+
+  if (response == NULL)
+    return MHD_NO;
+
+  if (methodType == HEAD)
+  {
+    CStdString contentLength;
+    contentLength.Format("%"PRId64, length);
+    MHD_add_response_header(response, "Content-Length", contentLength);
+  }
+
+  MHD_add_response_header(response, "Accept-Ranges", "bytes");
+  if (range != 0)
+  {
+    CStdString contentRange;
+    if (range > 0)
+      contentRange.Format("bytes %"PRId64"-%"PRId64"/%"PRId64, start, end, length);
+    else
+      contentRange.Format("bytes */%"PRId64, length);
+    MHD_add_response_header(response, "Content-Range", contentRange);
+  }
+
+  if (!etag.empty())
+    MHD_add_response_header(response, MHD_HTTP_HEADER_ETAG, etag.c_str());
+
+  // set the Content-Type header
+  CStdString ext = URIUtils::GetExtension(strURL);
+  ext = ext.ToLower();
+  const char *mime = CreateMimeTypeFromExtension(ext.c_str());
+  if (mime)
+    MHD_add_response_header(response, "Content-Type", mime);
+
+  // set the Last-Modified header
+  if (modified != 0)
+  {
+    struct tm *time = localtime(&modified);
+    if (time != NULL)
+    {
+      CDateTime lastModified = *time;
+      MHD_add_response_header(response, "Last-Modified", lastModified.GetAsRFC1123DateTime());
+    }
+  }
+
+  // set the Expires header
+  CDateTime expiryTime = CDateTime::GetCurrentDateTime();
+  if (mime && strncmp(mime, "text/html", 9) == 0)
+    expiryTime += CDateTimeSpan(1, 0, 0, 0);
+  else
+    expiryTime += CDateTimeSpan(365, 0, 0, 0);
+  MHD_add_response_header(response, "Expires", expiryTime.GetAsRFC1123DateTime());
+
   return MHD_YES;
 }
 
@@ -495,6 +709,32 @@ int CWebServer::CreateMemoryDownloadResponse(struct MHD_Connection *connection,
   return MHD_NO;
 }
 
+int CWebServer::CreateStreamDownloadResponse(struct MHD_Connection *connection, IHTTPRequestHandler *handler, struct MHD_Response *&response, CWebServer *bulkServer /* = NULL */)
+{
+  // the size of the response is unknown so it will be sent chunked
+  if (bulkServer != NULL)
+  {
+    CBulkDownload *download = new CBulkDownload(bulkServer, connection);
+    download->handler = handler;
+    response = CreateBulkResponse(MHD_SIZE_UNKNOWN, download);
+    if (response == NULL)
+    {
+      download->handler = NULL;
+      delete download;
+    }
+  }
+  else
+    response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, 32 * 1024,
+                                                 &CWebServer::StreamReaderCallback, handler,
+                                                 &CWebServer::StreamReaderFreeCallback);
+  if (response)
+    return MHD_YES;
+
+  // the free callback isn't called if the response wasn't created
+  CLog::Log(LOGERROR, "WebServer: failed to create a streamed response");
+  return MHD_NO;
+}
+
 int CWebServer::SendErrorResponse(struct MHD_Connection *connection, int errorType, HTTPMethod method)
 {
   struct MHD_Response *response = NULL;
@@ -522,9 +762,10 @@ int CWebServer::ContentReaderCallback(void *cls, uint64_t pos, char *buf, int ma
 int CWebServer::ContentReaderCallback(void *cls, size_t pos, char *buf, int max)
 #endif
 {
-  CFile *file = (CFile *)cls;
-  if((unsigned int)pos != file->GetPosition())
-    file->Seek(pos);
+  FileDownload *download = (FileDownload *)cls;
+  CFile *file = download->file;
+  if((int64_t)(download->offset + pos) != file->GetPosition())
+    file->Seek(download->offset + pos);
   unsigned res = file->Read(buf, max);
   if(res == 0)
     return -1;
@@ -533,13 +774,350 @@ int CWebServer::ContentReaderCallback(void *cls, size_t pos, char *buf, int max)
 
 void CWebServer::ContentReaderFreeCallback(void *cls)
 {
-  CFile *file = (CFile *)cls;
-  file->Close();
+  FileDownload *download = (FileDownload *)cls;
+  download->file->Close();
 
-  delete file;
+  delete download->file;
+  delete download;
 }
 
-struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
+#if (MHD_VERSION >= 0x00090200)
+ssize_t CWebServer::StreamReaderCallback (void *cls, uint64_t pos, char *buf, size_t max)
+#elif (MHD_VERSION >= 0x00040001)
+int CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, int max)
+#else   //libmicrohttpd < 0.4.0
+int CWebServer::StreamReaderCallback(void *cls, size_t pos, char *buf, int max)
+#endif
+{
+  IHTTPRequestHandler *handler = (IHTTPRequestHandler *)cls;
+  size_t res = handler->ReadHTTPResponseData(buf, max);
+  if (res == 0)
+    return -1;
+  return res;
+}
+
+void CWebServer::StreamReaderFreeCallback(void *cls)
+{
+  IHTTPRequestHandler *handler = (IHTTPRequestHandler *)cls;
+  delete handler;
+}
+
+void CWebServer::RequestCompleted(void *cls, struct MHD_Connection *connection,
+                                  void **con_cls, enum MHD_RequestTerminationCode toe)
+{
+  CWebServer *server = (CWebServer *)cls;
+  if (*con_cls == NULL)
+    return;
+
+  ConnectionHandler *conHandler = (ConnectionHandler *)*con_cls;
+  if (conHandler->bulk)
+    server->ReleaseBulkSlot(conHandler);
+
+  // the client went away before all POST data arrived
+  // or before the bulk request got a transfer slot
+  if (conHandler->postprocessor != NULL)
+    MHD_destroy_post_processor(conHandler->postprocessor);
+  delete conHandler->requestHandler;
+  delete conHandler;
+
+  *con_cls = NULL;
+}
+
+int CWebServer::HandleBulkRequest(CWebServer *server, ConnectionHandler *conHandler, const HTTPRequest &request)
+{
+  if (!conHandler->bulkSlot && !server->AcquireBulkSlot(conHandler))
+  {
+    // answering without a response makes MHD ask again the next time it
+    // polls the connection (at least once a second), so waiting doesn't
+    // stall the other connections of the thread
+    if (XbmcThreads::SystemClockMillis() - conHandler->bulkQueued < BULK_SLOT_TIMEOUT)
+      return MHD_YES;
+
+    CLog::Log(LOGDEBUG, "WebServer: No free bulk transfer slot for %s", request.url.c_str());
+    server->ReleaseBulkSlot(conHandler);
+    return SendErrorResponse(request.connection, MHD_HTTP_SERVICE_UNAVAILABLE, request.method);
+  }
+
+  IHTTPRequestHandler *handler = conHandler->requestHandler;
+  conHandler->requestHandler = NULL;
+  return HandleRequest(handler, request, server);
+}
+
+bool CWebServer::AcquireBulkSlot(ConnectionHandler *request)
+{
+  int limit = m_bulkLimit;
+
+  CSingleLock lock(m_laneSection);
+  deque<ConnectionHandler *>::iterator queued = find(m_bulkQueue.begin(), m_bulkQueue.end(), request);
+
+  // slots go to the requests in the order they came in
+  if (limit <= 0 || (m_bulkTransfers < limit && (m_bulkQueue.empty() || m_bulkQueue.front() == request)))
+  {
+    if (queued != m_bulkQueue.end())
+      m_bulkQueue.erase(queued);
+    m_bulkTransfers++;
+    request->bulkSlot = true;
+    return true;
+  }
+
+  if (queued == m_bulkQueue.end())
+  {
+    request->bulkQueued = XbmcThreads::SystemClockMillis();
+    m_bulkQueue.push_back(request);
+  }
+  return false;
+}
+
+void CWebServer::ReleaseBulkSlot(ConnectionHandler *request)
+{
+  CSingleLock lock(m_laneSection);
+  if (request->bulkSlot)
+  {
+    if (m_bulkTransfers > 0)
+      m_bulkTransfers--;
+    request->bulkSlot = false;
+  }
+  else
+  {
+    deque<ConnectionHandler *>::iterator queued = find(m_bulkQueue.begin(), m_bulkQueue.end(), request);
+    if (queued != m_bulkQueue.end())
+      m_bulkQueue.erase(queued);
+  }
+}
+
+CWebServer::CBulkDownload::CBulkDownload(CWebServer *server, struct MHD_Connection *connection)
+  : server(server), connection(connection), file(NULL), offset(0), remaining(0), handler(NULL),
+    front(0), position(0), filling(false), eof(false), suspended(false), released(false)
+{
+  buffers[0].resize(BULK_BUFFER_SIZE);
+  buffers[1].resize(BULK_BUFFER_SIZE);
+  sizes[0] = sizes[1] = 0;
+}
+
+CWebServer::CBulkDownload::~CBulkDownload()
+{
+  if (file != NULL)
+  {
+    file->Close();
+    delete file;
+  }
+  delete handler;
+}
+
+CWebServer::CBulkReader::CBulkReader(CWebServer *server)
+  : CThread("WebServerBulkReader"), m_server(server)
+{ }
+
+void CWebServer::CBulkReader::Process()
+{
+  CBulkDownload *download;
+  while ((download = m_server->NextBulkRead()) != NULL)
+    m_server->FillBulkBuffer(download);
+}
+
+void CWebServer::StartBulkReaders(int count)
+{
+  {
+    CSingleLock lock(m_laneSection);
+    m_bulkStopping = false;
+  }
+
+  // every transfer slot has a reader of its own so
+  // transfers don't wait for each other's reads
+  for (int i = 0; i < count; i++)
+  {
+    CBulkReader *reader = new CBulkReader(this);
+    reader->Create();
+    m_bulkReaders.push_back(reader);
+  }
+}
+
+void CWebServer::StopBulkReaders()
+{
+  {
+    CSingleLock lock(m_laneSection);
+    m_bulkStopping = true;
+    m_bulkReadCondition.notifyAll();
+  }
+
+  // the readers finish the reads already queued so that
+  // no connection stays suspended
+  for (vector<CBulkReader *>::iterator it = m_bulkReaders.begin(); it != m_bulkReaders.end(); ++it)
+  {
+    (*it)->StopThread(true);
+    delete *it;
+  }
+  m_bulkReaders.clear();
+}
+
+bool CWebServer::QueueBulkRead(CBulkDownload *download)
+{
+  CSingleLock lock(m_laneSection);
+  if (m_bulkStopping)
+    return false;
+
+  m_bulkReads.push_back(download);
+  m_bulkReadCondition.notify();
+  return true;
+}
+
+CWebServer::CBulkDownload *CWebServer::NextBulkRead()
+{
+  CSingleLock lock(m_laneSection);
+  while (m_bulkReads.empty() && !m_bulkStopping)
+    m_bulkReadCondition.wait(lock);
+
+  if (m_bulkReads.empty())
+    return NULL;
+
+  CBulkDownload *download = m_bulkReads.front();
+  m_bulkReads.pop_front();
+  return download;
+}
+
+void CWebServer::FillBulkBuffer(CBulkDownload *download)
+{
+  int back;
+  {
+    CSingleLock lock(download->section);
+    back = 1 - download->front;
+  }
+
+  // only this reader touches the back buffer while it's filling it
+  size_t size = 0;
+  bool stopping;
+  {
+    CSingleLock lock(m_laneSection);
+    stopping = m_bulkStopping;
+  }
+  if (!stopping)
+  {
+    char *buffer = &download->buffers[back][0];
+    if (download->file != NULL)
+    {
+      if (download->offset > 0)
+      {
+        download->file->Seek(download->offset);
+        download->offset = 0;
+      }
+      size_t max = (size_t)std::min((uint64_t)BULK_BUFFER_SIZE, download->remaining);
+      if (max > 0)
+        size = download->file->Read(buffer, max);
+      download->remaining -= size;
+    }
+    else if (download->handler != NULL)
+      size = download->handler->ReadHTTPResponseData(buffer, BULK_BUFFER_SIZE);
+  }
+
+  CSingleLock lock(download->section);
+  download->sizes[back] = size;
+  if (size == 0)
+    download->eof = true;
+  download->filling = false;
+
+  if (download->released)
+  {
+    lock.Leave();
+    delete download;
+    return;
+  }
+
+#if (MHD_VERSION >= 0x00095500)
+  if (download->suspended)
+  {
+    download->suspended = false;
+    MHD_resume_connection(download->connection);
+  }
+#endif
+  download->filled.Set();
+}
+
+struct MHD_Response *CWebServer::CreateBulkResponse(uint64_t size, CBulkDownload *download)
+{
+  return MHD_create_response_from_callback(size, 32 * 1024,
+                                           &CWebServer::BulkReaderCallback, download,
+                                           &CWebServer::BulkReaderFreeCallback);
+}
+
+#if (MHD_VERSION >= 0x00090200)
+ssize_t CWebServer::BulkReaderCallback (void *cls, uint64_t pos, char *buf, size_t max)
+#elif (MHD_VERSION >= 0x00040001)
+int CWebServer::BulkReaderCallback(void *cls, uint64_t pos, char *buf, int max)
+#else   //libmicrohttpd < 0.4.0
+int CWebServer::BulkReaderCallback(void *cls, size_t pos, char *buf, int max)
+#endif
+{
+  CBulkDownload *download = (CBulkDownload *)cls;
+  CSingleLock lock(download->section);
+  while (true)
+  {
+    int front = download->front;
+    if (download->position < download->sizes[front])
+    {
+      size_t size = std::min((size_t)max, download->sizes[front] - download->position);
+      memcpy(buf, &download->buffers[front][download->position], size);
+      download->position += size;
+      return size;
+    }
+
+    if (!download->filling)
+    {
+      // send the data read ahead and read the next part meanwhile
+      int back = 1 - front;
+      if (download->sizes[back] > 0)
+      {
+        download->front = back;
+        download->position = 0;
+        download->sizes[front] = 0;
+        if (!download->eof)
+        {
+          download->filling = download->server->QueueBulkRead(download);
+          if (!download->filling)
+            download->eof = true;
+        }
+        continue;
+      }
+
+      if (download->eof)
+        return -1;
+
+      download->filling = download->server->QueueBulkRead(download);
+      if (!download->filling)
+        return -1;
+    }
+
+#if (MHD_VERSION >= 0x00095500)
+    // the reader resumes the connection once it has read the data
+    if (!download->server->m_threadPerConnection)
+    {
+      download->suspended = true;
+      MHD_suspend_connection(download->connection);
+      return 0;
+    }
+#endif
+
+    // without suspending connections, only the thread of this
+    // connection (or the select thread serving it) waits for the read
+    CSingleExit exit(download->section);
+    download->filled.Wait();
+  }
+}
+
+void CWebServer::BulkReaderFreeCallback(void *cls)
+{
+  CBulkDownload *download = (CBulkDownload *)cls;
+  CSingleLock lock(download->section);
+  download->released = true;
+
+  // a reader still filling a buffer frees it when it's done
+  if (download->filling)
+    return;
+
+  lock.Leave();
+  delete download;
+}
+
+struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, unsigned int poolSize, int port)
 {
   // WARNING: when using MHD_USE_THREAD_PER_CONNECTION, set MHD_OPTION_CONNECTION_TIMEOUT to something higher than 1
   // otherwise on libmicrohttpd 0.4.4-1 it spins a busy loop
@@ -555,10 +1133,11 @@ struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
                           &CWebServer::AnswerToConnection,
                           this,
 #if (MHD_VERSION >= 0x00040002)
-                          MHD_OPTION_THREAD_POOL_SIZE, 4,
+                          MHD_OPTION_THREAD_POOL_SIZE, poolSize,
 #endif
-                          MHD_OPTION_CONNECTION_LIMIT, 512,
+                          MHD_OPTION_CONNECTION_LIMIT, (unsigned int)g_advancedSettings.m_webserverConnectionLimit,
                           MHD_OPTION_CONNECTION_TIMEOUT, timeout,
+                          MHD_OPTION_NOTIFY_COMPLETED, &CWebServer::RequestCompleted, this,
                           MHD_OPTION_URI_LOG_CALLBACK, &CWebServer::UriRequestLogger, this,
                           MHD_OPTION_END);
 }
@@ -568,11 +1147,43 @@ bool CWebServer::Start(int port, const string &username, const string &password)
   SetCredentials(username, password);
   if (!m_running)
   {
-    m_daemon = StartMHD(MHD_USE_SELECT_INTERNALLY, port);
+    const CStdString &model = g_advancedSettings.m_webserverThreadModel;
+    unsigned int flags = MHD_USE_SELECT_INTERNALLY;
+    unsigned int poolSize = g_advancedSettings.m_webserverThreadPoolSize;
+
+    m_threadPerConnection = model.Equals("perconnection");
+    if (m_threadPerConnection)
+    {
+      // a thread pool can't be combined with a thread per connection
+      flags = MHD_USE_THREAD_PER_CONNECTION;
+      poolSize = 0;
+    }
+    else if (model.Equals("epoll"))
+    {
+#if defined(TARGET_LINUX) && (MHD_VERSION >= 0x00092600)
+      flags |= MHD_USE_EPOLL_LINUX_ONLY;
+#else
+      CLog::Log(LOGWARNING, "WebServer: epoll isn't supported, using select instead");
+#endif
+    }
+    else if (!model.Equals("pool"))
+      CLog::Log(LOGWARNING, "WebServer: Unknown thread model \"%s\", using a thread pool", model.c_str());
+
+    m_bulkLimit = g_advancedSettings.m_webserverBulkTransfers;
+#if (MHD_VERSION >= 0x00095500)
+    // bulk transfers waiting for their readers free the select threads
+    if (m_bulkLimit > 0 && !m_threadPerConnection)
+      flags |= MHD_ALLOW_SUSPEND_RESUME;
+#endif
+
+    StartBulkReaders(m_bulkLimit);
+    m_daemon = StartMHD(flags, poolSize, port);
+    if (m_daemon == NULL)
+      StopBulkReaders();
 
     m_running = m_daemon != NULL;
     if (m_running)
-      CLog::Log(LOGNOTICE, "WebServer: Started the webserver");
+      CLog::Log(LOGNOTICE, "WebServer: Started the webserver (%s, %u threads)", m_threadPerConnection ? "thread per connection" : model.c_str(), poolSize);
     else
       CLog::Log(LOGERROR, "WebServer: Failed to start the webserver");
   }
@@ -583,6 +1194,7 @@ bool CWebServer::Stop()
 {
   if (m_running)
   {
+    StopBulkReaders();
     MHD_stop_daemon(m_daemon);
     m_running = false;
     CLog::Log(LOGNOTICE, "WebServer: Stopped the webserver");
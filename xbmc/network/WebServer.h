@@ -28,11 +28,20 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <deque>
 #include <vector>
 #include "interfaces/json-rpc/ITransportLayer.h"
+#include "threads/Condition.h"
 #include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/Thread.h"
 #include "httprequesthandler/IHTTPRequestHandler.h"
 
+namespace XFILE
+{
+  class CFile;
+}
+
 class CWebServer : public JSONRPC::ITransportLayer
 {
 public:
@@ -55,11 +64,13 @@ public:
   static int GetRequestHeaderValues(struct MHD_Connection *connection, enum MHD_ValueKind kind, std::map<std::string, std::string> &headerValues);
   static int GetRequestHeaderValues(struct MHD_Connection *connection, enum MHD_ValueKind kind, std::multimap<std::string, std::string> &headerValues);
 private:
-  struct MHD_Daemon* StartMHD(unsigned int flags, int port);
+  struct MHD_Daemon* StartMHD(unsigned int flags, unsigned int poolSize, int port);
   static int AskForAuthentication (struct MHD_Connection *connection);
   static bool IsAuthenticated (CWebServer *server, struct MHD_Connection *connection);
 
   static void* UriRequestLogger(void *cls, const char *uri);
+  static void RequestCompleted(void *cls, struct MHD_Connection *connection,
+                               void **con_cls, enum MHD_RequestTerminationCode toe);
 
 #if (MHD_VERSION >= 0x00090200)
   static ssize_t ContentReaderCallback (void *cls, uint64_t pos, char *buf, size_t max);
@@ -69,6 +80,14 @@ private:
   static int ContentReaderCallback (void *cls, size_t pos, char *buf, int max);
 #endif
 
+#if (MHD_VERSION >= 0x00090200)
+  static ssize_t StreamReaderCallback (void *cls, uint64_t pos, char *buf, size_t max);
+#elif (MHD_VERSION >= 0x00040001)
+  static int StreamReaderCallback (void *cls, uint64_t pos, char *buf, int max);
+#else
+  static int StreamReaderCallback (void *cls, size_t pos, char *buf, int max);
+#endif
+
 #if (MHD_VERSION >= 0x00040001)
   static int AnswerToConnection (void *cls, struct MHD_Connection *connection,
                         const char *url, const char *method,
@@ -88,12 +107,16 @@ private:
                              const char *transfer_encoding, const char *data, uint64_t off,
                              unsigned int size);
 #endif
-  static int HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &request);
+  static int HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &request, CWebServer *bulkServer = NULL);
   static void ContentReaderFreeCallback (void *cls);
+  static void StreamReaderFreeCallback (void *cls);
   static int CreateRedirect(struct MHD_Connection *connection, const std::string &strURL, struct MHD_Response *&response);
-  static int CreateFileDownloadResponse(struct MHD_Connection *connection, const std::string &strURL, HTTPMethod methodType, struct MHD_Response *&response, int &responseCode);
+  static int CreateFileDownloadResponse(struct MHD_Connection *connection, const std::string &strURL, const std::string &etag, HTTPMethod methodType, struct MHD_Response *&response, int &responseCode, CWebServer *bulkServer = NULL);
+  static bool MatchesETag(const std::string &header, const std::string &etag);
+  static int ParseRange(const std::string &range, int64_t length, int64_t &start, int64_t &end);
   static int CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response);
   static int CreateMemoryDownloadResponse(struct MHD_Connection *connection, void *data, size_t size, bool free, bool copy, struct MHD_Response *&response);
+  static int CreateStreamDownloadResponse(struct MHD_Connection *connection, IHTTPRequestHandler *handler, struct MHD_Response *&response, CWebServer *bulkServer = NULL);
 
   static int SendErrorResponse(struct MHD_Connection *connection, int errorType, HTTPMethod method);
   
@@ -113,6 +136,90 @@ private:
   {
     IHTTPRequestHandler *requestHandler;
     struct MHD_PostProcessor *postprocessor;
+    bool bulk;                // the request is in the bulk lane
+    bool bulkSlot;            // and holds one of its transfer slots
+    unsigned int bulkQueued;  // since when it waits for one
   } ConnectionHandler;
+
+  static int HandleBulkRequest(CWebServer *server, ConnectionHandler *conHandler, const HTTPRequest &request);
+  bool AcquireBulkSlot(ConnectionHandler *request);
+  void ReleaseBulkSlot(ConnectionHandler *request);
+
+  // requests in the bulk lane hold one of a limited number of transfer slots,
+  // the others wait for one in the order they came in
+  bool m_threadPerConnection;
+  int m_bulkLimit;
+  int m_bulkTransfers;
+  std::deque<ConnectionHandler *> m_bulkQueue;
+  CCriticalSection m_laneSection;
+
+  /*!
+   \brief Data of a transfer in the bulk lane
+   The data is read ahead into one buffer by a bulk reader thread while
+   libmicrohttpd sends the other one, so slow sources are never read on
+   the threads which also serve the interactive requests.
+   */
+  class CBulkDownload
+  {
+  public:
+    CBulkDownload(CWebServer *server, struct MHD_Connection *connection);
+    ~CBulkDownload();
+
+    CWebServer *server;
+    struct MHD_Connection *connection;
+    XFILE::CFile *file;            // either a file
+    uint64_t offset;               // starting at offset
+    uint64_t remaining;            // of which this many bytes are sent
+    IHTTPRequestHandler *handler;  // or a streamed response is read
+
+    CCriticalSection section;
+    CEvent filled;
+    std::vector<char> buffers[2];
+    size_t sizes[2];
+    int front;                     // buffer being sent
+    size_t position;               // in the front buffer
+    bool filling;                  // a reader fills the other buffer
+    bool eof;
+    bool suspended;                // until the reader is done
+    bool released;                 // by libmicrohttpd
+  };
+
+  class CBulkReader : public CThread
+  {
+  public:
+    CBulkReader(CWebServer *server);
+
+  protected:
+    virtual void Process();
+
+  private:
+    CWebServer *m_server;
+  };
+
+  void StartBulkReaders(int count);
+  void StopBulkReaders();
+  bool QueueBulkRead(CBulkDownload *download);
+  CBulkDownload *NextBulkRead();
+  void FillBulkBuffer(CBulkDownload *download);
+  static struct MHD_Response *CreateBulkResponse(uint64_t size, CBulkDownload *download);
+#if (MHD_VERSION >= 0x00090200)
+  static ssize_t BulkReaderCallback (void *cls, uint64_t pos, char *buf, size_t max);
+#elif (MHD_VERSION >= 0x00040001)
+  static int BulkReaderCallback (void *cls, uint64_t pos, char *buf, int max);
+#else
+  static int BulkReaderCallback (void *cls, size_t pos, char *buf, int max);
+#endif
+  static void BulkReaderFreeCallback (void *cls);
+
+  std::vector<CBulkReader *> m_bulkReaders;
+  std::deque<CBulkDownload *> m_bulkReads;
+  XbmcThreads::ConditionVariable m_bulkReadCondition;
+  bool m_bulkStopping;
+
+  typedef struct FileDownload
+  {
+    XFILE::CFile *file;
+    uint64_t offset;
+  } FileDownload;
 };
 #endif
@@ -22,6 +22,7 @@
 #include "network/WebServer.h"
 #include "URL.h"
 #include "filesystem/ImageFile.h"
+#include "TextureCache.h"
 
 using namespace std;
 
@@ -39,6 +40,14 @@ int CHTTPImageHandler::HandleHTTPRequest(const HTTPRequest &request)
     XFILE::CImageFile imageFile;
     if (imageFile.Exists(m_path))
     {
+      // serve cached images straight from the texture cache
+      CStdString cachedPath, tag;
+      if (CTextureCache::Get().GetCachedImageTag(m_path, cachedPath, tag))
+      {
+        m_path = cachedPath;
+        m_etag = "\"" + tag + "\"";
+      }
+
       m_responseCode = MHD_HTTP_OK;
       m_responseType = HTTPFileDownload;
     }
@@ -68,7 +68,11 @@ int CHTTPJsonRpcHandler::HandleHTTPRequest(const HTTPRequest &request)
   }
 
   if (isRequest)
-    m_response = CJSONRPC::MethodCall(m_request, request.webserver, &client);
+  {
+    // large results are sent chunked while they are being serialized
+    if (CJSONRPC::MethodCall(m_request, request.webserver, &client, m_jsonResponse) && !m_jsonResponse.IsStreamed())
+      m_jsonResponse.Read(m_response);
+  }
   else
   {
     // get the whole output of JSONRPC.Introspect
@@ -81,7 +85,7 @@ int CHTTPJsonRpcHandler::HandleHTTPRequest(const HTTPRequest &request)
 
   m_request.clear();
   
-  m_responseType = HTTPMemoryDownloadNoFreeCopy;
+  m_responseType = m_jsonResponse.IsStreamed() ? HTTPStreamDownload : HTTPMemoryDownloadNoFreeCopy;
   m_responseCode = MHD_HTTP_OK;
 
   return MHD_YES;
@@ -21,6 +21,7 @@
 
 #include "IHTTPRequestHandler.h"
 #include "interfaces/json-rpc/IClient.h"
+#include "interfaces/json-rpc/JSONRPC.h"
 
 class CHTTPJsonRpcHandler : public IHTTPRequestHandler
 {
@@ -33,6 +34,7 @@ public:
 
   virtual void* GetHTTPResponseData() const { return (void *)m_response.c_str(); };
   virtual size_t GetHTTPResonseDataLength() const { return m_response.size(); }
+  virtual size_t ReadHTTPResponseData(char *buffer, size_t size) { return m_jsonResponse.Read(buffer, size); }
 
   virtual int GetPriority() const { return 2; }
 
@@ -46,6 +48,7 @@ protected:
 private:
   std::string m_request;
   std::string m_response;
+  JSONRPC::CJSONRPCResponse m_jsonResponse;
 
   class CHTTPClient : public JSONRPC::IClient
   {
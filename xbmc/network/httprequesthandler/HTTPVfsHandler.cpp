@@ -24,6 +24,7 @@
 #include "filesystem/File.h"
 #include "network/WebServer.h"
 #include "settings/Settings.h"
+#include "TextureCache.h"
 #include "utils/URIUtils.h"
 
 using namespace std;
@@ -83,6 +84,14 @@ int CHTTPVfsHandler::HandleHTTPRequest(const HTTPRequest &request)
 
       if (accessible)
       {
+        // serve cached images straight from the texture cache
+        CStdString cachedPath, tag;
+        if (m_path.substr(0, 8) == "image://" && CTextureCache::Get().GetCachedImageTag(m_path, cachedPath, tag))
+        {
+          m_path = cachedPath;
+          m_etag = "\"" + tag + "\"";
+        }
+
         m_responseCode = MHD_HTTP_OK;
         m_responseType = HTTPFileDownload;
       }
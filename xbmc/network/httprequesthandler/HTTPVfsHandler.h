@@ -33,9 +33,12 @@ public:
   virtual int HandleHTTPRequest(const HTTPRequest &request);
 
   virtual std::string GetHTTPResponseFile() const { return m_path; }
+  virtual std::string GetHTTPResponseETag() const { return m_etag; }
 
   virtual int GetPriority() const { return 2; }
+  virtual HTTPRequestLane GetHTTPRequestLane() const { return HTTPLaneBulk; }
 
 private:
   CStdString m_path;
+  CStdString m_etag;
 };
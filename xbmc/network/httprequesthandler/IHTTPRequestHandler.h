@@ -50,7 +50,14 @@ enum HTTPResponseType
   HTTPMemoryDownloadNoFreeNoCopy,
   HTTPMemoryDownloadNoFreeCopy,
   HTTPMemoryDownloadFreeNoCopy,
-  HTTPMemoryDownloadFreeCopy
+  HTTPMemoryDownloadFreeCopy,
+  HTTPStreamDownload
+};
+
+enum HTTPRequestLane
+{
+  HTTPLaneInteractive,
+  HTTPLaneBulk
 };
 
 typedef struct HTTPRequest
@@ -73,11 +80,18 @@ public:
   
   virtual void* GetHTTPResponseData() const { return NULL; };
   virtual size_t GetHTTPResonseDataLength() const { return 0; }
+  // Used for HTTPStreamDownload, returns 0 at the end of the response
+  virtual size_t ReadHTTPResponseData(char *buffer, size_t size) { return 0; }
   virtual std::string GetHTTPRedirectUrl() const { return ""; }
   virtual std::string GetHTTPResponseFile() const { return ""; }
+  // Used for HTTPFileDownload, an entity tag which changes along with the file
+  virtual std::string GetHTTPResponseETag() const { return ""; }
 
   // The higher the more important
   virtual int GetPriority() const { return 0; }
+  // Long running transfers go into the bulk lane so they can't hold up
+  // short interactive requests
+  virtual HTTPRequestLane GetHTTPRequestLane() const { return HTTPLaneInteractive; }
 
   void AddPostField(const std::string &key, const std::string &value);
 #if (MHD_VERSION >= 0x00040001)
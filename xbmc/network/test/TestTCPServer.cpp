@@ -0,0 +1,131 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "network/TCPServer.h"
+#include "interfaces/AnnouncementManager.h"
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "threads/SystemClock.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string.h>
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+#define TESTPORT    19090
+#define TESTCLIENTS 300
+
+static int Connect()
+{
+  int fd = socket(PF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+
+  struct timeval timeout = { 10, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(TESTPORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+static bool WaitFor(int fd, const std::string &expected)
+{
+  std::string received;
+  char buffer[1024];
+  while (received.find(expected) == std::string::npos)
+  {
+    int res = recv(fd, buffer, sizeof(buffer), 0);
+    if (res <= 0)
+      return false;
+    received.append(buffer, res);
+  }
+
+  return true;
+}
+
+TEST(TestTCPServer, ManyClients)
+{
+  JSONRPC::CJSONRPC::Initialize();
+  ASSERT_TRUE(JSONRPC::CTCPServer::StartServer(TESTPORT, false));
+
+  std::vector<int> clients;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 0; i < TESTCLIENTS; i++)
+  {
+    int fd = Connect();
+    if (fd < 0)
+      break;
+    clients.push_back(fd);
+  }
+  unsigned int connected = XbmcThreads::SystemClockMillis() - start;
+  EXPECT_EQ((size_t)TESTCLIENTS, clients.size());
+
+  // every client gets its own response
+  const std::string ping = "{\"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Ping\", \"id\": 1}";
+  start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 0; i < clients.size(); i++)
+    EXPECT_EQ((ssize_t)ping.size(), send(clients[i], ping.c_str(), ping.size(), 0));
+
+  unsigned int pongs = 0;
+  for (unsigned int i = 0; i < clients.size(); i++)
+  {
+    if (WaitFor(clients[i], "pong"))
+      pongs++;
+  }
+  unsigned int responded = XbmcThreads::SystemClockMillis() - start;
+  EXPECT_EQ(clients.size(), pongs);
+
+  // and every client receives a single announcement
+  start = XbmcThreads::SystemClockMillis();
+  ANNOUNCEMENT::CAnnouncementManager::Announce(ANNOUNCEMENT::Other, "xbmc", "LoadTest");
+
+  unsigned int announced = 0;
+  for (unsigned int i = 0; i < clients.size(); i++)
+  {
+    if (WaitFor(clients[i], "LoadTest"))
+      announced++;
+  }
+  unsigned int notified = XbmcThreads::SystemClockMillis() - start;
+  EXPECT_EQ(clients.size(), announced);
+
+  for (unsigned int i = 0; i < clients.size(); i++)
+    close(clients[i]);
+
+  JSONRPC::CTCPServer::StopServer(true);
+
+  std::cout << "Clients: " << testing::PrintToString(clients.size()) << std::endl;
+  std::cout << "Connect (ms): " << testing::PrintToString(connected) << std::endl;
+  std::cout << "Ping round trip (ms): " << testing::PrintToString(responded) << std::endl;
+  std::cout << "Announcement (ms): " << testing::PrintToString(notified) << std::endl;
+}
@@ -0,0 +1,269 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#ifdef HAS_WEB_SERVER
+#include "network/WebServer.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+#define TESTPORT      18080
+#define DOWNLOADS     8
+#define RPCCALLS      50
+#define CHUNKSIZE     32 * 1024
+#define CHUNKS        200
+#define CHUNKDELAY    5000
+#define BULKSLOTS     4       // fewer than the concurrent downloads
+
+static int Connect()
+{
+  int fd = socket(PF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+
+  struct timeval timeout = { 10, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(TESTPORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+static bool Get(const std::string &url, std::string &response)
+{
+  int fd = Connect();
+  if (fd < 0)
+    return false;
+
+  std::string request = "GET " + url + " HTTP/1.0\r\n\r\n";
+  send(fd, request.c_str(), request.size(), 0);
+
+  char buffer[4096];
+  int res;
+  while ((res = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+    response.append(buffer, res);
+
+  close(fd);
+  return res == 0;
+}
+
+// a short request answered from memory, like a JSON-RPC call
+class CTestInteractiveHandler : public IHTTPRequestHandler
+{
+public:
+  virtual IHTTPRequestHandler* GetInstance() { return new CTestInteractiveHandler(); }
+  virtual bool CheckHTTPRequest(const HTTPRequest &request) { return request.url == "/rpc"; }
+  virtual int HandleHTTPRequest(const HTTPRequest &request)
+  {
+    m_responseType = HTTPMemoryDownloadNoFreeNoCopy;
+    m_responseCode = MHD_HTTP_OK;
+    return MHD_YES;
+  }
+
+  virtual void* GetHTTPResponseData() const { return (void *)"pong"; }
+  virtual size_t GetHTTPResonseDataLength() const { return 4; }
+};
+
+// a large transfer from a slow source, like a file on a network share
+class CTestBulkHandler : public IHTTPRequestHandler
+{
+public:
+  CTestBulkHandler() : m_chunks(0) { }
+
+  virtual IHTTPRequestHandler* GetInstance() { return new CTestBulkHandler(); }
+  virtual bool CheckHTTPRequest(const HTTPRequest &request) { return request.url == "/bulk"; }
+  virtual int HandleHTTPRequest(const HTTPRequest &request)
+  {
+    m_responseType = HTTPStreamDownload;
+    m_responseCode = MHD_HTTP_OK;
+    return MHD_YES;
+  }
+
+  virtual size_t ReadHTTPResponseData(char *buffer, size_t size)
+  {
+    if (m_chunks++ >= CHUNKS)
+      return 0;
+
+    usleep(CHUNKDELAY);
+    size = std::min(size, (size_t)CHUNKSIZE);
+    memset(buffer, 'x', size);
+    return size;
+  }
+
+  virtual HTTPRequestLane GetHTTPRequestLane() const { return HTTPLaneBulk; }
+
+private:
+  unsigned int m_chunks;
+};
+
+class CDownloadThread : public CThread
+{
+public:
+  CDownloadThread() : CThread("TestWebServerDownload"), m_bytes(0) { }
+
+  size_t m_bytes;
+  std::string m_status;
+
+protected:
+  virtual void Process()
+  {
+    std::string response;
+    Get("/bulk", response);
+    m_bytes = response.size();
+    m_status = response.substr(0, response.find("\r\n"));
+  }
+};
+
+// returns the average latency of the calls, or 0 if the webserver didn't start
+static unsigned int RunMixedLoad(const std::string &model, int bulkTransfers, unsigned int &maxLatency, unsigned int &failed)
+{
+  g_advancedSettings.m_webserverThreadModel = model;
+  g_advancedSettings.m_webserverBulkTransfers = bulkTransfers;
+
+  CWebServer webserver;
+  failed = RPCCALLS;
+  maxLatency = 0;
+  if (!webserver.Start(TESTPORT, "", ""))
+    return 0;
+
+  CDownloadThread downloads[DOWNLOADS];
+  for (unsigned int i = 0; i < DOWNLOADS; i++)
+    downloads[i].Create();
+
+  // let the downloads get going before measuring the calls
+  usleep(100000);
+
+  failed = 0;
+  unsigned int total = 0;
+  for (unsigned int i = 0; i < RPCCALLS; i++)
+  {
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    std::string response;
+    if (!Get("/rpc", response) || response.find("pong") == std::string::npos)
+      failed++;
+    unsigned int latency = XbmcThreads::SystemClockMillis() - start;
+    total += latency;
+    maxLatency = std::max(maxLatency, latency);
+  }
+
+  for (unsigned int i = 0; i < DOWNLOADS; i++)
+    downloads[i].StopThread(true);
+
+  webserver.Stop();
+  return total / RPCCALLS;
+}
+
+TEST(TestWebServer, MixedLoadBenchmark)
+{
+  CTestInteractiveHandler interactive;
+  CTestBulkHandler bulk;
+  CWebServer::RegisterRequestHandler(&interactive);
+  CWebServer::RegisterRequestHandler(&bulk);
+
+  int bulkTransfers = g_advancedSettings.m_webserverBulkTransfers;
+  CStdString threadModel = g_advancedSettings.m_webserverThreadModel;
+
+  // without the bulk lane the slow downloads are read on the threads
+  // serving the calls, with it they are read by the bulk readers and
+  // only BULKSLOTS of them run at once
+  const char *models[] = { "pool", "epoll", "perconnection" };
+  const int lanes[] = { 0, BULKSLOTS };
+  for (unsigned int i = 0; i < sizeof(models) / sizeof(models[0]); i++)
+  {
+    std::cout << "Thread model: " << models[i] << std::endl;
+    for (unsigned int j = 0; j < sizeof(lanes) / sizeof(lanes[0]); j++)
+    {
+      unsigned int failed = 0;
+      unsigned int maxLatency = 0;
+      unsigned int latency = RunMixedLoad(models[i], lanes[j], maxLatency, failed);
+      EXPECT_EQ(0U, failed);
+
+      std::cout << "  " << (lanes[j] > 0 ? "with" : "without") << " bulk lane: "
+                << testing::PrintToString(RPCCALLS) << " calls next to "
+                << testing::PrintToString(DOWNLOADS) << " downloads, latency (ms) average "
+                << testing::PrintToString(latency) << ", max "
+                << testing::PrintToString(maxLatency) << std::endl;
+    }
+  }
+
+  g_advancedSettings.m_webserverBulkTransfers = bulkTransfers;
+  g_advancedSettings.m_webserverThreadModel = threadModel;
+  CWebServer::UnregisterRequestHandler(&bulk);
+  CWebServer::UnregisterRequestHandler(&interactive);
+}
+
+TEST(TestWebServer, BulkTransfersWaitForSlot)
+{
+  CTestBulkHandler bulk;
+  CWebServer::RegisterRequestHandler(&bulk);
+
+  int bulkTransfers = g_advancedSettings.m_webserverBulkTransfers;
+  CStdString threadModel = g_advancedSettings.m_webserverThreadModel;
+  g_advancedSettings.m_webserverBulkTransfers = BULKSLOTS;
+
+  const char *models[] = { "pool", "perconnection" };
+  for (unsigned int i = 0; i < sizeof(models) / sizeof(models[0]); i++)
+  {
+    g_advancedSettings.m_webserverThreadModel = models[i];
+
+    CWebServer webserver;
+    ASSERT_TRUE(webserver.Start(TESTPORT, "", ""));
+
+    CDownloadThread downloads[DOWNLOADS];
+    for (unsigned int j = 0; j < DOWNLOADS; j++)
+      downloads[j].Create();
+
+    // the downloads beyond the slots are queued instead of refused
+    for (unsigned int j = 0; j < DOWNLOADS; j++)
+    {
+      downloads[j].StopThread(true);
+      EXPECT_NE(std::string::npos, downloads[j].m_status.find(" 200")) << models[i] << ": " << downloads[j].m_status;
+      EXPECT_LT((size_t)CHUNKS, downloads[j].m_bytes) << models[i];
+    }
+
+    webserver.Stop();
+  }
+
+  g_advancedSettings.m_webserverBulkTransfers = bulkTransfers;
+  g_advancedSettings.m_webserverThreadModel = threadModel;
+  CWebServer::UnregisterRequestHandler(&bulk);
+}
+#endif
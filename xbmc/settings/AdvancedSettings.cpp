@@ -50,6 +50,7 @@ void CAdvancedSettings::Initialize()
   m_audioApplyDrc = true;
   m_dvdplayerIgnoreDTSinWAV = false;
   m_audioResample = 0;
+  m_audioResampleQuality = 1;
   m_allowTranscode44100 = false;
   m_audioForceDirectSound = false;
   m_audioAudiophile = false;
@@ -61,6 +62,10 @@ void CAdvancedSettings::Initialize()
   m_limiterHold = 0.025f;
   m_limiterRelease = 0.1f;
 
+  m_audioPrefetchTracks = 1;
+  m_audioPrefetchSeconds = 10;
+  m_audioPrefetchSize = 16 * 1024 * 1024;
+
   m_omxHWAudioDecode = false;
   m_omxDecodeStartWithValidFrame = false;
 
@@ -205,6 +210,8 @@ void CAdvancedSettings::Initialize()
   m_strMusicLibraryAlbumFormatRight = "";
   m_prioritiseAPEv2tags = false;
   m_musicItemSeparator = " / ";
+  m_musicScanTagReaders = 4;
+  m_musicScanBatchSize = 250;
   m_videoItemSeparator = " / ";
 
   m_bVideoLibraryHideAllItems = false;
@@ -216,6 +223,7 @@ void CAdvancedSettings::Initialize()
   m_bVideoLibraryImportWatchedState = false;
   m_bVideoLibraryImportResumePoint = false;
   m_bVideoScannerIgnoreErrors = false;
+  m_iVideoScannerStatWorkers = 4;
   m_iVideoLibraryDateAdded = 1; // prefer mtime over ctime and current time
 
   m_iTuxBoxStreamtsPort = 31339;
@@ -254,6 +262,8 @@ void CAdvancedSettings::Initialize()
   m_curlretries = 2;
   m_curlDisableIPV6 = false;      //Certain hardware/OS combinations have trouble
                                   //with ipv6.
+  m_curlSegments = 1;
+  m_curlSegmentSize = 1024 * 1024;
 
   m_fullScreen = m_startFullScreen = false;
   m_showExitButton = true;
@@ -302,11 +312,23 @@ void CAdvancedSettings::Initialize()
   m_measureRefreshrate = false;
 
   m_cacheMemBufferSize = 1024 * 1024 * 20;
+  m_cacheSparse = false;
   m_addonPackageFolderSize = 200;
+  m_directoryCacheSize = 16 * 1024 * 1024;
 
   m_jsonOutputCompact = true;
+  m_jsonParallelBatch = true;
   m_jsonTcpPort = 9090;
 
+  // the four select threads the webserver always ran with, JSON-RPC
+  // handlers already run concurrently on them
+  m_webserverThreadModel = "pool";
+  m_webserverThreadPoolSize = 4;
+  m_webserverConnectionLimit = 512;
+  m_webserverBulkTransfers = 4;
+
+  m_jobManagerWorkStealing = false;
+
   m_enableMultimediaKeys = false;
 
   m_canWindowed = true;
@@ -322,6 +344,7 @@ void CAdvancedSettings::Initialize()
   m_databaseVideo.Reset();
 
   m_logLevelHint = m_logLevel = LOG_LEVEL_NORMAL;
+  m_logAsync = false;
 }
 
 bool CAdvancedSettings::Load()
@@ -390,6 +413,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetInt(pElement, "percentseekbackwardbig", m_musicPercentSeekBackwardBig, -100, 0);
 
     XMLUtils::GetInt(pElement, "resample", m_audioResample, 0, 192000);
+    XMLUtils::GetInt(pElement, "resamplequality", m_audioResampleQuality, 0, 2);
     XMLUtils::GetBoolean(pElement, "allowtranscode44100", m_allowTranscode44100);
     XMLUtils::GetBoolean(pElement, "forceDirectSound", m_audioForceDirectSound);
     XMLUtils::GetBoolean(pElement, "audiophile", m_audioAudiophile);
@@ -412,6 +436,10 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
 
     XMLUtils::GetFloat(pElement, "limiterhold", m_limiterHold, 0.0f, 100.0f);
     XMLUtils::GetFloat(pElement, "limiterrelease", m_limiterRelease, 0.001f, 100.0f);
+
+    XMLUtils::GetInt(pElement, "prefetchtracks", m_audioPrefetchTracks, 0, 10);
+    XMLUtils::GetInt(pElement, "prefetchseconds", m_audioPrefetchSeconds, 2, 60);
+    XMLUtils::GetUInt(pElement, "prefetchsize", m_audioPrefetchSize, 0, 256 * 1024 * 1024);
   }
 
   pElement = pRootElement->FirstChildElement("omx");
@@ -639,6 +667,8 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetString(pElement, "albumformat", m_strMusicLibraryAlbumFormat);
     XMLUtils::GetString(pElement, "albumformatright", m_strMusicLibraryAlbumFormatRight);
     XMLUtils::GetString(pElement, "itemseparator", m_musicItemSeparator);
+    XMLUtils::GetInt(pElement, "tagreaders", m_musicScanTagReaders, 1, 16);
+    XMLUtils::GetInt(pElement, "scanbatchsize", m_musicScanBatchSize, 1, INT_MAX);
   }
 
   pElement = pRootElement->FirstChildElement("videolibrary");
@@ -660,6 +690,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
   if (pElement)
   {
     XMLUtils::GetBoolean(pElement, "ignoreerrors", m_bVideoScannerIgnoreErrors);
+    XMLUtils::GetInt(pElement, "statworkers", m_iVideoScannerStatWorkers, 1, 32);
   }
 
   // Backward-compatibility of ExternalPlayer config
@@ -691,16 +722,33 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetInt(pElement, "curllowspeedtime", m_curllowspeedtime, 1, 1000);
     XMLUtils::GetInt(pElement, "curlretries", m_curlretries, 0, 10);
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
+    XMLUtils::GetInt(pElement, "curlsegments", m_curlSegments, 1, 16);
+    XMLUtils::GetInt(pElement, "curlsegmentsize", m_curlSegmentSize, 64 * 1024, 32 * 1024 * 1024);
     XMLUtils::GetUInt(pElement, "cachemembuffersize", m_cacheMemBufferSize);
+    XMLUtils::GetBoolean(pElement, "sparsecache", m_cacheSparse);
   }
 
   pElement = pRootElement->FirstChildElement("jsonrpc");
   if (pElement)
   {
     XMLUtils::GetBoolean(pElement, "compactoutput", m_jsonOutputCompact);
+    XMLUtils::GetBoolean(pElement, "parallelbatch", m_jsonParallelBatch);
     XMLUtils::GetUInt(pElement, "tcpport", m_jsonTcpPort);
   }
 
+  pElement = pRootElement->FirstChildElement("webserver");
+  if (pElement)
+  {
+    XMLUtils::GetString(pElement, "threadmodel", m_webserverThreadModel);
+    XMLUtils::GetInt(pElement, "threadpoolsize", m_webserverThreadPoolSize, 1, 64);
+    XMLUtils::GetInt(pElement, "connectionlimit", m_webserverConnectionLimit, 1, 4096);
+    XMLUtils::GetInt(pElement, "bulktransfers", m_webserverBulkTransfers, 0, 256);
+  }
+
+  pElement = pRootElement->FirstChildElement("jobmanager");
+  if (pElement)
+    XMLUtils::GetBoolean(pElement, "workstealing", m_jobManagerWorkStealing);
+
   pElement = pRootElement->FirstChildElement("samba");
   if (pElement)
   {
@@ -735,6 +783,10 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     CLog::SetLogLevel(g_advancedSettings.m_logLevel);
   }
 
+  // write the log from a background thread instead of the logging threads
+  XMLUtils::GetBoolean(pRootElement, "asynclog", m_logAsync);
+  CLog::SetAsync(m_logAsync);
+
   XMLUtils::GetString(pRootElement, "cddbaddress", m_cddbAddress);
 
   //airtunes + airplay
@@ -766,6 +818,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
   XMLUtils::GetFloat(pRootElement,"sleepbeforeflip", m_sleepBeforeFlip, 0.0f, 1.0f);
   XMLUtils::GetBoolean(pRootElement,"virtualshares", m_bVirtualShares);
   XMLUtils::GetUInt(pRootElement, "packagefoldersize", m_addonPackageFolderSize);
+  XMLUtils::GetUInt(pRootElement, "directorycachesize", m_directoryCacheSize);
 
   //Tuxbox
   pElement = pRootElement->FirstChildElement("tuxbox");
@@ -104,6 +104,7 @@ class CAdvancedSettings
     float m_audioPlayCountMinimumPercent;
     bool m_dvdplayerIgnoreDTSinWAV;
     int m_audioResample;
+    int m_audioResampleQuality; // 0 = low, 1 = medium, 2 = high, trades CPU time for quality
     bool m_allowTranscode44100;
     bool m_audioForceDirectSound;
     bool m_audioAudiophile;
@@ -113,6 +114,9 @@ class CAdvancedSettings
     CStdString m_audioTranscodeTo;
     float m_limiterHold;
     float m_limiterRelease;
+    int m_audioPrefetchTracks;        // upcoming playlist entries paplayer opens ahead of time, 0 disables
+    int m_audioPrefetchSeconds;       // how much of each of them is decoded ahead of time
+    unsigned int m_audioPrefetchSize; // memory the pre-decoded audio may use in total, in bytes
 
     bool  m_omxHWAudioDecode;
     bool  m_omxDecodeStartWithValidFrame;
@@ -181,6 +185,7 @@ class CAdvancedSettings
     int m_songInfoDuration;
     int m_logLevel;
     int m_logLevelHint;
+    bool m_logAsync;
     CStdString m_cddbAddress;
 
     //airtunes + airplay
@@ -240,6 +245,8 @@ class CAdvancedSettings
     CStdString m_strMusicLibraryAlbumFormatRight;
     bool m_prioritiseAPEv2tags;
     CStdString m_musicItemSeparator;
+    int m_musicScanTagReaders;
+    int m_musicScanBatchSize;
     CStdString m_videoItemSeparator;
     std::vector<CStdString> m_musicTagsFromFileFilters;
 
@@ -253,6 +260,7 @@ class CAdvancedSettings
     bool m_bVideoLibraryImportResumePoint;
 
     bool m_bVideoScannerIgnoreErrors;
+    int m_iVideoScannerStatWorkers;
     int m_iVideoLibraryDateAdded;
 
     std::vector<CStdString> m_vecTokens; // cleaning strings tied to language
@@ -294,6 +302,8 @@ class CAdvancedSettings
     int m_curllowspeedtime;
     int m_curlretries;
     bool m_curlDisableIPV6;
+    int m_curlSegments;             // parallel range requests per http stream, 1 disables
+    int m_curlSegmentSize;          // bytes
 
     bool m_fullScreen;
     bool m_startFullScreen;
@@ -327,6 +337,7 @@ class CAdvancedSettings
     CStdString m_cpuTempCmd;
     CStdString m_gpuTempCmd;
     int m_bgInfoLoaderMaxThreads;
+    bool m_jobManagerWorkStealing; ///< use per-worker job queues with work stealing in CJobManager
 
     /* PVR/TV related advanced settings */
     int m_iPVRTimeCorrection;     /*!< @brief correct all times (epg tags, timer tags, recording tags) by this amount of minutes. defaults to 0. */
@@ -351,12 +362,20 @@ class CAdvancedSettings
     int  m_guiAlgorithmDirtyRegions;
     int  m_guiDirtyRegionNoFlipTimeout;
     unsigned int m_addonPackageFolderSize;
+    unsigned int m_directoryCacheSize; // bytes of listings kept by the directory cache
 
     unsigned int m_cacheMemBufferSize;
+    bool m_cacheSparse; ///< keep several ranges of a file in the memory cache instead of one window
 
     bool m_jsonOutputCompact;
+    bool m_jsonParallelBatch;
     unsigned int m_jsonTcpPort;
 
+    CStdString m_webserverThreadModel; ///< "pool", "epoll" or "perconnection"
+    int m_webserverThreadPoolSize;
+    int m_webserverConnectionLimit;
+    int m_webserverBulkTransfers; ///< concurrent transfers (and reader threads) of the bulk lane, 0 disables the lane
+
     bool m_enableMultimediaKeys;
     std::vector<CStdString> m_settingsFiles;
     void ParseSettingsFile(const CStdString &file);
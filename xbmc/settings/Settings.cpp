@@ -55,6 +55,7 @@
 #include "filesystem/File.h"
 #include "filesystem/DirectoryCache.h"
 #include "DatabaseManager.h"
+#include "utils/JobManager.h"
 
 using namespace std;
 using namespace XFILE;
@@ -795,6 +796,9 @@ bool CSettings::LoadSettings(const CStdString& strSettingsFile)
   // Advanced settings
   g_advancedSettings.Load();
 
+  CJobManager::GetInstance().SetScheduler(g_advancedSettings.m_jobManagerWorkStealing ?
+                                          CJobManager::SCHEDULER_WORKSTEALING : CJobManager::SCHEDULER_SHARED);
+
   // Add the list of disc stub extensions (if any) to the list of video extensions
   if (!m_discStubExtensions.IsEmpty())
     g_settings.m_videoExtensions += "|" + m_discStubExtensions;
@@ -1539,6 +1543,7 @@ void CSettings::SetSkinString(int setting, const CStdString &label)
   if (it != m_skinStrings.end())
   {
     (*it).second.value = label;
+    g_infoManager.MarkSourcesChanged(INFO_SOURCE_SKIN);
     return;
   }
   assert(false);
@@ -1555,6 +1560,7 @@ void CSettings::ResetSkinSetting(const CStdString &setting)
     if (settingName.Equals((*it).second.name))
     {
       (*it).second.value = "";
+      g_infoManager.MarkSourcesChanged(INFO_SOURCE_SKIN);
       return;
     }
   }
@@ -1564,6 +1570,7 @@ void CSettings::ResetSkinSetting(const CStdString &setting)
     if (settingName.Equals((*it).second.name))
     {
       (*it).second.value = false;
+      g_infoManager.MarkSourcesChanged(INFO_SOURCE_SKIN);
       return;
     }
   }
@@ -1604,6 +1611,7 @@ void CSettings::SetSkinBool(int setting, bool set)
   if (it != m_skinBools.end())
   {
     (*it).second.value = set;
+    g_infoManager.MarkSourcesChanged(INFO_SOURCE_SKIN);
     return;
   }
   assert(false);
@@ -0,0 +1,245 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "GUIInfoManager.h"
+#include "threads/SystemClock.h"
+
+#include <iostream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define CONDITIONS  10000
+#define WINDOWS     5       // windows each registering the skin's conditions
+#define RELOADS     10      // activations of windows loaded every time
+
+/* conditions as a large skin has them, many differing only by control id */
+static void FillConditions(std::vector<CStdString> &conditions)
+{
+  for (int i = 0; i < CONDITIONS; i++)
+  {
+    CStdString condition;
+    if (i % 4 == 0)
+      condition.Format("Control.HasFocus(%d)", i);
+    else if (i % 4 == 1)
+      condition.Format("Control.IsVisible(%d) + Player.HasVideo", i);
+    else if (i % 4 == 2)
+      condition.Format("[Container(%d).HasFocus(%d) | Window.IsActive(%d)] + !Player.ShowInfo", i, i % 50, 10000 + i % 100);
+    else
+      condition.Format("StringCompare(ListItem.Label,label%d) | IntegerGreaterThan(ListItem.Size,%d)", i, i);
+    conditions.push_back(condition);
+  }
+}
+
+class TestGUIInfoManager : public testing::Test
+{
+protected:
+  TestGUIInfoManager()
+  {
+    g_infoManager.Clear();
+    g_infoManager.SetShowInfo(false);
+    g_infoManager.ResetCache();
+    m_requests = m_evaluations = 0;
+  }
+
+  ~TestGUIInfoManager()
+  {
+    g_infoManager.Clear();
+    g_infoManager.SetShowInfo(false);
+  }
+
+  /* requests and evaluations since the last call */
+  void GetStats(uint64_t &requests, uint64_t &evaluations)
+  {
+    unsigned int conditions;
+    uint64_t totalRequests, totalEvaluations;
+    g_infoManager.GetBoolStats(conditions, totalRequests, totalEvaluations);
+    requests = totalRequests - m_requests;
+    evaluations = totalEvaluations - m_evaluations;
+    m_requests = totalRequests;
+    m_evaluations = totalEvaluations;
+  }
+
+  uint64_t m_requests;
+  uint64_t m_evaluations;
+};
+
+TEST_F(TestGUIInfoManager, ConstantsAreCached)
+{
+  unsigned int always = g_infoManager.Register("true");
+  unsigned int never = g_infoManager.Register("false");
+  ASSERT_NE(0U, always);
+  ASSERT_NE(0U, never);
+  EXPECT_EQ(always, g_infoManager.Register(" TRUE "));
+
+  uint64_t requests, evaluations;
+  GetStats(requests, evaluations);
+  for (int frame = 0; frame < 10; frame++)
+  {
+    EXPECT_TRUE(g_infoManager.GetBoolValue(always));
+    EXPECT_FALSE(g_infoManager.GetBoolValue(never));
+    g_infoManager.UpdateCache();
+  }
+  GetStats(requests, evaluations);
+  EXPECT_EQ(20U, requests);
+  EXPECT_EQ(2U, evaluations);
+
+  // only a full reset updates them again
+  g_infoManager.ResetCache();
+  EXPECT_TRUE(g_infoManager.GetBoolValue(always));
+  GetStats(requests, evaluations);
+  EXPECT_EQ(1U, evaluations);
+}
+
+TEST_F(TestGUIInfoManager, PlayerOnlyWhilePlaying)
+{
+  unsigned int hasMedia = g_infoManager.Register("player.hasmedia");
+
+  uint64_t requests, evaluations;
+  GetStats(requests, evaluations);
+  for (int frame = 0; frame < 10; frame++)
+  {
+    EXPECT_FALSE(g_infoManager.GetBoolValue(hasMedia));
+    g_infoManager.UpdateCache();
+  }
+  GetStats(requests, evaluations);
+  EXPECT_EQ(10U, requests);
+  EXPECT_EQ(1U, evaluations);
+}
+
+TEST_F(TestGUIInfoManager, VolatileEveryFrame)
+{
+  unsigned int showInfo = g_infoManager.Register("player.showinfo");
+
+  uint64_t requests, evaluations;
+  GetStats(requests, evaluations);
+  for (int frame = 0; frame < 10; frame++)
+  {
+    g_infoManager.SetShowInfo(frame % 2 == 1);
+    EXPECT_EQ(frame % 2 == 1, g_infoManager.GetBoolValue(showInfo));
+    EXPECT_EQ(frame % 2 == 1, g_infoManager.GetBoolValue(showInfo));
+    g_infoManager.UpdateCache();
+  }
+  GetStats(requests, evaluations);
+  EXPECT_EQ(20U, requests);
+  EXPECT_EQ(10U, evaluations);
+}
+
+TEST_F(TestGUIInfoManager, ShortCircuit)
+{
+  // the cached operand is tried first, whatever its position
+  unsigned int either = g_infoManager.Register("player.showinfo | true");
+  unsigned int both = g_infoManager.Register("player.showinfo + [false + player.hasmedia]");
+
+  uint64_t requests, evaluations;
+  GetStats(requests, evaluations);
+  EXPECT_TRUE(g_infoManager.GetBoolValue(either));
+  EXPECT_FALSE(g_infoManager.GetBoolValue(both));
+  GetStats(requests, evaluations);
+  EXPECT_EQ(4U, requests);      // the expressions, "true" and "false"
+  EXPECT_EQ(4U, evaluations);
+
+  g_infoManager.SetShowInfo(true);
+  g_infoManager.UpdateCache();
+  EXPECT_TRUE(g_infoManager.GetBoolValue(either));
+  EXPECT_FALSE(g_infoManager.GetBoolValue(both));
+  GetStats(requests, evaluations);
+  EXPECT_EQ(4U, requests);
+  EXPECT_EQ(2U, evaluations);   // only the expressions themselves
+}
+
+TEST_F(TestGUIInfoManager, Expressions)
+{
+  const char *expressions[] = { "!!player.showinfo", "![!player.showinfo]", "player.showinfo + true", "false | player.showinfo",
+                                "[player.showinfo | false] + [true | player.hasmedia]", "!player.hasmedia + player.showinfo" };
+  for (unsigned int i = 0; i < sizeof(expressions) / sizeof(expressions[0]); i++)
+  {
+    unsigned int expression = g_infoManager.Register(expressions[i]);
+    for (int show = 0; show < 2; show++)
+    {
+      g_infoManager.SetShowInfo(show == 1);
+      g_infoManager.UpdateCache();
+      EXPECT_EQ(show == 1, g_infoManager.GetBoolValue(expression)) << expressions[i];
+    }
+  }
+
+  // broken expressions are false
+  EXPECT_FALSE(g_infoManager.EvaluateBool("true +"));
+  EXPECT_FALSE(g_infoManager.EvaluateBool("[true | false"));
+}
+
+TEST_F(TestGUIInfoManager, Interning)
+{
+  unsigned int first = g_infoManager.Register("Control.HasFocus(1) + Player.HasVideo", 1);
+  EXPECT_EQ(first, g_infoManager.Register(" control.hasfocus(1) + player.hasvideo", 1));
+  EXPECT_NE(first, g_infoManager.Register("Control.HasFocus(1) + Player.HasVideo", 2));
+  EXPECT_NE(first, g_infoManager.Register("Control.HasFocus(2) + Player.HasVideo", 1));
+
+  int label = g_infoManager.TranslateString("StringCompare(ListItem.Label,Foo)");
+  EXPECT_NE(0, label);
+  EXPECT_EQ(label, g_infoManager.TranslateString(" StringCompare(ListItem.Label,Foo)"));
+  EXPECT_EQ(label, g_infoManager.TranslateString("stringcompare(listitem.label,foo)"));
+  EXPECT_NE(label, g_infoManager.TranslateString("StringCompare(ListItem.Label,Bar)"));
+}
+
+TEST_F(TestGUIInfoManager, RegisterSkinBenchmark)
+{
+  std::vector<CStdString> conditions;
+  FillConditions(conditions);
+
+  // the first window registers them all
+  std::vector<unsigned int> ids;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 0; i < conditions.size(); i++)
+    ids.push_back(g_infoManager.Register(conditions[i], WINDOWS));
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+  unsigned int registered;
+  uint64_t requests, evaluations;
+  g_infoManager.GetBoolStats(registered, requests, evaluations);
+  EXPECT_LT((unsigned int)CONDITIONS, registered);
+
+  std::cout << "Conditions: " << testing::PrintToString(CONDITIONS) << " Registered: " << testing::PrintToString(registered) << std::endl;
+  std::cout << "  Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+
+  // then the other windows do, with most of them already known
+  start = XbmcThreads::SystemClockMillis();
+  for (int window = 0; window < WINDOWS; window++)
+  {
+    for (unsigned int i = 0; i < conditions.size(); i++)
+      g_infoManager.Register(conditions[i], window);
+  }
+  elapsed = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << "Windows: " << testing::PrintToString(WINDOWS) << std::endl;
+  std::cout << "  Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+
+  // and windows loaded every time register theirs again on each activation
+  start = XbmcThreads::SystemClockMillis();
+  for (int reload = 0; reload < RELOADS; reload++)
+  {
+    for (unsigned int i = 0; i < conditions.size(); i++)
+      EXPECT_EQ(ids[i], g_infoManager.Register(conditions[i], WINDOWS));
+  }
+  elapsed = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << "Reloads: " << testing::PrintToString(RELOADS) << std::endl;
+  std::cout << "  Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+}
@@ -24,9 +24,13 @@
 #include "LangInfo.h"
 #include "threads/SingleLock.h"
 #include "log.h"
+#include "EndianSwap.h"
 
 #include <errno.h>
 #include <iconv.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #if defined(TARGET_DARWIN)
 #ifdef __POWERPC__
@@ -52,19 +56,18 @@
   #define UTF8_SOURCE "UTF-8"
 #endif
 
+// UTF-8-MAC also composes decomposed characters, which is left to iconv
+#if !defined(TARGET_DARWIN)
+  #define UTF8_NATIVE
+#endif
+
+// strings of 16 bit units in little or big endian need their units swapped on some hosts
+#ifdef WORDS_BIGENDIAN
+static const bool swapUTF16LE = true;
+#else
+static const bool swapUTF16LE = false;
+#endif
 
-static iconv_t m_iconvStringCharsetToFontCharset = (iconv_t)-1;
-static iconv_t m_iconvSubtitleCharsetToW         = (iconv_t)-1;
-static iconv_t m_iconvUtf8ToStringCharset        = (iconv_t)-1;
-static iconv_t m_iconvStringCharsetToUtf8        = (iconv_t)-1;
-static iconv_t m_iconvUcs2CharsetToStringCharset = (iconv_t)-1;
-static iconv_t m_iconvUtf32ToStringCharset       = (iconv_t)-1;
-static iconv_t m_iconvWtoUtf8                    = (iconv_t)-1;
-static iconv_t m_iconvUtf16LEtoW                 = (iconv_t)-1;
-static iconv_t m_iconvUtf16BEtoUtf8              = (iconv_t)-1;
-static iconv_t m_iconvUtf16LEtoUtf8              = (iconv_t)-1;
-static iconv_t m_iconvUtf8toW                    = (iconv_t)-1;
-static iconv_t m_iconvUcs2CharsetToUtf8          = (iconv_t)-1;
 
 #if defined(FRIBIDI_CHAR_SET_NOT_FOUND)
 static FriBidiCharSet m_stringFribidiCharset     = FRIBIDI_CHAR_SET_NOT_FOUND;
@@ -138,7 +141,6 @@ static struct SCharsetMapping
 #define UTF8_DEST_MULTIPLIER 6
 
 #define ICONV_PREPARE(iconv) iconv=(iconv_t)-1
-#define ICONV_SAFE_CLOSE(iconv) if (iconv!=(iconv_t)-1) { iconv_close(iconv); iconv=(iconv_t)-1; }
 
 size_t iconv_const (void* cd, const char** inbuf, size_t *inbytesleft,
                     char* * outbuf, size_t *outbytesleft)
@@ -160,6 +162,70 @@ size_t iconv_const (void* cd, const char** inbuf, size_t *inbytesleft,
     return iconv((iconv_t)cd, iconv_param_adapter(inbuf), inbytesleft, outbuf, outbytesleft);
 }
 
+/* iconv handles can't be shared between threads, so each conversion keeps a
+ * pool of them. A thread takes a handle for one conversion and gives it back
+ * afterwards, conversions only wait for each other while taking a handle.
+ * reset() retires the handles, as the charsets they were opened for may have
+ * changed, handles that are in use are closed when they are given back.
+ */
+class CIconvPool
+{
+public:
+  CIconvPool() : m_generation(0) {}
+  ~CIconvPool() { Reset(); }
+
+  iconv_t Acquire(unsigned int& generation)
+  {
+    CSingleLock lock(m_lock);
+    generation = m_generation;
+    if (m_free.empty())
+      return (iconv_t)-1;
+    iconv_t handle = m_free.back();
+    m_free.pop_back();
+    return handle;
+  }
+
+  void Release(iconv_t handle, unsigned int generation)
+  {
+    if (handle == (iconv_t)-1)
+      return;
+
+    CSingleLock lock(m_lock);
+    if (generation == m_generation)
+    {
+      m_free.push_back(handle);
+      return;
+    }
+    lock.Leave();
+    iconv_close(handle);
+  }
+
+  void Reset()
+  {
+    CSingleLock lock(m_lock);
+    m_generation++;
+    for (std::vector<iconv_t>::iterator it = m_free.begin(); it != m_free.end(); ++it)
+      iconv_close(*it);
+    m_free.clear();
+  }
+
+private:
+  CCriticalSection     m_lock;
+  std::vector<iconv_t> m_free;
+  unsigned int         m_generation;
+};
+
+static CIconvPool m_iconvStringCharsetToFontCharset;
+static CIconvPool m_iconvSubtitleCharsetToW;
+static CIconvPool m_iconvUtf8ToStringCharset;
+static CIconvPool m_iconvStringCharsetToUtf8;
+static CIconvPool m_iconvUcs2CharsetToStringCharset;
+static CIconvPool m_iconvUtf32ToStringCharset;
+static CIconvPool m_iconvUcs2CharsetToUtf8;
+#if defined(TARGET_DARWIN)
+static CIconvPool m_iconvUtf8toW;
+#endif
+
 template<class INPUT,class OUTPUT>
 static bool convert_checked(iconv_t& type, int multiplier, const CStdString& strFromCharset, const CStdString& strToCharset, const INPUT& strSource, OUTPUT& strDest)
 {
@@ -271,6 +337,304 @@ static void convert(iconv_t& type, int multiplier, const CStdString& strFromChar
     strDest = strSource;
 }
 
+template<class INPUT,class OUTPUT>
+static bool convert_checked(CIconvPool& pool, int multiplier, const CStdString& strFromCharset, const CStdString& strToCharset, const INPUT& strSource, OUTPUT& strDest)
+{
+  unsigned int generation;
+  iconv_t type = pool.Acquire(generation);
+  bool result = convert_checked(type, multiplier, strFromCharset, strToCharset, strSource, strDest);
+  pool.Release(type, generation);
+  return result;
+}
+
+template<class INPUT,class OUTPUT>
+static void convert(CIconvPool& pool, int multiplier, const CStdString& strFromCharset, const CStdString& strToCharset, const INPUT& strSource,  OUTPUT& strDest)
+{
+  if(!convert_checked(pool, multiplier, strFromCharset, strToCharset, strSource, strDest))
+    strDest = strSource;
+}
+
+/* Native transcoding between UTF-8 and the UTF-16/UTF-32 strings used in the
+ * GUI. These are the conversions that run for every label and sort key, they
+ * don't need iconv or a lock. Runs of ASCII are widened or narrowed 16 bytes
+ * at a time. Invalid input is skipped, like convert() does with iconv.
+ */
+
+/* widens the ASCII at the start of [src, end), returns where it stopped in dst */
+template<typename CHAR>
+static inline CHAR* widenAscii(const unsigned char*& src, const unsigned char* end, CHAR* dst)
+{
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  while (end - src >= 16)
+  {
+    __m128i in = _mm_loadu_si128((const __m128i*)src);
+    if (_mm_movemask_epi8(in))
+      break;
+
+    __m128i lo = _mm_unpacklo_epi8(in, zero);
+    __m128i hi = _mm_unpackhi_epi8(in, zero);
+    if (sizeof(CHAR) == 2)
+    {
+      _mm_storeu_si128((__m128i*)dst, lo);
+      _mm_storeu_si128((__m128i*)(dst + 8), hi);
+    }
+    else
+    {
+      _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(lo, zero));
+      _mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi16(lo, zero));
+      _mm_storeu_si128((__m128i*)(dst + 8), _mm_unpacklo_epi16(hi, zero));
+      _mm_storeu_si128((__m128i*)(dst + 12), _mm_unpackhi_epi16(hi, zero));
+    }
+    src += 16;
+    dst += 16;
+  }
+#endif
+  while (src < end && *src < 0x80)
+    *dst++ = (CHAR)*src++;
+  return dst;
+}
+
+/* narrows the ASCII at the start of [src, end), returns where it stopped in dst */
+template<typename CHAR>
+static inline char* narrowAscii(const CHAR*& src, const CHAR* end, bool swap, char* dst)
+{
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  if (sizeof(CHAR) == 2)
+  {
+    const __m128i mask = _mm_set1_epi16((short)0xff80);
+    while (end - src >= 8)
+    {
+      __m128i in = _mm_loadu_si128((const __m128i*)src);
+      if (swap)
+        in = _mm_or_si128(_mm_srli_epi16(in, 8), _mm_slli_epi16(in, 8));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(in, mask), zero)) != 0xffff)
+        break;
+
+      _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(in, in));
+      src += 8;
+      dst += 8;
+    }
+  }
+  else if (!swap)
+  {
+    const __m128i mask = _mm_set1_epi32((int)0xffffff80);
+    while (end - src >= 8)
+    {
+      __m128i in1 = _mm_loadu_si128((const __m128i*)src);
+      __m128i in2 = _mm_loadu_si128((const __m128i*)(src + 4));
+      __m128i ascii = _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(in1, mask), zero),
+                                    _mm_cmpeq_epi32(_mm_and_si128(in2, mask), zero));
+      if (_mm_movemask_epi8(ascii) != 0xffff)
+        break;
+
+      __m128i in = _mm_packs_epi32(in1, in2);
+      _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(in, in));
+      src += 8;
+      dst += 8;
+    }
+  }
+#endif
+  while (src < end)
+  {
+    uint32_t c = (uint32_t)*src;
+    if (swap)
+      c = sizeof(CHAR) == 2 ? Endian_Swap16((uint16_t)c) : Endian_Swap32(c);
+    if (c >= 0x80)
+      break;
+    *dst++ = (char)c;
+    src++;
+  }
+  return dst;
+}
+
+/* appends a code point as UTF-16 or UTF-32, depending on the size of CHAR */
+template<typename CHAR>
+static inline CHAR* putCodePoint(CHAR* dst, uint32_t c)
+{
+  if (sizeof(CHAR) == 2 && c >= 0x10000)
+  {
+    c -= 0x10000;
+    *dst++ = (CHAR)(0xd800 | (c >> 10));
+    *dst++ = (CHAR)(0xdc00 | (c & 0x3ff));
+  }
+  else
+    *dst++ = (CHAR)c;
+  return dst;
+}
+
+/* reads a code point from UTF-16 or UTF-32, returns false and skips a unit if there is none */
+template<typename CHAR>
+static inline bool getCodePoint(const CHAR*& src, const CHAR* end, bool swap, uint32_t& c)
+{
+  if (sizeof(CHAR) == 2)
+  {
+    c = swap ? Endian_Swap16((uint16_t)*src) : (uint16_t)*src;
+    src++;
+    if (c < 0xd800 || c > 0xdfff)
+      return true;
+    if (c > 0xdbff || src == end)
+      return false;
+
+    uint32_t low = swap ? Endian_Swap16((uint16_t)*src) : (uint16_t)*src;
+    if (low < 0xdc00 || low > 0xdfff)
+      return false;
+    src++;
+    c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+    return true;
+  }
+
+  c = swap ? Endian_Swap32((uint32_t)*src) : (uint32_t)*src;
+  src++;
+  return c <= 0x10ffff && (c < 0xd800 || c > 0xdfff);
+}
+
+template<typename CHAR>
+static void utf8ToUnicode(const CStdStringA& strSource, CStdStr<CHAR>& strDest)
+{
+  const unsigned char* src = (const unsigned char*)strSource.c_str();
+  const unsigned char* end = src + strSource.length();
+
+  // every byte of UTF-8 gives at most one unit of UTF-16 or UTF-32
+  CHAR* start = strDest.GetBuffer(strSource.length());
+  CHAR* dst   = start;
+  while (src < end)
+  {
+    if (*src < 0x80)
+    {
+      dst = widenAscii(src, end, dst);
+      continue;
+    }
+
+    int      trailing;
+    uint32_t c, min;
+    if (*src >= 0xc2 && *src <= 0xdf)
+    {
+      trailing = 1; c = *src & 0x1f; min = 0x80;
+    }
+    else if ((*src & 0xf0) == 0xe0)
+    {
+      trailing = 2; c = *src & 0x0f; min = 0x800;
+    }
+    else if (*src >= 0xf0 && *src <= 0xf4)
+    {
+      trailing = 3; c = *src & 0x07; min = 0x10000;
+    }
+    else
+    {
+      src++;
+      continue;
+    }
+
+    if (end - src <= trailing)
+    {
+      src++;
+      continue;
+    }
+
+    int i;
+    for (i = 1; i <= trailing && (src[i] & 0xc0) == 0x80; i++)
+      c = (c << 6) | (src[i] & 0x3f);
+
+    // overlong forms, surrogates and code points past unicode are invalid
+    if (i <= trailing || c < min || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff))
+    {
+      src++;
+      continue;
+    }
+
+    src += trailing + 1;
+    dst = putCodePoint(dst, c);
+  }
+  strDest.ReleaseBuffer(dst - start);
+}
+
+template<typename CHAR>
+static void unicodeToUtf8(const CHAR* src, size_t length, bool swap, CStdStringA& strDest)
+{
+  const CHAR* end = src + length;
+
+  // a unit of UTF-16 gives at most 3 bytes, a unit of UTF-32 at most 4
+  char* start = strDest.GetBuffer(length * (sizeof(CHAR) == 2 ? 3 : 4));
+  char* dst   = start;
+  while (src < end)
+  {
+    dst = narrowAscii(src, end, swap, dst);
+    if (src == end)
+      break;
+
+    uint32_t c;
+    if (!getCodePoint(src, end, swap, c))
+      continue;
+
+    if (c < 0x80)
+      *dst++ = (char)c;
+    else if (c < 0x800)
+    {
+      *dst++ = (char)(0xc0 | (c >> 6));
+      *dst++ = (char)(0x80 | (c & 0x3f));
+    }
+    else if (c < 0x10000)
+    {
+      *dst++ = (char)(0xe0 | (c >> 12));
+      *dst++ = (char)(0x80 | ((c >> 6) & 0x3f));
+      *dst++ = (char)(0x80 | (c & 0x3f));
+    }
+    else
+    {
+      *dst++ = (char)(0xf0 | (c >> 18));
+      *dst++ = (char)(0x80 | ((c >> 12) & 0x3f));
+      *dst++ = (char)(0x80 | ((c >> 6) & 0x3f));
+      *dst++ = (char)(0x80 | (c & 0x3f));
+    }
+  }
+  strDest.ReleaseBuffer(dst - start);
+}
+
+template<typename CHAR>
+static void utf16ToUnicode(const uint16_t* src, size_t length, bool swap, CStdStr<CHAR>& strDest)
+{
+  const uint16_t* end = src + length;
+
+  CHAR* start = strDest.GetBuffer(length);
+  CHAR* dst   = start;
+  while (src < end)
+  {
+    uint32_t c;
+    if (getCodePoint(src, end, swap, c))
+      dst = putCodePoint(dst, c);
+  }
+  strDest.ReleaseBuffer(dst - start);
+}
+
+/* Text that is printable ASCII apart from line breaks is always left to right,
+ * so fribidi would only drop the line breaks. Returns false for anything else.
+ */
+static bool asciiToVisualW(const CStdStringA& strSource, CStdStringW& strDest)
+{
+  const unsigned char* src = (const unsigned char*)strSource.c_str();
+  const unsigned char* end = src + strSource.length();
+
+  wchar_t* start = strDest.GetBuffer(strSource.length());
+  wchar_t* dst   = start;
+  dst = widenAscii(src, end, dst);
+  if (src != end)
+    return false;
+
+  wchar_t* visual = start;
+  for (wchar_t* c = start; c < dst; c++)
+  {
+    if (*c == '\n')
+      continue;
+    if (*c < 0x20 || *c == 0x7f)
+      return false;
+    *visual++ = *c;
+  }
+  strDest.ReleaseBuffer(visual - start);
+  return true;
+}
+
 using namespace std;
 
 static void logicalToVisualBiDi(const CStdStringA& strSource, CStdStringA& strDest, FriBidiCharSet fribidiCharset, FriBidiCharType base = FRIBIDI_TYPE_LTR, bool* bWasFlipped =NULL)
@@ -388,18 +752,16 @@ void CCharsetConverter::reset(void)
 {
   CSingleLock lock(m_critSection);
 
-  ICONV_SAFE_CLOSE(m_iconvStringCharsetToFontCharset);
-  ICONV_SAFE_CLOSE(m_iconvUtf8ToStringCharset);
-  ICONV_SAFE_CLOSE(m_iconvStringCharsetToUtf8);
-  ICONV_SAFE_CLOSE(m_iconvUcs2CharsetToStringCharset);
-  ICONV_SAFE_CLOSE(m_iconvSubtitleCharsetToW);
-  ICONV_SAFE_CLOSE(m_iconvWtoUtf8);
-  ICONV_SAFE_CLOSE(m_iconvUtf16BEtoUtf8);
-  ICONV_SAFE_CLOSE(m_iconvUtf16LEtoUtf8);
-  ICONV_SAFE_CLOSE(m_iconvUtf32ToStringCharset);
-  ICONV_SAFE_CLOSE(m_iconvUtf8toW);
-  ICONV_SAFE_CLOSE(m_iconvUcs2CharsetToUtf8);
-
+  m_iconvStringCharsetToFontCharset.Reset();
+  m_iconvUtf8ToStringCharset.Reset();
+  m_iconvStringCharsetToUtf8.Reset();
+  m_iconvUcs2CharsetToStringCharset.Reset();
+  m_iconvSubtitleCharsetToW.Reset();
+  m_iconvUtf32ToStringCharset.Reset();
+  m_iconvUcs2CharsetToUtf8.Reset();
+#if defined(TARGET_DARWIN)
+  m_iconvUtf8toW.Reset();
+#endif
 
   m_stringFribidiCharset = FRIBIDI_NOTFOUND;
 
@@ -418,23 +780,35 @@ void CCharsetConverter::utf8ToW(const CStdStringA& utf8String, CStdStringW &wStr
   // Try to flip hebrew/arabic characters, if any
   if (bVisualBiDiFlip)
   {
+    if (asciiToVisualW(utf8String, wString))
+    {
+      if (bWasFlipped)
+        *bWasFlipped = false;
+      return;
+    }
+
     CStdStringA strFlipped;
     FriBidiCharType charset = forceLTRReadingOrder ? FRIBIDI_TYPE_LTR : FRIBIDI_TYPE_PDF;
     logicalToVisualBiDi(utf8String, strFlipped, FRIBIDI_UTF8, charset, bWasFlipped);
-    CSingleLock lock(m_critSection);
+#ifdef UTF8_NATIVE
+    utf8ToUnicode(strFlipped, wString);
+#else
     convert(m_iconvUtf8toW,sizeof(wchar_t),UTF8_SOURCE,WCHAR_CHARSET,strFlipped,wString);
+#endif
   }
   else
   {
-    CSingleLock lock(m_critSection);
+#ifdef UTF8_NATIVE
+    utf8ToUnicode(utf8String, wString);
+#else
     convert(m_iconvUtf8toW,sizeof(wchar_t),UTF8_SOURCE,WCHAR_CHARSET,utf8String,wString);
+#endif
   }
 }
 
 void CCharsetConverter::subtitleCharsetToW(const CStdStringA& strSource, CStdStringW& strDest)
 {
   // No need to flip hebrew/arabic as mplayer does the flipping
-  CSingleLock lock(m_critSection);
   convert(m_iconvSubtitleCharsetToW,sizeof(wchar_t),g_langInfo.GetSubtitleCharSet(),WCHAR_CHARSET,strSource,strDest);
 }
 
@@ -458,7 +832,6 @@ void CCharsetConverter::toW(const CStdStringA& strSource,
 
 void CCharsetConverter::utf8ToStringCharset(const CStdStringA& strSource, CStdStringA& strDest)
 {
-  CSingleLock lock(m_critSection);
   convert(m_iconvUtf8ToStringCharset,1,UTF8_SOURCE,g_langInfo.GetGuiCharSet(),strSource,strDest);
 }
 
@@ -520,45 +893,34 @@ void CCharsetConverter::unknownToUTF8(const CStdStringA &source, CStdStringA &de
   if (isValidUtf8(source))
     dest = source;
   else
-  {
-    CSingleLock lock(m_critSection);
     convert(m_iconvStringCharsetToUtf8, UTF8_DEST_MULTIPLIER, g_langInfo.GetGuiCharSet(), "UTF-8", source, dest);
-  }
 }
 
 void CCharsetConverter::wToUTF8(const CStdStringW& strSource, CStdStringA &strDest)
 {
-  CSingleLock lock(m_critSection);
-  convert(m_iconvWtoUtf8,UTF8_DEST_MULTIPLIER,WCHAR_CHARSET,"UTF-8",strSource,strDest);
+  unicodeToUtf8(strSource.c_str(), strSource.length(), false, strDest);
 }
 
 void CCharsetConverter::utf16BEtoUTF8(const CStdString16& strSource, CStdStringA &strDest)
 {
-  CSingleLock lock(m_critSection);
-  if(!convert_checked(m_iconvUtf16BEtoUtf8,UTF8_DEST_MULTIPLIER,"UTF-16BE","UTF-8",strSource,strDest))
-    strDest.clear();
+  unicodeToUtf8(strSource.c_str(), strSource.length(), !swapUTF16LE, strDest);
 }
 
 void CCharsetConverter::utf16LEtoUTF8(const CStdString16& strSource,
                                       CStdStringA &strDest)
 {
-  CSingleLock lock(m_critSection);
-  if(!convert_checked(m_iconvUtf16LEtoUtf8,UTF8_DEST_MULTIPLIER,"UTF-16LE","UTF-8",strSource,strDest))
-    strDest.clear();
+  unicodeToUtf8(strSource.c_str(), strSource.length(), swapUTF16LE, strDest);
 }
 
 void CCharsetConverter::ucs2ToUTF8(const CStdString16& strSource, CStdStringA& strDest)
 {
-  CSingleLock lock(m_critSection);
   if(!convert_checked(m_iconvUcs2CharsetToUtf8,UTF8_DEST_MULTIPLIER,"UCS-2LE","UTF-8",strSource,strDest))
     strDest.clear();
 }
 
 void CCharsetConverter::utf16LEtoW(const CStdString16& strSource, CStdStringW &strDest)
 {
-  CSingleLock lock(m_critSection);
-  if(!convert_checked(m_iconvUtf16LEtoW,sizeof(wchar_t),"UTF-16LE",WCHAR_CHARSET,strSource,strDest))
-    strDest.clear();
+  utf16ToUnicode(strSource.c_str(), strSource.length(), swapUTF16LE, strDest);
 }
 
 void CCharsetConverter::ucs2CharsetToStringCharset(const CStdStringW& strSource, CStdStringA& strDest, bool swap)
@@ -578,22 +940,22 @@ void CCharsetConverter::ucs2CharsetToStringCharset(const CStdStringW& strSource,
       s++;
     }
   }
-  CSingleLock lock(m_critSection);
   convert(m_iconvUcs2CharsetToStringCharset,4,"UTF-16LE",
           g_langInfo.GetGuiCharSet(),strCopy,strDest);
 }
 
 void CCharsetConverter::utf32ToStringCharset(const unsigned long* strSource, CStdStringA& strDest)
 {
-  CSingleLock lock(m_critSection);
+  unsigned int generation;
+  iconv_t type = m_iconvUtf32ToStringCharset.Acquire(generation);
 
-  if (m_iconvUtf32ToStringCharset == (iconv_t) - 1)
+  if (type == (iconv_t) - 1)
   {
     CStdString strCharset=g_langInfo.GetGuiCharSet();
-    m_iconvUtf32ToStringCharset = iconv_open(strCharset.c_str(), "UTF-32LE");
+    type = iconv_open(strCharset.c_str(), "UTF-32LE");
   }
 
-  if (m_iconvUtf32ToStringCharset != (iconv_t) - 1)
+  if (type != (iconv_t) - 1)
   {
     const unsigned long* ptr=strSource;
     while (*ptr) ptr++;
@@ -603,24 +965,23 @@ void CCharsetConverter::utf32ToStringCharset(const unsigned long* strSource, CSt
     char *dst = strDest.GetBuffer(inBytes);
     size_t outBytes = inBytes;
 
-    if (iconv_const(m_iconvUtf32ToStringCharset, &src, &inBytes, &dst, &outBytes) == (size_t)-1)
+    if (iconv_const(type, &src, &inBytes, &dst, &outBytes) == (size_t)-1)
     {
       CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
       strDest.ReleaseBuffer();
       strDest = (const char *)strSource;
-      return;
     }
-
-    if (iconv(m_iconvUtf32ToStringCharset, NULL, NULL, &dst, &outBytes) == (size_t)-1)
+    else if (iconv(type, NULL, NULL, &dst, &outBytes) == (size_t)-1)
     {
       CLog::Log(LOGERROR, "%s failed cleanup", __FUNCTION__);
       strDest.ReleaseBuffer();
       strDest = (const char *)strSource;
-      return;
     }
-
-    strDest.ReleaseBuffer();
+    else
+      strDest.ReleaseBuffer();
   }
+
+  m_iconvUtf32ToStringCharset.Release(type, generation);
 }
 
 void CCharsetConverter::utf8ToSystem(CStdStringA& strSourceDest)
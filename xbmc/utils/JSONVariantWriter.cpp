@@ -28,14 +28,7 @@ string CJSONVariantWriter::Write(const CVariant &value, bool compact)
 {
   string output;
 
-#if YAJL_MAJOR == 2
-  yajl_gen g = yajl_gen_alloc(NULL);
-  yajl_gen_config(g, yajl_gen_beautify, compact ? 0 : 1);
-  yajl_gen_config(g, yajl_gen_indent_string, "\t");
-#else
-  yajl_gen_config conf = { compact ? 0 : 1, "\t" };
-  yajl_gen g = yajl_gen_alloc(&conf, NULL);
-#endif
+  yajl_gen g = Create(compact);
 
   // Set locale to classic ("C") to ensure valid JSON numbers
   const char *currentLocale = setlocale(LC_NUMERIC, NULL);
@@ -66,6 +59,20 @@ string CJSONVariantWriter::Write(const CVariant &value, bool compact)
   return output;
 }
 
+yajl_gen CJSONVariantWriter::Create(bool compact)
+{
+#if YAJL_MAJOR == 2
+  yajl_gen g = yajl_gen_alloc(NULL);
+  yajl_gen_config(g, yajl_gen_beautify, compact ? 0 : 1);
+  yajl_gen_config(g, yajl_gen_indent_string, "\t");
+#else
+  yajl_gen_config conf = { compact ? 0 : 1, "\t" };
+  yajl_gen g = yajl_gen_alloc(&conf, NULL);
+#endif
+
+  return g;
+}
+
 bool CJSONVariantWriter::InternalWrite(yajl_gen g, const CVariant &value)
 {
   bool success = false;
@@ -136,3 +143,89 @@ bool CJSONVariantWriter::InternalWrite(yajl_gen g, const CVariant &value)
 
   return success;
 }
+
+CJSONStreamWriter::CJSONStreamWriter(bool compact)
+  : m_gen(CJSONVariantWriter::Create(compact))
+{ }
+
+CJSONStreamWriter::~CJSONStreamWriter()
+{
+  yajl_gen_clear(m_gen);
+  yajl_gen_free(m_gen);
+}
+
+bool CJSONStreamWriter::OpenObject()
+{
+  return yajl_gen_status_ok == yajl_gen_map_open(m_gen);
+}
+
+bool CJSONStreamWriter::CloseObject()
+{
+  return yajl_gen_status_ok == yajl_gen_map_close(m_gen);
+}
+
+bool CJSONStreamWriter::OpenArray()
+{
+  return yajl_gen_status_ok == yajl_gen_array_open(m_gen);
+}
+
+bool CJSONStreamWriter::CloseArray()
+{
+  return yajl_gen_status_ok == yajl_gen_array_close(m_gen);
+}
+
+bool CJSONStreamWriter::WriteKey(const std::string &key)
+{
+#if YAJL_MAJOR == 2
+  return yajl_gen_status_ok == yajl_gen_string(m_gen, (const unsigned char*)key.c_str(), (size_t)key.length());
+#else
+  return yajl_gen_status_ok == yajl_gen_string(m_gen, (const unsigned char*)key.c_str(), key.length());
+#endif
+}
+
+bool CJSONStreamWriter::Write(const CVariant &value)
+{
+  // Set locale to classic ("C") to ensure valid JSON numbers
+  string currentLocale;
+  const char *locale = setlocale(LC_NUMERIC, NULL);
+  if (locale != NULL)
+  {
+    currentLocale = locale;
+    setlocale(LC_NUMERIC, "C");
+  }
+
+  bool success = CJSONVariantWriter::InternalWrite(m_gen, value);
+
+  // Re-set locale to what it was before using yajl
+  if (!currentLocale.empty())
+    setlocale(LC_NUMERIC, currentLocale.c_str());
+
+  return success;
+}
+
+size_t CJSONStreamWriter::GetLength() const
+{
+  const unsigned char *buffer;
+#if YAJL_MAJOR == 2
+  size_t length;
+#else
+  unsigned int length;
+#endif
+  yajl_gen_get_buf(m_gen, &buffer, &length);
+
+  return length;
+}
+
+void CJSONStreamWriter::TakeOutput(std::string &output)
+{
+  const unsigned char *buffer;
+#if YAJL_MAJOR == 2
+  size_t length;
+#else
+  unsigned int length;
+#endif
+  yajl_gen_get_buf(m_gen, &buffer, &length);
+
+  output.append((const char *)buffer, length);
+  yajl_gen_clear(m_gen);
+}
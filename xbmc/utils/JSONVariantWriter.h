@@ -31,5 +31,42 @@ class CJSONVariantWriter
 public:
   static std::string Write(const CVariant &value, bool compact);
 private:
+  friend class CJSONStreamWriter;
+
+  static yajl_gen Create(bool compact);
   static bool InternalWrite(yajl_gen g, const CVariant &value);
 };
+
+/*!
+ \brief Incremental JSON writer
+
+ Allows to write a JSON document piece by piece (e.g. one array item at
+ a time) and to take the generated output whenever it is needed so that
+ the whole document never has to be kept in memory.
+ */
+class CJSONStreamWriter
+{
+public:
+  CJSONStreamWriter(bool compact);
+  ~CJSONStreamWriter();
+
+  bool OpenObject();
+  bool CloseObject();
+  bool OpenArray();
+  bool CloseArray();
+  bool WriteKey(const std::string &key);
+  bool Write(const CVariant &value);
+
+  /*!
+   \brief Returns the size of the output which hasn't been taken yet
+   */
+  size_t GetLength() const;
+  /*!
+   \brief Appends the output which hasn't been taken yet to the given string
+   and clears it
+   */
+  void TakeOutput(std::string &output);
+
+private:
+  yajl_gen m_gen;
+};
@@ -21,6 +21,8 @@
 #include "JobManager.h"
 #include <algorithm>
 #include "threads/SingleLock.h"
+#include "threads/Atomics.h"
+#include "threads/SystemClock.h"
 #include "utils/log.h"
 
 #include "system.h"
@@ -35,9 +37,10 @@ bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
   return false;
 }
 
-CJobWorker::CJobWorker(CJobManager *manager) : CThread("Jobworker")
+CJobWorker::CJobWorker(CJobManager *manager, unsigned int lane) : CThread("Jobworker")
 {
   m_jobManager = manager;
+  m_lane = lane;
   Create(true); // start work immediately, and kill ourselves when we're done
 }
 
@@ -168,6 +171,51 @@ CJobManager::CJobManager()
 {
   m_jobCounter = 0;
   m_running = true;
+  m_scheduler = SCHEDULER_SHARED;
+  m_nextLane = 0;
+  m_idleWorkers = 0;
+  m_laneWakeups = 0;
+  m_processingCount = 0;
+  m_pausedCount = 0;
+  // one lane per worker we may ever have
+  for (unsigned int i = 0; i < GetMaxWorkers(CJob::PRIORITY_HIGH); i++)
+    m_lanes.push_back(new CWorkerLane);
+}
+
+void CJobManager::Restart()
+{
+  CSingleLock lock(m_section);
+  if (m_running)
+  {
+    CLog::Log(LOGWARNING, "%s - job manager is already running", __FUNCTION__);
+    return;
+  }
+  m_running = true;
+}
+
+bool CJobManager::SetScheduler(SCHEDULER scheduler)
+{
+  CSingleLock lock(m_section);
+  if (scheduler == m_scheduler)
+    return true;
+
+  // workers and queued jobs belong to the current scheduler, so only switch once they're gone
+  bool idle = m_workers.empty();
+  for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
+  {
+    idle &= m_jobQueue[priority].empty();
+    for (Lanes::iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
+      idle &= (*lane)->m_queued[priority] == 0;
+  }
+  if (!idle)
+  {
+    CLog::Log(LOGWARNING, "%s - unable to switch scheduler while jobs are being processed", __FUNCTION__);
+    return false;
+  }
+
+  m_scheduler = scheduler;
+  CLog::Log(LOGDEBUG, "%s - using %s scheduler", __FUNCTION__, scheduler == SCHEDULER_WORKSTEALING ? "work-stealing" : "shared");
+  return true;
 }
 
 void CJobManager::CancelJobs()
@@ -175,6 +223,9 @@ void CJobManager::CancelJobs()
   CSingleLock lock(m_section);
   m_running = false;
 
+  if (m_scheduler == SCHEDULER_WORKSTEALING)
+    CancelLaneJobs();
+
   // clear any pending jobs
   for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
   {
@@ -190,6 +241,11 @@ void CJobManager::CancelJobs()
   {
     lock.Leave();
     m_jobEvent.Set();
+    if (m_scheduler == SCHEDULER_WORKSTEALING)
+    {
+      CSingleLock wakeLock(m_laneWakeSection);
+      m_laneWakeCondition.notifyAll();
+    }
     Sleep(0); // yield after setting the event to give the workers some time to die
     lock.Enter();
   }
@@ -197,22 +253,31 @@ void CJobManager::CancelJobs()
 
 CJobManager::~CJobManager()
 {
+  for (Lanes::iterator i = m_lanes.begin(); i != m_lanes.end(); ++i)
+    delete *i;
+}
+
+unsigned int CJobManager::NextJobID()
+{
+  // increment the job counter, ensuring 0 (invalid job) is never hit
+  unsigned int id = (unsigned int)AtomicIncrement(&m_jobCounter);
+  while (id == 0)
+    id = (unsigned int)AtomicIncrement(&m_jobCounter);
+  return id;
 }
 
 unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
 {
+  if (m_scheduler == SCHEDULER_WORKSTEALING)
+    return AddLaneJob(job, callback, priority);
+
   CSingleLock lock(m_section);
 
   if (!m_running)
     return 0;
 
-  // increment the job counter, ensuring 0 (invalid job) is never hit
-  m_jobCounter++;
-  if (m_jobCounter == 0)
-    m_jobCounter++;
-
   // create a work item for this job
-  CWorkItem work(job, m_jobCounter, callback);
+  CWorkItem work(job, NextJobID(), callback);
   m_jobQueue[priority].push_back(work);
 
   StartWorkers(priority);
@@ -221,6 +286,32 @@ unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORI
 
 void CJobManager::CancelJob(unsigned int jobID)
 {
+  if (m_scheduler == SCHEDULER_WORKSTEALING)
+  {
+    for (Lanes::iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
+    {
+      CSingleLock lock((*lane)->m_section);
+      for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
+      {
+        JobQueue::iterator i = find((*lane)->m_queue[priority].begin(), (*lane)->m_queue[priority].end(), jobID);
+        if (i != (*lane)->m_queue[priority].end())
+        {
+          delete i->m_job;
+          (*lane)->m_queue[priority].erase(i);
+          AtomicDecrement(&(*lane)->m_queued[priority]);
+          return;
+        }
+      }
+      // job is in progress, so only thing to do is to remove callback
+      if ((*lane)->m_current == jobID)
+      {
+        (*lane)->m_current.Cancel();
+        return;
+      }
+    }
+    return;
+  }
+
   CSingleLock lock(m_section);
 
   // check whether we have this job in the queue
@@ -285,28 +376,38 @@ CJob *CJobManager::PopJob()
 
 void CJobManager::Pause(const std::string &pausedType)
 {
-  CSingleLock lock(m_section);
+  CSingleLock lock(m_pausedSection);
   // just push it in so we get ref counting,
   // the queue will resume when all Pause requests
   // for a given type have been UnPaused.
   m_pausedTypes.push_back(pausedType);
+  m_pausedCount = m_pausedTypes.size();
 }
 
 void CJobManager::UnPause(const std::string &pausedType)
 {
-  CSingleLock lock(m_section);
+  CSingleLock lock(m_pausedSection);
   std::vector<std::string>::iterator i = find(m_pausedTypes.begin(), m_pausedTypes.end(), pausedType);
   if (i != m_pausedTypes.end())
     m_pausedTypes.erase(i);
+  m_pausedCount = m_pausedTypes.size();
 }
 
 bool CJobManager::IsPaused(const std::string &pausedType)
 {
-  CSingleLock lock(m_section);
+  CSingleLock lock(m_pausedSection);
   std::vector<std::string>::iterator i = find(m_pausedTypes.begin(), m_pausedTypes.end(), pausedType);
   return (i != m_pausedTypes.end());
 }
 
+bool CJobManager::IsPausedType(const char *type)
+{
+  if (!m_pausedCount)
+    return false;
+  CSingleLock lock(m_pausedSection);
+  return find(m_pausedTypes.begin(), m_pausedTypes.end(), type) != m_pausedTypes.end();
+}
+
 bool CJobManager::SkipPausedJobs(CJob::PRIORITY priority)
 {
   if (priority > CJob::PRIORITY_LOW)
@@ -316,8 +417,7 @@ bool CJobManager::SkipPausedJobs(CJob::PRIORITY priority)
   JobQueue::iterator first_job = m_jobQueue[priority].begin();
   for (; first_job != m_jobQueue[priority].end(); ++first_job)
   {
-    std::vector<std::string>::iterator i = find(m_pausedTypes.begin(), m_pausedTypes.end(), first_job->m_job->GetType());
-    if (i == m_pausedTypes.end())
+    if (!IsPausedType(first_job->m_job->GetType()))
       break; // found a job that can be performed
   }
   if (first_job == m_jobQueue[priority].end())
@@ -335,6 +435,17 @@ bool CJobManager::SkipPausedJobs(CJob::PRIORITY priority)
 int CJobManager::IsProcessing(const std::string &pausedType)
 {
   int jobsMatched = 0;
+  if (m_scheduler == SCHEDULER_WORKSTEALING)
+  {
+    for (Lanes::iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
+    {
+      CSingleLock lock((*lane)->m_section);
+      if ((*lane)->m_current.m_job && pausedType == std::string((*lane)->m_current.m_job->GetType()))
+        jobsMatched++;
+    }
+    return jobsMatched;
+  }
+
   CSingleLock lock(m_section);
   for(Processing::iterator it = m_processing.begin(); it < m_processing.end(); it++)
   {
@@ -346,6 +457,9 @@ int CJobManager::IsProcessing(const std::string &pausedType)
 
 CJob *CJobManager::GetNextJob(const CJobWorker *worker)
 {
+  if (m_scheduler == SCHEDULER_WORKSTEALING)
+    return GetNextLaneJob(worker);
+
   CSingleLock lock(m_section);
   while (m_running)
   {
@@ -372,6 +486,17 @@ CJob *CJobManager::GetNextJob(const CJobWorker *worker)
 
 bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const
 {
+  if (m_scheduler == SCHEDULER_WORKSTEALING)
+  {
+    CWorkItem item(NULL, 0, NULL);
+    if (FindLane(job, item) && item.m_callback)
+    {
+      item.m_callback->OnJobProgress(item.m_id, progress, total, job);
+      return false;
+    }
+    return true; // couldn't find the job, or it's been cancelled
+  }
+
   CSingleLock lock(m_section);
   // find the job in the processing queue, and check whether it's cancelled (no callback)
   Processing::const_iterator i = find(m_processing.begin(), m_processing.end(), job);
@@ -390,6 +515,31 @@ bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const
 
 void CJobManager::OnJobComplete(bool success, CJob *job)
 {
+  if (m_scheduler == SCHEDULER_WORKSTEALING)
+  {
+    CWorkItem item(NULL, 0, NULL);
+    CWorkerLane *lane = FindLane(job, item);
+    if (!lane)
+      return;
+    // tell any listeners we're done with the job, then delete it
+    try
+    {
+      if (item.m_callback)
+        item.m_callback->OnJobComplete(item.m_id, success, item.m_job);
+    }
+    catch (...)
+    {
+      CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, item.m_job->GetType());
+    }
+    {
+      CSingleLock lock(lane->m_section);
+      lane->m_current = CWorkItem(NULL, 0, NULL);
+    }
+    AtomicDecrement(&m_processingCount);
+    item.FreeJob();
+    return;
+  }
+
   CSingleLock lock(m_section);
   // remove the job from the processing queue
   Processing::iterator i = find(m_processing.begin(), m_processing.end(), job);
@@ -422,7 +572,11 @@ void CJobManager::RemoveWorker(const CJobWorker *worker)
   // remove our worker
   Workers::iterator i = find(m_workers.begin(), m_workers.end(), worker);
   if (i != m_workers.end())
+  {
+    if (m_scheduler == SCHEDULER_WORKSTEALING)
+      m_lanes[worker->m_lane]->m_inUse = false;
     m_workers.erase(i); // workers auto-delete
+  }
 }
 
 unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority) const
@@ -430,3 +584,229 @@ unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority) const
   static const unsigned int max_workers = 5;
   return max_workers - (CJob::PRIORITY_HIGH - priority);
 }
+
+unsigned int CJobManager::AddLaneJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
+{
+  if (!m_running)
+    return 0;
+
+  // jobs queued from within a job stay in that worker's lane, as they're often related
+  // to the job being processed.  Everything else is spread over the lanes round-robin.
+  unsigned int index;
+  CJobWorker *worker = dynamic_cast<CJobWorker*>(CThread::GetCurrentThread());
+  if (worker && worker->m_jobManager == this)
+    index = worker->m_lane;
+  else
+    index = (unsigned int)AtomicIncrement(&m_nextLane) % m_lanes.size();
+
+  CWorkItem work(job, NextJobID(), callback);
+  {
+    CWorkerLane *lane = m_lanes[index];
+    CSingleLock lock(lane->m_section);
+    // CancelJobs() clears the lanes after resetting m_running, so check again while we hold the lane
+    if (!m_running)
+      return 0;
+    lane->m_queue[priority].push_back(work);
+    AtomicIncrement(&lane->m_queued[priority]);
+  }
+
+  StartLaneWorkers(priority);
+  return work.m_id;
+}
+
+void CJobManager::StartLaneWorkers(CJob::PRIORITY priority)
+{
+  // wake a sleeping worker for each queued job. Whichever wakes up will steal the job if needed.
+  long queued = QueuedLaneJobs();
+  if (WakeLaneWorkers(queued) >= queued)
+    return;
+
+  CSingleLock lock(m_section);
+
+  // check how many free threads we have
+  if ((unsigned int)m_processingCount >= GetMaxWorkers(priority))
+    return;
+
+  // find a lane for a new worker. If there are none left, all workers are alive and
+  // will pick the job up when they're next looking for work.
+  for (unsigned int i = 0; i < m_lanes.size(); i++)
+  {
+    if (!m_lanes[i]->m_inUse)
+    {
+      m_lanes[i]->m_inUse = true;
+      m_workers.push_back(new CJobWorker(this, i));
+      return;
+    }
+  }
+}
+
+long CJobManager::QueuedLaneJobs() const
+{
+  long queued = 0;
+  for (Lanes::const_iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
+  {
+    for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
+      queued += (*lane)->m_queued[priority];
+  }
+  return queued;
+}
+
+long CJobManager::WakeLaneWorkers(long jobs)
+{
+  CSingleLock lock(m_laneWakeSection);
+
+  // wake-ups handed out before cover some of the jobs already. A worker that found a job
+  // after announcing it was idle leaves its wake-up behind, so never count more than are idle.
+  long idle = AtomicAdd(&m_idleWorkers, 0);
+  while (m_laneWakeups < std::min(jobs, idle))
+  {
+    m_laneWakeups++;
+    m_laneWakeCondition.notify();
+  }
+  return std::min(m_laneWakeups, idle);
+}
+
+bool CJobManager::WaitForLaneWakeup(unsigned int milliSeconds)
+{
+  CSingleLock lock(m_laneWakeSection);
+  XbmcThreads::EndTime timeout(milliSeconds);
+  while (m_laneWakeups == 0 && m_running)
+  {
+    if (timeout.IsTimePast())
+      return false;
+    m_laneWakeCondition.wait(lock, timeout.MillisLeft());
+  }
+  if (m_laneWakeups > 0)
+    m_laneWakeups--;
+  return true;
+}
+
+bool CJobManager::ReserveLaneSlot(CJob::PRIORITY priority)
+{
+  const long maxWorkers = GetMaxWorkers(priority);
+  while (true)
+  {
+    long processing = m_processingCount;
+    if (processing >= maxWorkers)
+      return false;
+    if (cas(&m_processingCount, processing, processing + 1) == processing)
+      return true;
+  }
+}
+
+bool CJobManager::TakeLaneJob(CWorkerLane *lane, CJob::PRIORITY priority, CWorkItem &item)
+{
+  if (!lane->m_queued[priority])
+    return false;
+
+  CSingleLock lock(lane->m_section);
+  JobQueue &queue = lane->m_queue[priority];
+  JobQueue::iterator job = queue.begin();
+  // only low priority jobs may be paused - take the first one that isn't
+  if (priority == CJob::PRIORITY_LOW)
+  {
+    while (job != queue.end() && IsPausedType(job->m_job->GetType()))
+      ++job;
+  }
+  if (job == queue.end())
+    return false;
+
+  item = *job;
+  queue.erase(job);
+  AtomicDecrement(&lane->m_queued[priority]);
+  return true;
+}
+
+CJob *CJobManager::PopLaneJob(unsigned int lane)
+{
+  for (int priority = CJob::PRIORITY_HIGH; priority >= CJob::PRIORITY_LOW; --priority)
+  {
+    // lower priorities have less headroom, so if there's no room at this one there's none below
+    if (!ReserveLaneSlot(CJob::PRIORITY(priority)))
+      return NULL;
+
+    // our own lane first, then steal from the others
+    CWorkItem job(NULL, 0, NULL);
+    for (unsigned int i = 0; i < m_lanes.size(); i++)
+    {
+      if (TakeLaneJob(m_lanes[(lane + i) % m_lanes.size()], CJob::PRIORITY(priority), job))
+      {
+        CSingleLock lock(m_lanes[lane]->m_section);
+        m_lanes[lane]->m_current = job;
+        job.m_job->m_callback = this;
+        return job.m_job;
+      }
+    }
+    AtomicDecrement(&m_processingCount);
+  }
+  return NULL;
+}
+
+CJob *CJobManager::GetNextLaneJob(const CJobWorker *worker)
+{
+  while (m_running)
+  {
+    // grab a job if we have one
+    CJob *job = PopLaneJob(worker->m_lane);
+    if (job)
+      return job;
+
+    // announce that we're about to sleep, then look again so that a job queued
+    // before the announcement was visible isn't missed
+    AtomicIncrement(&m_idleWorkers);
+    job = PopLaneJob(worker->m_lane);
+    if (job)
+    {
+      AtomicDecrement(&m_idleWorkers);
+      return job;
+    }
+    // no jobs are left - sleep for 30 seconds to allow new jobs to come in
+    bool newJob = WaitForLaneWakeup(30000);
+    AtomicDecrement(&m_idleWorkers);
+    if (!newJob)
+      break;
+  }
+  // retire while holding m_section, so that StartLaneWorkers either sees a job
+  // queued during the timeout here, or sees that we're gone and starts a new worker
+  CSingleLock lock(m_section);
+  if (m_running)
+  {
+    CJob *job = PopLaneJob(worker->m_lane);
+    if (job)
+      return job;
+  }
+  // have no jobs
+  RemoveWorker(worker);
+  return NULL;
+}
+
+CJobManager::CWorkerLane *CJobManager::FindLane(const CJob *job, CWorkItem &item) const
+{
+  for (Lanes::const_iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
+  {
+    CSingleLock lock((*lane)->m_section);
+    if ((*lane)->m_current.m_job && (*lane)->m_current == job)
+    {
+      item = (*lane)->m_current;
+      return *lane;
+    }
+  }
+  return NULL;
+}
+
+void CJobManager::CancelLaneJobs()
+{
+  for (Lanes::iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
+  {
+    CSingleLock lock((*lane)->m_section);
+    // clear any pending jobs
+    for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
+    {
+      for_each((*lane)->m_queue[priority].begin(), (*lane)->m_queue[priority].end(), mem_fun_ref(&CWorkItem::FreeJob));
+      (*lane)->m_queue[priority].clear();
+      (*lane)->m_queued[priority] = 0;
+    }
+    // cancel any callback on the job still processing
+    (*lane)->m_current.Cancel();
+  }
+}
@@ -22,6 +22,7 @@
 #include <queue>
 #include <vector>
 #include <string>
+#include "threads/Condition.h"
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
 #include "Job.h"
@@ -31,12 +32,14 @@ class CJobManager;
 class CJobWorker : public CThread
 {
 public:
-  CJobWorker(CJobManager *manager);
+  CJobWorker(CJobManager *manager, unsigned int lane = 0);
   virtual ~CJobWorker();
 
   void Process();
 private:
+  friend class CJobManager;
   CJobManager  *m_jobManager;
+  unsigned int  m_lane;        ///< the work-stealing lane owned by this worker
 };
 
 /*!
@@ -194,6 +197,16 @@ class CJobManager
   };
 
 public:
+  /*!
+   \brief Scheduling strategies available to the job manager.
+   \sa SetScheduler()
+   */
+  enum SCHEDULER
+  {
+    SCHEDULER_SHARED = 0,   ///< one queue per priority shared by all workers and guarded by a single lock
+    SCHEDULER_WORKSTEALING  ///< a local queue per worker, idle workers steal jobs from the others
+  };
+
   /*!
    \brief The only way through which the global instance of the CJobManager should be accessed.
    \return the global instance.
@@ -224,6 +237,30 @@ public:
    */
   void CancelJobs();
 
+  /*!
+   \brief Re-start accepting jobs again
+   Called after calling CancelJobs() to allow this manager to accept more jobs.
+   \sa CancelJobs()
+   */
+  void Restart();
+
+  /*!
+   \brief Switch the scheduling strategy used to distribute jobs to the workers.
+   Both strategies honour job priorities, the worker headroom kept free for higher
+   priority jobs, paused job types and job cancellation.  The strategy can only be
+   switched while no workers are alive, e.g. at startup or after CancelJobs().
+   \param scheduler the strategy to use.
+   \return true if the strategy is now in use, false if the manager was busy.
+   \sa SCHEDULER, GetScheduler()
+   */
+  bool SetScheduler(SCHEDULER scheduler);
+
+  /*!
+   \brief Retrieve the scheduling strategy currently in use.
+   \sa SetScheduler()
+   */
+  SCHEDULER GetScheduler() const { return m_scheduler; };
+
   /*!
    \brief Suspends queueing of the specified type until unpaused
    Useful to (for ex) stop queuing thumb jobs during video playback. Only affects PRIORITY_LOW or lower.
@@ -303,6 +340,8 @@ private:
   void StartWorkers(CJob::PRIORITY priority);
   void RemoveWorker(const CJobWorker *worker);
   unsigned int GetMaxWorkers(CJob::PRIORITY priority) const;
+  unsigned int NextJobID();
+  bool IsPausedType(const char *type);
 
   /*! \brief skips over any paused jobs of given priority.
    Moves any paused jobs at the front of the queue to the back of the
@@ -312,18 +351,80 @@ private:
    */
   bool SkipPausedJobs(CJob::PRIORITY priority);
 
-  unsigned int m_jobCounter;
-
   typedef std::deque<CWorkItem>    JobQueue;
   typedef std::vector<CWorkItem>   Processing;
   typedef std::vector<CJobWorker*> Workers;
 
+  /*! \brief Per-worker job queues used by the work-stealing scheduler.
+   Each lane is owned by at most one worker at a time, which processes the jobs in its
+   own lane first and steals from the other lanes when its own is empty. Lanes outlive
+   their workers so that queued jobs are never lost when a worker retires.
+   */
+  class CWorkerLane
+  {
+  public:
+    CWorkerLane() : m_current(NULL, 0, NULL), m_inUse(false)
+    {
+      for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
+        m_queued[priority] = 0;
+    };
+    CCriticalSection m_section;
+    JobQueue         m_queue[CJob::PRIORITY_HIGH+1];
+    volatile long    m_queued[CJob::PRIORITY_HIGH+1]; ///< lock-free hint of the queue sizes
+    CWorkItem        m_current;                       ///< job being processed by the owning worker
+    bool             m_inUse;                         ///< guarded by CJobManager::m_section
+  };
+  typedef std::vector<CWorkerLane*> Lanes;
+
+  /*! \name Work-stealing scheduler
+   Counterparts of the functions above used when m_scheduler is SCHEDULER_WORKSTEALING.
+   None of them hold m_section on the fast path.
+   */
+  //@{
+  unsigned int AddLaneJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority);
+  void StartLaneWorkers(CJob::PRIORITY priority);
+  CJob *GetNextLaneJob(const CJobWorker *worker);
+  long QueuedLaneJobs() const;
+
+  /*! \brief Wake idle workers for queued jobs, one worker per job
+   \param jobs the number of queued jobs.
+   \return the number of those jobs a woken worker is on its way to
+   */
+  long WakeLaneWorkers(long jobs);
+  bool WaitForLaneWakeup(unsigned int milliSeconds);
+
+  /*! \brief Pop the next job to process into the given lane
+   Jobs are taken in priority order, from the lane itself first and then stolen from the
+   other lanes. Lower priority jobs are only taken if there is headroom for them.
+   \param lane the lane of the worker requesting a job.
+   \return the job to process, NULL if no jobs are available
+   */
+  CJob *PopLaneJob(unsigned int lane);
+  bool TakeLaneJob(CWorkerLane *lane, CJob::PRIORITY priority, CWorkItem &item);
+  bool ReserveLaneSlot(CJob::PRIORITY priority);
+  CWorkerLane *FindLane(const CJob *job, CWorkItem &item) const;
+  void CancelLaneJobs();
+  //@}
+
+  volatile long m_jobCounter;
+
   JobQueue   m_jobQueue[CJob::PRIORITY_HIGH+1];
   Processing m_processing;
   Workers    m_workers;
 
+  SCHEDULER     m_scheduler;
+  Lanes         m_lanes;
+  volatile long m_nextLane;        ///< round-robin counter for jobs queued from outside the workers
+  volatile long m_idleWorkers;     ///< workers waiting for a wake-up in work-stealing mode
+  long          m_laneWakeups;     ///< wake-ups handed to idle workers and not yet taken, guarded by m_laneWakeSection
+  CCriticalSection m_laneWakeSection;
+  XbmcThreads::ConditionVariable m_laneWakeCondition;
+  volatile long m_processingCount; ///< jobs being processed in work-stealing mode
+  volatile long m_pausedCount;     ///< size of m_pausedTypes, read without locking
+
   CCriticalSection m_section;
   CEvent           m_jobEvent;
-  bool             m_running;
+  volatile bool    m_running;
+  CCriticalSection m_pausedSection;
   std::vector<std::string>  m_pausedTypes;
 };
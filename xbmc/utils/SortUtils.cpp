@@ -411,111 +411,67 @@ string ByChannel(SortAttribute attributes, const SortItem &values)
   return values.at(FieldChannelName).asString();
 }
 
-bool preliminarySort(const SortItem &left, const SortItem &right, bool handleFolder, bool &result, std::wstring &labelLeft, std::wstring &labelRight)
+/*! \brief Everything needed to order a single item, extracted once before sorting
+ so that comparisons don't have to look anything up in the item's field map.
+ */
+typedef struct SortKey
 {
-  // make sure both items have the necessary data to do the sorting
-  SortItem::const_iterator itLeftSort, itRightSort;
-  if ((itLeftSort = left.find(FieldSort)) == left.end())
-  {
-    result = false;
-    return true;
-  }
-  if ((itRightSort = right.find(FieldSort)) == right.end())
-  {
-    result = true;
-    return true;
-  }
+  CStdStringW label;   // label prepared by the SortPreparator
+  SortSpecial special; // whether the item is sorted on top or bottom regardless of its label
+  bool folder;         // items that don't say whether they are a folder sort as files
+  size_t index;        // position before sorting, used to keep the sort stable
+} SortKey;
 
-  // look at special sorting behaviour
-  SortItem::const_iterator itLeft, itRight;
-  SortSpecial leftSortSpecial = SortSpecialNone;
-  SortSpecial rightSortSpecial = SortSpecialNone;
-  if ((itLeft = left.find(FieldSortSpecial)) != left.end() && itLeft->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    leftSortSpecial = (SortSpecial)itLeft->second.asInteger();
-  if ((itRight = right.find(FieldSortSpecial)) != right.end() && itRight->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    rightSortSpecial = (SortSpecial)itRight->second.asInteger();
-  
-  // one has a special sort
-  if (leftSortSpecial != rightSortSpecial)
-  {
-    // left should be sorted on top
-    // or right should be sorted on bottom
-    // => left is sorted above right
-    if (leftSortSpecial == SortSpecialOnTop ||
-        rightSortSpecial == SortSpecialOnBottom)
-    {
-      result = true;
-      return true;
-    }
-    
-    // otherwise right is sorted above left
-    result = false;
-    return true;
-  }
-  // both have either sort on top or sort on bottom -> leave as-is
-  else if (leftSortSpecial != SortSpecialNone && leftSortSpecial == rightSortSpecial)
+class SortKeyCompare
+{
+public:
+  SortKeyCompare(bool descending, bool handleFolder)
+    : m_descending(descending), m_handleFolder(handleFolder)
+  { }
+
+  /*! \brief Compare two keys, ordering items with special sorting and folders as required.
+   Items that compare equal keep their original order.
+   */
+  bool operator()(const SortKey *left, const SortKey *right) const
   {
-    result = false;
-    return true;
+    int result = Compare(*left, *right);
+    if (result != 0)
+      return result < 0;
+    return left->index < right->index;
   }
 
-  if (handleFolder)
+private:
+  int Compare(const SortKey &left, const SortKey &right) const
   {
-    itLeft = left.find(FieldFolder);
-    itRight = right.find(FieldFolder);
-    if (itLeft != left.end() && itRight != right.end() &&
-        itLeft->second.asBoolean() != itRight->second.asBoolean())
+    // one has a special sort
+    if (left.special != right.special)
     {
-      result = itLeft->second.asBoolean();
-      return true;
+      // left should be sorted on top
+      // or right should be sorted on bottom
+      // => left is sorted above right
+      if (left.special == SortSpecialOnTop ||
+          right.special == SortSpecialOnBottom)
+        return -1;
+
+      // otherwise right is sorted above left
+      return 1;
     }
-  }
-
-  labelLeft = itLeftSort->second.asWideString();
-  labelRight = itRightSort->second.asWideString();
-
-  return false;
-}
-
-bool SorterAscending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
-
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
+    // both have either sort on top or sort on bottom -> leave as-is
+    else if (left.special != SortSpecialNone)
+      return 0;
 
-bool SorterDescending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
-
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
-}
-
-bool SorterIgnoreFoldersAscending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+    if (m_handleFolder && left.folder != right.folder)
+      return left.folder ? -1 : 1;
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
-
-bool SorterIgnoreFoldersDescending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+    int64_t result = StringUtils::AlphaNumericCompare(left.label.c_str(), right.label.c_str());
+    if (m_descending)
+      result = -result;
+    return result < 0 ? -1 : (result > 0 ? 1 : 0);
+  }
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
-}
+  bool m_descending;
+  bool m_handleFolder;
+};
 
 map<SortBy, SortUtils::SortPreparator> fillPreparators()
 {
@@ -650,25 +606,61 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
     SortPreparator preparator = getPreparator(sortBy);
     if (preparator != NULL)
     {
-      Fields sortingFields = GetFieldsForSorting(sortBy);
+      const Fields &sortingFields = GetFieldsForSorting(sortBy);
 
-      // Prepare the string used for sorting and store it under FieldSort
-      for (SortItems::iterator item = items.begin(); item != items.end(); item++)
+      // Prepare the keys used for sorting once, and store the label under FieldSort
+      vector<SortKey> keys(items.size());
+      for (size_t i = 0; i < items.size(); i++)
       {
+        SortItem &item = items[i];
         // add all fields to the item that are required for sorting if they are currently missing
         for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); field++)
         {
-          if (item->find(*field) == item->end())
-            item->insert(pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+          if (item.find(*field) == item.end())
+            item.insert(pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
         }
 
-        CStdStringW sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, *item), sortLabel, false);
-        item->insert(pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
+        SortKey &key = keys[i];
+        key.index = i;
+        g_charsetConverter.utf8ToW(preparator(attributes, item), key.label, false);
+        item[FieldSort] = CVariant(key.label);
+
+        key.special = SortSpecialNone;
+        SortItem::const_iterator it = item.find(FieldSortSpecial);
+        if (it != item.end() && it->second.asInteger() <= (int64_t)SortSpecialOnBottom)
+          key.special = (SortSpecial)it->second.asInteger();
+
+        it = item.find(FieldFolder);
+        key.folder = it != item.end() && it->second.asBoolean();
       }
 
-      // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
+      // Do the sorting on the keys, only ordering the requested range if limits are given
+      vector<const SortKey*> order(keys.size());
+      for (size_t i = 0; i < keys.size(); i++)
+        order[i] = &keys[i];
+
+      size_t start = 0, end = order.size();
+      if (limitStart > 0 && (size_t)limitStart < order.size())
+      {
+        start = limitStart;
+        limitEnd -= limitStart;
+      }
+      if (limitEnd > 0 && (size_t)limitEnd < order.size() - start)
+        end = start + limitEnd;
+
+      SortKeyCompare compare(sortOrder == SortOrderDescending, !(attributes & SortAttributeIgnoreFolders));
+      if (end < order.size())
+        std::nth_element(order.begin(), order.begin() + end, order.end(), compare);
+      if (start > 0)
+        std::nth_element(order.begin(), order.begin() + start, order.begin() + end, compare);
+      std::sort(order.begin() + start, order.begin() + end, compare);
+
+      // apply the new order, swapping the items rather than copying them
+      SortItems sorted(end - start);
+      for (size_t i = start; i < end; i++)
+        sorted[i - start].swap(items[order[i]->index]);
+      items.swap(sorted);
+      return;
     }
   }
 
@@ -716,14 +708,6 @@ const SortUtils::SortPreparator& SortUtils::getPreparator(SortBy sortBy)
   return m_preparators[SortByNone];
 }
 
-SortUtils::Sorter SortUtils::getSorter(SortOrder sortOrder, SortAttribute attributes)
-{
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIgnoreFoldersDescending : SorterIgnoreFoldersAscending;
-
-  return sortOrder == SortOrderDescending ? SorterDescending : SorterAscending;
-}
-
 const Fields& SortUtils::GetFieldsForSorting(SortBy sortBy)
 {
   map<SortBy, Fields>::const_iterator it = m_sortingFields.find(sortBy);
@@ -38,6 +38,9 @@ public:
   bool Search(const CStdString &strHaystack) const;
   bool IsValid(void) const;
 
+  const std::vector<CStdString> &AndTerms(void) const { return m_AND; }
+  const std::vector<CStdString> &OrTerms(void) const { return m_OR; }
+
 private:
   void GetAndCutNextTerm(CStdString &strSearchTerm, CStdString &strNextTerm);
   void ExtractSearchTerms(const CStdString &strSearchTerm, TextSearchDefault defaultSearchMode);
@@ -25,7 +25,12 @@
 #include "threads/CriticalSection.h"
 #include "threads/SingleLock.h"
 #include "threads/Thread.h"
+#include "threads/Atomics.h"
 #include "utils/StdString.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <exception>
 #if defined(TARGET_ANDROID)
 #include "android/activity/XBMCApp.h"
 #elif defined(TARGET_WINDOWS)
@@ -38,10 +43,58 @@
 #define m_repeatLogLevel XBMC_GLOBAL_USE(CLog::CLogGlobals).m_repeatLogLevel
 #define m_repeatLine XBMC_GLOBAL_USE(CLog::CLogGlobals).m_repeatLine
 #define m_logLevel XBMC_GLOBAL_USE(CLog::CLogGlobals).m_logLevel
+#define m_async XBMC_GLOBAL_USE(CLog::CLogGlobals).m_async
+#define m_pushing XBMC_GLOBAL_USE(CLog::CLogGlobals).m_pushing
+#define m_queueHead XBMC_GLOBAL_USE(CLog::CLogGlobals).m_queueHead
+#define m_pool XBMC_GLOBAL_USE(CLog::CLogGlobals).m_pool
+#define m_poolNext XBMC_GLOBAL_USE(CLog::CLogGlobals).m_poolNext
+#define m_queuedEvent XBMC_GLOBAL_USE(CLog::CLogGlobals).m_queuedEvent
+#define m_writer XBMC_GLOBAL_USE(CLog::CLogGlobals).m_writer
+
+#if defined(TARGET_WINDOWS)
+#define vsnprintf _vsnprintf
+#endif
+
+// lines that fit are formatted on the stack of the calling thread
+#define LOG_FORMAT_BUFFER 2048
+
+// records preallocated for async logging, longer lines are allocated as they come
+#define LOG_POOL_RECORDS  256
+#define LOG_RECORD_SIZE   512
+
+// the handler that was installed before async logging was turned on
+static std::terminate_handler previousTerminate = NULL;
 
 static char levelNames[][8] =
 {"DEBUG", "INFO", "NOTICE", "WARNING", "ERROR", "SEVERE", "FATAL", "NONE"};
 
+struct CLog::LogRecord
+{
+  LogRecord*    next;
+  volatile long inUse;     // pooled records are taken with cas and handed back once written
+  bool          pooled;
+  int           loglevel;
+  SYSTEMTIME    time;
+  uint64_t      threadId;
+  char          text[1];
+};
+
+class CLogWriter : public CThread
+{
+public:
+  CLogWriter() : CThread("LogWriter") {}
+
+protected:
+  virtual void Process()
+  {
+    while (!m_bStop)
+    {
+      if (!CLog::WriteQueued())
+        m_queuedEvent.WaitMSec(1000);
+    }
+  }
+};
+
 CLog::CLog()
 {}
 
@@ -50,7 +103,8 @@ CLog::~CLog()
 
 void CLog::Close()
 {
-  
+  SetAsync(false);
+
   CSingleLock waitLock(critSec);
   if (m_file)
   {
@@ -62,76 +116,262 @@ void CLog::Close()
 
 void CLog::Log(int loglevel, const char *format, ... )
 {
-  static const char* prefixFormat = "%02.2d:%02.2d:%02.2d T:%"PRIu64" %7s: ";
-  CSingleLock waitLock(critSec);
 #if !(defined(_DEBUG) || defined(PROFILE))
-  if (m_logLevel > LOG_LEVEL_NORMAL ||
-     (m_logLevel > LOG_LEVEL_NONE && loglevel >= LOGNOTICE))
+  if (m_logLevel <= LOG_LEVEL_NORMAL &&
+     (m_logLevel <= LOG_LEVEL_NONE || loglevel < LOGNOTICE))
+    return;
 #endif
-  {
-    if (!m_file)
-      return;
 
-    SYSTEMTIME time;
-    GetLocalTime(&time);
+  char buffer[LOG_FORMAT_BUFFER];
+  CStdString strData;
+  const char *text = buffer;
 
-    CStdString strPrefix, strData;
+  va_list va;
+  va_start(va, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, va);
+  va_end(va);
 
-    strData.reserve(16384);
-    va_list va;
+  if (length < 0 || length >= (int)sizeof(buffer))
+  {
     va_start(va, format);
-    strData.FormatV(format,va);
+    strData.FormatV(format, va);
     va_end(va);
+    text = strData.c_str();
+    length = strData.length();
+  }
 
-    if (m_repeatLogLevel == loglevel && m_repeatLine == strData)
-    {
-      m_repeatCount++;
-      return;
-    }
-    else if (m_repeatCount)
+  // SetAsync(false) waits for m_pushing to drop before it writes what is left
+  AtomicIncrement(&m_pushing);
+  if (m_async)
+  {
+    LogRecord *record = AllocRecord(length);
+    if (record)
     {
-      CStdString strData2;
-      strPrefix.Format(prefixFormat, time.wHour, time.wMinute, time.wSecond, (uint64_t)CThread::GetCurrentThreadId(), levelNames[m_repeatLogLevel]);
-
-      strData2.Format("Previous line repeats %d times." LINE_ENDING, m_repeatCount);
-      fputs(strPrefix.c_str(), m_file);
-      fputs(strData2.c_str(), m_file);
-      OutputDebugString(strData2);
-      m_repeatCount = 0;
+      record->loglevel = loglevel;
+      record->threadId = (uint64_t)CThread::GetCurrentThreadId();
+      GetLocalTime(&record->time);
+      memcpy(record->text, text, length + 1);
+      Push(record);
     }
-    
-    m_repeatLine      = strData;
-    m_repeatLogLevel  = loglevel;
+    AtomicDecrement(&m_pushing);
 
-    unsigned int length = 0;
-    while ( length != strData.length() )
-    {
-      length = strData.length();
-      strData.TrimRight(" ");
-      strData.TrimRight('\n');
-      strData.TrimRight("\r");
-    }
+    // get the lines leading up to an error on disk, in case we're about to crash
+    if (record && loglevel >= LOGERROR)
+      Flush();
+    return;
+  }
+  AtomicDecrement(&m_pushing);
 
-    if (!length)
-      return;
-    
-    OutputDebugString(strData);
+  CSingleLock waitLock(critSec);
+  if (!m_file)
+    return;
+
+  LogRecord record;
+  record.loglevel = loglevel;
+  record.threadId = (uint64_t)CThread::GetCurrentThreadId();
+  GetLocalTime(&record.time);
+
+  std::string line(text, length);
+  WriteLine(record, line);
+  fflush(m_file);
+}
+
+void CLog::WriteLine(const LogRecord& record, std::string& strData)
+{
+  static const char* prefixFormat = "%02.2d:%02.2d:%02.2d T:%"PRIu64" %7s: ";
+  const SYSTEMTIME &time = record.time;
+  int loglevel = record.loglevel;
+  CStdString strPrefix;
+
+  if (m_repeatLogLevel == loglevel && m_repeatLine == strData)
+  {
+    m_repeatCount++;
+    return;
+  }
+  else if (m_repeatCount)
+  {
+    CStdString strData2;
+    strPrefix.Format(prefixFormat, time.wHour, time.wMinute, time.wSecond, record.threadId, levelNames[m_repeatLogLevel]);
+
+    strData2.Format("Previous line repeats %d times." LINE_ENDING, m_repeatCount);
+    fputs(strPrefix.c_str(), m_file);
+    fputs(strData2.c_str(), m_file);
+    OutputDebugString(strData2);
+    m_repeatCount = 0;
+  }
+
+  m_repeatLine      = strData;
+  m_repeatLogLevel  = loglevel;
 
-    /* fixup newline alignment, number of spaces should equal prefix length */
-    strData.Replace("\n", LINE_ENDING"                                            ");
-    strData += LINE_ENDING;
+  size_t length = strData.find_last_not_of(" \r\n");
+  if (length == std::string::npos)
+    return;
+  strData.erase(length + 1);
 
-    strPrefix.Format(prefixFormat, time.wHour, time.wMinute, time.wSecond, (uint64_t)CThread::GetCurrentThreadId(), levelNames[loglevel]);
+  OutputDebugString(strData);
+
+  /* fixup newline alignment, number of spaces should equal prefix length */
+  static const std::string newLine = LINE_ENDING"                                            ";
+  for (size_t pos = 0; (pos = strData.find('\n', pos)) != std::string::npos; pos += newLine.length())
+    strData.replace(pos, 1, newLine);
+  strData += LINE_ENDING;
+
+  strPrefix.Format(prefixFormat, time.wHour, time.wMinute, time.wSecond, record.threadId, levelNames[loglevel]);
 
 //print to adb
 #if defined(TARGET_ANDROID) && defined(_DEBUG)
   CXBMCApp::android_printf("%s%s",strPrefix.c_str(), strData.c_str());
 #endif
 
-    fputs(strPrefix.c_str(), m_file);
-    fputs(strData.c_str(), m_file);
+  fputs(strPrefix.c_str(), m_file);
+  fputs(strData.c_str(), m_file);
+}
+
+/* takes a free record from the pool, or allocates one if the line doesn't fit or the pool is queued up */
+CLog::LogRecord* CLog::AllocRecord(int length)
+{
+  if (offsetof(LogRecord, text) + length + 1 <= LOG_RECORD_SIZE)
+  {
+    for (int i = 0; i < LOG_POOL_RECORDS; i++)
+    {
+      unsigned long slot = (unsigned long)AtomicIncrement(&m_poolNext) % LOG_POOL_RECORDS;
+      LogRecord* record = (LogRecord*)(m_pool + slot * LOG_RECORD_SIZE);
+      if (!record->inUse && cas(&record->inUse, 0, 1) == 0)
+        return record;
+    }
+  }
+
+  LogRecord* record = (LogRecord*)malloc(offsetof(LogRecord, text) + length + 1);
+  if (record)
+    record->pooled = false;
+  return record;
+}
+
+void CLog::FreeRecord(LogRecord* record)
+{
+  if (record->pooled)
+    cas(&record->inUse, 1, 0);
+  else
+    free(record);
+}
+
+/* queues a record for the writer. records are only ever taken off all at once,
+   so pushing with cas is safe even when a record is reused */
+void CLog::Push(LogRecord* record)
+{
+  void* head;
+  do
+  {
+    head = m_queueHead;
+    record->next = (LogRecord*)head;
+  } while (casPointer(&m_queueHead, head, record) != head);
+
+  // only wake the writer if it may have run out of work
+  if (!head)
+    m_queuedEvent.Set();
+}
+
+/* writes everything that was queued so far, returns false if the queue was empty */
+bool CLog::WriteQueued()
+{
+  CSingleLock waitLock(critSec);
+
+  void* head;
+  do
+  {
+    head = m_queueHead;
+  } while (head && casPointer(&m_queueHead, head, NULL) != head);
+
+  if (!head)
+    return false;
+
+  // the queue is newest first, restore the order the lines were logged in
+  LogRecord* record = NULL;
+  for (LogRecord* next = (LogRecord*)head; next;)
+  {
+    LogRecord* current = next;
+    next = current->next;
+    current->next = record;
+    record = current;
+  }
+
+  while (record)
+  {
+    if (m_file)
+    {
+      std::string strData(record->text);
+      WriteLine(*record, strData);
+    }
+    LogRecord* next = record->next;
+    FreeRecord(record);
+    record = next;
+  }
+
+  if (m_file)
     fflush(m_file);
+
+  return true;
+}
+
+void CLog::Flush()
+{
+  while (WriteQueued());
+}
+
+void CLog::SetAsync(bool async)
+{
+  CSingleLock waitLock(critSec);
+  if (async == (m_writer != NULL))
+    return;
+
+  if (async)
+  {
+    m_pool = (char*)malloc(LOG_POOL_RECORDS * LOG_RECORD_SIZE);
+    if (!m_pool)
+      return;
+    for (int i = 0; i < LOG_POOL_RECORDS; i++)
+    {
+      LogRecord* record = (LogRecord*)(m_pool + i * LOG_RECORD_SIZE);
+      record->inUse = 0;
+      record->pooled = true;
+    }
+
+    m_writer = new CLogWriter();
+    m_writer->Create();
+    previousTerminate = std::set_terminate(OnTerminate);
+    cas(&m_async, 0, 1);
+    return;
   }
+
+  // from here on Log writes on the calling thread, once the lines being pushed are queued
+  cas(&m_async, 1, 0);
+  while (m_pushing)
+    XbmcThreads::ThreadSleep(1);
+
+  CLogWriter* writer = m_writer;
+  char* pool = m_pool;
+  m_writer = NULL;
+  m_pool = NULL;
+  std::set_terminate(previousTerminate);
+  waitLock.Leave();
+
+  writer->StopThread(false);
+  m_queuedEvent.Set();
+  writer->StopThread(true);
+  delete writer;
+
+  // every pooled record is handed back once the queue is written
+  Flush();
+  free(pool);
+}
+
+/* an uncaught exception is about to end the process, get the queued lines on disk */
+void CLog::OnTerminate()
+{
+  Flush();
+  if (previousTerminate)
+    previousTerminate();
+  abort();
 }
 
 bool CLog::Init(const char* path)
@@ -25,6 +25,7 @@
 
 #include "commons/ilog.h"
 #include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include "utils/GlobalsHandling.h"
 
 #ifdef __GNUC__
@@ -33,20 +34,34 @@
 #define ATTRIB_LOG_FORMAT
 #endif
 
+class CLogWriter;
+
 class CLog
 {
 public:
+  struct LogRecord;
 
   class CLogGlobals
   {
   public:
-    CLogGlobals() : m_file(NULL), m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG) {}
+    CLogGlobals() : m_file(NULL), m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG),
+                    m_async(0), m_pushing(0), m_queueHead(NULL), m_pool(NULL), m_poolNext(0), m_writer(NULL) {}
     FILE*       m_file;
     int         m_repeatCount;
     int         m_repeatLogLevel;
     std::string m_repeatLine;
     int         m_logLevel;
     CCriticalSection critSec;
+
+    /* asynchronous logging, records are pushed without taking a lock and
+       written in batches by m_writer */
+    volatile long m_async;         // 1 while lines go to m_writer
+    volatile long m_pushing;       // threads that may be pushing a record right now
+    void* volatile m_queueHead;    // LogRecord stack, newest record first
+    char*       m_pool;            // preallocated records, allocated while async
+    volatile long m_poolNext;      // where to look for a free pooled record
+    CEvent      m_queuedEvent;
+    CLogWriter* m_writer;          // guarded by critSec
   };
 
   CLog();
@@ -57,8 +72,19 @@ public:
   static bool Init(const char* path);
   static void SetLogLevel(int level);
   static int  GetLogLevel();
+  /*! \brief Hands lines to a background writer instead of writing them on the calling thread */
+  static void SetAsync(bool async);
+  /*! \brief Writes all lines that are queued for the background writer */
+  static void Flush();
 private:
+  friend class CLogWriter;
+  static LogRecord* AllocRecord(int length);
+  static void FreeRecord(LogRecord* record);
+  static void Push(LogRecord* record);
+  static bool WriteQueued();
+  static void WriteLine(const LogRecord& record, std::string& strData);
   static void OutputDebugString(const std::string& line);
+  static void OnTerminate();
 };
 
 #undef ATTRIB_LOG_FORMAT
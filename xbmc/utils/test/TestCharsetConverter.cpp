@@ -20,9 +20,18 @@
 
 #include "settings/GUISettings.h"
 #include "utils/CharsetConverter.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+
+#include <iconv.h>
+#include <iostream>
 
 #include "gtest/gtest.h"
 
+#define THREADS     4
+#define CONVERSIONS 200000
+
 static const uint16_t refutf16LE1[] = { 0xff54, 0xff45, 0xff53, 0xff54,
                                         0xff3f, 0xff55, 0xff54, 0xff46,
                                         0xff11, 0xff16, 0xff2c, 0xff25,
@@ -393,3 +402,135 @@ TEST_F(TestCharsetConverter, fromW)
   g_charsetConverter.fromW(refstrw1, varstra1, "UTF-16LE");
   EXPECT_STREQ(refstra1.c_str(), varstra1.c_str());
 }
+
+TEST_F(TestCharsetConverter, utf8ToW_invalid)
+{
+  // a stray continuation byte, a truncated sequence, an overlong form and a surrogate are skipped
+  refstra1 = "a\x80" "b\xe2\x82" "c\xc0\xaf" "d\xed\xa0\x80" "e";
+  refstrw1 = L"abcde";
+  varstrw1.clear();
+  g_charsetConverter.utf8ToW(refstra1, varstrw1, false);
+  EXPECT_STREQ(refstrw1.c_str(), varstrw1.c_str());
+}
+
+TEST_F(TestCharsetConverter, utf8ToW_roundtrip)
+{
+  // long enough for the vectorized ascii runs, with every length of sequence around them
+  refstra1 = "ascii only for more than sixteen bytes, "
+             "\xc3\xa9t\xc3\xa9 \xe2\x82\xac \xf0\x9f\x90\xad "
+             "and some ascii at the end that is long enough";
+  varstrw1.clear();
+  g_charsetConverter.utf8ToW(refstra1, varstrw1, false);
+
+  const char* ascii = "ascii only for more than sixteen bytes, ";
+  ASSERT_LT(strlen(ascii), varstrw1.length());
+  for (unsigned int i = 0; i < strlen(ascii); i++)
+    EXPECT_EQ((wchar_t)ascii[i], varstrw1[i]);
+
+  varstra1.clear();
+  g_charsetConverter.wToUTF8(varstrw1, varstra1);
+  EXPECT_STREQ(refstra1.c_str(), varstra1.c_str());
+}
+
+TEST_F(TestCharsetConverter, utf16LEtoUTF8_surrogates)
+{
+  // a surrogate pair, followed by a lone low surrogate that is skipped
+  static const uint16_t utf16[] = { 'x', 0xd83d, 0xdc2d, 0xdc2d, 'y', 0x0 };
+  refstr16_1.assign(utf16);
+  varstra1.clear();
+  g_charsetConverter.utf16LEtoUTF8(refstr16_1, varstra1);
+  EXPECT_STREQ("x\xf0\x9f\x90\xady", varstra1.c_str());
+}
+
+TEST_F(TestCharsetConverter, utf8ToW_visualAscii)
+{
+  // plain ascii isn't reordered by the bidi flip, which drops the line breaks
+  refstra1 = "first line\nsecond line";
+  refstrw1 = L"first linesecond line";
+  varstrw1.clear();
+  bool flipped = true;
+  g_charsetConverter.utf8ToW(refstra1, varstrw1, true, false, &flipped);
+  EXPECT_STREQ(refstrw1.c_str(), varstrw1.c_str());
+  EXPECT_FALSE(flipped);
+}
+
+/* what utf8ToW did before it transcoded natively: iconv, one handle behind a lock */
+static CCriticalSection g_iconvSection;
+static iconv_t g_iconv = (iconv_t)-1;
+
+static void iconvUtf8ToW(const CStdStringA& strSource, CStdStringW& strDest)
+{
+  CSingleLock lock(g_iconvSection);
+  if (g_iconv == (iconv_t)-1)
+    g_iconv = iconv_open("WCHAR_T", "UTF-8");
+
+  const char* src = strSource.c_str();
+  size_t srcLength = strSource.length() + 1;
+  size_t dstLength = srcLength * sizeof(wchar_t);
+  char* dst = (char*)strDest.GetBuffer(srcLength);
+  iconv_const(g_iconv, &src, &srcLength, &dst, &dstLength);
+  strDest.ReleaseBuffer();
+}
+
+class CConvertThread : public CThread
+{
+public:
+  CConvertThread(bool native, const std::vector<CStdStringA>& labels)
+    : CThread("TestCharsetConverter"), m_native(native), m_labels(labels) {}
+
+protected:
+  virtual void Process()
+  {
+    CStdStringW label;
+    for (unsigned int i = 0; i < CONVERSIONS; i++)
+    {
+      if (m_native)
+        g_charsetConverter.utf8ToW(m_labels[i % m_labels.size()], label, false);
+      else
+        iconvUtf8ToW(m_labels[i % m_labels.size()], label);
+    }
+  }
+
+  bool m_native;
+  const std::vector<CStdStringA>& m_labels;
+};
+
+TEST_F(TestCharsetConverter, utf8ToWBenchmark)
+{
+  // the kind of labels a library sorts by
+  std::vector<CStdStringA> labels;
+  labels.push_back("The Quick Brown Fox (2012)");
+  labels.push_back("Amélie");
+  labels.push_back("Season 3 - Episode 12 - A rather long episode title");
+  labels.push_back("ｔｅｓｔ＿ｕｔｆ８ＴｏＷ");
+
+  for (unsigned int i = 0; i < labels.size(); i++)
+  {
+    CStdStringW native, reference;
+    g_charsetConverter.utf8ToW(labels[i], native, false);
+    iconvUtf8ToW(labels[i], reference);
+    EXPECT_STREQ(reference.c_str(), native.c_str());
+  }
+
+  const char* modes[] = { "iconv", "native" };
+  for (unsigned int mode = 0; mode < 2; mode++)
+  {
+    CConvertThread* threads[THREADS];
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (unsigned int i = 0; i < THREADS; i++)
+    {
+      threads[i] = new CConvertThread(mode == 1, labels);
+      threads[i]->Create();
+    }
+    for (unsigned int i = 0; i < THREADS; i++)
+    {
+      threads[i]->StopThread(true);
+      delete threads[i];
+    }
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+    std::cout << "Mode: " << modes[mode] << std::endl;
+    std::cout << "  Elapsed (ms): " << testing::PrintToString(elapsed) << std::endl;
+    std::cout << "  Conversions/sec: " << testing::PrintToString(elapsed ? (uint64_t)THREADS * CONVERSIONS * 1000 / elapsed : 0) << std::endl;
+  }
+}
@@ -21,6 +21,10 @@
 #include "utils/JobManager.h"
 #include "settings/GUISettings.h"
 #include "utils/SystemInfo.h"
+#include "threads/Atomics.h"
+#include "threads/Event.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
 
 #include "gtest/gtest.h"
 
@@ -88,3 +92,152 @@ TEST_F(TestJobManager, IsProcessing)
 
   CJobManager::GetInstance().CancelJobs();
 }
+
+class CountingJob : public CJob
+{
+public:
+  CountingJob(volatile long *counter) : m_counter(counter) {}
+  virtual bool DoWork()
+  {
+    AtomicIncrement(m_counter);
+    return true;
+  }
+  virtual const char *GetType() const { return "counting"; }
+private:
+  volatile long *m_counter;
+};
+
+class JobProducer : public IRunnable
+{
+public:
+  JobProducer(volatile long *counter, unsigned int jobs) : m_counter(counter), m_jobs(jobs) {}
+  virtual void Run()
+  {
+    for (unsigned int i = 0; i < m_jobs; i++)
+      CJobManager::GetInstance().AddJob(new CountingJob(m_counter), NULL, CJob::PRIORITY(i % (CJob::PRIORITY_HIGH + 1)));
+  }
+private:
+  volatile long *m_counter;
+  unsigned int m_jobs;
+};
+
+/* Queues jobs from several threads at once and waits for all of them to run,
+ * returning the time taken in milliseconds.
+ */
+static unsigned int RunContention(CJobManager::SCHEDULER scheduler, unsigned int producers, unsigned int jobs)
+{
+  CJobManager &manager = CJobManager::GetInstance();
+  manager.CancelJobs(); // waits for the workers so the scheduler can be switched
+  EXPECT_TRUE(manager.SetScheduler(scheduler));
+  manager.Restart();
+
+  volatile long counter = 0;
+  JobProducer producer(&counter, jobs);
+  std::vector<CThread*> threads;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 0; i < producers; i++)
+  {
+    threads.push_back(new CThread(&producer, "JobProducer"));
+    threads.back()->Create();
+  }
+  for (unsigned int i = 0; i < producers; i++)
+  {
+    threads[i]->WaitForThreadExit(60000);
+    delete threads[i];
+  }
+  const long total = producers * jobs;
+  while (counter < total && XbmcThreads::SystemClockMillis() - start < 60000)
+    XbmcThreads::ThreadSleep(1);
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+  EXPECT_EQ(total, counter);
+  manager.CancelJobs();
+  return elapsed;
+}
+
+TEST_F(TestJobManager, WorkStealingCancelJob)
+{
+  CJobManager &manager = CJobManager::GetInstance();
+  manager.CancelJobs();
+  EXPECT_TRUE(manager.SetScheduler(CJobManager::SCHEDULER_WORKSTEALING));
+  manager.Restart();
+
+  manager.Pause("counting");
+  volatile long counter = 0;
+  unsigned int id = manager.AddJob(new CountingJob(&counter), NULL);
+  EXPECT_NE(0U, id);
+  manager.CancelJob(id);
+  manager.UnPause("counting");
+  XbmcThreads::ThreadSleep(100);
+  EXPECT_EQ(0, counter);
+
+  manager.CancelJobs();
+  EXPECT_TRUE(manager.SetScheduler(CJobManager::SCHEDULER_SHARED));
+}
+
+class BlockingJob : public CJob
+{
+public:
+  BlockingJob(volatile long *started, CEvent *release) : m_started(started), m_release(release) {}
+  virtual bool DoWork()
+  {
+    AtomicIncrement(m_started);
+    m_release->WaitMSec(10000);
+    return true;
+  }
+  virtual const char *GetType() const { return "blocking"; }
+private:
+  volatile long *m_started;
+  CEvent *m_release;
+};
+
+/* Queues jobs that only finish together and waits for all of them to start */
+static bool RunBurst(unsigned int jobs)
+{
+  CJobManager &manager = CJobManager::GetInstance();
+  volatile long started = 0;
+  CEvent release(true);
+  for (unsigned int i = 0; i < jobs; i++)
+    manager.AddJob(new BlockingJob(&started, &release), NULL, CJob::PRIORITY_HIGH);
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  while (started < (long)jobs && XbmcThreads::SystemClockMillis() - start < 5000)
+    XbmcThreads::ThreadSleep(1);
+  bool allStarted = started == (long)jobs;
+
+  release.Set();
+  while (manager.IsProcessing("blocking") > 0 && XbmcThreads::SystemClockMillis() - start < 15000)
+    XbmcThreads::ThreadSleep(1);
+  return allStarted;
+}
+
+TEST_F(TestJobManager, WorkStealingBurstWakesIdleWorkers)
+{
+  CJobManager &manager = CJobManager::GetInstance();
+  manager.CancelJobs();
+  EXPECT_TRUE(manager.SetScheduler(CJobManager::SCHEDULER_WORKSTEALING));
+  manager.Restart();
+
+  // the first burst starts the workers, which are idle for the second one
+  EXPECT_TRUE(RunBurst(3));
+  XbmcThreads::ThreadSleep(100);
+  EXPECT_TRUE(RunBurst(3));
+
+  manager.CancelJobs();
+  EXPECT_TRUE(manager.SetScheduler(CJobManager::SCHEDULER_SHARED));
+}
+
+TEST_F(TestJobManager, ContentionBenchmark)
+{
+  const unsigned int producers = 8;
+  const unsigned int jobs = 10000;
+
+  unsigned int shared = RunContention(CJobManager::SCHEDULER_SHARED, producers, jobs);
+  unsigned int stealing = RunContention(CJobManager::SCHEDULER_WORKSTEALING, producers, jobs);
+
+  std::cout << "Jobs: " << testing::PrintToString(producers * jobs) << std::endl;
+  std::cout << "Shared scheduler (ms): " << testing::PrintToString(shared) << std::endl;
+  std::cout << "Work-stealing scheduler (ms): " << testing::PrintToString(stealing) << std::endl;
+
+  CJobManager::GetInstance().SetScheduler(CJobManager::SCHEDULER_SHARED);
+}
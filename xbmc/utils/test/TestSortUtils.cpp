@@ -131,3 +131,76 @@ TEST(TestSortUtils, GetFieldsForSorting)
   EXPECT_EQ(FieldTrackNumber, *it);
   EXPECT_EQ((unsigned int)4, fields.size());
 }
+
+TEST(TestSortUtils, Sort_Special)
+{
+  SortItems items;
+  const char *labels[] = { "B", "Top", "A", "Folder", "Bottom", "C" };
+  for (unsigned int i = 0; i < sizeof(labels) / sizeof(labels[0]); i++)
+  {
+    SortItem item;
+    item[FieldLabel] = labels[i];
+    items.push_back(item);
+  }
+  items[1][FieldSortSpecial] = SortSpecialOnTop;
+  items[4][FieldSortSpecial] = SortSpecialOnBottom;
+  items[3][FieldFolder] = true;
+  items[0][FieldFolder] = false;
+
+  SortUtils::Sort(SortByLabel, SortOrderDescending, SortAttributeNone, items);
+
+  EXPECT_STREQ("Top", items.at(0)[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Folder", items.at(1)[FieldLabel].asString().c_str());
+  EXPECT_STREQ("C", items.at(2)[FieldLabel].asString().c_str());
+  EXPECT_STREQ("B", items.at(3)[FieldLabel].asString().c_str());
+  EXPECT_STREQ("A", items.at(4)[FieldLabel].asString().c_str());
+  EXPECT_STREQ("Bottom", items.at(5)[FieldLabel].asString().c_str());
+}
+
+TEST(TestSortUtils, Sort_FolderUnknown)
+{
+  SortItems items;
+  const char *labels[] = { "M", "A", "Z", "B" };
+  for (unsigned int i = 0; i < sizeof(labels) / sizeof(labels[0]); i++)
+  {
+    SortItem item;
+    item[FieldLabel] = labels[i];
+    items.push_back(item);
+  }
+  items[0][FieldFolder] = false;
+  items[2][FieldFolder] = true;
+
+  // items without the folder field are sorted with the files
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeNone, items);
+
+  EXPECT_STREQ("Z", items.at(0)[FieldLabel].asString().c_str());
+  EXPECT_STREQ("A", items.at(1)[FieldLabel].asString().c_str());
+  EXPECT_STREQ("B", items.at(2)[FieldLabel].asString().c_str());
+  EXPECT_STREQ("M", items.at(3)[FieldLabel].asString().c_str());
+}
+
+TEST(TestSortUtils, Sort_Limits)
+{
+  SortItems items;
+  for (int i = 0; i < 100; i++)
+  {
+    SortItem item;
+    CStdString label;
+    label.Format("Track %i", (i * 37) % 50); // every label twice
+    item[FieldLabel] = label;
+    item[FieldId] = i;
+    items.push_back(item);
+  }
+  SortItems limited = items;
+
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeNone, items);
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeNone, limited, 30, 10);
+
+  ASSERT_EQ((size_t)20, limited.size());
+  for (size_t i = 0; i < limited.size(); i++)
+  {
+    // the limited range must match the full sort, including the order of equal labels
+    EXPECT_EQ(items.at(i + 10)[FieldId].asInteger(), limited.at(i)[FieldId].asInteger());
+    EXPECT_STREQ(items.at(i + 10)[FieldLabel].asString().c_str(), limited.at(i)[FieldLabel].asString().c_str());
+  }
+}
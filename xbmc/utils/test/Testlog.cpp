@@ -22,11 +22,20 @@
 #include "utils/RegExp.h"
 #include "filesystem/File.h"
 #include "filesystem/SpecialProtocol.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
 
 #include "test/TestUtils.h"
 
+#include <algorithm>
+#include <iostream>
+
 #include "gtest/gtest.h"
 
+#define THREADS     4
+#define LINES       2000
+#define BENCHLINES  20000
+
 class Testlog : public testing::Test
 {
 protected:
@@ -146,3 +155,122 @@ TEST_F(Testlog, SetLogLevel)
   CLog::Close();
   EXPECT_TRUE(XFILE::CFile::Delete(logfile));
 }
+
+class CLogThread : public CThread
+{
+public:
+  CLogThread() : CThread("Testlog"), m_index(0), m_lines(0), m_elapsed(0) {}
+
+  int m_index;
+  int m_lines;
+  unsigned int m_elapsed;
+
+protected:
+  virtual void Process()
+  {
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (int i = 0; i < m_lines; i++)
+      CLog::Log(LOGDEBUG, "thread %d line %d, a log line of a realistic length", m_index, i);
+    m_elapsed = XbmcThreads::SystemClockMillis() - start;
+  }
+};
+
+/* logs from THREADS threads at once, returns the longest time a thread
+ * spent logging and the time until everything was written in total */
+static unsigned int LogFromThreads(int lines, unsigned int &total)
+{
+  CLogThread threads[THREADS];
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < THREADS; i++)
+  {
+    threads[i].m_index = i;
+    threads[i].m_lines = lines;
+    threads[i].Create();
+  }
+
+  unsigned int elapsed = 0;
+  for (int i = 0; i < THREADS; i++)
+  {
+    threads[i].StopThread(true);
+    elapsed = std::max(elapsed, threads[i].m_elapsed);
+  }
+
+  CLog::Flush();
+  total = XbmcThreads::SystemClockMillis() - start;
+  return elapsed;
+}
+
+TEST_F(Testlog, AsyncLog)
+{
+  CStdString logfile, logstring;
+  char buf[4096];
+  unsigned int bytesread;
+  XFILE::CFile file;
+
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + "xbmc.log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/")));
+  CLog::SetAsync(true);
+
+  for (int i = 0; i < 5; i++)
+    CLog::Log(LOGDEBUG, "repeated log message");
+  CLog::Log(LOGDEBUG, "log message after the repeats");
+
+  unsigned int total;
+  LogFromThreads(LINES, total);
+  CLog::Close();
+
+  EXPECT_TRUE(file.Open(logfile));
+  while ((bytesread = file.Read(buf, sizeof(buf) - 1)) > 0)
+  {
+    buf[bytesread] = '\0';
+    logstring.append(buf);
+  }
+  file.Close();
+
+  // repeats are collapsed, and each thread's lines are written in order
+  EXPECT_EQ(logstring.find("repeated log message"), logstring.rfind("repeated log message"));
+  EXPECT_NE(std::string::npos, logstring.find("Previous line repeats 4 times."));
+
+  int next[THREADS] = { 0 };
+  size_t pos = 0;
+  while ((pos = logstring.find("thread ", pos)) != std::string::npos)
+  {
+    int thread, line;
+    if (sscanf(logstring.c_str() + pos, "thread %d line %d", &thread, &line) == 2)
+    {
+      ASSERT_TRUE(thread >= 0 && thread < THREADS);
+      EXPECT_EQ(next[thread], line);
+      next[thread] = line + 1;
+    }
+    pos++;
+  }
+  for (int i = 0; i < THREADS; i++)
+    EXPECT_EQ(LINES, next[i]);
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
+
+TEST_F(Testlog, ThroughputBenchmark)
+{
+  CStdString logfile;
+  const char *modes[] = { "sync", "async" };
+
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + "xbmc.log";
+  for (int i = 0; i < 2; i++)
+  {
+    EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/")));
+    CLog::SetAsync(i == 1);
+
+    unsigned int total;
+    unsigned int elapsed = LogFromThreads(BENCHLINES, total);
+    CLog::Close();
+
+    uint64_t lines = (uint64_t)THREADS * BENCHLINES;
+    std::cout << "Mode: " << modes[i] << std::endl;
+    std::cout << "  Time spent in CLog::Log (ms): " << testing::PrintToString(elapsed) << std::endl;
+    std::cout << "  Time until written (ms): " << testing::PrintToString(total) << std::endl;
+    std::cout << "  Lines/sec: " << testing::PrintToString(total ? lines * 1000 / total : 0) << std::endl;
+  }
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
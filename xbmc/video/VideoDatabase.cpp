@@ -161,7 +161,7 @@ bool CVideoDatabase::CreateTables()
     m_pDS->exec("CREATE TABLE actors ( idActor integer primary key, strActor text, strThumb text )\n");
 
     CLog::Log(LOGINFO, "create path table");
-    m_pDS->exec("CREATE TABLE path ( idPath integer primary key, strPath text, strContent text, strScraper text, strHash text, scanRecursive integer, useFolderNames bool, strSettings text, noUpdate bool, exclude bool, dateAdded text)");
+    m_pDS->exec("CREATE TABLE path ( idPath integer primary key, strPath text, strContent text, strScraper text, strHash text, scanRecursive integer, useFolderNames bool, strSettings text, noUpdate bool, exclude bool, dateAdded text, strFingerprint text)");
     m_pDS->exec("CREATE INDEX ix_path ON path ( strPath(255) )");
 
     CLog::Log(LOGINFO, "create files table");
@@ -600,6 +600,31 @@ int CVideoDatabase::RunQuery(const CStdString &sql)
   return rows;
 }
 
+int CVideoDatabase::RunStreamedQuery(const CStdString &sql)
+{
+  unsigned int time = XbmcThreads::SystemClockMillis();
+  int rows = -1;
+  m_pDS->set_forward_only(true);
+  try
+  {
+    if (m_pDS->query(sql.c_str()))
+    {
+      rows = m_pDS->eof() ? 0 : 1;
+      if (rows == 0)
+        m_pDS->close();
+    }
+  }
+  catch (...)
+  {
+    m_pDS->set_forward_only(false);
+    throw;
+  }
+  if (rows <= 0)
+    m_pDS->set_forward_only(false);
+  CLog::Log(LOGDEBUG, "%s took %d ms to start query: %s", __FUNCTION__, XbmcThreads::SystemClockMillis() - time, sql.c_str());
+  return rows;
+}
+
 bool CVideoDatabase::GetSubPaths(const CStdString &basepath, vector< pair<int,string> >& subpaths)
 {
   CStdString sql;
@@ -826,6 +851,56 @@ bool CVideoDatabase::SetPathHash(const CStdString &path, const CStdString &hash)
   return false;
 }
 
+bool CVideoDatabase::SetPathFingerprint(const CStdString &path, const CStdString &fingerprint)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    int idPath = AddPath(path);
+    if (idPath < 0) return false;
+
+    CStdString strSQL=PrepareSQL("update path set strFingerprint='%s' where idPath=%ld", fingerprint.c_str(), idPath);
+    m_pDS->exec(strSQL.c_str());
+
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s, %s) failed", __FUNCTION__, path.c_str(), fingerprint.c_str());
+  }
+
+  return false;
+}
+
+bool CVideoDatabase::GetPathFingerprints(const CStdString &basepath, map<string, pair<string, string> > &fingerprints)
+{
+  CStdString sql;
+  try
+  {
+    if (!m_pDB.get() || !m_pDS.get())
+      return false;
+
+    CStdString path(basepath);
+    URIUtils::AddSlashAtEnd(path);
+    sql = PrepareSQL("SELECT strPath,strHash,strFingerprint FROM path WHERE SUBSTR(strPath,1,%i)='%s'", StringUtils::utf8_strlen(path.c_str()), path.c_str());
+    m_pDS->query(sql.c_str());
+    while (!m_pDS->eof())
+    {
+      fingerprints[m_pDS->fv(0).get_asString()] = make_pair(m_pDS->fv(1).get_asString(), m_pDS->fv(2).get_asString());
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s error during query: %s",__FUNCTION__, sql.c_str());
+  }
+  return false;
+}
+
 bool CVideoDatabase::LinkMovieToTvshow(int idMovie, int idShow, bool bRemove)
 {
    try
@@ -3130,8 +3205,9 @@ bool CVideoDatabase::GetStreamDetails(CVideoInfoTag& tag) const
   auto_ptr<Dataset> pDS(m_pDB->CreateDataset());
   try
   {
-    CStdString strSQL = PrepareSQL("SELECT * FROM streamdetails WHERE idFile = %i", tag.m_iFileId);
-    pDS->query(strSQL);
+    ParamList params;
+    params["idFile"] = tag.m_iFileId;
+    pDS->query("SELECT * FROM streamdetails WHERE idFile = :idFile", params);
 
     while (!pDS->eof())
     {
@@ -3283,8 +3359,9 @@ CVideoInfoTag CVideoDatabase::GetDetailsForMovie(const dbiplus::sql_record* cons
     details.m_strPictureURL.Parse();
 
     // get tags
-    CStdString strSQL = PrepareSQL("SELECT tag.strTag FROM tag, taglinks WHERE taglinks.idMedia = %i AND taglinks.media_type = 'movie' AND taglinks.idTag = tag.idTag ORDER BY tag.idTag", idMovie);
-    m_pDS2->query(strSQL.c_str());
+    ParamList params;
+    params["id"] = idMovie;
+    m_pDS2->query("SELECT tag.strTag FROM tag, taglinks WHERE taglinks.idMedia = :id AND taglinks.media_type = 'movie' AND taglinks.idTag = tag.idTag ORDER BY tag.idTag", params);
     while (!m_pDS2->eof())
     {
       details.m_tags.push_back(m_pDS2->fv("tag.strTag").get_asString());
@@ -3343,8 +3420,9 @@ CVideoInfoTag CVideoDatabase::GetDetailsForTvShow(const dbiplus::sql_record* con
     GetCast("tvshow", "idShow", details.m_iDbId, details.m_cast);
 
     // get tags
-    CStdString strSQL = PrepareSQL("SELECT tag.strTag FROM tag, taglinks WHERE taglinks.idMedia = %i AND taglinks.media_type = 'tvshow' AND taglinks.idTag = tag.idTag ORDER BY tag.idTag", idTvShow);
-    m_pDS2->query(strSQL.c_str());
+    ParamList params;
+    params["id"] = idTvShow;
+    m_pDS2->query("SELECT tag.strTag FROM tag, taglinks WHERE taglinks.idMedia = :id AND taglinks.media_type = 'tvshow' AND taglinks.idTag = tag.idTag ORDER BY tag.idTag", params);
     while (!m_pDS2->eof())
     {
       details.m_tags.push_back(m_pDS2->fv("tag.strTag").get_asString());
@@ -3447,8 +3525,9 @@ CVideoInfoTag CVideoDatabase::GetDetailsForMusicVideo(const dbiplus::sql_record*
   if (getDetails)
   {
     // get tags
-    CStdString strSQL = PrepareSQL("SELECT tag.strTag FROM tag, taglinks WHERE taglinks.idMedia = %i AND taglinks.media_type = 'musicvideo' AND taglinks.idTag = tag.idTag ORDER BY tag.idTag", idMVideo);
-    m_pDS2->query(strSQL.c_str());
+    ParamList params;
+    params["id"] = idMVideo;
+    m_pDS2->query("SELECT tag.strTag FROM tag, taglinks WHERE taglinks.idMedia = :id AND taglinks.media_type = 'musicvideo' AND taglinks.idTag = tag.idTag ORDER BY tag.idTag", params);
     while (!m_pDS2->eof())
     {
       details.m_tags.push_back(m_pDS2->fv("tag.strTag").get_asString());
@@ -3480,9 +3559,11 @@ void CVideoDatabase::GetCast(const CStdString &table, const CStdString &table_id
                                 "    actorlink%s.idActor=actors.idActor"
                                 "  LEFT JOIN art ON"
                                 "    art.media_id=actors.idActor AND art.media_type='actor' AND art.type='thumb' "
-                                "WHERE actorlink%s.%s=%i "
-                                "ORDER BY actorlink%s.iOrder",table.c_str(), table.c_str(), table.c_str(), table.c_str(), table_id.c_str(), type_id, table.c_str());
-    m_pDS2->query(sql.c_str());
+                                "WHERE actorlink%s.%s=:id "
+                                "ORDER BY actorlink%s.iOrder",table.c_str(), table.c_str(), table.c_str(), table.c_str(), table_id.c_str(), table.c_str());
+    ParamList params;
+    params["id"] = type_id;
+    m_pDS2->query(sql, params);
     while (!m_pDS2->eof())
     {
       SActorInfo info;
@@ -3680,8 +3761,11 @@ bool CVideoDatabase::GetArtForItem(int mediaId, const string &mediaType, map<str
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS2.get()) return false; // using dataset 2 as we're likely called in loops on dataset 1
 
-    CStdString sql = PrepareSQL("SELECT type,url FROM art WHERE media_id=%i AND media_type='%s'", mediaId, mediaType.c_str());
-    m_pDS2->query(sql.c_str());
+    // bound, so the statement is prepared once for the whole listing
+    ParamList params;
+    params["id"] = mediaId;
+    params["type"] = mediaType;
+    m_pDS2->query("SELECT type,url FROM art WHERE media_id=:id AND media_type=:type", params);
     while (!m_pDS2->eof())
     {
       art.insert(make_pair(m_pDS2->fv(0).get_asString(), m_pDS2->fv(1).get_asString()));
@@ -3699,8 +3783,11 @@ bool CVideoDatabase::GetArtForItem(int mediaId, const string &mediaType, map<str
 
 string CVideoDatabase::GetArtForItem(int mediaId, const string &mediaType, const string &artType)
 {
-  std::string query = PrepareSQL("SELECT url FROM art WHERE media_id=%i AND media_type='%s' AND type='%s'", mediaId, mediaType.c_str(), artType.c_str());
-  return GetSingleValue(query, m_pDS2);
+  ParamList params;
+  params["id"] = mediaId;
+  params["mediatype"] = mediaType;
+  params["type"] = artType;
+  return GetSingleValue("SELECT url FROM art WHERE media_id=:id AND media_type=:mediatype AND type=:type", params, m_pDS2);
 }
 
 bool CVideoDatabase::GetTvShowSeasonArt(int showId, map<int, map<string, string> > &seasonArt)
@@ -3711,8 +3798,9 @@ bool CVideoDatabase::GetTvShowSeasonArt(int showId, map<int, map<string, string>
     if (NULL == m_pDS2.get()) return false; // using dataset 2 as we're likely called in loops on dataset 1
 
     // get all seasons for this show
-    CStdString sql = PrepareSQL("select idSeason,season from seasons where idShow=%i", showId);
-    m_pDS2->query(sql.c_str());
+    ParamList params;
+    params["id"] = showId;
+    m_pDS2->query("select idSeason,season from seasons where idShow=:id", params);
 
     vector< pair<int, int> > seasons;
     while (!m_pDS2->eof())
@@ -4336,6 +4424,8 @@ bool CVideoDatabase::UpdateOldVersion(int iVersion)
     m_pDS->exec("CREATE INDEX ix_path ON path ( strPath(255) )");
     m_pDS->exec("CREATE INDEX ix_files ON files ( idPath, strFilename(255) )");
   }
+  if (iVersion < 76)
+    m_pDS->exec("ALTER TABLE path ADD strFingerprint text");
   // always recreate the view after any table change
   CreateViews();
   return true;
@@ -4343,7 +4433,7 @@ bool CVideoDatabase::UpdateOldVersion(int iVersion)
 
 int CVideoDatabase::GetMinVersion() const
 {
-  return 75;
+  return 76;
 }
 
 bool CVideoDatabase::LookupByFolders(const CStdString &path, bool shows)
@@ -5859,28 +5949,27 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const Filter
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
+    // without sorting the rows are used in the order they come, so stream them
+    bool stream = sortDescription.sortBy == SortByNone;
+    int iRowsFound = stream ? RunStreamedQuery(strSQL) : RunQuery(strSQL);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
 
-    // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
-    items.SetProperty("total", total);
-    
     DatabaseResults results;
-    results.reserve(iRowsFound);
-
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeMovie, m_pDS, results))
-      return false;
+    if (!stream)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sortDescription, MediaTypeMovie, m_pDS, results))
+        return false;
+      items.Reserve(results.size());
+    }
 
     // get data from returned rows
-    items.Reserve(results.size());
     const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    unsigned int row = 0;
+    for (; stream ? !m_pDS->eof() : row < results.size(); row++)
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = stream ? m_pDS->get_sql_record() : data.at((unsigned int)results[row].at(FieldRow).asInteger());
 
       CVideoInfoTag movie = GetDetailsForMovie(record);
       if (g_settings.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
@@ -5897,15 +5986,26 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const Filter
         pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.m_playCount > 0);
         items.Add(pItem);
       }
+      if (stream)
+        m_pDS->next();
     }
 
+    // store the total value of items as a property, only known now if the rows were streamed
+    if (stream)
+      iRowsFound = row;
+    if (total < iRowsFound)
+      total = iRowsFound;
+    items.SetProperty("total", total);
+
     // cleanup
     m_pDS->close();
+    m_pDS->set_forward_only(false);
     return true;
   }
   catch (...)
   {
     CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+    m_pDS->set_forward_only(false);
   }
   return false;
 }
@@ -6284,29 +6384,29 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const Filt
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
+    // without sorting the rows are used in the order they come, so stream them
+    bool stream = sorting.sortBy == SortByNone;
+    int iRowsFound = stream ? RunStreamedQuery(strSQL) : RunQuery(strSQL);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
 
-    // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
-    items.SetProperty("total", total);
-    
     DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeEpisode, m_pDS, results))
-      return false;
-    
+    if (!stream)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sorting, MediaTypeEpisode, m_pDS, results))
+        return false;
+      items.Reserve(results.size());
+    }
+
     // get data from returned rows
-    items.Reserve(results.size());
     CLabelFormatter formatter("%H. %T", "");
 
     const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    unsigned int row = 0;
+    for (; stream ? !m_pDS->eof() : row < results.size(); row++)
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = stream ? m_pDS->get_sql_record() : data.at((unsigned int)results[row].at(FieldRow).asInteger());
 
       CVideoInfoTag movie = GetDetailsForEpisode(record);
       if (g_settings.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
@@ -6332,15 +6432,26 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const Filt
         pItem->GetVideoInfoTag()->m_iYear = pItem->m_dateTime.GetYear();
         items.Add(pItem);
       }
+      if (stream)
+        m_pDS->next();
     }
 
+    // store the total value of items as a property, only known now if the rows were streamed
+    if (stream)
+      iRowsFound = row;
+    if (total < iRowsFound)
+      total = iRowsFound;
+    items.SetProperty("total", total);
+
     // cleanup
     m_pDS->close();
+    m_pDS->set_forward_only(false);
     return true;
   }
   catch (...)
   {
     CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+    m_pDS->set_forward_only(false);
   }
   return false;
 }
@@ -7146,28 +7257,27 @@ bool CVideoDatabase::GetMusicVideosByWhere(const CStdString &baseDir, const Filt
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
+    // without sorting the rows are used in the order they come, so stream them
+    bool stream = sorting.sortBy == SortByNone;
+    int iRowsFound = stream ? RunStreamedQuery(strSQL) : RunQuery(strSQL);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
 
-    // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
-    items.SetProperty("total", total);
-    
     DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeMusicVideo, m_pDS, results))
-      return false;
-    
-    // get data from returned rows
-    items.Reserve(results.size());
+    if (!stream)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sorting, MediaTypeMusicVideo, m_pDS, results))
+        return false;
+      items.Reserve(results.size());
+    }
+
     // get songs from returned subtable
     const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    unsigned int row = 0;
+    for (; stream ? !m_pDS->eof() : row < results.size(); row++)
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = stream ? m_pDS->get_sql_record() : data.at((unsigned int)results[row].at(FieldRow).asInteger());
       
       CVideoInfoTag musicvideo = GetDetailsForMusicVideo(record);
       if (!checkLocks || g_settings.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE || g_passwordManager.bMasterUser ||
@@ -7183,15 +7293,26 @@ bool CVideoDatabase::GetMusicVideosByWhere(const CStdString &baseDir, const Filt
         item->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED, musicvideo.m_playCount > 0);
         items.Add(item);
       }
+      if (stream)
+        m_pDS->next();
     }
 
+    // store the total value of items as a property, only known now if the rows were streamed
+    if (stream)
+      iRowsFound = row;
+    if (total < iRowsFound)
+      total = iRowsFound;
+    items.SetProperty("total", total);
+
     // cleanup
     m_pDS->close();
+    m_pDS->set_forward_only(false);
     return true;
   }
   catch (...)
   {
     CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+    m_pDS->set_forward_only(false);
   }
   return false;
 }
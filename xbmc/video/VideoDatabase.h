@@ -528,6 +528,23 @@ public:
   // scanning hashes and paths scanned
   bool SetPathHash(const CStdString &path, const CStdString &hash);
   bool GetPathHash(const CStdString &path, CStdString &hash);
+
+  /*! \brief Set the fingerprint of a directory tree
+   The fingerprint is used by the scanner to skip unchanged directory trees without listing them.
+   \param path the directory.
+   \param fingerprint the fingerprint of the directory, empty to invalidate it.
+   \return true on success, false otherwise.
+   \sa GetPathFingerprints
+   */
+  bool SetPathFingerprint(const CStdString &path, const CStdString &fingerprint);
+
+  /*! \brief Retrieve the hashes and fingerprints of a directory and all known directories below it
+   \param basepath the directory.
+   \param fingerprints [out] map of the paths to their hash and fingerprint.
+   \return true on success, false otherwise.
+   \sa SetPathFingerprint
+   */
+  bool GetPathFingerprints(const CStdString &basepath, std::map<std::string, std::pair<std::string, std::string> > &fingerprints);
   bool GetPaths(std::set<CStdString> &paths);
   bool GetPathsForTvShow(int idShow, std::set<int>& paths);
 
@@ -782,6 +799,13 @@ private:
    */
   int RunQuery(const CStdString &sql);
 
+  /*! \brief Run a query on the main dataset, streaming the rows rather than fetching them all.
+   The dataset is left in forward-only mode until the caller has read the rows and resets it.
+   \param sql the sql query to run
+   \return 1 if there are rows, 0 if there are none, -1 for an error.
+   */
+  int RunStreamedQuery(const CStdString &sql);
+
   /*! \brief Update routine for base path of videos
    Only required for videodb version < 59
    \param table the table to update
@@ -50,6 +50,9 @@
 #include "TextureCache.h"
 #include "GUIUserMessages.h"
 #include "URL.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "utils/JobManager.h"
 
 using namespace std;
 using namespace XFILE;
@@ -57,6 +60,87 @@ using namespace ADDON;
 
 namespace VIDEO
 {
+  /*! \brief Keeps track of the directories being stat'ed by FingerprintTree()
+   The count and its signal are guarded by one lock, so the batch isn't
+   touched by a job once the waiter may have gone.
+   */
+  class CFingerprintBatch
+  {
+  public:
+    CFingerprintBatch() : m_pending(0) {}
+
+    void Add()
+    {
+      CSingleLock lock(m_section);
+      m_pending++;
+    }
+
+    void Done()
+    {
+      CSingleLock lock(m_section);
+      m_pending--;
+      m_done.Set();
+    }
+
+    /*! \brief Wait until no more than the given number of jobs are pending
+     */
+    void Wait(unsigned int pending)
+    {
+      CSingleLock lock(m_section);
+      while (m_pending > pending)
+      {
+        CSingleExit exit(m_section);
+        m_done.Wait();
+      }
+    }
+
+  private:
+    CCriticalSection m_section;
+    CEvent m_done;
+    unsigned int m_pending;
+  };
+
+  /*! \brief Retrieves the fast hash of a single directory
+   The job signals its completion when it's destroyed, so cancelled jobs
+   are accounted for as well.
+   */
+  class CFingerprintJob : public CJob
+  {
+  public:
+    CFingerprintJob(const CVideoInfoScanner *scanner, const std::string &path, std::string &hash, CFingerprintBatch &batch)
+      : m_scanner(scanner), m_path(path), m_hash(hash), m_batch(batch)
+    {
+    }
+
+    virtual ~CFingerprintJob()
+    {
+      m_batch.Done();
+    }
+
+    virtual const char *GetType() const { return "videofingerprint"; }
+
+    virtual bool DoWork()
+    {
+      m_hash = m_scanner->GetFastHash(m_path);
+      return true;
+    }
+
+  private:
+    const CVideoInfoScanner *m_scanner;
+    std::string m_path;
+    std::string &m_hash;
+    CFingerprintBatch &m_batch;
+  };
+
+  static CStdString GetFingerprint(const CStdString &fastHash, int subfolders)
+  {
+    if (fastHash.IsEmpty())
+      return "";
+
+    CStdString fingerprint;
+    fingerprint.Format("%s:%d", fastHash.c_str(), subfolders);
+    return fingerprint;
+  }
 
   CVideoInfoScanner::CVideoInfoScanner() : CThread("CVideoInfoScanner")
   {
@@ -68,6 +152,16 @@ namespace VIDEO
     m_itemCount = 0;
     m_bClean = false;
     m_scanAll = false;
+    m_fingerprinted = false;
+    m_treeScanned = true;
+    m_dirsScanned = 0;
+    m_dirsPruned = 0;
+    m_treesPruned = 0;
+    m_dirsFastHash = 0;
+    m_dirsUnchanged = 0;
+    m_dirsEmpty = 0;
+    m_dirsExcluded = 0;
+    m_dirsNoUpdate = 0;
   }
 
   CVideoInfoScanner::~CVideoInfoScanner()
@@ -106,6 +200,11 @@ namespace VIDEO
       // result in unexpected behaviour.
       m_bCanInterrupt = false;
 
+      m_fastHashes.clear();
+      m_unchangedTrees.clear();
+      m_dirsScanned = m_dirsPruned = m_treesPruned = m_dirsFastHash = 0;
+      m_dirsUnchanged = m_dirsEmpty = m_dirsExcluded = m_dirsNoUpdate = 0;
+
       bool bCancelled = false;
       while (!bCancelled && m_pathsToScan.size())
       {
@@ -126,8 +225,14 @@ namespace VIDEO
           CLog::Log(LOGWARNING, "%s directory '%s' does not exist - skipping scan%s.", __FUNCTION__, directory.c_str(), m_bClean ? " and clean" : "");
           m_pathsToScan.erase(m_pathsToScan.begin());
         }
-        else if (!DoScan(directory))
-          bCancelled = true;
+        else
+        {
+          // sources below a source we've already checked are covered by its fingerprints
+          if (m_fastHashes.find(directory) == m_fastHashes.end())
+            FingerprintTree(directory);
+          if (!DoScan(directory))
+            bCancelled = true;
+        }
       }
 
       if (!bCancelled)
@@ -146,6 +251,9 @@ namespace VIDEO
 
       tick = XbmcThreads::SystemClockMillis() - tick;
       CLog::Log(LOGNOTICE, "VideoInfoScanner: Finished scan. Scanning for video info took %s", StringUtils::SecondsToTimeString(tick / 1000).c_str());
+      CLog::Log(LOGNOTICE, "VideoInfoScanner: Scanned %d directories. Skipped %d directories in %d unchanged trees (fingerprint), "
+                           "%d unchanged (fast hash), %d unchanged (hash), %d empty or unavailable, %d excluded and %d not set to be scanned",
+                m_dirsScanned, m_dirsPruned, m_treesPruned, m_dirsFastHash, m_dirsUnchanged, m_dirsEmpty, m_dirsExcluded, m_dirsNoUpdate);
     }
     catch (...)
     {
@@ -235,6 +343,9 @@ namespace VIDEO
     if (it != m_pathsToScan.end())
       m_pathsToScan.erase(it);
 
+    m_fingerprinted = false;
+    m_treeScanned = true;
+
     // load subfolder
     CFileItemList items;
     bool foundDirectly = false;
@@ -249,13 +360,19 @@ namespace VIDEO
                                                          : g_advancedSettings.m_moviesExcludeFromScanRegExps;
 
     if (CUtil::ExcludeFileOrFolder(strDirectory, regexps))
+    {
+      m_dirsExcluded++;
       return true;
+    }
 
     bool ignoreFolder = !m_scanAll && settings.noupdate;
     if (content == CONTENT_NONE || ignoreFolder)
+    {
+      m_dirsNoUpdate++;
       return true;
+    }
 
-    CStdString hash, dbHash;
+    CStdString hash, dbHash, fastHash;
     if (content == CONTENT_MOVIES ||content == CONTENT_MUSICVIDEOS)
     {
       if (m_handle)
@@ -264,10 +381,28 @@ namespace VIDEO
         m_handle->SetTitle(StringUtils::Format(g_localizeStrings.Get(str), info->Name().c_str()));
       }
 
-      CStdString fastHash = GetFastHash(strDirectory);
+      map<string, int>::const_iterator tree = m_unchangedTrees.find(strDirectory);
+      if (tree != m_unchangedTrees.end())
+      { // nothing changed in the whole tree - no need to list any of it
+        CLog::Log(LOGDEBUG, "VideoInfoScanner: Skipping dir '%s' and its %d subfolders due to no change (fingerprint)", strDirectory.c_str(), tree->second - 1);
+        m_dirsPruned += tree->second;
+        m_treesPruned++;
+
+        // sources within this tree are unchanged as well
+        for (it = m_pathsToScan.lower_bound(strDirectory); it != m_pathsToScan.end() && StringUtils::StartsWith(*it, strDirectory, true); )
+          m_pathsToScan.erase(it++);
+
+        m_fingerprinted = true;
+        if (m_handle)
+          OnDirectoryScanned(strDirectory);
+        return true;
+      }
+
+      fastHash = GetCachedFastHash(strDirectory);
       if (m_database.GetPathHash(strDirectory, dbHash) && !fastHash.IsEmpty() && fastHash == dbHash)
       { // fast hashes match - no need to process anything
         CLog::Log(LOGDEBUG, "VideoInfoScanner: Skipping dir '%s' due to no change (fasthash)", strDirectory.c_str());
+        m_dirsFastHash++;
         hash = fastHash;
         bSkip = true;
       }
@@ -290,9 +425,13 @@ namespace VIDEO
           {
             CLog::Log(LOGDEBUG, "VideoInfoScanner: Skipping dir '%s' as it's empty or doesn't exist - adding to clean list", strDirectory.c_str());
             m_pathsToClean.insert(m_database.GetPathId(strDirectory));
+            m_dirsEmpty++;
           }
           else
+          {
             CLog::Log(LOGDEBUG, "VideoInfoScanner: Skipping dir '%s' due to no change", strDirectory.c_str());
+            m_dirsUnchanged++;
+          }
           bSkip = true;
           if (m_handle)
             OnDirectoryScanned(strDirectory);
@@ -319,7 +458,10 @@ namespace VIDEO
           bSkip = false;
         }
         else
+        {
           items.Clear();
+          m_dirsUnchanged++;
+        }
       }
       else
       {
@@ -331,10 +473,14 @@ namespace VIDEO
       }
     }
 
+    // whether this directory needn't be scraped again unless it changes
+    bool scanned = bSkip;
     if (!bSkip)
     {
+      m_dirsScanned++;
       if (RetrieveVideoInfo(items, settings.parent_name_root, content))
       {
+        scanned = !m_bStop;
         if (!m_bStop && (content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS))
         {
           m_database.SetPathHash(strDirectory, hash);
@@ -356,6 +502,7 @@ namespace VIDEO
     if (m_handle)
       OnDirectoryScanned(strDirectory);
 
+    int subfolders = 0;
     for (int i = 0; i < items.Size(); ++i)
     {
       CFileItemPtr pItem = items[i];
@@ -371,8 +518,23 @@ namespace VIDEO
         {
           m_bStop = true;
         }
+        if (m_fingerprinted)
+          subfolders++;
+        // a subfolder that has to be scraped again mustn't be pruned with its parent
+        if (!m_treeScanned)
+          scanned = false;
       }
     }
+
+    // the fingerprint is only valid once the whole tree has been scanned
+    m_fingerprinted = false;
+    m_treeScanned = scanned && !m_bStop;
+    if ((content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS) && !fastHash.IsEmpty())
+    { // store the fingerprint, or clear an old one so the tree is listed again next time
+      CStdString fingerprint = GetDirectoryFingerprint(fastHash, m_treeScanned, subfolders);
+      m_fingerprinted = m_database.SetPathFingerprint(strDirectory, fingerprint) && !fingerprint.IsEmpty();
+    }
+
     return !m_bStop;
   }
 
@@ -1689,6 +1851,95 @@ namespace VIDEO
     return "";
   }
 
+  CStdString CVideoInfoScanner::GetCachedFastHash(const CStdString &directory) const
+  {
+    map<string, string>::const_iterator i = m_fastHashes.find(directory);
+    if (i != m_fastHashes.end())
+      return i->second;
+    return GetFastHash(directory);
+  }
+
+  CStdString CVideoInfoScanner::GetDirectoryFingerprint(const CStdString &fastHash, bool scanned, int subfolders)
+  {
+    if (!scanned)
+      return "";
+    return GetFingerprint(fastHash, subfolders);
+  }
+
+  void CVideoInfoScanner::FindUnchangedTrees(const map<string, pair<string, string> > &known,
+                                             const map<string, string> &fastHashes,
+                                             map<string, int> &unchangedTrees)
+  {
+    // count the subfolders we know of for each directory
+    map<string, int> subfolders;
+    for (map<string, pair<string, string> >::const_iterator i = known.begin(); i != known.end(); ++i)
+    {
+      CStdString parent;
+      if (URIUtils::GetParentPath(i->first, parent) && known.find(parent) != known.end())
+        subfolders[parent]++;
+    }
+
+    // subfolders sort after their parents, so walk backwards to decide on them first
+    map<string, int> treeSize;
+    set<string> changed;
+    for (map<string, pair<string, string> >::const_reverse_iterator i = known.rbegin(); i != known.rend(); ++i)
+    {
+      const string &path = i->first;
+      const pair<string, string> &stored = i->second;
+      map<string, string>::const_iterator fastHash = fastHashes.find(path);
+
+      CStdString parent;
+      bool hasParent = URIUtils::GetParentPath(path, parent) && known.find(parent) != known.end();
+      if (!stored.first.empty() && !stored.second.empty() && changed.find(path) == changed.end() &&
+          fastHash != fastHashes.end() && stored.second == GetFingerprint(fastHash->second, subfolders[path]))
+      {
+        int size = ++treeSize[path];
+        unchangedTrees[path] = size;
+        if (hasParent)
+          treeSize[parent] += size;
+      }
+      else if (hasParent)
+        changed.insert(parent);
+    }
+  }
+
+  void CVideoInfoScanner::FingerprintTree(const CStdString &strDirectory)
+  {
+    map<string, pair<string, string> > known;
+    if (!m_database.GetPathFingerprints(strDirectory, known) || known.empty())
+      return;
+
+    unsigned int tick = XbmcThreads::SystemClockMillis();
+
+    // stat the known directories concurrently, the hashes are filled in by the jobs
+    vector<string> paths;
+    for (map<string, pair<string, string> >::const_iterator i = known.begin(); i != known.end(); ++i)
+      paths.push_back(i->first);
+    vector<string> hashes(paths.size());
+
+    CFingerprintBatch batch;
+    for (unsigned int i = 0; i < paths.size(); i++)
+    {
+      batch.Wait(g_advancedSettings.m_iVideoScannerStatWorkers - 1);
+      batch.Add();
+      CFingerprintJob *job = new CFingerprintJob(this, paths[i], hashes[i], batch);
+      if (!CJobManager::GetInstance().AddJob(job, NULL, CJob::PRIORITY_NORMAL))
+      { // the job manager isn't running, stat it ourselves
+        job->DoWork();
+        delete job;
+      }
+    }
+    batch.Wait(0);
+
+    for (unsigned int i = 0; i < paths.size(); i++)
+      m_fastHashes[paths[i]] = hashes[i];
+
+    FindUnchangedTrees(known, m_fastHashes, m_unchangedTrees);
+
+    CLog::Log(LOGDEBUG, "VideoInfoScanner: Checked %u known directories below '%s' in %u ms",
+              (unsigned int)paths.size(), strDirectory.c_str(), XbmcThreads::SystemClockMillis() - tick);
+  }
+
   void CVideoInfoScanner::GetSeasonThumbs(const CVideoInfoTag &show, map<int, map<string, string> > &seasonArt, const vector<string> &artTypes, bool useLocal)
   {
     bool lookForThumb = find(artTypes.begin(), artTypes.end(), "thumb") == artTypes.end();
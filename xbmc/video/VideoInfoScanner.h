@@ -29,6 +29,8 @@ class CFileItemList;
 
 namespace VIDEO
 {
+  class CFingerprintJob;
+
   typedef struct SScanSettings
   {
     SScanSettings() { parent_name = parent_name_root = noupdate = exclude = false; recurse = 1;}
@@ -120,7 +122,28 @@ namespace VIDEO
     static std::string GetImage(CFileItem *pItem, bool useLocal, bool bApplyToDir, const std::string &type = "");
     static std::string GetFanart(CFileItem *pItem, bool useLocal);
 
+    /*! \brief Retrieve the fingerprint to store for a directory after scanning it
+     \param fastHash the fast hash of the directory
+     \param scanned whether the directory and all of its subfolders were scraped successfully or skipped as unchanged
+     \param subfolders the number of subfolders that have a fingerprint of their own
+     \return the fingerprint, empty if the directory has to be listed again by the next scan
+     \sa FindUnchangedTrees
+     */
+    static CStdString GetDirectoryFingerprint(const CStdString &fastHash, bool scanned, int subfolders);
+
+    /*! \brief Find the directory trees whose directories all match their stored fingerprints
+     \param known map of the known directories to their stored hash and fingerprint
+     \param fastHashes the current fast hashes of the known directories
+     \param unchangedTrees [out] map of the roots of the unchanged trees to the number of directories in them
+     \sa GetDirectoryFingerprint, FingerprintTree
+     */
+    static void FindUnchangedTrees(const std::map<std::string, std::pair<std::string, std::string> > &known,
+                                   const std::map<std::string, std::string> &fastHashes,
+                                   std::map<std::string, int> &unchangedTrees);
+
   protected:
+    friend class CFingerprintJob;
+
     virtual void Process();
     bool DoScan(const CStdString& strDirectory);
 
@@ -199,6 +222,23 @@ namespace VIDEO
      */
     bool CanFastHash(const CFileItemList &items) const;
 
+    /*! \brief Stat all known directories below a path concurrently and find the unchanged directory trees
+     The fingerprint of a directory combines its fast hash with the number of subfolders that have
+     a fingerprint of their own. A directory tree is unchanged if the fingerprints of all of its
+     directories match and they all have a hash, in which case DoScan() skips it without listing it.
+     The directories are stat'ed by up to m_iVideoScannerStatWorkers jobs at once.
+     \param strDirectory root of the directory trees to check
+     \sa GetFastHash, DoScan
+     */
+    void FingerprintTree(const CStdString &strDirectory);
+
+    /*! \brief Retrieve the fast hash of a directory, using the one from FingerprintTree() if available
+     \param directory folder to hash
+     \return the fast hash of the folder, empty if not available
+     \sa GetFastHash, FingerprintTree
+     */
+    CStdString GetCachedFastHash(const CStdString &directory) const;
+
     /*! \brief Process a series folder, filling in episode details and adding them to the database.
      TODO: Ideally we would return INFO_HAVE_ALREADY if we don't have to update any episodes
      and we should return INFO_NOT_FOUND only if no information is found for any of
@@ -238,6 +278,21 @@ namespace VIDEO
     std::set<CStdString> m_pathsToCount;
     std::set<int> m_pathsToClean;
     CNfoFile m_nfoReader;
+
+    std::map<std::string, std::string> m_fastHashes;  ///< fast hashes of the known directories
+    std::map<std::string, int> m_unchangedTrees;      ///< unchanged directory trees and the number of directories in them
+    bool m_fingerprinted;                             ///< whether the last call to DoScan() stored a fingerprint
+    bool m_treeScanned;                               ///< whether the last call to DoScan() scanned its whole tree successfully
+
+    // directories scanned and skipped (and why) during the last scan
+    int m_dirsScanned;
+    int m_dirsPruned;
+    int m_treesPruned;
+    int m_dirsFastHash;
+    int m_dirsUnchanged;
+    int m_dirsEmpty;
+    int m_dirsExcluded;
+    int m_dirsNoUpdate;
   };
 }
 
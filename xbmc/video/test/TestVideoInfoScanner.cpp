@@ -0,0 +1,113 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "video/VideoInfoScanner.h"
+
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace VIDEO;
+
+typedef map<string, pair<string, string> > KnownPaths;
+
+static const char *root = "/movies/";
+static const char *good = "/movies/good/";
+static const char *bad = "/movies/bad/";
+
+static void SetFastHashes(map<string, string> &fastHashes)
+{
+  fastHashes[root] = "root";
+  fastHashes[good] = "good";
+  fastHashes[bad] = "bad";
+}
+
+TEST(TestVideoInfoScanner, FingerprintOnlyScannedDirectories)
+{
+  EXPECT_STREQ("hash:2", CVideoInfoScanner::GetDirectoryFingerprint("hash", true, 2).c_str());
+  EXPECT_TRUE(CVideoInfoScanner::GetDirectoryFingerprint("hash", false, 2).IsEmpty());
+  EXPECT_TRUE(CVideoInfoScanner::GetDirectoryFingerprint("", true, 2).IsEmpty());
+}
+
+TEST(TestVideoInfoScanner, FailedScrapeIsRevisited)
+{
+  map<string, string> fastHashes;
+  SetFastHashes(fastHashes);
+
+  // first scan: the scrape of one subfolder fails, so it keeps no hash
+  // and neither it nor its parent get a fingerprint
+  KnownPaths known;
+  known[good] = make_pair("goodhash", CVideoInfoScanner::GetDirectoryFingerprint(fastHashes[good], true, 0));
+  known[bad] = make_pair("", CVideoInfoScanner::GetDirectoryFingerprint(fastHashes[bad], false, 0));
+  known[root] = make_pair("roothash", CVideoInfoScanner::GetDirectoryFingerprint(fastHashes[root], false, 1));
+  EXPECT_TRUE(known[bad].second.empty());
+  EXPECT_TRUE(known[root].second.empty());
+
+  // the next scan must list the root and the failed folder again
+  map<string, int> unchanged;
+  CVideoInfoScanner::FindUnchangedTrees(known, fastHashes, unchanged);
+  EXPECT_TRUE(unchanged.find(root) == unchanged.end());
+  EXPECT_TRUE(unchanged.find(bad) == unchanged.end());
+  ASSERT_TRUE(unchanged.find(good) != unchanged.end());
+  EXPECT_EQ(1, unchanged[good]);
+
+  // once the scrape succeeds the whole tree is pruned
+  known[bad] = make_pair("badhash", CVideoInfoScanner::GetDirectoryFingerprint(fastHashes[bad], true, 0));
+  known[root] = make_pair("roothash", CVideoInfoScanner::GetDirectoryFingerprint(fastHashes[root], true, 2));
+  unchanged.clear();
+  CVideoInfoScanner::FindUnchangedTrees(known, fastHashes, unchanged);
+  ASSERT_TRUE(unchanged.find(root) != unchanged.end());
+  EXPECT_EQ(3, unchanged[root]);
+}
+
+TEST(TestVideoInfoScanner, UnknownFailedSubfolderBlocksParent)
+{
+  map<string, string> fastHashes;
+  SetFastHashes(fastHashes);
+
+  // the failed subfolder isn't in the database at all, only
+  // the parent's cleared fingerprint keeps the tree from being pruned
+  KnownPaths known;
+  known[good] = make_pair("goodhash", CVideoInfoScanner::GetDirectoryFingerprint(fastHashes[good], true, 0));
+  known[root] = make_pair("roothash", CVideoInfoScanner::GetDirectoryFingerprint(fastHashes[root], false, 1));
+
+  map<string, int> unchanged;
+  CVideoInfoScanner::FindUnchangedTrees(known, fastHashes, unchanged);
+  EXPECT_TRUE(unchanged.find(root) == unchanged.end());
+  EXPECT_TRUE(unchanged.find(good) != unchanged.end());
+}
+
+TEST(TestVideoInfoScanner, ChangedSubfolderBlocksParent)
+{
+  map<string, string> fastHashes;
+  SetFastHashes(fastHashes);
+
+  KnownPaths known;
+  known[good] = make_pair("goodhash", CVideoInfoScanner::GetDirectoryFingerprint(fastHashes[good], true, 0));
+  known[bad] = make_pair("badhash", CVideoInfoScanner::GetDirectoryFingerprint(fastHashes[bad], true, 0));
+  known[root] = make_pair("roothash", CVideoInfoScanner::GetDirectoryFingerprint(fastHashes[root], true, 2));
+
+  fastHashes[bad] = "changed";
+  map<string, int> unchanged;
+  CVideoInfoScanner::FindUnchangedTrees(known, fastHashes, unchanged);
+  EXPECT_TRUE(unchanged.find(root) == unchanged.end());
+  EXPECT_TRUE(unchanged.find(bad) == unchanged.end());
+  EXPECT_TRUE(unchanged.find(good) != unchanged.end());
+}
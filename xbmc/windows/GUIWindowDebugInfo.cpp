@@ -19,6 +19,7 @@
  */
 
 #include "GUIWindowDebugInfo.h"
+#include "Application.h"
 #include "input/MouseStat.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
@@ -111,6 +112,22 @@ void CGUIWindowDebugInfo::Process(unsigned int currentTime, CDirtyRegionList &di
     info.Format("LOG: %sxbmc.log\nMEM: %"PRIu64"/%"PRIu64" KB - FPS: %2.1f fps\nCPU: %s (CPU-XBMC %4.2f%%%s)", g_settings.m_logFolder.c_str(),
                 stat.ullAvailPhys/1024, stat.ullTotalPhys/1024, g_infoManager.GetFPS(), strCores.c_str(), dCPU, profiling.c_str());
 #endif
+
+    // show what the player has to say about itself, e.g. paplayer's prefetch hit rate
+    if (g_application.IsPlaying() && g_application.m_pPlayer)
+    {
+      CStdString strPlayer;
+      g_application.m_pPlayer->GetGeneralInfo(strPlayer);
+      if (!strPlayer.IsEmpty())
+        info.AppendFormat("\nPLAYER: %s", strPlayer.c_str());
+    }
+
+    // how many of the skin's conditions were served from the cache
+    unsigned int conditions;
+    uint64_t requests, evaluations;
+    g_infoManager.GetBoolStats(conditions, requests, evaluations);
+    info.AppendFormat("\nBOOLS: %u - %"PRIu64" requests, %"PRIu64" evaluations (%2.1f%% cached)", conditions,
+                      requests, evaluations, requests ? 100.0 * (requests - evaluations) / requests : 0.0);
   }
 
   // render the skin debug info